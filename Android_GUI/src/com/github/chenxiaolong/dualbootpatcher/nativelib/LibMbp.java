@@ -195,6 +195,8 @@ public class LibMbp {
         static native Pointer mbp_config_temp_directory(CPatcherConfig pc);
         static native void mbp_config_set_data_directory(CPatcherConfig pc, String path);
         static native void mbp_config_set_temp_directory(CPatcherConfig pc, String path);
+        static native long mbp_config_memory_budget(CPatcherConfig pc);
+        static native void mbp_config_set_memory_budget(CPatcherConfig pc, long bytes);
         static native Pointer mbp_config_version(CPatcherConfig pc);
         static native Pointer mbp_config_devices(CPatcherConfig pc);
         static native Pointer mbp_config_patchers(CPatcherConfig pc);
@@ -226,6 +228,10 @@ public class LibMbp {
         static native void mbp_patcher_set_fileinfo(CPatcher patcher, CFileInfo info);
         static native boolean mbp_patcher_patch_file(CPatcher patcher, ProgressUpdatedCallback progressCb, FilesUpdatedCallback filesCb, DetailsUpdatedCallback detailsCb, Pointer userData);
         static native void mbp_patcher_cancel_patching(CPatcher patcher);
+        static native void mbp_patcher_pause_patching(CPatcher patcher);
+        static native void mbp_patcher_resume_patching(CPatcher patcher);
+        static native Pointer mbp_patcher_memory_phases(CPatcher patcher);
+        static native long mbp_patcher_memory_peak(CPatcher patcher, String phase);
 
         static native /* ErrorCode */ int mbp_autopatcher_error(CAutoPatcher patcher);
         static native Pointer mbp_autopatcher_id(CAutoPatcher patcher);
@@ -237,6 +243,14 @@ public class LibMbp {
         static native Pointer mbp_ramdiskpatcher_id(CRamdiskPatcher patcher);
         static native boolean mbp_ramdiskpatcher_patch_ramdisk(CRamdiskPatcher patcher);
         // END: cpatcherinterface.h
+
+        // BEGIN: ctracing.h
+        static native void mbp_tracing_set_enabled(boolean enabled);
+        static native boolean mbp_tracing_is_enabled();
+        static native void mbp_tracing_clear();
+        static native Pointer mbp_tracing_chrome_json();
+        static native boolean mbp_tracing_write_chrome_trace(String path);
+        // END: ctracing.h
     }
 
     private static String[] getStringArrayAndFree(Pointer p) {
@@ -1511,6 +1525,16 @@ public class LibMbp {
             CWrapper.mbp_config_set_temp_directory(mCPatcherConfig, path);
         }
 
+        public long getMemoryBudget() {
+            validate(mCPatcherConfig, PatcherConfig.class, "getMemoryBudget");
+            return CWrapper.mbp_config_memory_budget(mCPatcherConfig);
+        }
+
+        public void setMemoryBudget(long bytes) {
+            validate(mCPatcherConfig, PatcherConfig.class, "setMemoryBudget", bytes);
+            CWrapper.mbp_config_set_memory_budget(mCPatcherConfig, bytes);
+        }
+
         public String getVersion() {
             validate(mCPatcherConfig, PatcherConfig.class, "getVersion");
             Pointer p = CWrapper.mbp_config_version(mCPatcherConfig);
@@ -1709,6 +1733,29 @@ public class LibMbp {
             CWrapper.mbp_patcher_cancel_patching(mCPatcher);
         }
 
+        public void pausePatching() {
+            validate(mCPatcher, Patcher.class, "pausePatching");
+            CWrapper.mbp_patcher_pause_patching(mCPatcher);
+        }
+
+        public void resumePatching() {
+            validate(mCPatcher, Patcher.class, "resumePatching");
+            CWrapper.mbp_patcher_resume_patching(mCPatcher);
+        }
+
+        public String[] getMemoryPhases() {
+            validate(mCPatcher, Patcher.class, "getMemoryPhases");
+            Pointer p = CWrapper.mbp_patcher_memory_phases(mCPatcher);
+            return getStringArrayAndFree(p);
+        }
+
+        public long getMemoryPeak(String phase) {
+            validate(mCPatcher, Patcher.class, "getMemoryPeak", phase);
+            ensureNotNull(phase);
+
+            return CWrapper.mbp_patcher_memory_peak(mCPatcher, phase);
+        }
+
         public interface ProgressListener {
             void onProgressUpdated(long bytes, long maxBytes);
 
@@ -1873,4 +1920,27 @@ public class LibMbp {
             return CWrapper.mbp_ramdiskpatcher_patch_ramdisk(mCRamdiskPatcher);
         }
     }
+
+    public static class Tracing {
+        public static void setEnabled(boolean enabled) {
+            CWrapper.mbp_tracing_set_enabled(enabled);
+        }
+
+        public static boolean isEnabled() {
+            return CWrapper.mbp_tracing_is_enabled();
+        }
+
+        public static void clear() {
+            CWrapper.mbp_tracing_clear();
+        }
+
+        public static String getChromeJson() {
+            return getStringAndFree(CWrapper.mbp_tracing_chrome_json());
+        }
+
+        public static boolean writeChromeTrace(String path) {
+            ensureNotNull(path);
+            return CWrapper.mbp_tracing_write_chrome_trace(path);
+        }
+    }
 }
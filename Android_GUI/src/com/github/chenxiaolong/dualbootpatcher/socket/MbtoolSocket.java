@@ -39,6 +39,7 @@ import com.google.flatbuffers.Table;
 
 import org.apache.commons.io.IOUtils;
 
+import java.io.FileDescriptor;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
@@ -48,10 +49,14 @@ import mbtool.daemon.v3.FileChmodRequest;
 import mbtool.daemon.v3.FileChmodResponse;
 import mbtool.daemon.v3.FileCloseRequest;
 import mbtool.daemon.v3.FileCloseResponse;
+import mbtool.daemon.v3.FileOpenFdRequest;
+import mbtool.daemon.v3.FileOpenFdResponse;
 import mbtool.daemon.v3.FileOpenRequest;
 import mbtool.daemon.v3.FileOpenResponse;
 import mbtool.daemon.v3.FileReadRequest;
 import mbtool.daemon.v3.FileReadResponse;
+import mbtool.daemon.v3.FileReadStreamRequest;
+import mbtool.daemon.v3.FileReadStreamResponse;
 import mbtool.daemon.v3.FileSELinuxGetLabelRequest;
 import mbtool.daemon.v3.FileSELinuxGetLabelResponse;
 import mbtool.daemon.v3.FileSELinuxSetLabelRequest;
@@ -62,6 +67,8 @@ import mbtool.daemon.v3.FileStatRequest;
 import mbtool.daemon.v3.FileStatResponse;
 import mbtool.daemon.v3.FileWriteRequest;
 import mbtool.daemon.v3.FileWriteResponse;
+import mbtool.daemon.v3.FileWriteStreamRequest;
+import mbtool.daemon.v3.FileWriteStreamResponse;
 import mbtool.daemon.v3.MbGetBootedRomIdRequest;
 import mbtool.daemon.v3.MbGetBootedRomIdResponse;
 import mbtool.daemon.v3.MbGetInstalledRomsRequest;
@@ -530,6 +537,152 @@ public class MbtoolSocket {
         }
     }
 
+    /**
+     * Open a file as root and receive its file descriptor
+     *
+     * The returned descriptor is owned by the caller. Wrap it in a
+     * {@link java.io.FileInputStream} or {@link java.io.FileOutputStream} to
+     * read or write the file directly without going through mbtool.
+     *
+     * @return File descriptor or null if the file could not be opened
+     */
+    @Nullable
+    public synchronized FileDescriptor fileOpenFd(Context context, String path, short[] flags,
+                                                  int perms) throws IOException {
+        connect(context);
+
+        try {
+            // Create request
+            FlatBufferBuilder builder = new FlatBufferBuilder(FBB_SIZE);
+
+            int fbPath = builder.createString(path);
+            int fbFlags = FileOpenFdRequest.createFlagsVector(builder, flags);
+
+            FileOpenFdRequest.startFileOpenFdRequest(builder);
+            FileOpenFdRequest.addPath(builder, fbPath);
+            FileOpenFdRequest.addFlags(builder, fbFlags);
+            FileOpenFdRequest.addPerms(builder, perms);
+            int fbRequest = FileOpenFdRequest.endFileOpenFdRequest(builder);
+
+            // Send request
+            FileOpenFdResponse response = (FileOpenFdResponse)
+                    sendRequest(builder, fbRequest, RequestType.FileOpenFdRequest,
+                            ResponseType.FileOpenFdResponse);
+
+            if (!response.success()) {
+                Log.e(TAG, "[" + path + "]: open failed: " + response.errorMsg());
+                return null;
+            }
+
+            // The fd is attached to a single dummy byte
+            if (mSocketIS.read() < 0) {
+                throw new IOException("Unexpected EOF when receiving file descriptor");
+            }
+            FileDescriptor[] fds = mSocket.getAncillaryFileDescriptors();
+            if (fds == null || fds.length != 1) {
+                throw new IOException("Did not receive exactly one file descriptor");
+            }
+            return fds[0];
+        } catch (IOException e) {
+            disconnect();
+            throw e;
+        }
+    }
+
+    /**
+     * Read up to {@code size} bytes from an opened file into a stream
+     *
+     * Unlike {@link #fileRead(Context, int, long)}, the data is not wrapped in
+     * a FlatBuffer and may be larger than what fits in memory.
+     *
+     * @return Number of bytes read or -1 if a read error occurred
+     */
+    public synchronized long fileReadStream(Context context, int id, long size,
+                                            OutputStream out) throws IOException {
+        connect(context);
+
+        try {
+            // Create request
+            FlatBufferBuilder builder = new FlatBufferBuilder(FBB_SIZE);
+            FileReadStreamRequest.startFileReadStreamRequest(builder);
+            FileReadStreamRequest.addId(builder, id);
+            FileReadStreamRequest.addCount(builder, size);
+            int fbRequest = FileReadStreamRequest.endFileReadStreamRequest(builder);
+
+            // Send request
+            sendRequest(builder, fbRequest, RequestType.FileReadStreamRequest,
+                    ResponseType.FileReadStreamResponse);
+
+            // Receive chunks until the terminator
+            byte[] buf = new byte[0];
+            long total = 0;
+            int length;
+
+            while ((length = SocketUtils.readInt32(mSocketIS)) > 0) {
+                if (buf.length < length) {
+                    buf = new byte[length];
+                }
+                SocketUtils.readFully(mSocketIS, buf, 0, length);
+                out.write(buf, 0, length);
+                total += length;
+            }
+
+            if (length < 0) {
+                Log.e(TAG, "[" + id + "]: streaming read failed after " + total + " bytes");
+                return -1;
+            }
+            return total;
+        } catch (IOException e) {
+            disconnect();
+            throw e;
+        }
+    }
+
+    /**
+     * Write exactly {@code size} bytes from a stream to an opened file
+     *
+     * @return Number of bytes written or -1 if a write error occurred
+     */
+    public synchronized long fileWriteStream(Context context, int id, InputStream in,
+                                             long size) throws IOException {
+        connect(context);
+
+        try {
+            // Create request
+            FlatBufferBuilder builder = new FlatBufferBuilder(FBB_SIZE);
+            FileWriteStreamRequest.startFileWriteStreamRequest(builder);
+            FileWriteStreamRequest.addId(builder, id);
+            FileWriteStreamRequest.addCount(builder, size);
+            int fbRequest = FileWriteStreamRequest.endFileWriteStreamRequest(builder);
+
+            writeRequest(builder, fbRequest, RequestType.FileWriteStreamRequest);
+
+            // The data must follow the request immediately
+            byte[] buf = new byte[64 * 1024];
+            long remaining = size;
+            while (remaining > 0) {
+                int n = in.read(buf, 0, (int) Math.min(buf.length, remaining));
+                if (n < 0) {
+                    throw new IOException("Input stream ended before " + size + " bytes");
+                }
+                mSocketOS.write(buf, 0, n);
+                remaining -= n;
+            }
+
+            FileWriteStreamResponse response = (FileWriteStreamResponse)
+                    readResponse(ResponseType.FileWriteStreamResponse);
+
+            if (!response.success()) {
+                Log.e(TAG, "[" + id + "]: streaming write failed: " + response.errorMsg());
+                return -1;
+            }
+            return response.bytesWritten();
+        } catch (IOException e) {
+            disconnect();
+            throw e;
+        }
+    }
+
     @Nullable
     public synchronized String fileSelinuxGetLabel(Context context, int id) throws IOException {
         connect(context);
@@ -1162,6 +1315,12 @@ public class MbtoolSocket {
     @NonNull
     private synchronized Table sendRequest(FlatBufferBuilder builder, int fbRequest,
                                            byte fbRequestType, byte expected) throws IOException {
+        writeRequest(builder, fbRequest, fbRequestType);
+        return readResponse(expected);
+    }
+
+    private synchronized void writeRequest(FlatBufferBuilder builder, int fbRequest,
+                                           byte fbRequestType) throws IOException {
         ThreadUtils.enforceExecutionOnNonMainThread();
 
         Request.startRequest(builder);
@@ -1170,7 +1329,10 @@ public class MbtoolSocket {
         builder.finish(Request.endRequest(builder));
 
         SocketUtils.writeBytes(mSocketOS, builder.sizedByteArray());
+    }
 
+    @NonNull
+    private synchronized Table readResponse(byte expected) throws IOException {
         byte[] responseBytes = SocketUtils.readBytes(mSocketIS);
         ByteBuffer bb = ByteBuffer.wrap(responseBytes);
         Response response = Response.getRootAsResponse(bb);
@@ -1253,6 +1415,15 @@ public class MbtoolSocket {
         case ResponseType.RebootResponse:
             table = new RebootResponse();
             break;
+        case ResponseType.FileOpenFdResponse:
+            table = new FileOpenFdResponse();
+            break;
+        case ResponseType.FileReadStreamResponse:
+            table = new FileReadStreamResponse();
+            break;
+        case ResponseType.FileWriteStreamResponse:
+            table = new FileWriteStreamResponse();
+            break;
         default:
             throw new IOException("Invalid response type");
         }
@@ -0,0 +1,36 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class BatchResult extends Table {
+  public static BatchResult getRootAsBatchResult(ByteBuffer _bb) { return getRootAsBatchResult(_bb, new BatchResult()); }
+  public static BatchResult getRootAsBatchResult(ByteBuffer _bb, BatchResult obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public BatchResult __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public int response(int j) { int o = __offset(4); return o != 0 ? bb.get(__vector(o) + j * 1) & 0xFF : 0; }
+  public int responseLength() { int o = __offset(4); return o != 0 ? __vector_len(o) : 0; }
+  public ByteBuffer responseAsByteBuffer() { return __vector_as_bytebuffer(4, 1); }
+
+  public static int createBatchResult(FlatBufferBuilder builder,
+      int response) {
+    builder.startObject(1);
+    BatchResult.addResponse(builder, response);
+    return BatchResult.endBatchResult(builder);
+  }
+
+  public static void startBatchResult(FlatBufferBuilder builder) { builder.startObject(1); }
+  public static void addResponse(FlatBufferBuilder builder, int responseOffset) { builder.addOffset(0, responseOffset, 0); }
+  public static int createResponseVector(FlatBufferBuilder builder, byte[] data) { builder.startVector(1, data.length, 1); for (int i = data.length - 1; i >= 0; i--) builder.addByte(data[i]); return builder.endVector(); }
+  public static void startResponseVector(FlatBufferBuilder builder, int numElems) { builder.startVector(1, numElems, 1); }
+  public static int endBatchResult(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
@@ -0,0 +1,36 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class FileReadStreamRequest extends Table {
+  public static FileReadStreamRequest getRootAsFileReadStreamRequest(ByteBuffer _bb) { return getRootAsFileReadStreamRequest(_bb, new FileReadStreamRequest()); }
+  public static FileReadStreamRequest getRootAsFileReadStreamRequest(ByteBuffer _bb, FileReadStreamRequest obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public FileReadStreamRequest __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public int id() { int o = __offset(4); return o != 0 ? bb.getInt(o + bb_pos) : 0; }
+  public long count() { int o = __offset(6); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+
+  public static int createFileReadStreamRequest(FlatBufferBuilder builder,
+      int id,
+      long count) {
+    builder.startObject(2);
+    FileReadStreamRequest.addCount(builder, count);
+    FileReadStreamRequest.addId(builder, id);
+    return FileReadStreamRequest.endFileReadStreamRequest(builder);
+  }
+
+  public static void startFileReadStreamRequest(FlatBufferBuilder builder) { builder.startObject(2); }
+  public static void addId(FlatBufferBuilder builder, int id) { builder.addInt(0, id, 0); }
+  public static void addCount(FlatBufferBuilder builder, long count) { builder.addLong(1, count, 0); }
+  public static int endFileReadStreamRequest(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
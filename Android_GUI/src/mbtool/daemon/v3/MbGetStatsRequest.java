@@ -0,0 +1,23 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class MbGetStatsRequest extends Table {
+  public static MbGetStatsRequest getRootAsMbGetStatsRequest(ByteBuffer _bb) { return getRootAsMbGetStatsRequest(_bb, new MbGetStatsRequest()); }
+  public static MbGetStatsRequest getRootAsMbGetStatsRequest(ByteBuffer _bb, MbGetStatsRequest obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public MbGetStatsRequest __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+
+  public static void startMbGetStatsRequest(FlatBufferBuilder builder) { builder.startObject(0); }
+  public static int endMbGetStatsRequest(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
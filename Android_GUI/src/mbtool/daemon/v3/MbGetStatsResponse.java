@@ -0,0 +1,76 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class MbGetStatsResponse extends Table {
+  public static MbGetStatsResponse getRootAsMbGetStatsResponse(ByteBuffer _bb) { return getRootAsMbGetStatsResponse(_bb, new MbGetStatsResponse()); }
+  public static MbGetStatsResponse getRootAsMbGetStatsResponse(ByteBuffer _bb, MbGetStatsResponse obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public MbGetStatsResponse __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public long uptimeUs() { int o = __offset(4); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long connectionsTotal() { int o = __offset(6); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long connectionsActive() { int o = __offset(8); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long connectionsRejected() { int o = __offset(10); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long bytesRead() { int o = __offset(12); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long bytesWritten() { int o = __offset(14); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long workersActive() { int o = __offset(16); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long workersPeak() { int o = __offset(18); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long forks() { int o = __offset(20); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long execs() { int o = __offset(22); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public MbRequestStats requests(int j) { return requests(new MbRequestStats(), j); }
+  public MbRequestStats requests(MbRequestStats obj, int j) { int o = __offset(24); return o != 0 ? obj.__init(__indirect(__vector(o) + j * 4), bb) : null; }
+  public int requestsLength() { int o = __offset(24); return o != 0 ? __vector_len(o) : 0; }
+
+  public static int createMbGetStatsResponse(FlatBufferBuilder builder,
+      long uptime_us,
+      long connections_total,
+      long connections_active,
+      long connections_rejected,
+      long bytes_read,
+      long bytes_written,
+      long workers_active,
+      long workers_peak,
+      long forks,
+      long execs,
+      int requests) {
+    builder.startObject(11);
+    MbGetStatsResponse.addExecs(builder, execs);
+    MbGetStatsResponse.addForks(builder, forks);
+    MbGetStatsResponse.addWorkersPeak(builder, workers_peak);
+    MbGetStatsResponse.addWorkersActive(builder, workers_active);
+    MbGetStatsResponse.addBytesWritten(builder, bytes_written);
+    MbGetStatsResponse.addBytesRead(builder, bytes_read);
+    MbGetStatsResponse.addConnectionsRejected(builder, connections_rejected);
+    MbGetStatsResponse.addConnectionsActive(builder, connections_active);
+    MbGetStatsResponse.addConnectionsTotal(builder, connections_total);
+    MbGetStatsResponse.addUptimeUs(builder, uptime_us);
+    MbGetStatsResponse.addRequests(builder, requests);
+    return MbGetStatsResponse.endMbGetStatsResponse(builder);
+  }
+
+  public static void startMbGetStatsResponse(FlatBufferBuilder builder) { builder.startObject(11); }
+  public static void addUptimeUs(FlatBufferBuilder builder, long uptimeUs) { builder.addLong(0, uptimeUs, 0); }
+  public static void addConnectionsTotal(FlatBufferBuilder builder, long connectionsTotal) { builder.addLong(1, connectionsTotal, 0); }
+  public static void addConnectionsActive(FlatBufferBuilder builder, long connectionsActive) { builder.addLong(2, connectionsActive, 0); }
+  public static void addConnectionsRejected(FlatBufferBuilder builder, long connectionsRejected) { builder.addLong(3, connectionsRejected, 0); }
+  public static void addBytesRead(FlatBufferBuilder builder, long bytesRead) { builder.addLong(4, bytesRead, 0); }
+  public static void addBytesWritten(FlatBufferBuilder builder, long bytesWritten) { builder.addLong(5, bytesWritten, 0); }
+  public static void addWorkersActive(FlatBufferBuilder builder, long workersActive) { builder.addLong(6, workersActive, 0); }
+  public static void addWorkersPeak(FlatBufferBuilder builder, long workersPeak) { builder.addLong(7, workersPeak, 0); }
+  public static void addForks(FlatBufferBuilder builder, long forks) { builder.addLong(8, forks, 0); }
+  public static void addExecs(FlatBufferBuilder builder, long execs) { builder.addLong(9, execs, 0); }
+  public static void addRequests(FlatBufferBuilder builder, int requestsOffset) { builder.addOffset(10, requestsOffset, 0); }
+  public static int createRequestsVector(FlatBufferBuilder builder, int[] data) { builder.startVector(4, data.length, 4); for (int i = data.length - 1; i >= 0; i--) builder.addOffset(data[i]); return builder.endVector(); }
+  public static void startRequestsVector(FlatBufferBuilder builder, int numElems) { builder.startVector(4, numElems, 4); }
+  public static int endMbGetStatsResponse(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
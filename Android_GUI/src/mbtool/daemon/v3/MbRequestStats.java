@@ -0,0 +1,56 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class MbRequestStats extends Table {
+  public static MbRequestStats getRootAsMbRequestStats(ByteBuffer _bb) { return getRootAsMbRequestStats(_bb, new MbRequestStats()); }
+  public static MbRequestStats getRootAsMbRequestStats(ByteBuffer _bb, MbRequestStats obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public MbRequestStats __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public int requestType() { int o = __offset(4); return o != 0 ? bb.get(o + bb_pos) & 0xFF : 0; }
+  public long count() { int o = __offset(6); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long errors() { int o = __offset(8); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long totalTimeUs() { int o = __offset(10); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long maxTimeUs() { int o = __offset(12); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long latencyHistogram(int j) { int o = __offset(14); return o != 0 ? bb.getLong(__vector(o) + j * 8) : 0; }
+  public int latencyHistogramLength() { int o = __offset(14); return o != 0 ? __vector_len(o) : 0; }
+  public ByteBuffer latencyHistogramAsByteBuffer() { return __vector_as_bytebuffer(14, 8); }
+
+  public static int createMbRequestStats(FlatBufferBuilder builder,
+      int request_type,
+      long count,
+      long errors,
+      long total_time_us,
+      long max_time_us,
+      int latency_histogram) {
+    builder.startObject(6);
+    MbRequestStats.addMaxTimeUs(builder, max_time_us);
+    MbRequestStats.addTotalTimeUs(builder, total_time_us);
+    MbRequestStats.addErrors(builder, errors);
+    MbRequestStats.addCount(builder, count);
+    MbRequestStats.addLatencyHistogram(builder, latency_histogram);
+    MbRequestStats.addRequestType(builder, request_type);
+    return MbRequestStats.endMbRequestStats(builder);
+  }
+
+  public static void startMbRequestStats(FlatBufferBuilder builder) { builder.startObject(6); }
+  public static void addRequestType(FlatBufferBuilder builder, int requestType) { builder.addByte(0, (byte)(requestType & 0xFF), 0); }
+  public static void addCount(FlatBufferBuilder builder, long count) { builder.addLong(1, count, 0); }
+  public static void addErrors(FlatBufferBuilder builder, long errors) { builder.addLong(2, errors, 0); }
+  public static void addTotalTimeUs(FlatBufferBuilder builder, long totalTimeUs) { builder.addLong(3, totalTimeUs, 0); }
+  public static void addMaxTimeUs(FlatBufferBuilder builder, long maxTimeUs) { builder.addLong(4, maxTimeUs, 0); }
+  public static void addLatencyHistogram(FlatBufferBuilder builder, int latencyHistogramOffset) { builder.addOffset(5, latencyHistogramOffset, 0); }
+  public static int createLatencyHistogramVector(FlatBufferBuilder builder, long[] data) { builder.startVector(8, data.length, 8); for (int i = data.length - 1; i >= 0; i--) builder.addLong(data[i]); return builder.endVector(); }
+  public static void startLatencyHistogramVector(FlatBufferBuilder builder, int numElems) { builder.startVector(8, numElems, 8); }
+  public static int endMbRequestStats(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
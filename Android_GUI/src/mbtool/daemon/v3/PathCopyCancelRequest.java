@@ -0,0 +1,32 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class PathCopyCancelRequest extends Table {
+  public static PathCopyCancelRequest getRootAsPathCopyCancelRequest(ByteBuffer _bb) { return getRootAsPathCopyCancelRequest(_bb, new PathCopyCancelRequest()); }
+  public static PathCopyCancelRequest getRootAsPathCopyCancelRequest(ByteBuffer _bb, PathCopyCancelRequest obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public PathCopyCancelRequest __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public long jobId() { int o = __offset(4); return o != 0 ? (long)bb.getInt(o + bb_pos) & 0xFFFFFFFFL : 0; }
+
+  public static int createPathCopyCancelRequest(FlatBufferBuilder builder,
+      long job_id) {
+    builder.startObject(1);
+    PathCopyCancelRequest.addJobId(builder, job_id);
+    return PathCopyCancelRequest.endPathCopyCancelRequest(builder);
+  }
+
+  public static void startPathCopyCancelRequest(FlatBufferBuilder builder) { builder.startObject(1); }
+  public static void addJobId(FlatBufferBuilder builder, long jobId) { builder.addInt(0, (int)(jobId & 0xFFFFFFFFL), 0); }
+  public static int endPathCopyCancelRequest(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
@@ -0,0 +1,32 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class PathCopyCancelResponse extends Table {
+  public static PathCopyCancelResponse getRootAsPathCopyCancelResponse(ByteBuffer _bb) { return getRootAsPathCopyCancelResponse(_bb, new PathCopyCancelResponse()); }
+  public static PathCopyCancelResponse getRootAsPathCopyCancelResponse(ByteBuffer _bb, PathCopyCancelResponse obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public PathCopyCancelResponse __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public boolean success() { int o = __offset(4); return o != 0 ? 0!=bb.get(o + bb_pos) : false; }
+
+  public static int createPathCopyCancelResponse(FlatBufferBuilder builder,
+      boolean success) {
+    builder.startObject(1);
+    PathCopyCancelResponse.addSuccess(builder, success);
+    return PathCopyCancelResponse.endPathCopyCancelResponse(builder);
+  }
+
+  public static void startPathCopyCancelResponse(FlatBufferBuilder builder) { builder.startObject(1); }
+  public static void addSuccess(FlatBufferBuilder builder, boolean success) { builder.addBoolean(0, success, false); }
+  public static int endPathCopyCancelResponse(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
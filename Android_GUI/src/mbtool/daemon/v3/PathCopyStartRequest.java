@@ -0,0 +1,38 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class PathCopyStartRequest extends Table {
+  public static PathCopyStartRequest getRootAsPathCopyStartRequest(ByteBuffer _bb) { return getRootAsPathCopyStartRequest(_bb, new PathCopyStartRequest()); }
+  public static PathCopyStartRequest getRootAsPathCopyStartRequest(ByteBuffer _bb, PathCopyStartRequest obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public PathCopyStartRequest __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public String source() { int o = __offset(4); return o != 0 ? __string(o + bb_pos) : null; }
+  public ByteBuffer sourceAsByteBuffer() { return __vector_as_bytebuffer(4, 1); }
+  public String target() { int o = __offset(6); return o != 0 ? __string(o + bb_pos) : null; }
+  public ByteBuffer targetAsByteBuffer() { return __vector_as_bytebuffer(6, 1); }
+
+  public static int createPathCopyStartRequest(FlatBufferBuilder builder,
+      int source,
+      int target) {
+    builder.startObject(2);
+    PathCopyStartRequest.addTarget(builder, target);
+    PathCopyStartRequest.addSource(builder, source);
+    return PathCopyStartRequest.endPathCopyStartRequest(builder);
+  }
+
+  public static void startPathCopyStartRequest(FlatBufferBuilder builder) { builder.startObject(2); }
+  public static void addSource(FlatBufferBuilder builder, int sourceOffset) { builder.addOffset(0, sourceOffset, 0); }
+  public static void addTarget(FlatBufferBuilder builder, int targetOffset) { builder.addOffset(1, targetOffset, 0); }
+  public static int endPathCopyStartRequest(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
@@ -0,0 +1,41 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class PathCopyStartResponse extends Table {
+  public static PathCopyStartResponse getRootAsPathCopyStartResponse(ByteBuffer _bb) { return getRootAsPathCopyStartResponse(_bb, new PathCopyStartResponse()); }
+  public static PathCopyStartResponse getRootAsPathCopyStartResponse(ByteBuffer _bb, PathCopyStartResponse obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public PathCopyStartResponse __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public boolean success() { int o = __offset(4); return o != 0 ? 0!=bb.get(o + bb_pos) : false; }
+  public String errorMsg() { int o = __offset(6); return o != 0 ? __string(o + bb_pos) : null; }
+  public ByteBuffer errorMsgAsByteBuffer() { return __vector_as_bytebuffer(6, 1); }
+  public long jobId() { int o = __offset(8); return o != 0 ? (long)bb.getInt(o + bb_pos) & 0xFFFFFFFFL : 0; }
+
+  public static int createPathCopyStartResponse(FlatBufferBuilder builder,
+      boolean success,
+      int error_msg,
+      long job_id) {
+    builder.startObject(3);
+    PathCopyStartResponse.addJobId(builder, job_id);
+    PathCopyStartResponse.addErrorMsg(builder, error_msg);
+    PathCopyStartResponse.addSuccess(builder, success);
+    return PathCopyStartResponse.endPathCopyStartResponse(builder);
+  }
+
+  public static void startPathCopyStartResponse(FlatBufferBuilder builder) { builder.startObject(3); }
+  public static void addSuccess(FlatBufferBuilder builder, boolean success) { builder.addBoolean(0, success, false); }
+  public static void addErrorMsg(FlatBufferBuilder builder, int errorMsgOffset) { builder.addOffset(1, errorMsgOffset, 0); }
+  public static void addJobId(FlatBufferBuilder builder, long jobId) { builder.addInt(2, (int)(jobId & 0xFFFFFFFFL), 0); }
+  public static int endPathCopyStartResponse(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
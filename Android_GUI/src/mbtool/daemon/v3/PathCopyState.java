@@ -0,0 +1,16 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+public final class PathCopyState {
+  private PathCopyState() { }
+  public static final short RUNNING = 0;
+  public static final short SUCCEEDED = 1;
+  public static final short FAILED = 2;
+  public static final short CANCELLED = 3;
+
+  private static final String[] names = { "RUNNING", "SUCCEEDED", "FAILED", "CANCELLED", };
+
+  public static String name(int e) { return names[e]; }
+};
+
@@ -0,0 +1,36 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class PathCopyStatusRequest extends Table {
+  public static PathCopyStatusRequest getRootAsPathCopyStatusRequest(ByteBuffer _bb) { return getRootAsPathCopyStatusRequest(_bb, new PathCopyStatusRequest()); }
+  public static PathCopyStatusRequest getRootAsPathCopyStatusRequest(ByteBuffer _bb, PathCopyStatusRequest obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public PathCopyStatusRequest __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public long jobId() { int o = __offset(4); return o != 0 ? (long)bb.getInt(o + bb_pos) & 0xFFFFFFFFL : 0; }
+  public long progressInterval() { int o = __offset(6); return o != 0 ? (long)bb.getInt(o + bb_pos) & 0xFFFFFFFFL : 0; }
+
+  public static int createPathCopyStatusRequest(FlatBufferBuilder builder,
+      long job_id,
+      long progress_interval) {
+    builder.startObject(2);
+    PathCopyStatusRequest.addProgressInterval(builder, progress_interval);
+    PathCopyStatusRequest.addJobId(builder, job_id);
+    return PathCopyStatusRequest.endPathCopyStatusRequest(builder);
+  }
+
+  public static void startPathCopyStatusRequest(FlatBufferBuilder builder) { builder.startObject(2); }
+  public static void addJobId(FlatBufferBuilder builder, long jobId) { builder.addInt(0, (int)(jobId & 0xFFFFFFFFL), 0); }
+  public static void addProgressInterval(FlatBufferBuilder builder, long progressInterval) { builder.addInt(1, (int)(progressInterval & 0xFFFFFFFFL), 0); }
+  public static int endPathCopyStatusRequest(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
@@ -0,0 +1,57 @@
+// automatically generated, do not modify
+
+package mbtool.daemon.v3;
+
+import java.nio.*;
+import java.lang.*;
+import java.util.*;
+import com.google.flatbuffers.*;
+
+@SuppressWarnings("unused")
+public final class PathCopyStatusResponse extends Table {
+  public static PathCopyStatusResponse getRootAsPathCopyStatusResponse(ByteBuffer _bb) { return getRootAsPathCopyStatusResponse(_bb, new PathCopyStatusResponse()); }
+  public static PathCopyStatusResponse getRootAsPathCopyStatusResponse(ByteBuffer _bb, PathCopyStatusResponse obj) { _bb.order(ByteOrder.LITTLE_ENDIAN); return (obj.__init(_bb.getInt(_bb.position()) + _bb.position(), _bb)); }
+  public PathCopyStatusResponse __init(int _i, ByteBuffer _bb) { bb_pos = _i; bb = _bb; return this; }
+
+  public boolean success() { int o = __offset(4); return o != 0 ? 0!=bb.get(o + bb_pos) : false; }
+  public String errorMsg() { int o = __offset(6); return o != 0 ? __string(o + bb_pos) : null; }
+  public ByteBuffer errorMsgAsByteBuffer() { return __vector_as_bytebuffer(6, 1); }
+  public short state() { int o = __offset(8); return o != 0 ? bb.getShort(o + bb_pos) : 0; }
+  public long bytesCopied() { int o = __offset(10); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long bytesTotal() { int o = __offset(12); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public long filesCopied() { int o = __offset(14); return o != 0 ? (long)bb.getInt(o + bb_pos) & 0xFFFFFFFFL : 0; }
+  public long filesTotal() { int o = __offset(16); return o != 0 ? (long)bb.getInt(o + bb_pos) & 0xFFFFFFFFL : 0; }
+
+  public static int createPathCopyStatusResponse(FlatBufferBuilder builder,
+      boolean success,
+      int error_msg,
+      short state,
+      long bytes_copied,
+      long bytes_total,
+      long files_copied,
+      long files_total) {
+    builder.startObject(7);
+    PathCopyStatusResponse.addBytesTotal(builder, bytes_total);
+    PathCopyStatusResponse.addBytesCopied(builder, bytes_copied);
+    PathCopyStatusResponse.addFilesTotal(builder, files_total);
+    PathCopyStatusResponse.addFilesCopied(builder, files_copied);
+    PathCopyStatusResponse.addErrorMsg(builder, error_msg);
+    PathCopyStatusResponse.addState(builder, state);
+    PathCopyStatusResponse.addSuccess(builder, success);
+    return PathCopyStatusResponse.endPathCopyStatusResponse(builder);
+  }
+
+  public static void startPathCopyStatusResponse(FlatBufferBuilder builder) { builder.startObject(7); }
+  public static void addSuccess(FlatBufferBuilder builder, boolean success) { builder.addBoolean(0, success, false); }
+  public static void addErrorMsg(FlatBufferBuilder builder, int errorMsgOffset) { builder.addOffset(1, errorMsgOffset, 0); }
+  public static void addState(FlatBufferBuilder builder, short state) { builder.addShort(2, state, 0); }
+  public static void addBytesCopied(FlatBufferBuilder builder, long bytesCopied) { builder.addLong(3, bytesCopied, 0); }
+  public static void addBytesTotal(FlatBufferBuilder builder, long bytesTotal) { builder.addLong(4, bytesTotal, 0); }
+  public static void addFilesCopied(FlatBufferBuilder builder, long filesCopied) { builder.addInt(5, (int)(filesCopied & 0xFFFFFFFFL), 0); }
+  public static void addFilesTotal(FlatBufferBuilder builder, long filesTotal) { builder.addInt(6, (int)(filesTotal & 0xFFFFFFFFL), 0); }
+  public static int endPathCopyStatusResponse(FlatBufferBuilder builder) {
+    int o = builder.endObject();
+    return o;
+  }
+};
+
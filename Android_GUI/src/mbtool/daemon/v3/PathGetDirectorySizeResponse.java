@@ -17,22 +17,26 @@ public final class PathGetDirectorySizeResponse extends Table {
   public String errorMsg() { int o = __offset(6); return o != 0 ? __string(o + bb_pos) : null; }
   public ByteBuffer errorMsgAsByteBuffer() { return __vector_as_bytebuffer(6, 1); }
   public long size() { int o = __offset(8); return o != 0 ? bb.getLong(o + bb_pos) : 0; }
+  public boolean inProgress() { int o = __offset(10); return o != 0 ? 0!=bb.get(o + bb_pos) : false; }
 
   public static int createPathGetDirectorySizeResponse(FlatBufferBuilder builder,
       boolean success,
       int error_msg,
-      long size) {
-    builder.startObject(3);
+      long size,
+      boolean in_progress) {
+    builder.startObject(4);
     PathGetDirectorySizeResponse.addSize(builder, size);
     PathGetDirectorySizeResponse.addErrorMsg(builder, error_msg);
+    PathGetDirectorySizeResponse.addInProgress(builder, in_progress);
     PathGetDirectorySizeResponse.addSuccess(builder, success);
     return PathGetDirectorySizeResponse.endPathGetDirectorySizeResponse(builder);
   }
 
-  public static void startPathGetDirectorySizeResponse(FlatBufferBuilder builder) { builder.startObject(3); }
+  public static void startPathGetDirectorySizeResponse(FlatBufferBuilder builder) { builder.startObject(4); }
   public static void addSuccess(FlatBufferBuilder builder, boolean success) { builder.addBoolean(0, success, false); }
   public static void addErrorMsg(FlatBufferBuilder builder, int errorMsgOffset) { builder.addOffset(1, errorMsgOffset, 0); }
   public static void addSize(FlatBufferBuilder builder, long size) { builder.addLong(2, size, 0); }
+  public static void addInProgress(FlatBufferBuilder builder, boolean inProgress) { builder.addBoolean(3, inProgress, false); }
   public static int endPathGetDirectorySizeResponse(FlatBufferBuilder builder) {
     int o = builder.endObject();
     return o;
@@ -27,8 +27,16 @@ public final class RequestType {
   public static final byte MbWipeRomRequest = 20;
   public static final byte MbGetPackagesCountRequest = 21;
   public static final byte RebootRequest = 22;
+  public static final byte FileOpenFdRequest = 23;
+  public static final byte FileReadStreamRequest = 24;
+  public static final byte FileWriteStreamRequest = 25;
+  public static final byte BatchRequest = 26;
+  public static final byte MbGetStatsRequest = 27;
+  public static final byte PathCopyStartRequest = 28;
+  public static final byte PathCopyStatusRequest = 29;
+  public static final byte PathCopyCancelRequest = 30;
 
-  private static final String[] names = { "NONE", "FileChmodRequest", "FileCloseRequest", "FileOpenRequest", "FileReadRequest", "FileSeekRequest", "FileStatRequest", "FileWriteRequest", "FileSELinuxGetLabelRequest", "FileSELinuxSetLabelRequest", "PathChmodRequest", "PathCopyRequest", "PathSELinuxGetLabelRequest", "PathSELinuxSetLabelRequest", "PathGetDirectorySizeRequest", "MbGetVersionRequest", "MbGetInstalledRomsRequest", "MbGetBootedRomIdRequest", "MbSwitchRomRequest", "MbSetKernelRequest", "MbWipeRomRequest", "MbGetPackagesCountRequest", "RebootRequest", };
+  private static final String[] names = { "NONE", "FileChmodRequest", "FileCloseRequest", "FileOpenRequest", "FileReadRequest", "FileSeekRequest", "FileStatRequest", "FileWriteRequest", "FileSELinuxGetLabelRequest", "FileSELinuxSetLabelRequest", "PathChmodRequest", "PathCopyRequest", "PathSELinuxGetLabelRequest", "PathSELinuxSetLabelRequest", "PathGetDirectorySizeRequest", "MbGetVersionRequest", "MbGetInstalledRomsRequest", "MbGetBootedRomIdRequest", "MbSwitchRomRequest", "MbSetKernelRequest", "MbWipeRomRequest", "MbGetPackagesCountRequest", "RebootRequest", "FileOpenFdRequest", "FileReadStreamRequest", "FileWriteStreamRequest", "BatchRequest", "MbGetStatsRequest", "PathCopyStartRequest", "PathCopyStatusRequest", "PathCopyCancelRequest", };
 
   public static String name(int e) { return names[e]; }
 };
@@ -29,8 +29,16 @@ public final class ResponseType {
   public static final byte MbWipeRomResponse = 22;
   public static final byte MbGetPackagesCountResponse = 23;
   public static final byte RebootResponse = 24;
+  public static final byte FileOpenFdResponse = 25;
+  public static final byte FileReadStreamResponse = 26;
+  public static final byte FileWriteStreamResponse = 27;
+  public static final byte BatchResponse = 28;
+  public static final byte MbGetStatsResponse = 29;
+  public static final byte PathCopyStartResponse = 30;
+  public static final byte PathCopyStatusResponse = 31;
+  public static final byte PathCopyCancelResponse = 32;
 
-  private static final String[] names = { "NONE", "Invalid", "Unsupported", "FileChmodResponse", "FileCloseResponse", "FileOpenResponse", "FileReadResponse", "FileSeekResponse", "FileStatResponse", "FileWriteResponse", "FileSELinuxGetLabelResponse", "FileSELinuxSetLabelResponse", "PathChmodResponse", "PathCopyResponse", "PathSELinuxGetLabelResponse", "PathSELinuxSetLabelResponse", "PathGetDirectorySizeResponse", "MbGetVersionResponse", "MbGetInstalledRomsResponse", "MbGetBootedRomIdResponse", "MbSwitchRomResponse", "MbSetKernelResponse", "MbWipeRomResponse", "MbGetPackagesCountResponse", "RebootResponse", };
+  private static final String[] names = { "NONE", "Invalid", "Unsupported", "FileChmodResponse", "FileCloseResponse", "FileOpenResponse", "FileReadResponse", "FileSeekResponse", "FileStatResponse", "FileWriteResponse", "FileSELinuxGetLabelResponse", "FileSELinuxSetLabelResponse", "PathChmodResponse", "PathCopyResponse", "PathSELinuxGetLabelResponse", "PathSELinuxSetLabelResponse", "PathGetDirectorySizeResponse", "MbGetVersionResponse", "MbGetInstalledRomsResponse", "MbGetBootedRomIdResponse", "MbSwitchRomResponse", "MbSetKernelResponse", "MbWipeRomResponse", "MbGetPackagesCountResponse", "RebootResponse", "FileOpenFdResponse", "FileReadStreamResponse", "FileWriteStreamResponse", "BatchResponse", "MbGetStatsResponse", "PathCopyStartResponse", "PathCopyStatusResponse", "PathCopyCancelResponse", };
 
   public static String name(int e) { return names[e]; }
 };
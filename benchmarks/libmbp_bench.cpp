@@ -0,0 +1,794 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <archive.h>
+
+#include <libmbpio/delete.h>
+#include <libmbpio/path.h>
+
+#include <libmbp/bootimage.h>
+#include <libmbp/cpiofile.h>
+#include <libmbp/edify/tokenizer.h>
+#include <libmbp/logging.h>
+#include <libmbp/private/fileutils.h>
+
+#include "synthetic.h"
+
+
+typedef std::unique_ptr<std::FILE, int (*)(std::FILE *)> file_ptr;
+
+
+static const char Usage[] =
+    "Usage: libmbp_bench [options]\n"
+    "\n"
+    "Options:\n"
+    "  -f, --filter [prefix]\n"
+    "                  Only run benchmarks whose names start with [prefix]\n"
+    "                  (eg. \"bootimage/mtk\" or \"cpio/\")\n"
+    "  -n, --iterations [count]\n"
+    "                  Minimum number of iterations per benchmark (default: 5)\n"
+    "  -t, --min-time [seconds]\n"
+    "                  Minimum time spent per benchmark (default: 1.0)\n"
+    "  -o, --output [file]\n"
+    "                  Write JSON results to [file] instead of stdout\n"
+    "  -a, --aboot [aboot image]\n"
+    "                  Aboot image to use for the loki benchmarks. The loki\n"
+    "                  benchmarks are skipped if this is not specified.\n"
+    "  -l, --list      List benchmarks without running them\n"
+    "\n"
+    "All inputs are generated deterministically, so results from different\n"
+    "builds can be compared directly. Progress is printed to stderr.\n";
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark runner
+////////////////////////////////////////////////////////////////////////////////
+
+struct BenchResult
+{
+    std::string name;
+    bool success;
+    uint64_t iterations;
+    // Bytes processed per iteration
+    uint64_t bytes;
+    double minNs;
+    double medianNs;
+    double meanNs;
+    double maxNs;
+};
+
+class BenchRunner
+{
+public:
+    BenchRunner(std::string filter, uint64_t minIterations, double minTime,
+                bool listOnly)
+        : m_filter(std::move(filter)), m_minIterations(minIterations),
+        m_minTime(minTime), m_listOnly(listOnly)
+    {
+    }
+
+    /*!
+     * \brief Whether any benchmark starting with \p prefix can be selected
+     *
+     * Used to skip generating the inputs for a group of benchmarks.
+     */
+    bool wants(const std::string &prefix) const
+    {
+        return m_filter.empty()
+                || prefix.compare(0, m_filter.size(), m_filter) == 0
+                || m_filter.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    void run(const std::string &name, uint64_t bytes,
+             const std::function<bool()> &fn)
+    {
+        if (!m_filter.empty()
+                && name.compare(0, m_filter.size(), m_filter) != 0) {
+            return;
+        }
+
+        if (m_listOnly) {
+            printf("%s\n", name.c_str());
+            return;
+        }
+
+        BenchResult result;
+        result.name = name;
+        result.success = true;
+        result.bytes = bytes;
+
+        // Warm up caches and allocator
+        if (!fn()) {
+            fprintf(stderr, "%-40s FAILED\n", name.c_str());
+            result.success = false;
+            result.iterations = 0;
+            result.minNs = result.medianNs = result.meanNs = result.maxNs = 0;
+            m_results.push_back(std::move(result));
+            return;
+        }
+
+        std::vector<double> samples;
+        double total = 0;
+
+        while (samples.size() < m_minIterations || total < m_minTime * 1e9) {
+            auto start = std::chrono::steady_clock::now();
+            bool ret = fn();
+            auto end = std::chrono::steady_clock::now();
+
+            if (!ret) {
+                result.success = false;
+                break;
+            }
+
+            double ns = std::chrono::duration<double, std::nano>(
+                    end - start).count();
+            samples.push_back(ns);
+            total += ns;
+        }
+
+        result.iterations = samples.size();
+
+        if (samples.empty()) {
+            result.minNs = result.medianNs = result.meanNs = result.maxNs = 0;
+        } else {
+            std::sort(samples.begin(), samples.end());
+            result.minNs = samples.front();
+            result.maxNs = samples.back();
+            result.meanNs = total / samples.size();
+            result.medianNs = samples[samples.size() / 2];
+        }
+
+        if (result.success) {
+            fprintf(stderr, "%-40s %10.3f ms %10.2f MiB/s (%" PRIu64 " iterations)\n",
+                    name.c_str(), result.medianNs / 1e6,
+                    mibPerSec(result.bytes, result.medianNs),
+                    result.iterations);
+        } else {
+            fprintf(stderr, "%-40s FAILED\n", name.c_str());
+        }
+
+        m_results.push_back(std::move(result));
+    }
+
+    void skip(const std::string &name, const char *reason)
+    {
+        if (wants(name) && !m_listOnly) {
+            fprintf(stderr, "%-40s skipped: %s\n", name.c_str(), reason);
+        }
+    }
+
+    const std::vector<BenchResult> & results() const
+    {
+        return m_results;
+    }
+
+    static double mibPerSec(uint64_t bytes, double ns)
+    {
+        return ns > 0 ? bytes / 1048576.0 / (ns / 1e9) : 0;
+    }
+
+private:
+    std::string m_filter;
+    uint64_t m_minIterations;
+    double m_minTime;
+    bool m_listOnly;
+    std::vector<BenchResult> m_results;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// BootImage
+////////////////////////////////////////////////////////////////////////////////
+
+struct BootImageFormat
+{
+    const char *name;
+    mbp::BootImage::Type type;
+};
+
+static const BootImageFormat BootImageFormats[] = {
+    { "android", mbp::BootImage::Type::Android },
+    { "bump",    mbp::BootImage::Type::Bump    },
+    { "loki",    mbp::BootImage::Type::Loki    },
+    { "mtk",     mbp::BootImage::Type::Mtk     },
+    { "sonyelf", mbp::BootImage::Type::SonyElf },
+};
+
+static void bench_bootimage(BenchRunner *runner,
+                            const std::vector<unsigned char> &aboot)
+{
+    for (const BootImageFormat &format : BootImageFormats) {
+        std::string prefix = std::string("bootimage/") + format.name + "/";
+
+        if (!runner->wants(prefix)) {
+            continue;
+        }
+
+        if (format.type == mbp::BootImage::Type::Loki && aboot.empty()) {
+            runner->skip(prefix, "no aboot image specified (--aboot)");
+            continue;
+        }
+
+        auto bi = std::make_shared<mbp::BootImage>();
+        auto data = std::make_shared<std::vector<unsigned char>>();
+
+        bench::setUpBootImage(bi.get(), format.type,
+                              bench::generateData(4 * 1024 * 1024, 2, 20),
+                              aboot);
+
+        if (!bi->create(data.get())) {
+            fprintf(stderr, "Failed to create %s boot image\n", format.name);
+            continue;
+        }
+
+        runner->run(prefix + "create", data->size(), [bi]() {
+            std::vector<unsigned char> out;
+            return bi->create(&out);
+        });
+
+        runner->run(prefix + "load", data->size(), [data]() {
+            mbp::BootImage loaded;
+            return loaded.load(*data);
+        });
+
+        runner->run(prefix + "inspect", data->size(), [data]() {
+            mbp::BootImage loaded;
+            return loaded.inspect(data->data(), data->size());
+        });
+    }
+}
+
+
+static bool write_fully(int fd, const unsigned char *data, std::size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Loads or inspects the boot image from a FIFO, which cannot be mapped or
+// seeked like the block devices and pipes that mbtool passes to
+// BootImage::loadFile()
+static bool load_from_fifo(const std::string &fifoPath,
+                           const std::vector<unsigned char> &data,
+                           bool inspect)
+{
+    std::thread writer([&]() {
+        int fd = open(fifoPath.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            write_fully(fd, data.data(), data.size());
+            close(fd);
+        }
+    });
+
+    mbp::BootImage bi;
+    bool ret = inspect ? bi.inspectFile(fifoPath) : bi.loadFile(fifoPath);
+
+    // Unblock the writer if loadFile() never opened the FIFO
+    int fd = open(fifoPath.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    writer.join();
+
+    uint64_t offset;
+    uint64_t size;
+    return ret && bi.sectionLocation(mbp::BootImage::Section::Kernel,
+                                     &offset, &size) && size > 0;
+}
+
+static void bench_bootimage_file(BenchRunner *runner)
+{
+    const char *prefix = "bootimage/file/";
+
+    if (!runner->wants(prefix)) {
+        return;
+    }
+
+    std::string tempDir = mbp::FileUtils::createTemporaryDir(
+            mbp::FileUtils::systemTemporaryDir());
+    if (tempDir.empty()) {
+        fprintf(stderr, "Failed to create temporary directory\n");
+        return;
+    }
+
+    std::string filePath = io::pathJoin({tempDir, "boot.img"});
+    std::string fifoPath = io::pathJoin({tempDir, "boot.fifo"});
+    auto data = std::make_shared<std::vector<unsigned char>>();
+
+    mbp::BootImage bi;
+    bench::setUpBootImage(&bi, mbp::BootImage::Type::Android,
+                          bench::generateData(4 * 1024 * 1024, 2, 20), {});
+
+    if (!bi.create(data.get()) || !bi.createFile(filePath)) {
+        fprintf(stderr, "Failed to create boot image\n");
+        io::deleteRecursively(tempDir);
+        return;
+    }
+
+    if (mkfifo(fifoPath.c_str(), 0600) < 0) {
+        fprintf(stderr, "%s: Failed to create FIFO: %s\n",
+                fifoPath.c_str(), strerror(errno));
+        io::deleteRecursively(tempDir);
+        return;
+    }
+
+    runner->run(std::string(prefix) + "load_mapped", data->size(),
+                [filePath]() {
+        mbp::BootImage loaded;
+        return loaded.loadFile(filePath);
+    });
+
+    runner->run(std::string(prefix) + "load_fifo", data->size(),
+                [fifoPath, data]() {
+        return load_from_fifo(fifoPath, *data, false);
+    });
+
+    runner->run(std::string(prefix) + "inspect_fifo", data->size(),
+                [fifoPath, data]() {
+        return load_from_fifo(fifoPath, *data, true);
+    });
+
+    io::deleteRecursively(tempDir);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// CpioFile
+////////////////////////////////////////////////////////////////////////////////
+
+struct CpioCompression
+{
+    const char *name;
+    int (*addFilter)(archive *);
+};
+
+static const CpioCompression CpioCompressions[] = {
+    { "none", &archive_write_add_filter_none },
+    { "gzip", &archive_write_add_filter_gzip },
+    { "lzop", &archive_write_add_filter_lzop },
+    { "lz4",  &archive_write_add_filter_lz4  },
+    { "lzma", &archive_write_add_filter_lzma },
+};
+
+static bool generate_cpio(const CpioCompression &compression,
+                          std::vector<unsigned char> *out)
+{
+    return bench::generateCpio(bench::generateRamdiskEntries(1000, 42),
+                               compression.addFilter, out);
+}
+
+static void bench_cpio(BenchRunner *runner)
+{
+    for (const CpioCompression &compression : CpioCompressions) {
+        std::string prefix = std::string("cpio/") + compression.name + "/";
+
+        if (!runner->wants(prefix)) {
+            continue;
+        }
+
+        auto data = std::make_shared<std::vector<unsigned char>>();
+        if (!generate_cpio(compression, data.get())) {
+            runner->skip(prefix, "compression not supported by libarchive");
+            continue;
+        }
+
+        auto cpio = std::make_shared<mbp::CpioFile>();
+        if (!cpio->load(*data)) {
+            fprintf(stderr, "Failed to load %s cpio archive\n",
+                    compression.name);
+            continue;
+        }
+
+        runner->run(prefix + "load", data->size(), [data]() {
+            mbp::CpioFile loaded;
+            return loaded.load(*data);
+        });
+
+        runner->run(prefix + "create", data->size(), [cpio]() {
+            std::vector<unsigned char> out;
+            return cpio->createData(&out);
+        });
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// EdifyTokenizer
+////////////////////////////////////////////////////////////////////////////////
+
+static void free_tokens(std::vector<mbp::EdifyToken *> *tokens)
+{
+    for (mbp::EdifyToken *t : *tokens) {
+        delete t;
+    }
+    tokens->clear();
+}
+
+static void bench_edify(BenchRunner *runner)
+{
+    if (!runner->wants("edify/")) {
+        return;
+    }
+
+    auto script = std::make_shared<std::string>(
+            bench::generateUpdaterScript(20000, 7));
+
+    runner->run("edify/tokenize", script->size(), [script]() {
+        std::vector<mbp::EdifyToken *> tokens;
+        bool ret = mbp::EdifyTokenizer::tokenize(
+                script->data(), script->size(), &tokens);
+        free_tokens(&tokens);
+        return ret;
+    });
+
+    // Share the tokens between iterations. The vector is only freed at exit.
+    auto tokens = std::shared_ptr<std::vector<mbp::EdifyToken *>>(
+            new std::vector<mbp::EdifyToken *>(),
+            [](std::vector<mbp::EdifyToken *> *t) {
+                free_tokens(t);
+                delete t;
+            });
+    if (!mbp::EdifyTokenizer::tokenize(
+            script->data(), script->size(), tokens.get())) {
+        fprintf(stderr, "Failed to tokenize updater-script\n");
+        return;
+    }
+
+    runner->run("edify/untokenize", script->size(), [tokens]() {
+        return !mbp::EdifyTokenizer::untokenize(*tokens).empty();
+    });
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// FileUtils
+////////////////////////////////////////////////////////////////////////////////
+
+static bool generate_zip(const std::string &path, uint64_t *totalSize)
+{
+    bench::Random random(1234);
+
+    mbp::FileUtils::MzZipCtx *ctx = mbp::FileUtils::mzOpenOutputFile(path);
+    if (!ctx) {
+        return false;
+    }
+
+    zipFile zf = mbp::FileUtils::mzCtxGetZipFile(ctx);
+    bool ret = true;
+    *totalSize = 0;
+
+    // Lots of small files, like a typical /system
+    for (int i = 0; i < 2000 && ret; ++i) {
+        std::vector<unsigned char> contents = bench::generateData(
+                random.range(256, 32768), random.next(), 50);
+        *totalSize += contents.size();
+        ret = mbp::FileUtils::mzAddFile(
+                zf, "system/lib/file" + std::to_string(i), contents)
+                == mbp::ErrorCode::NoError;
+    }
+
+    // A few large ones, like boot images and firmware
+    for (int i = 0; i < 4 && ret; ++i) {
+        std::vector<unsigned char> contents = bench::generateData(
+                16 * 1024 * 1024, random.next(), 10);
+        *totalSize += contents.size();
+        ret = mbp::FileUtils::mzAddFile(
+                zf, "firmware/image" + std::to_string(i) + ".img", contents)
+                == mbp::ErrorCode::NoError;
+    }
+
+    if (mbp::FileUtils::mzCloseOutputFile(ctx) != ZIP_OK) {
+        ret = false;
+    }
+
+    return ret;
+}
+
+static bool zip_copy_raw(const std::string &input, const std::string &output)
+{
+    mbp::FileUtils::MzUnzCtx *in = mbp::FileUtils::mzOpenInputFile(input);
+    if (!in) {
+        return false;
+    }
+    mbp::FileUtils::MzZipCtx *out = mbp::FileUtils::mzOpenOutputFile(output);
+    if (!out) {
+        mbp::FileUtils::mzCloseInputFile(in);
+        return false;
+    }
+
+    unzFile uf = mbp::FileUtils::mzCtxGetUnzFile(in);
+    zipFile zf = mbp::FileUtils::mzCtxGetZipFile(out);
+    bool ret = true;
+
+    int n = unzGoToFirstFile(uf);
+    while (n == UNZ_OK && ret) {
+        std::string name;
+        ret = mbp::FileUtils::mzGetInfo(uf, nullptr, &name)
+                && mbp::FileUtils::mzCopyFileRaw(uf, zf, name, nullptr, nullptr);
+        n = unzGoToNextFile(uf);
+    }
+
+    if (n != UNZ_END_OF_LIST_OF_FILE) {
+        ret = false;
+    }
+
+    mbp::FileUtils::mzCloseInputFile(in);
+    if (mbp::FileUtils::mzCloseOutputFile(out) != ZIP_OK) {
+        ret = false;
+    }
+    return ret;
+}
+
+static bool zip_read_to_memory(const std::string &input)
+{
+    mbp::FileUtils::MzUnzCtx *in = mbp::FileUtils::mzOpenInputFile(input);
+    if (!in) {
+        return false;
+    }
+
+    unzFile uf = mbp::FileUtils::mzCtxGetUnzFile(in);
+    std::vector<unsigned char> data;
+    bool ret = true;
+
+    int n = unzGoToFirstFile(uf);
+    while (n == UNZ_OK && ret) {
+        ret = mbp::FileUtils::mzReadToMemory(uf, &data, nullptr, nullptr);
+        n = unzGoToNextFile(uf);
+    }
+
+    if (n != UNZ_END_OF_LIST_OF_FILE) {
+        ret = false;
+    }
+
+    mbp::FileUtils::mzCloseInputFile(in);
+    return ret;
+}
+
+static void bench_fileutils(BenchRunner *runner)
+{
+    if (!runner->wants("fileutils/")) {
+        return;
+    }
+
+    std::string tempDir = mbp::FileUtils::createTemporaryDir(
+            mbp::FileUtils::systemTemporaryDir());
+    if (tempDir.empty()) {
+        fprintf(stderr, "Failed to create temporary directory\n");
+        return;
+    }
+
+    std::string zipPath = io::pathJoin({tempDir, "input.zip"});
+    std::string copyPath = io::pathJoin({tempDir, "output.zip"});
+    uint64_t totalSize;
+
+    if (!generate_zip(zipPath, &totalSize)) {
+        fprintf(stderr, "Failed to create zip file\n");
+        io::deleteRecursively(tempDir);
+        return;
+    }
+
+    runner->run("fileutils/zip_stats", totalSize, [zipPath]() {
+        mbp::FileUtils::ArchiveStats stats;
+        return mbp::FileUtils::mzArchiveStats(zipPath, &stats, {})
+                == mbp::ErrorCode::NoError;
+    });
+
+    runner->run("fileutils/zip_copy_raw", totalSize, [zipPath, copyPath]() {
+        return zip_copy_raw(zipPath, copyPath);
+    });
+
+    runner->run("fileutils/zip_read_to_memory", totalSize, [zipPath]() {
+        return zip_read_to_memory(zipPath);
+    });
+
+    runner->run("fileutils/read_to_memory", totalSize, [zipPath]() {
+        std::vector<unsigned char> data;
+        return mbp::FileUtils::readToMemory(zipPath, &data)
+                == mbp::ErrorCode::NoError;
+    });
+
+    io::deleteRecursively(tempDir);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Output
+////////////////////////////////////////////////////////////////////////////////
+
+static void write_json(std::FILE *fp, const std::vector<BenchResult> &results,
+                       uint64_t minIterations, double minTime)
+{
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"min_iterations\": %" PRIu64 ",\n", minIterations);
+    fprintf(fp, "  \"min_time\": %g,\n", minTime);
+    fprintf(fp, "  \"benchmarks\": [");
+
+    bool first = true;
+    for (const BenchResult &r : results) {
+        // Benchmark names never need escaping
+        fprintf(fp, "%s\n    {\n", first ? "" : ",");
+        fprintf(fp, "      \"name\": \"%s\",\n", r.name.c_str());
+        fprintf(fp, "      \"success\": %s,\n", r.success ? "true" : "false");
+        fprintf(fp, "      \"iterations\": %" PRIu64 ",\n", r.iterations);
+        fprintf(fp, "      \"bytes\": %" PRIu64 ",\n", r.bytes);
+        fprintf(fp, "      \"min_ns\": %.0f,\n", r.minNs);
+        fprintf(fp, "      \"median_ns\": %.0f,\n", r.medianNs);
+        fprintf(fp, "      \"mean_ns\": %.0f,\n", r.meanNs);
+        fprintf(fp, "      \"max_ns\": %.0f,\n", r.maxNs);
+        fprintf(fp, "      \"mib_per_sec\": %.2f\n",
+                BenchRunner::mibPerSec(r.bytes, r.medianNs));
+        fprintf(fp, "    }");
+        first = false;
+    }
+
+    fprintf(fp, "%s]\n}\n", first ? "" : "\n  ");
+}
+
+static void mbp_log_cb(mbp::LogLevel prio, const std::string &msg)
+{
+    // Debug output would dominate the timings
+    switch (prio) {
+    case mbp::LogLevel::Error:
+    case mbp::LogLevel::Warning:
+        fprintf(stderr, "%s\n", msg.c_str());
+        break;
+    case mbp::LogLevel::Debug:
+    case mbp::LogLevel::Info:
+    case mbp::LogLevel::Verbose:
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+
+    std::string filter;
+    std::string output;
+    std::string abootPath;
+    uint64_t minIterations = 5;
+    double minTime = 1.0;
+    bool listOnly = false;
+
+    static struct option long_options[] = {
+        {"help",       no_argument,       0, 'h'},
+        {"filter",     required_argument, 0, 'f'},
+        {"iterations", required_argument, 0, 'n'},
+        {"min-time",   required_argument, 0, 't'},
+        {"output",     required_argument, 0, 'o'},
+        {"aboot",      required_argument, 0, 'a'},
+        {"list",       no_argument,       0, 'l'},
+        {0, 0, 0, 0}
+    };
+
+    int long_index = 0;
+
+    while ((opt = getopt_long(argc, argv, "hf:n:t:o:a:l", long_options, &long_index)) != -1) {
+        switch (opt) {
+        case 'f':
+            filter = optarg;
+            break;
+        case 'n':
+            minIterations = strtoull(optarg, nullptr, 10);
+            if (minIterations == 0) {
+                fprintf(stderr, "Invalid iteration count: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 't':
+            minTime = strtod(optarg, nullptr);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'a':
+            abootPath = optarg;
+            break;
+        case 'l':
+            listOnly = true;
+            break;
+
+        case 'h':
+            fprintf(stdout, Usage);
+            return EXIT_SUCCESS;
+
+        default:
+            fprintf(stderr, Usage);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind != 0) {
+        fprintf(stderr, Usage);
+        return EXIT_FAILURE;
+    }
+
+    mbp::setLogCallback(mbp_log_cb);
+
+    // The FIFO benchmark's writer must not be killed if the reader goes away
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<unsigned char> aboot;
+    if (!abootPath.empty() && mbp::FileUtils::readToMemory(abootPath, &aboot)
+            != mbp::ErrorCode::NoError) {
+        fprintf(stderr, "%s: Failed to read aboot image\n", abootPath.c_str());
+        return EXIT_FAILURE;
+    }
+
+    BenchRunner runner(filter, minIterations, minTime, listOnly);
+
+    bench_bootimage(&runner, aboot);
+    bench_bootimage_file(&runner);
+    bench_cpio(&runner);
+    bench_edify(&runner);
+    bench_fileutils(&runner);
+
+    if (listOnly) {
+        return EXIT_SUCCESS;
+    }
+
+    file_ptr fp(nullptr, fclose);
+    if (!output.empty()) {
+        fp.reset(fopen(output.c_str(), "wb"));
+        if (!fp) {
+            fprintf(stderr, "%s: %s\n", output.c_str(), strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    write_json(fp ? fp.get() : stdout, runner.results(),
+               minIterations, minTime);
+
+    bool success = std::all_of(runner.results().begin(),
+                               runner.results().end(),
+                               [](const BenchResult &r) { return r.success; });
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,798 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <libmbpio/delete.h>
+#include <libmbpio/directory.h>
+#include <libmbpio/path.h>
+
+#include <libmbp/fileinfo.h>
+#include <libmbp/logging.h>
+#include <libmbp/patcherconfig.h>
+#include <libmbp/patcherinterface.h>
+#include <libmbp/tracing.h>
+#include <libmbp/private/fileutils.h>
+#include <libmbp/private/stringutils.h>
+
+#include "synthetic.h"
+
+
+typedef std::unique_ptr<std::FILE, int (*)(std::FILE *)> file_ptr;
+typedef std::chrono::steady_clock Clock;
+
+
+static const char Usage[] =
+    "Usage: mbp_patch_bench -i <input zip> [options]\n"
+    "\n"
+    "Runs the full MultiBootPatcher patch of <input zip> for each device and\n"
+    "reports wall time, throughput, peak RSS and per-phase times and memory.\n"
+    "\n"
+    "Options:\n"
+    "  -i, --input [zip]\n"
+    "                  Zip file to patch (eg. from mbp_romgen)\n"
+    "  -d, --device [id]\n"
+    "                  Device to patch for. Can be specified multiple times and\n"
+    "                  accepts comma-separated lists (default: hammerhead)\n"
+    "  -D, --data-dir [dir]\n"
+    "                  Patcher data directory. If not specified, a temporary one\n"
+    "                  with placeholder binaries is created.\n"
+    "  -r, --runs [count]\n"
+    "                  Number of runs per device. The median run is reported.\n"
+    "                  (default: 1)\n"
+    "  -o, --output [file]\n"
+    "                  Write JSON results to [file] instead of stdout\n"
+    "  -b, --baseline [file]\n"
+    "                  Compare results against a baseline file and fail if the\n"
+    "                  wall time or peak RSS regressed\n"
+    "  -w, --write-baseline [file]\n"
+    "                  Write the results to a baseline file\n"
+    "  -t, --tolerance [percent]\n"
+    "                  Allowed regression relative to the baseline (default: 10)\n"
+    "  -T, --trace-dir [dir]\n"
+    "                  Write a Chrome trace of each run to [dir]/<device>-<run>.json\n"
+    "  -m, --memory-budget [MiB]\n"
+    "                  Patcher memory budget (default: unlimited)\n"
+    "\n"
+    "Each run happens in a separate process so that the peak RSS of one run\n"
+    "does not hide the next one.\n";
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Measurements
+////////////////////////////////////////////////////////////////////////////////
+
+enum Phase
+{
+    PHASE_STATS,
+    PHASE_PASS1,
+    PHASE_PASS2,
+    PHASE_FINALIZE,
+    PHASE_COUNT
+};
+
+static const char *PhaseNames[PHASE_COUNT] = {
+    "stats",
+    "pass1",
+    "pass2",
+    "finalize",
+};
+
+// Sent from the child over a pipe, so it must be trivially copyable
+struct RunResult
+{
+    bool success;
+    char error[128];
+    double wallMs;
+    double phaseMs[PHASE_COUNT];
+    // High-water marks of the buffers accounted for by libmbp
+    uint64_t phasePeakBytes[PHASE_COUNT];
+    long peakRssKb;
+};
+
+/*!
+ * \brief Derives phase boundaries from the patcher callbacks
+ *
+ * MultiBootPatcher reports the file count (0) right after computing the archive
+ * stats, reports progress for every entry during the first pass and does not
+ * report anything during the second pass, until the files added at the end are
+ * counted. The last callback before that is the end of the first pass. The error
+ * is at most the time it takes to write the final chunk of the last entry.
+ */
+class PhaseTracker
+{
+public:
+    PhaseTracker() : m_start(Clock::now()), m_statsEnd(), m_lastPass1(),
+        m_pass2End(), m_state(STATE_STATS)
+    {
+    }
+
+    void filesUpdated(uint64_t files, uint64_t maxFiles)
+    {
+        auto now = Clock::now();
+
+        if (m_state == STATE_STATS) {
+            m_statsEnd = now;
+            m_lastPass1 = now;
+            m_state = STATE_PASS1;
+        } else if (m_state == STATE_PASS1) {
+            // 3 files are added after the second pass
+            if (files == maxFiles - 2) {
+                m_pass2End = now;
+                m_state = STATE_FINALIZE;
+            } else {
+                m_lastPass1 = now;
+            }
+        }
+    }
+
+    void otherUpdated()
+    {
+        if (m_state == STATE_PASS1) {
+            m_lastPass1 = Clock::now();
+        }
+    }
+
+    void finish(RunResult *result)
+    {
+        auto end = Clock::now();
+
+        // Collapse phases that were never reached
+        if (m_state < STATE_PASS1) {
+            m_statsEnd = m_lastPass1 = end;
+        }
+        if (m_state < STATE_FINALIZE) {
+            m_pass2End = end;
+        }
+
+        result->wallMs = ms(m_start, end);
+        result->phaseMs[PHASE_STATS] = ms(m_start, m_statsEnd);
+        result->phaseMs[PHASE_PASS1] = ms(m_statsEnd, m_lastPass1);
+        result->phaseMs[PHASE_PASS2] = ms(m_lastPass1, m_pass2End);
+        result->phaseMs[PHASE_FINALIZE] = ms(m_pass2End, end);
+    }
+
+private:
+    enum State
+    {
+        STATE_STATS,
+        STATE_PASS1,
+        STATE_FINALIZE
+    };
+
+    static double ms(Clock::time_point begin, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+
+    Clock::time_point m_start;
+    Clock::time_point m_statsEnd;
+    Clock::time_point m_lastPass1;
+    Clock::time_point m_pass2End;
+    State m_state;
+};
+
+static void progress_cb(uint64_t bytes, uint64_t maxBytes, void *userData)
+{
+    (void) bytes;
+    (void) maxBytes;
+    static_cast<PhaseTracker *>(userData)->otherUpdated();
+}
+
+static void files_cb(uint64_t files, uint64_t maxFiles, void *userData)
+{
+    static_cast<PhaseTracker *>(userData)->filesUpdated(files, maxFiles);
+}
+
+static void details_cb(const std::string &text, void *userData)
+{
+    (void) text;
+    static_cast<PhaseTracker *>(userData)->otherUpdated();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Patching
+////////////////////////////////////////////////////////////////////////////////
+
+static void set_error(RunResult *result, const std::string &error)
+{
+    strncpy(result->error, error.c_str(), sizeof(result->error) - 1);
+    result->error[sizeof(result->error) - 1] = '\0';
+}
+
+static void patch_once(const std::string &input, const std::string &deviceId,
+                       const std::string &dataDir, const std::string &tempDir,
+                       const std::string &tracePath, uint64_t memoryBudget,
+                       RunResult *result)
+{
+    if (!tracePath.empty()) {
+        mbp::setTracingEnabled(true);
+    }
+
+    mbp::PatcherConfig pc;
+    pc.setDataDirectory(dataDir);
+    pc.setTempDirectory(tempDir);
+    pc.setMemoryBudget(memoryBudget);
+
+    mbp::Device *device = nullptr;
+    for (mbp::Device *d : pc.devices()) {
+        if (d->id() == deviceId) {
+            device = d;
+            break;
+        }
+    }
+    if (!device) {
+        set_error(result, "Unknown device");
+        return;
+    }
+
+    mbp::FileInfo info;
+    info.setInputPath(input);
+    info.setOutputPath(io::pathJoin({ tempDir, "output.zip" }));
+    info.setDevice(device);
+    info.setRomId("dual");
+
+    mbp::Patcher *patcher = pc.createPatcher("MultiBootPatcher");
+    if (!patcher) {
+        set_error(result, "Failed to create patcher");
+        return;
+    }
+
+    patcher->setFileInfo(&info);
+
+    PhaseTracker tracker;
+    result->success = patcher->patchFile(&progress_cb, &files_cb, &details_cb,
+                                         &tracker);
+    tracker.finish(result);
+
+    for (const mbp::PhaseMemoryUsage &usage : patcher->memoryUsage()) {
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            if (usage.phase == PhaseNames[i]) {
+                result->phasePeakBytes[i] = usage.peakBytes;
+            }
+        }
+    }
+
+    if (!result->success) {
+        set_error(result, StringUtils::format(
+                "Patching failed with error code %d",
+                static_cast<int>(patcher->error())));
+    }
+
+    pc.destroyPatcher(patcher);
+
+    remove(info.outputPath().c_str());
+
+    if (!tracePath.empty() && !mbp::writeChromeTrace(tracePath)) {
+        fprintf(stderr, "%s: Failed to write trace\n", tracePath.c_str());
+    }
+}
+
+/*!
+ * \brief Run a single patch in a child process
+ */
+static bool run_patch(const std::string &input, const std::string &deviceId,
+                      const std::string &dataDir, const std::string &tempDir,
+                      const std::string &tracePath, uint64_t memoryBudget,
+                      RunResult *result)
+{
+    memset(result, 0, sizeof(*result));
+
+    int fds[2];
+    if (pipe(fds) < 0) {
+        fprintf(stderr, "Failed to create pipe: %s\n", strerror(errno));
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Failed to fork: %s\n", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    } else if (pid == 0) {
+        close(fds[0]);
+
+        RunResult childResult;
+        memset(&childResult, 0, sizeof(childResult));
+        patch_once(input, deviceId, dataDir, tempDir, tracePath, memoryBudget,
+                   &childResult);
+
+        bool ok = write(fds[1], &childResult, sizeof(childResult))
+                == sizeof(childResult);
+        _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+
+    ssize_t n = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        fprintf(stderr, "Failed to wait for child: %s\n", strerror(errno));
+        return false;
+    }
+
+    if (n != sizeof(*result) || !WIFEXITED(status)
+            || WEXITSTATUS(status) != 0) {
+        memset(result, 0, sizeof(*result));
+        set_error(result, "Patcher process crashed");
+    }
+
+    // ru_maxrss is in KiB on Linux
+    result->peakRssKb = usage.ru_maxrss;
+
+    return true;
+}
+
+/*!
+ * \brief Create a data directory with placeholder binaries
+ *
+ * The patcher only copies these files, so their contents don't matter. Only
+ * their sizes roughly match the real ones.
+ */
+static bool create_data_dir(const std::string &dir,
+                            const std::vector<std::string> &architectures)
+{
+    struct Placeholder {
+        const char *name;
+        std::size_t size;
+    };
+    static const Placeholder binaries[] = {
+        { "mbtool",          2 * 1024 * 1024 },
+        { "mbtool_recovery", 2 * 1024 * 1024 },
+        { "mount.exfat",     256 * 1024      },
+    };
+
+    std::string scripts = io::pathJoin({ dir, "scripts" });
+    if (!io::createDirectories(scripts)
+            || mbp::FileUtils::writeFromMemory(
+                    io::pathJoin({ scripts, "bb-wrapper.sh" }),
+                    bench::generateData(8 * 1024, 1, 100))
+                            != mbp::ErrorCode::NoError) {
+        return false;
+    }
+
+    uint64_t seed = 1;
+
+    for (const std::string &arch : architectures) {
+        std::string archDir = io::pathJoin({ dir, "binaries", "android", arch });
+        if (!io::createDirectories(archDir)) {
+            return false;
+        }
+
+        for (const Placeholder &binary : binaries) {
+            if (mbp::FileUtils::writeFromMemory(
+                    io::pathJoin({ archDir, binary.name }),
+                    bench::generateData(binary.size, ++seed, 10))
+                            != mbp::ErrorCode::NoError) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Baselines
+////////////////////////////////////////////////////////////////////////////////
+
+struct DeviceResult
+{
+    std::string device;
+    RunResult result;
+    uint64_t inputBytes;
+};
+
+static double mib_per_sec(uint64_t bytes, double ms)
+{
+    return ms > 0 ? bytes / 1048576.0 / (ms / 1000.0) : 0;
+}
+
+static bool read_baseline(const std::string &path,
+                          std::unordered_map<std::string, double> *values)
+{
+    std::string contents;
+    if (mbp::FileUtils::readToString(path, &contents)
+            != mbp::ErrorCode::NoError) {
+        fprintf(stderr, "%s: Failed to read baseline\n", path.c_str());
+        return false;
+    }
+
+    for (const std::string &line : StringUtils::split(contents, '\n')) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::size_t pos = line.find('=');
+        if (pos == std::string::npos) {
+            fprintf(stderr, "%s: Invalid line: %s\n",
+                    path.c_str(), line.c_str());
+            return false;
+        }
+
+        (*values)[line.substr(0, pos)] = strtod(line.c_str() + pos + 1, nullptr);
+    }
+
+    return true;
+}
+
+static bool write_baseline(const std::string &path,
+                           const std::vector<DeviceResult> &results)
+{
+    std::string out = "# mbp_patch_bench baseline\n";
+
+    for (const DeviceResult &r : results) {
+        out += StringUtils::format("%s.wall_ms=%.0f\n",
+                                        r.device.c_str(), r.result.wallMs);
+        out += StringUtils::format("%s.peak_rss_kb=%ld\n",
+                                        r.device.c_str(), r.result.peakRssKb);
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            out += StringUtils::format("%s.%s_ms=%.0f\n",
+                                            r.device.c_str(), PhaseNames[i],
+                                            r.result.phaseMs[i]);
+            out += StringUtils::format("%s.%s_peak_bytes=%" PRIu64 "\n",
+                                            r.device.c_str(), PhaseNames[i],
+                                            r.result.phasePeakBytes[i]);
+        }
+    }
+
+    if (mbp::FileUtils::writeFromString(path, out)
+            != mbp::ErrorCode::NoError) {
+        fprintf(stderr, "%s: Failed to write baseline\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_value(const std::string &key, double value,
+                        const std::unordered_map<std::string, double> &baseline,
+                        double tolerance, bool enforce)
+{
+    auto it = baseline.find(key);
+    if (it == baseline.end() || it->second <= 0) {
+        fprintf(stderr, "  %-32s %12.0f (no baseline)\n", key.c_str(), value);
+        return true;
+    }
+
+    double change = (value - it->second) / it->second * 100.0;
+    bool regressed = enforce && change > tolerance;
+
+    fprintf(stderr, "  %-32s %12.0f vs %12.0f (%+6.1f%%)%s\n",
+            key.c_str(), value, it->second, change,
+            regressed ? " REGRESSED" : "");
+
+    return !regressed;
+}
+
+static bool compare_baseline(const std::vector<DeviceResult> &results,
+                             const std::unordered_map<std::string, double> &baseline,
+                             double tolerance)
+{
+    bool ret = true;
+
+    fprintf(stderr, "Comparison against baseline (tolerance: %.1f%%):\n",
+            tolerance);
+
+    for (const DeviceResult &r : results) {
+        // Individual phases are informational only. They are too short to be
+        // stable for small inputs.
+        ret = check_value(r.device + ".wall_ms", r.result.wallMs,
+                          baseline, tolerance, true) && ret;
+        ret = check_value(r.device + ".peak_rss_kb", r.result.peakRssKb,
+                          baseline, tolerance, true) && ret;
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            check_value(r.device + "." + PhaseNames[i] + "_ms",
+                        r.result.phaseMs[i], baseline, tolerance, false);
+            check_value(r.device + "." + PhaseNames[i] + "_peak_bytes",
+                        r.result.phasePeakBytes[i], baseline, tolerance,
+                        false);
+        }
+    }
+
+    return ret;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Output
+////////////////////////////////////////////////////////////////////////////////
+
+static void write_json(std::FILE *fp, const std::vector<DeviceResult> &results)
+{
+    fprintf(fp, "{\n  \"results\": [");
+
+    bool first = true;
+    for (const DeviceResult &r : results) {
+        // Device IDs and phase names never need escaping
+        fprintf(fp, "%s\n    {\n", first ? "" : ",");
+        fprintf(fp, "      \"device\": \"%s\",\n", r.device.c_str());
+        fprintf(fp, "      \"success\": %s,\n",
+                r.result.success ? "true" : "false");
+        fprintf(fp, "      \"input_bytes\": %" PRIu64 ",\n", r.inputBytes);
+        fprintf(fp, "      \"wall_ms\": %.1f,\n", r.result.wallMs);
+        fprintf(fp, "      \"mib_per_sec\": %.2f,\n",
+                mib_per_sec(r.inputBytes, r.result.wallMs));
+        fprintf(fp, "      \"peak_rss_kb\": %ld,\n", r.result.peakRssKb);
+        fprintf(fp, "      \"phases_ms\": {");
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            fprintf(fp, "%s\"%s\": %.1f", i == 0 ? " " : ", ",
+                    PhaseNames[i], r.result.phaseMs[i]);
+        }
+        fprintf(fp, " },\n");
+        fprintf(fp, "      \"phases_peak_bytes\": {");
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            fprintf(fp, "%s\"%s\": %" PRIu64, i == 0 ? " " : ", ",
+                    PhaseNames[i], r.result.phasePeakBytes[i]);
+        }
+        fprintf(fp, " }\n    }");
+        first = false;
+    }
+
+    fprintf(fp, "%s]\n}\n", first ? "" : "\n  ");
+}
+
+static void mbp_log_cb(mbp::LogLevel prio, const std::string &msg)
+{
+    switch (prio) {
+    case mbp::LogLevel::Error:
+    case mbp::LogLevel::Warning:
+        fprintf(stderr, "%s\n", msg.c_str());
+        break;
+    case mbp::LogLevel::Debug:
+    case mbp::LogLevel::Info:
+    case mbp::LogLevel::Verbose:
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+
+    std::string input;
+    std::vector<std::string> devices;
+    std::string dataDir;
+    std::string output;
+    std::string baselinePath;
+    std::string writeBaselinePath;
+    std::string traceDir;
+    uint64_t runs = 1;
+    uint64_t memoryBudget = 0;
+    double tolerance = 10.0;
+
+    static struct option long_options[] = {
+        {"help",           no_argument,       0, 'h'},
+        {"input",          required_argument, 0, 'i'},
+        {"device",         required_argument, 0, 'd'},
+        {"data-dir",       required_argument, 0, 'D'},
+        {"runs",           required_argument, 0, 'r'},
+        {"output",         required_argument, 0, 'o'},
+        {"baseline",       required_argument, 0, 'b'},
+        {"write-baseline", required_argument, 0, 'w'},
+        {"tolerance",      required_argument, 0, 't'},
+        {"trace-dir",      required_argument, 0, 'T'},
+        {"memory-budget",  required_argument, 0, 'm'},
+        {0, 0, 0, 0}
+    };
+
+    int long_index = 0;
+
+    while ((opt = getopt_long(argc, argv, "hi:d:D:r:o:b:w:t:T:m:", long_options, &long_index)) != -1) {
+        switch (opt) {
+        case 'i':
+            input = optarg;
+            break;
+        case 'd':
+            for (const std::string &id : StringUtils::split(optarg, ',')) {
+                if (!id.empty()) {
+                    devices.push_back(id);
+                }
+            }
+            break;
+        case 'D':
+            dataDir = optarg;
+            break;
+        case 'r':
+            runs = strtoull(optarg, nullptr, 10);
+            if (runs == 0) {
+                fprintf(stderr, "Invalid run count: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'b':
+            baselinePath = optarg;
+            break;
+        case 'w':
+            writeBaselinePath = optarg;
+            break;
+        case 't':
+            tolerance = strtod(optarg, nullptr);
+            break;
+        case 'T':
+            traceDir = optarg;
+            break;
+        case 'm':
+            memoryBudget = strtoull(optarg, nullptr, 10) * 1024 * 1024;
+            break;
+
+        case 'h':
+            fprintf(stdout, Usage);
+            return EXIT_SUCCESS;
+
+        default:
+            fprintf(stderr, Usage);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (input.empty() || argc - optind != 0) {
+        fprintf(stderr, Usage);
+        return EXIT_FAILURE;
+    }
+
+    if (devices.empty()) {
+        devices.push_back("hammerhead");
+    }
+
+    if (!traceDir.empty() && !io::createDirectories(traceDir)) {
+        fprintf(stderr, "%s: Failed to create directory\n", traceDir.c_str());
+        return EXIT_FAILURE;
+    }
+
+    mbp::setLogCallback(mbp_log_cb);
+
+    struct stat sb;
+    if (stat(input.c_str(), &sb) < 0) {
+        fprintf(stderr, "%s: %s\n", input.c_str(), strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    std::unordered_map<std::string, double> baseline;
+    if (!baselinePath.empty() && !read_baseline(baselinePath, &baseline)) {
+        return EXIT_FAILURE;
+    }
+
+    std::string tempDir = mbp::FileUtils::createTemporaryDir(
+            mbp::FileUtils::systemTemporaryDir());
+    if (tempDir.empty()) {
+        fprintf(stderr, "Failed to create temporary directory\n");
+        return EXIT_FAILURE;
+    }
+
+    if (dataDir.empty()) {
+        std::vector<std::string> architectures;
+        mbp::PatcherConfig pc;
+        for (mbp::Device *d : pc.devices()) {
+            if (std::find(architectures.begin(), architectures.end(),
+                          d->architecture()) == architectures.end()) {
+                architectures.push_back(d->architecture());
+            }
+        }
+
+        dataDir = io::pathJoin({ tempDir, "data" });
+        if (!create_data_dir(dataDir, architectures)) {
+            fprintf(stderr, "Failed to create data directory\n");
+            io::deleteRecursively(tempDir);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<DeviceResult> results;
+    bool success = true;
+
+    for (const std::string &device : devices) {
+        std::vector<RunResult> deviceRuns;
+
+        for (uint64_t i = 0; i < runs; ++i) {
+            std::string tracePath;
+            if (!traceDir.empty()) {
+                tracePath = io::pathJoin({ traceDir, StringUtils::format(
+                        "%s-%" PRIu64 ".json", device.c_str(), i + 1) });
+            }
+
+            RunResult result;
+            if (!run_patch(input, device, dataDir, tempDir, tracePath,
+                           memoryBudget, &result)) {
+                io::deleteRecursively(tempDir);
+                return EXIT_FAILURE;
+            }
+
+            if (!result.success) {
+                fprintf(stderr, "%s: %s\n", device.c_str(), result.error);
+                deviceRuns.clear();
+                deviceRuns.push_back(result);
+                break;
+            }
+
+            fprintf(stderr, "%s: run %" PRIu64 ": %.1f ms, %ld KiB peak RSS\n",
+                    device.c_str(), i + 1, result.wallMs, result.peakRssKb);
+            deviceRuns.push_back(result);
+        }
+
+        std::sort(deviceRuns.begin(), deviceRuns.end(),
+                  [](const RunResult &a, const RunResult &b) {
+                      return a.wallMs < b.wallMs;
+                  });
+
+        DeviceResult dr;
+        dr.device = device;
+        dr.result = deviceRuns[deviceRuns.size() / 2];
+        dr.inputBytes = sb.st_size;
+        results.push_back(dr);
+
+        if (!dr.result.success) {
+            success = false;
+        }
+    }
+
+    io::deleteRecursively(tempDir);
+
+    file_ptr fp(nullptr, fclose);
+    if (!output.empty()) {
+        fp.reset(fopen(output.c_str(), "wb"));
+        if (!fp) {
+            fprintf(stderr, "%s: %s\n", output.c_str(), strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    write_json(fp ? fp.get() : stdout, results);
+
+    if (!success) {
+        return EXIT_FAILURE;
+    }
+
+    if (!writeBaselinePath.empty() && !write_baseline(writeBaselinePath, results)) {
+        return EXIT_FAILURE;
+    }
+
+    if (!baselinePath.empty() && !compare_baseline(results, baseline, tolerance)) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
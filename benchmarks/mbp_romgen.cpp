@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <getopt.h>
+
+#include <archive.h>
+
+#include <libmbp/bootimage.h>
+#include <libmbp/logging.h>
+#include <libmbp/private/fileutils.h>
+
+#include "synthetic.h"
+
+
+static const char Usage[] =
+    "Usage: mbp_romgen -o <output zip> [options]\n"
+    "\n"
+    "Generates a deterministic, ROM-like zip file for benchmarking the patcher.\n"
+    "\n"
+    "Options:\n"
+    "  -o, --output [file]\n"
+    "                  Path to the output zip file\n"
+    "  -s, --system-size [MiB]\n"
+    "                  Size of system.new.dat (default: 2048)\n"
+    "  -n, --files [count]\n"
+    "                  Number of small files in system/ (default: 5000)\n"
+    "  -l, --script-lines [count]\n"
+    "                  Number of updater-script lines (default: 20000)\n"
+    "  -z, --level [0-9]\n"
+    "                  Deflate level used for system.new.dat (default: 6)\n"
+    "  --seed [seed]   PRNG seed (default: 1)\n"
+    "\n"
+    "The zip contains:\n"
+    "  - META-INF/com/google/android/{update-binary,updater-script}\n"
+    "  - system.new.dat, system.transfer.list, system.patch.dat\n"
+    "  - system/**: many small files\n"
+    "  - boot.img (android), firmware/boot-{bump,mtk,sonyelf}.img\n"
+    "  - ramdisk.gz: split out ramdisk, as built at install time by some ROMs\n";
+
+
+static const char *UpdaterScript = "META-INF/com/google/android/updater-script";
+static const char *UpdateBinary = "META-INF/com/google/android/update-binary";
+
+
+struct GeneratedImage
+{
+    const char *name;
+    mbp::BootImage::Type type;
+};
+
+static const GeneratedImage GeneratedImages[] = {
+    { "boot.img",                  mbp::BootImage::Type::Android },
+    { "firmware/boot-bump.img",    mbp::BootImage::Type::Bump    },
+    { "firmware/boot-mtk.img",     mbp::BootImage::Type::Mtk     },
+    { "firmware/boot-sonyelf.img", mbp::BootImage::Type::SonyElf },
+};
+
+
+static bool add_file(zipFile zf, const std::string &name,
+                     const std::vector<unsigned char> &contents)
+{
+    auto ret = mbp::FileUtils::mzAddFile(zf, name, contents);
+    if (ret != mbp::ErrorCode::NoError) {
+        fprintf(stderr, "%s: Failed to add file to zip\n", name.c_str());
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief Stream a large generated file into the zip
+ *
+ * The data is generated in chunks so that multi-GiB files don't need to fit in
+ * memory.
+ */
+static bool add_large_file(zipFile zf, const std::string &name, uint64_t size,
+                           uint64_t seed, int level)
+{
+    zip_fileinfo zi;
+    memset(&zi, 0, sizeof(zi));
+
+    int ret = zipOpenNewFileInZip2_64(
+        zf,                     // file
+        name.c_str(),           // filename
+        &zi,                    // zip_fileinfo
+        nullptr,                // extrafield_local
+        0,                      // size_extrafield_local
+        nullptr,                // extrafield_global
+        0,                      // size_extrafield_global
+        nullptr,                // comment
+        Z_DEFLATED,             // method
+        level,                  // level
+        0,                      // raw
+        size >= ((1ull << 32) - 1) // zip64
+    );
+    if (ret != ZIP_OK) {
+        fprintf(stderr, "%s: Failed to open inner file: %s\n", name.c_str(),
+                mbp::FileUtils::mzZipErrorString(ret).c_str());
+        return false;
+    }
+
+    bench::DataGenerator generator(seed, 30);
+    std::vector<unsigned char> buf(1024 * 1024);
+    uint64_t remaining = size;
+
+    while (remaining > 0) {
+        unsigned int n = std::min<uint64_t>(remaining, buf.size());
+        generator.fill(buf.data(), n);
+
+        ret = zipWriteInFileInZip(zf, buf.data(), n);
+        if (ret != ZIP_OK) {
+            fprintf(stderr, "%s: Failed to write inner file data: %s\n",
+                    name.c_str(),
+                    mbp::FileUtils::mzZipErrorString(ret).c_str());
+            zipCloseFileInZip(zf);
+            return false;
+        }
+
+        remaining -= n;
+    }
+
+    ret = zipCloseFileInZip(zf);
+    if (ret != ZIP_OK) {
+        fprintf(stderr, "%s: Failed to close inner file: %s\n", name.c_str(),
+                mbp::FileUtils::mzZipErrorString(ret).c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static bool generate_ramdisk(uint64_t seed, std::vector<unsigned char> *out)
+{
+    // Real ramdisks are almost always gzip compressed
+    if (!bench::generateCpio(bench::generateRamdiskEntries(300, seed),
+                             &archive_write_add_filter_gzip, out)) {
+        fprintf(stderr, "Failed to create ramdisk\n");
+        return false;
+    }
+    return true;
+}
+
+static std::string generate_transfer_list(uint64_t systemSize)
+{
+    uint64_t blocks = (systemSize + 4095) / 4096;
+    std::string list;
+    list += "3\n";
+    list += std::to_string(blocks);
+    list += "\n0\n0\n";
+    list += "new 2,0,";
+    list += std::to_string(blocks);
+    list += "\n";
+    return list;
+}
+
+static bool generate_rom(const std::string &path, uint64_t systemSize,
+                         uint64_t files, uint64_t scriptLines, int level,
+                         uint64_t seed)
+{
+    bench::Random random(seed);
+
+    mbp::FileUtils::MzZipCtx *ctx = mbp::FileUtils::mzOpenOutputFile(path);
+    if (!ctx) {
+        fprintf(stderr, "%s: Failed to open for writing\n", path.c_str());
+        return false;
+    }
+
+    zipFile zf = mbp::FileUtils::mzCtxGetZipFile(ctx);
+    bool ret = true;
+
+    // Installer
+    std::string script = bench::generateUpdaterScript(scriptLines,
+                                                      random.next());
+    ret = ret && add_file(zf, UpdaterScript,
+            std::vector<unsigned char>(script.begin(), script.end()));
+    ret = ret && add_file(zf, UpdateBinary,
+            bench::generateData(300 * 1024, random.next(), 10));
+
+    // Boot images
+    for (const GeneratedImage &image : GeneratedImages) {
+        if (!ret) {
+            break;
+        }
+
+        std::vector<unsigned char> ramdisk;
+        std::vector<unsigned char> data;
+        mbp::BootImage bi;
+
+        ret = generate_ramdisk(random.next(), &ramdisk);
+        if (ret) {
+            bench::setUpBootImage(&bi, image.type, std::move(ramdisk), {});
+            ret = bi.create(&data);
+            if (!ret) {
+                fprintf(stderr, "%s: Failed to create boot image\n",
+                        image.name);
+            }
+        }
+
+        ret = ret && add_file(zf, image.name, data);
+    }
+
+    // Split out ramdisk
+    std::vector<unsigned char> ramdisk;
+    ret = ret && generate_ramdisk(random.next(), &ramdisk)
+            && add_file(zf, "ramdisk.gz", ramdisk);
+
+    // Many small files, like a file-based ROM or gapps package
+    for (uint64_t i = 0; i < files && ret; ++i) {
+        std::string name = "system/app/App" + std::to_string(i / 16)
+                + "/file" + std::to_string(i);
+        ret = add_file(zf, name, bench::generateData(
+                random.range(256, 64 * 1024), random.next(), 50));
+    }
+
+    // Block-based system image
+    std::string transferList = generate_transfer_list(systemSize);
+    ret = ret && add_file(zf, "system.transfer.list",
+            std::vector<unsigned char>(transferList.begin(),
+                                       transferList.end()));
+    ret = ret && add_file(zf, "system.patch.dat", {});
+    ret = ret && add_large_file(zf, "system.new.dat", systemSize,
+                                random.next(), level);
+
+    int closeRet = mbp::FileUtils::mzCloseOutputFile(ctx);
+    if (closeRet != ZIP_OK) {
+        fprintf(stderr, "%s: Failed to close zip: %s\n", path.c_str(),
+                mbp::FileUtils::mzZipErrorString(closeRet).c_str());
+        ret = false;
+    }
+
+    return ret;
+}
+
+static bool parse_uint64(const char *str, uint64_t *out)
+{
+    char *end;
+    errno = 0;
+    uint64_t value = strtoull(str, &end, 10);
+    if (errno || *str == '\0' || *end != '\0') {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+static void mbp_log_cb(mbp::LogLevel prio, const std::string &msg)
+{
+    switch (prio) {
+    case mbp::LogLevel::Error:
+    case mbp::LogLevel::Warning:
+        fprintf(stderr, "%s\n", msg.c_str());
+        break;
+    case mbp::LogLevel::Debug:
+    case mbp::LogLevel::Info:
+    case mbp::LogLevel::Verbose:
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+
+    std::string output;
+    uint64_t systemSize = 2048;
+    uint64_t files = 5000;
+    uint64_t scriptLines = 20000;
+    uint64_t level = 6;
+    uint64_t seed = 1;
+
+    enum Options {
+        OPT_SEED = 1000,
+    };
+
+    static struct option long_options[] = {
+        {"help",         no_argument,       0, 'h'},
+        {"output",       required_argument, 0, 'o'},
+        {"system-size",  required_argument, 0, 's'},
+        {"files",        required_argument, 0, 'n'},
+        {"script-lines", required_argument, 0, 'l'},
+        {"level",        required_argument, 0, 'z'},
+        {"seed",         required_argument, 0, OPT_SEED},
+        {0, 0, 0, 0}
+    };
+
+    int long_index = 0;
+
+    while ((opt = getopt_long(argc, argv, "ho:s:n:l:z:", long_options, &long_index)) != -1) {
+        switch (opt) {
+        case 'o':
+            output = optarg;
+            break;
+        case 's':
+            if (!parse_uint64(optarg, &systemSize)) {
+                fprintf(stderr, "Invalid system size: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'n':
+            if (!parse_uint64(optarg, &files)) {
+                fprintf(stderr, "Invalid file count: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'l':
+            if (!parse_uint64(optarg, &scriptLines)) {
+                fprintf(stderr, "Invalid line count: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'z':
+            if (!parse_uint64(optarg, &level) || level > 9) {
+                fprintf(stderr, "Invalid deflate level: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case OPT_SEED:
+            if (!parse_uint64(optarg, &seed)) {
+                fprintf(stderr, "Invalid seed: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+
+        case 'h':
+            fprintf(stdout, Usage);
+            return EXIT_SUCCESS;
+
+        default:
+            fprintf(stderr, Usage);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (output.empty() || argc - optind != 0) {
+        fprintf(stderr, Usage);
+        return EXIT_FAILURE;
+    }
+
+    mbp::setLogCallback(mbp_log_cb);
+
+    if (!generate_rom(output, systemSize * 1024 * 1024, files, scriptLines,
+                      static_cast<int>(level), seed)) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
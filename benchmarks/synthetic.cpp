@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synthetic.h"
+
+#include <algorithm>
+
+#include <cstring>
+
+#include <archive.h>
+#include <archive_entry.h>
+
+#include <libmbp/bootimage.h>
+
+
+namespace bench
+{
+
+static const char *Words[] = {
+    "import", "service", "/system/bin/", "on property:", "setprop",
+    "chmod 0644", "chown system system", "mount", "write /proc/",
+    "class_start", "ro.build.", "\n", "    ", "=", "true", "false",
+};
+static const std::size_t NumWords = sizeof(Words) / sizeof(Words[0]);
+
+Random::Random(uint64_t seed) : m_state(seed ? seed : 0x9e3779b97f4a7c15ull)
+{
+}
+
+uint64_t Random::next()
+{
+    m_state ^= m_state >> 12;
+    m_state ^= m_state << 25;
+    m_state ^= m_state >> 27;
+    return m_state * 0x2545f4914f6cdd1dull;
+}
+
+uint64_t Random::range(uint64_t min, uint64_t max)
+{
+    return min + next() % (max - min + 1);
+}
+
+DataGenerator::DataGenerator(uint64_t seed, unsigned int textRatio)
+    : m_random(seed), m_textRatio(textRatio), m_remaining(0), m_text(false),
+    m_word("")
+{
+}
+
+void DataGenerator::fill(unsigned char *buf, std::size_t size)
+{
+    while (size > 0) {
+        if (m_remaining == 0) {
+            m_remaining = m_random.range(64, 4096);
+            m_text = m_random.range(0, 99) < m_textRatio;
+            m_word = "";
+        }
+
+        std::size_t n = std::min(m_remaining, size);
+        m_remaining -= n;
+        size -= n;
+
+        if (m_text) {
+            while (n > 0) {
+                if (!*m_word) {
+                    m_word = Words[m_random.range(0, NumWords - 1)];
+                }
+                while (n > 0 && *m_word) {
+                    *buf++ = static_cast<unsigned char>(*m_word++);
+                    --n;
+                }
+            }
+        } else {
+            for (; n >= 8; n -= 8) {
+                uint64_t value = m_random.next();
+                std::memcpy(buf, &value, 8);
+                buf += 8;
+            }
+            for (; n > 0; --n) {
+                *buf++ = static_cast<unsigned char>(m_random.next());
+            }
+        }
+    }
+}
+
+std::vector<unsigned char> generateData(std::size_t size, uint64_t seed,
+                                        unsigned int textRatio)
+{
+    std::vector<unsigned char> data(size);
+    DataGenerator(seed, textRatio).fill(data.data(), data.size());
+    return data;
+}
+
+std::vector<unsigned char> generateMtkHeader(const char *type)
+{
+    // 512-byte mtk header with its size field cleared, like BootImage expects
+    std::vector<unsigned char> header(512, 0xff);
+    static const unsigned char magic[] = { 0x88, 0x16, 0x88, 0x58 };
+    std::memcpy(header.data(), magic, sizeof(magic));
+    std::memset(header.data() + 4, 0, 4 + 32);
+    std::memcpy(header.data() + 8, type, strlen(type));
+    return header;
+}
+
+std::string generateUpdaterScript(std::size_t lines, uint64_t seed)
+{
+    Random random(seed);
+    std::string script;
+    script.reserve(lines * 80);
+
+    // Preamble that the StandardPatcher rewrites
+    script += "getprop(\"ro.product.device\") == \"hammerhead\" || "
+            "abort(\"This package is for \\\"hammerhead\\\"\");\n"
+            "ui_print(\"Target: synthetic/bench\");\n"
+            "show_progress(0.750000, 0);\n"
+            "format(\"ext4\", \"EMMC\", \"/dev/block/platform/msm_sdcc.1/"
+            "by-name/system\", \"0\", \"/system\");\n"
+            "mount(\"ext4\", \"EMMC\", \"/dev/block/platform/msm_sdcc.1/"
+            "by-name/system\", \"/system\");\n"
+            "run_program(\"/sbin/busybox\", \"mount\", \"/data\");\n";
+
+    for (std::size_t i = 0; i < lines; ++i) {
+        switch (random.range(0, 7)) {
+        case 0:
+            script += "ui_print(\"Installing part ";
+            script += std::to_string(i);
+            script += "...\");\n";
+            break;
+        case 1:
+            script += "set_metadata_recursive(\"/system/bin\", \"uid\", 0, "
+                    "\"gid\", 2000, \"dmode\", 0755, \"fmode\", 0755, "
+                    "\"capabilities\", 0x0, \"selabel\", "
+                    "\"u:object_r:system_file:s0\");\n";
+            break;
+        case 2:
+            script += "if is_mounted(\"/system\") then\n"
+                    "    unmount(\"/system\");\nendif;\n";
+            break;
+        case 3:
+            script += "# Comment line ";
+            script += std::to_string(random.next());
+            script += "\n";
+            break;
+        case 4:
+            script += "symlink(\"toolbox\", \"/system/bin/cmd";
+            script += std::to_string(i);
+            script += "\");\n";
+            break;
+        case 5:
+            script += "package_extract_file(\"boot.img\", "
+                    "\"/dev/block/platform/msm_sdcc.1/by-name/boot\");\n";
+            break;
+        case 6:
+            script += "set_metadata(\"/system/xbin/file";
+            script += std::to_string(i);
+            script += "\", \"uid\", 0, \"gid\", 0, \"mode\", 0644);\n";
+            break;
+        default:
+            script += "block_image_update(\"/dev/block/platform/msm_sdcc.1/"
+                    "by-name/system\", package_extract_file(\"system.transfer."
+                    "list\"), \"system.new.dat\", \"system.patch.dat\");\n";
+            break;
+        }
+    }
+
+    script += "unmount(\"/system\");\n";
+
+    return script;
+}
+
+void setUpBootImage(mbp::BootImage *bi, mbp::BootImage::Type type,
+                    std::vector<unsigned char> ramdisk,
+                    const std::vector<unsigned char> &aboot)
+{
+    bi->setTargetType(type);
+    bi->setKernelCmdline("console=ttyHSL0,115200,n8 androidboot.hardware=qcom "
+                         "user_debug=31 msm_rtb.filter=0x3F");
+    bi->setKernelImage(generateData(8 * 1024 * 1024, 1, 5));
+    bi->setRamdiskImage(std::move(ramdisk));
+
+    if (type == mbp::BootImage::Type::SonyElf) {
+        bi->setKernelAddress(mbp::BootImage::SonyElfDefaultKernelAddress);
+        bi->setRamdiskAddress(mbp::BootImage::SonyElfDefaultRamdiskAddress);
+        bi->setIplAddress(mbp::BootImage::SonyElfDefaultIplAddress);
+        bi->setRpmAddress(mbp::BootImage::SonyElfDefaultRpmAddress);
+        bi->setAppsblAddress(mbp::BootImage::SonyElfDefaultAppsblAddress);
+        bi->setEntrypointAddress(
+                mbp::BootImage::SonyElfDefaultEntrypointAddress);
+        bi->setIplImage(generateData(128 * 1024, 3, 0));
+        bi->setRpmImage(generateData(128 * 1024, 4, 0));
+        bi->setAppsblImage(generateData(512 * 1024, 5, 0));
+        return;
+    }
+
+    bi->setBoardName("bench");
+    bi->setPageSize(mbp::BootImage::AndroidDefaultPageSize);
+    bi->setKernelAddress(mbp::BootImage::AndroidDefaultBase
+            + mbp::BootImage::AndroidDefaultKernelOffset);
+    bi->setRamdiskAddress(mbp::BootImage::AndroidDefaultBase
+            + mbp::BootImage::AndroidDefaultRamdiskOffset);
+    bi->setSecondBootloaderAddress(mbp::BootImage::AndroidDefaultBase
+            + mbp::BootImage::AndroidDefaultSecondOffset);
+    bi->setKernelTagsAddress(mbp::BootImage::AndroidDefaultBase
+            + mbp::BootImage::AndroidDefaultTagsOffset);
+    bi->setDeviceTreeImage(generateData(512 * 1024, 6, 0));
+
+    if (type == mbp::BootImage::Type::Mtk) {
+        bi->setKernelMtkHeader(generateMtkHeader("KERNEL"));
+        bi->setRamdiskMtkHeader(generateMtkHeader("ROOTFS"));
+    } else if (type == mbp::BootImage::Type::Loki) {
+        bi->setAbootImage(aboot);
+    }
+}
+
+static int cpio_open_cb(archive *a, void *userData)
+{
+    (void) a;
+    (void) userData;
+    return ARCHIVE_OK;
+}
+
+static ssize_t cpio_write_cb(archive *a, void *userData,
+                             const void *buf, size_t size)
+{
+    (void) a;
+    auto data = reinterpret_cast<std::vector<unsigned char> *>(userData);
+    auto ptr = reinterpret_cast<const unsigned char *>(buf);
+    data->insert(data->end(), ptr, ptr + size);
+    return size;
+}
+
+static int cpio_close_cb(archive *a, void *userData)
+{
+    (void) a;
+    (void) userData;
+    return ARCHIVE_OK;
+}
+
+bool generateCpio(const std::vector<CpioEntry> &entries,
+                  int (*addFilter)(archive *),
+                  std::vector<unsigned char> *out)
+{
+    std::vector<unsigned char> data;
+
+    archive *a = archive_write_new();
+    archive_write_set_format_cpio_newc(a);
+    if (addFilter(a) != ARCHIVE_OK) {
+        archive_write_free(a);
+        return false;
+    }
+    archive_write_set_bytes_per_block(a, 512);
+
+    if (archive_write_open(a, &data, &cpio_open_cb, &cpio_write_cb,
+                           &cpio_close_cb) != ARCHIVE_OK) {
+        archive_write_free(a);
+        return false;
+    }
+
+    bool ret = true;
+
+    for (auto it = entries.begin(); it != entries.end() && ret; ++it) {
+        archive_entry *entry = archive_entry_new();
+        archive_entry_set_pathname(entry, it->name.c_str());
+        archive_entry_set_perm(entry, it->perms);
+
+        if (!it->symlinkTarget.empty()) {
+            archive_entry_set_filetype(entry, AE_IFLNK);
+            archive_entry_set_symlink(entry, it->symlinkTarget.c_str());
+            ret = archive_write_header(a, entry) == ARCHIVE_OK;
+        } else {
+            archive_entry_set_filetype(entry, AE_IFREG);
+            archive_entry_set_size(entry, it->contents.size());
+            ret = archive_write_header(a, entry) == ARCHIVE_OK
+                    && archive_write_data(a, it->contents.data(),
+                                          it->contents.size())
+                            == static_cast<ssize_t>(it->contents.size());
+        }
+
+        archive_entry_free(entry);
+    }
+
+    if (archive_write_close(a) != ARCHIVE_OK) {
+        ret = false;
+    }
+    archive_write_free(a);
+
+    if (ret) {
+        out->swap(data);
+    }
+    return ret;
+}
+
+static CpioEntry text_entry(const char *name, unsigned int perms,
+                            const std::string &contents)
+{
+    CpioEntry entry;
+    entry.name = name;
+    entry.perms = perms;
+    entry.contents.assign(contents.begin(), contents.end());
+    return entry;
+}
+
+std::vector<CpioEntry> generateRamdiskEntries(std::size_t extraFiles,
+                                              uint64_t seed)
+{
+    Random random(seed);
+    std::vector<CpioEntry> entries;
+
+    CpioEntry init;
+    init.name = "init";
+    init.perms = 0750;
+    init.contents = generateData(1024 * 1024, random.next(), 20);
+    entries.push_back(std::move(init));
+
+    entries.push_back(text_entry("default.prop", 0644,
+            "ro.secure=1\n"
+            "ro.allow.mock.location=0\n"
+            "ro.debuggable=0\n"
+            "persist.sys.usb.config=mtp\n"));
+
+    std::string initRc;
+    for (int i = 0; i < 200; ++i) {
+        initRc += "service svc" + std::to_string(i)
+                + " /system/bin/svc" + std::to_string(i) + "\n"
+                "    class main\n"
+                "    user system\n"
+                "    group system\n\n";
+    }
+    entries.push_back(text_entry("init.rc", 0750, initRc));
+
+    entries.push_back(text_entry("fstab.qcom", 0640,
+            "/dev/block/platform/msm_sdcc.1/by-name/system /system ext4 "
+            "ro,barrier=1 wait\n"
+            "/dev/block/platform/msm_sdcc.1/by-name/cache /cache ext4 "
+            "noatime,nosuid,nodev,barrier=1 wait,check\n"
+            "/dev/block/platform/msm_sdcc.1/by-name/userdata /data ext4 "
+            "noatime,nosuid,nodev,barrier=1 wait,check,encryptable=footer\n"));
+
+    CpioEntry symlink;
+    symlink.name = "sbin/ueventd";
+    symlink.perms = 0777;
+    symlink.symlinkTarget = "../init";
+    entries.push_back(std::move(symlink));
+
+    for (std::size_t i = 0; i < extraFiles; ++i) {
+        CpioEntry entry;
+        entry.name = "sbin/file" + std::to_string(i);
+        entry.perms = 0750;
+        entry.contents = generateData(random.range(16, 16384),
+                                      random.next(), 60);
+        entries.push_back(std::move(entry));
+    }
+
+    return entries;
+}
+
+}
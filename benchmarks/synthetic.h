@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <libmbp/bootimage.h>
+
+struct archive;
+
+
+namespace bench
+{
+
+/*!
+ * \brief Deterministic PRNG (xorshift64*)
+ *
+ * Inputs generated from the same seed are identical across platforms and runs,
+ * so results from different builds can be compared directly.
+ */
+class Random
+{
+public:
+    Random(uint64_t seed);
+
+    uint64_t next();
+    uint64_t range(uint64_t min, uint64_t max);
+
+private:
+    uint64_t m_state;
+};
+
+/*!
+ * \brief Generates data that compresses roughly like real ROM contents
+ *
+ * The output is a mix of runs of repetitive text and runs of random bytes (like
+ * already compressed data). Consecutive calls to fill() continue the same
+ * stream, so large files can be generated in chunks.
+ */
+class DataGenerator
+{
+public:
+    /*!
+     * \param seed PRNG seed
+     * \param textRatio Percentage of the runs that are repetitive text
+     */
+    DataGenerator(uint64_t seed, unsigned int textRatio);
+
+    void fill(unsigned char *buf, std::size_t size);
+
+private:
+    Random m_random;
+    unsigned int m_textRatio;
+    std::size_t m_remaining;
+    bool m_text;
+    const char *m_word;
+};
+
+std::vector<unsigned char> generateData(std::size_t size, uint64_t seed,
+                                        unsigned int textRatio);
+
+std::vector<unsigned char> generateMtkHeader(const char *type);
+
+std::string generateUpdaterScript(std::size_t lines, uint64_t seed);
+
+/*!
+ * \brief Fill in a boot image of the specified type
+ *
+ * The kernel and device tree are random data. \p aboot is only used for Loki
+ * images.
+ */
+void setUpBootImage(mbp::BootImage *bi, mbp::BootImage::Type type,
+                    std::vector<unsigned char> ramdisk,
+                    const std::vector<unsigned char> &aboot);
+
+struct CpioEntry
+{
+    std::string name;
+    unsigned int perms;
+    std::vector<unsigned char> contents;
+    // Creates a symlink instead of a regular file if non-empty
+    std::string symlinkTarget;
+};
+
+/*!
+ * \brief Write a newc cpio archive with the specified libarchive filter
+ *
+ * CpioFile keeps the compression of the archive it loaded, so compressed
+ * archives have to be written with libarchive directly.
+ *
+ * \return Whether the archive was written. Fails if the filter is not supported
+ *         by the libarchive build.
+ */
+bool generateCpio(const std::vector<CpioEntry> &entries,
+                  int (*addFilter)(archive *),
+                  std::vector<unsigned char> *out);
+
+/*!
+ * \brief Generate the entries of a typical ramdisk
+ *
+ * Includes the files that the ramdisk patchers expect (init, default.prop,
+ * init.rc, fstab) along with \p extraFiles filler binaries in sbin/.
+ */
+std::vector<CpioEntry> generateRamdiskEntries(std::size_t extraFiles,
+                                              uint64_t seed);
+
+}
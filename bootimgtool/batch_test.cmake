@@ -0,0 +1,39 @@
+# Runs bootimgtool's batch mode on a small manifest
+#
+# cmake -DBOOTIMGTOOL=<path> -DWORK_DIR=<path> -P batch_test.cmake
+
+if(NOT BOOTIMGTOOL OR NOT WORK_DIR)
+    message(FATAL_ERROR "BOOTIMGTOOL and WORK_DIR must be set")
+endif()
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/items)
+file(WRITE ${WORK_DIR}/items/boot.img-kernel "kernel")
+file(WRITE ${WORK_DIR}/items/boot.img-ramdisk "ramdisk")
+
+function(run_batch manifest_contents)
+    file(WRITE ${WORK_DIR}/jobs.txt "${manifest_contents}")
+    execute_process(
+        COMMAND ${BOOTIMGTOOL} batch -j 1 -m jobs.txt
+        WORKING_DIRECTORY ${WORK_DIR}
+        RESULT_VARIABLE ret
+    )
+    if(NOT ret EQUAL 0)
+        message(FATAL_ERROR "Batch failed (${ret}):\n${manifest_contents}")
+    endif()
+endfunction()
+
+# The output path has no directory component
+run_batch("pack boot.img items\n")
+if(NOT EXISTS ${WORK_DIR}/boot.img)
+    message(FATAL_ERROR "boot.img was not created")
+endif()
+
+run_batch("unpack boot.img unpacked\n")
+foreach(item kernel ramdisk)
+    file(READ ${WORK_DIR}/items/boot.img-${item} expected)
+    file(READ ${WORK_DIR}/unpacked/boot.img-${item} actual)
+    if(NOT actual STREQUAL expected)
+        message(FATAL_ERROR "boot.img-${item} does not match after repacking")
+    endif()
+endforeach()
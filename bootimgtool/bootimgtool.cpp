@@ -17,36 +17,58 @@
  * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
 #include <string>
-#include <unordered_map>
+#include <thread>
+#include <vector>
 
 #include <cassert>
+#include <cinttypes>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
 
 #include <getopt.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <glob.h>
+#endif
 
 #include <libmbpio/directory.h>
 #include <libmbpio/error.h>
+#include <libmbpio/file.h>
+#include <libmbpio/mappedfile.h>
 #include <libmbpio/path.h>
 
 #include <libmbp/bootimage.h>
 #include <libmbp/errors.h>
 #include <libmbp/logging.h>
+#include <libmbp/tracing.h>
 
 
 typedef std::unique_ptr<std::FILE, int (*)(std::FILE *)> file_ptr;
 
 
 static const char MainUsage[] =
-    "Usage: bootimgtool <command> [<args>]\n"
+    "Usage: bootimgtool [--trace <file>] <command> [<args>]\n"
     "\n"
     "Available commands:\n"
     "  unpack         Unpack a boot image\n"
     "  pack           Assemble boot image from unpacked files\n"
+    "  batch          Unpack or pack many boot images in parallel\n"
+    "  info           Print boot image header information\n"
     "\n"
-    "Pass -h/--help as a argument to a command to see it's available options.\n";
+    "Pass -h/--help as a argument to a command to see it's available options.\n"
+    "\n"
+    "Global options:\n"
+    "  --trace <file>  Record libmbp trace spans and write them to <file> in the\n"
+    "                  Chrome trace event format (chrome://tracing, Perfetto)\n";
 
 static const char UnpackUsage[] =
     "Usage: bootimgtool unpack [input file] [options]\n"
@@ -207,6 +229,73 @@ static const char PackUsage[] =
     "\n"
     "        bootimgtool pack boot.img -i /tmp/android --input-kernel /tmp/newkernel\n";
 
+static const char BatchUsage[] =
+    "Usage: bootimgtool batch [options] [input file]...\n"
+    "\n"
+    "Options:\n"
+    "  -m, --manifest [manifest file]\n"
+    "                  Read jobs from a manifest file (\"-\" for stdin)\n"
+    "  -o, --output [output directory]\n"
+    "                  Output directory for input files given on the command\n"
+    "                  line (current directory if unspecified)\n"
+    "  -j, --jobs [count]\n"
+    "                  Number of images to process in parallel (number of CPUs\n"
+    "                  if unspecified)\n"
+    "  -v, --verbose   Print libmbp log messages\n"
+    "\n"
+    "Each input file given on the command line is unpacked into the output\n"
+    "directory. Wildcards are expanded, so quoted patterns like \"*.img\" can be\n"
+    "passed without hitting the shell's argument length limit.\n"
+    "\n"
+    "Manifest format:\n"
+    "\n"
+    "One job per line. Empty lines and lines beginning with '#' are ignored.\n"
+    "\n"
+    "    unpack [input file or pattern] [output directory]\n"
+    "    pack [output file] [input directory] [type]\n"
+    "\n"
+    "The item files use the same naming as the \"unpack\" and \"pack\" commands\n"
+    "with their default prefix: [directory]/[image filename]-[item]. The type\n"
+    "for \"pack\" defaults to \"android\". For loki images, the aboot image is\n"
+    "loaded from [input directory]/[image filename]-aboot.\n"
+    "\n"
+    "The time taken for each image and the total throughput are printed once\n"
+    "all jobs have finished.\n"
+    "\n"
+    "Examples:\n"
+    "\n"
+    "1. Unpack all boot images in a directory using 8 threads\n"
+    "\n"
+    "        bootimgtool batch -j 8 -o extracted 'images/*.img'\n"
+    "\n"
+    "2. Run the jobs listed in a manifest\n"
+    "\n"
+    "        bootimgtool batch -m jobs.txt\n";
+
+static const char InfoUsage[] =
+    "Usage: bootimgtool info [options] [input file]...\n"
+    "\n"
+    "Options:\n"
+    "  -f, --format [format]\n"
+    "                  Output format [text, json] (text if unspecified)\n"
+    "  -v, --verbose   Print libmbp log messages\n"
+    "\n"
+    "Only the boot image headers are read. The images themselves (eg. kernel and\n"
+    "ramdisk) are not loaded, so listing a large number of boot images is fast.\n"
+    "\n"
+    "The text format prints one \"key=value\" pair per line with a blank line\n"
+    "between boot images. Each image is listed as \"section.[item]=[offset],[size]\".\n"
+    "The json format prints an array with one object per boot image.\n"
+    "\n"
+    "Files that cannot be parsed are reported on stderr and the exit status will\n"
+    "be non-zero.\n"
+    "\n"
+    "Examples:\n"
+    "\n"
+    "1. Print the page size of all boot images in a directory\n"
+    "\n"
+    "        bootimgtool info images/*.img | grep page_size\n";
+
 
 static std::string error_to_string(const mbp::ErrorCode &error) {
     switch (error) {
@@ -286,47 +375,138 @@ static bool write_file_fmt(const std::string &path, const char *fmt, ...)
 
 }
 
+static std::string errno_to_string(const std::string &path)
+{
+    return path + ": " + strerror(errno);
+}
+
+static bool file_size(const std::string &path, uint64_t *size)
+{
+    struct stat sb;
+    if (stat(path.c_str(), &sb) < 0) {
+        return false;
+    }
+    *size = sb.st_size;
+    return true;
+}
+
 static bool write_file_data(const std::string &path,
-                            const void *data, std::size_t size)
+                            const unsigned char *data, std::size_t size,
+                            std::string *error)
 {
-    file_ptr fp(fopen(path.c_str(), "wb"), fclose);
-    if (!fp) {
+    io::File file;
+    if (!file.open(path, io::File::OpenWrite)) {
+        *error = path + ": " + file.errorString();
+        return false;
+    }
+
+    // Not all filesystems support preallocation, so this is just a hint
+    file.preallocate(size);
+
+    uint64_t bytesWritten;
+    if (size > 0 && !file.write(data, size, &bytesWritten)) {
+        *error = path + ": " + file.errorString();
         return false;
     }
 
-    if (fwrite(data, 1, size, fp.get()) != size && ferror(fp.get())) {
+    if (!file.close()) {
+        *error = path + ": " + file.errorString();
         return false;
     }
 
     return true;
 }
 
-static bool write_file_data(const std::string &path,
-                            const std::vector<unsigned char> &data)
+static bool read_file_uint32(const std::string &path, bool hex,
+                             uint32_t default_value, uint32_t *out,
+                             std::string *error)
 {
-    return write_file_data(path, data.data(), data.size());
+    file_ptr fp(fopen(path.c_str(), "rb"), fclose);
+    if (!fp) {
+        if (errno != ENOENT) {
+            *error = errno_to_string(path);
+            return false;
+        }
+        *out = default_value;
+        return true;
+    }
+
+    int count = hex ? fscanf(fp.get(), "%08x", out)
+            : fscanf(fp.get(), "%u", out);
+    if (count == EOF && ferror(fp.get())) {
+        *error = errno_to_string(path);
+        return false;
+    } else if (count != 1) {
+        *error = path + ": Error: expected '"
+                + (hex ? "%08x" : "%u") + "' format";
+        return false;
+    }
+
+    return true;
 }
 
-static bool read_file_data(const std::string &path,
-                           std::vector<unsigned char> *out)
+static bool read_file_string(const std::string &path, std::size_t max_size,
+                             const char *default_value, std::string *out,
+                             std::string *error)
 {
     file_ptr fp(fopen(path.c_str(), "rb"), fclose);
     if (!fp) {
-        return false;
+        if (errno != ENOENT) {
+            *error = errno_to_string(path);
+            return false;
+        }
+        *out = default_value;
+        return true;
+    }
+
+    std::vector<char> buf(max_size + 1);
+    if (!fgets(buf.data(), buf.size(), fp.get())) {
+        if (ferror(fp.get())) {
+            *error = errno_to_string(path);
+            return false;
+        }
+    }
+
+    *out = buf.data();
+    auto pos = out->find('\n');
+    if (pos != std::string::npos) {
+        out->erase(pos);
     }
 
-    fseek(fp.get(), 0, SEEK_END);
-    std::size_t size = ftell(fp.get());
-    rewind(fp.get());
+    return true;
+}
 
-    std::vector<unsigned char> data(size);
+/*!
+ * \brief Map an item file and pass its contents to a BootImage setter
+ *
+ * \p map is owned by the caller so that it can be reused for every item. The
+ * setter copies the data, so the file is unmapped before returning.
+ */
+static bool load_file_data(io::MappedFile *map, const std::string &path,
+                           bool required, mbp::BootImage *bi,
+                           void (mbp::BootImage::*set)(const unsigned char *,
+                                                       std::size_t),
+                           std::string *error)
+{
+    uint64_t size;
+    if (!file_size(path, &size)) {
+        if (errno != ENOENT || required) {
+            *error = errno_to_string(path);
+            return false;
+        }
+        (bi->*set)(nullptr, 0);
+        return true;
+    }
 
-    auto nread = fread(data.data(), 1, size, fp.get());
-    if (nread != size) {
+    if (!map->map(path, io::MappedFile::MapRead)) {
+        *error = path + ": " + map->errorString();
         return false;
     }
+    map->advise(io::MappedFile::AdviceSequential);
 
-    data.swap(*out);
+    (bi->*set)(map->data(), map->size());
+
+    map->unmap();
     return true;
 }
 
@@ -345,6 +525,424 @@ static bool str_to_uint32(uint32_t *out, const char *str, int base = 0)
     return true;
 }
 
+static bool parse_type(const std::string &str, mbp::BootImage::Type *type)
+{
+    if (str == "android") {
+        *type = mbp::BootImage::Type::Android;
+    } else if (str == "bump") {
+        *type = mbp::BootImage::Type::Bump;
+    } else if (str == "loki") {
+        *type = mbp::BootImage::Type::Loki;
+    } else if (str == "mtk") {
+        *type = mbp::BootImage::Type::Mtk;
+    } else if (str == "sonyelf") {
+        *type = mbp::BootImage::Type::SonyElf;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Unpacking and packing a single image
+////////////////////////////////////////////////////////////////////////////////
+
+// Paths to the item files. Used by the "unpack", "pack" and "batch" commands.
+struct ItemPaths
+{
+    std::string cmdline;
+    std::string board;
+    std::string base;
+    std::string kernel_offset;
+    std::string ramdisk_offset;
+    std::string second_offset;
+    std::string tags_offset;
+    std::string ipl_address;
+    std::string rpm_address;
+    std::string appsbl_address;
+    std::string entrypoint;
+    std::string page_size;
+    std::string kernel;
+    std::string ramdisk;
+    std::string second;
+    std::string dt;
+    std::string aboot;
+    std::string kernel_mtkhdr;
+    std::string ramdisk_mtkhdr;
+    std::string ipl;
+    std::string rpm;
+    std::string appsbl;
+    std::string sin;
+    std::string sinhdr;
+};
+
+// Item values given directly with the "pack" command's --value-* options
+struct ItemValues
+{
+    bool has_cmdline = false;
+    bool has_board = false;
+    bool has_base = false;
+    bool has_kernel_offset = false;
+    bool has_ramdisk_offset = false;
+    bool has_second_offset = false;
+    bool has_tags_offset = false;
+    bool has_ipl_address = false;
+    bool has_rpm_address = false;
+    bool has_appsbl_address = false;
+    bool has_entrypoint = false;
+    bool has_page_size = false;
+
+    std::string cmdline;
+    std::string board;
+    uint32_t base = 0;
+    uint32_t kernel_offset = 0;
+    uint32_t ramdisk_offset = 0;
+    uint32_t second_offset = 0;
+    uint32_t tags_offset = 0;
+    uint32_t ipl_address = 0;
+    uint32_t rpm_address = 0;
+    uint32_t appsbl_address = 0;
+    uint32_t entrypoint = 0;
+    uint32_t page_size = 0;
+};
+
+struct DataItem
+{
+    const char *name;
+    uint64_t flag;
+    std::string ItemPaths::*path;
+    // nullptr if the item is never unpacked
+    void (mbp::BootImage::*get)(const unsigned char **, std::size_t *) const;
+    void (mbp::BootImage::*set)(const unsigned char *, std::size_t);
+    // Whether the item file must exist when packing
+    bool required;
+};
+
+static const DataItem DataItems[] = {
+    { "kernel",         SUPPORTS_KERNEL_IMAGE,    &ItemPaths::kernel,
+      &mbp::BootImage::kernelImageC,
+      &mbp::BootImage::setKernelImageC,            true  },
+    { "ramdisk",        SUPPORTS_RAMDISK_IMAGE,   &ItemPaths::ramdisk,
+      &mbp::BootImage::ramdiskImageC,
+      &mbp::BootImage::setRamdiskImageC,           true  },
+    { "second",         SUPPORTS_SECOND_IMAGE,    &ItemPaths::second,
+      &mbp::BootImage::secondBootloaderImageC,
+      &mbp::BootImage::setSecondBootloaderImageC,  false },
+    { "dt",             SUPPORTS_DT_IMAGE,        &ItemPaths::dt,
+      &mbp::BootImage::deviceTreeImageC,
+      &mbp::BootImage::setDeviceTreeImageC,        false },
+    { "aboot",          SUPPORTS_ABOOT_IMAGE,     &ItemPaths::aboot,
+      nullptr,
+      &mbp::BootImage::setAbootImageC,             true  },
+    { "kernel_mtkhdr",  SUPPORTS_KERNEL_MTKHDR,   &ItemPaths::kernel_mtkhdr,
+      &mbp::BootImage::kernelMtkHeaderC,
+      &mbp::BootImage::setKernelMtkHeaderC,        true  },
+    { "ramdisk_mtkhdr", SUPPORTS_RAMDISK_MTKHDR,  &ItemPaths::ramdisk_mtkhdr,
+      &mbp::BootImage::ramdiskMtkHeaderC,
+      &mbp::BootImage::setRamdiskMtkHeaderC,       true  },
+    { "ipl",            SUPPORTS_IPL_IMAGE,       &ItemPaths::ipl,
+      &mbp::BootImage::iplImageC,
+      &mbp::BootImage::setIplImageC,               false },
+    { "rpm",            SUPPORTS_RPM_IMAGE,       &ItemPaths::rpm,
+      &mbp::BootImage::rpmImageC,
+      &mbp::BootImage::setRpmImageC,               false },
+    { "appsbl",         SUPPORTS_APPSBL_IMAGE,    &ItemPaths::appsbl,
+      &mbp::BootImage::appsblImageC,
+      &mbp::BootImage::setAppsblImageC,            false },
+    { "sin",            SUPPORTS_SONY_SIN_IMAGE,  &ItemPaths::sin,
+      &mbp::BootImage::sinImageC,
+      &mbp::BootImage::setSinImageC,               false },
+    { "sinhdr",         SUPPORTS_SONY_SIN_HEADER, &ItemPaths::sinhdr,
+      &mbp::BootImage::sinHeaderC,
+      &mbp::BootImage::setSinHeaderC,              false },
+};
+
+/*!
+ * \brief Set empty paths to [directory]/[prefix][item]
+ *
+ * The aboot image is only an input for loki images and is left alone.
+ */
+static void default_item_paths(ItemPaths *paths, const std::string &dir,
+                               const std::string &prefix)
+{
+#define DEFAULT_PATH(item) \
+    if (paths->item.empty()) { \
+        paths->item = io::pathJoin({dir, prefix + #item}); \
+    }
+
+    DEFAULT_PATH(cmdline);
+    DEFAULT_PATH(board);
+    DEFAULT_PATH(base);
+    DEFAULT_PATH(kernel_offset);
+    DEFAULT_PATH(ramdisk_offset);
+    DEFAULT_PATH(second_offset);
+    DEFAULT_PATH(tags_offset);
+    DEFAULT_PATH(ipl_address);
+    DEFAULT_PATH(rpm_address);
+    DEFAULT_PATH(appsbl_address);
+    DEFAULT_PATH(entrypoint);
+    DEFAULT_PATH(page_size);
+
+#undef DEFAULT_PATH
+
+    for (const DataItem &item : DataItems) {
+        if (item.get && (paths->*item.path).empty()) {
+            paths->*item.path = io::pathJoin({dir, prefix + item.name});
+        }
+    }
+}
+
+/*!
+ * \brief Unpack the items of a boot image
+ *
+ * All paths in \p paths must be set. Only the items supported by the boot
+ * image's type are written. If \p verbose is true, the output files are
+ * listed on stdout.
+ */
+static bool unpack_image(const std::string &input_file, const ItemPaths &paths,
+                         bool verbose, std::string *error)
+{
+    // BootImage::loadFile() memory maps the input file
+    mbp::BootImage bi;
+    if (!bi.loadFile(input_file)) {
+        *error = input_file + ": " + error_to_string(bi.error());
+        return false;
+    }
+
+    uint64_t supportMask = mbp::BootImage::typeSupportMask(bi.wasType());
+
+    if (verbose) {
+        printf("\nOutput files:\n");
+#define PRINT_IF(supported, fmt, ...) \
+        if (supportMask & (supported)) { \
+            printf(fmt, __VA_ARGS__); \
+        }
+        PRINT_IF(SUPPORTS_CMDLINE,         "- cmdline:        %s\n", paths.cmdline.c_str());
+        PRINT_IF(SUPPORTS_BOARD_NAME,      "- board:          %s\n", paths.board.c_str());
+        PRINT_IF(SUPPORTS_OFFSET_BASE,     "- base:           %s\n", paths.base.c_str());
+        PRINT_IF(SUPPORTS_KERNEL_ADDRESS,  "- kernel_offset:  %s\n", paths.kernel_offset.c_str());
+        PRINT_IF(SUPPORTS_RAMDISK_ADDRESS, "- ramdisk_offset: %s\n", paths.ramdisk_offset.c_str());
+        PRINT_IF(SUPPORTS_SECOND_ADDRESS,  "- second_offset:  %s\n", paths.second_offset.c_str());
+        PRINT_IF(SUPPORTS_TAGS_ADDRESS,    "- tags_offset:    %s\n", paths.tags_offset.c_str());
+        PRINT_IF(SUPPORTS_IPL_ADDRESS,     "- ipl_address:    %s\n", paths.ipl_address.c_str());
+        PRINT_IF(SUPPORTS_RPM_ADDRESS,     "- rpm_address:    %s\n", paths.rpm_address.c_str());
+        PRINT_IF(SUPPORTS_APPSBL_ADDRESS,  "- appsbl_address: %s\n", paths.appsbl_address.c_str());
+        PRINT_IF(SUPPORTS_ENTRYPOINT,      "- entrypoint:     %s\n", paths.entrypoint.c_str());
+        PRINT_IF(SUPPORTS_PAGE_SIZE,       "- page_size:      %s\n", paths.page_size.c_str());
+#undef PRINT_IF
+
+        for (const DataItem &item : DataItems) {
+            if (item.get && (supportMask & item.flag)) {
+                printf("- %-15s %s\n", (std::string(item.name) + ":").c_str(),
+                       (paths.*item.path).c_str());
+            }
+        }
+    }
+
+    /* Extract all the stuff! */
+
+    // Use base relative to the default kernel offset
+    uint32_t base = bi.kernelAddress() - mbp::BootImage::AndroidDefaultKernelOffset;
+    uint32_t kernel_offset = mbp::BootImage::AndroidDefaultKernelOffset;
+    uint32_t ramdisk_offset = bi.ramdiskAddress() - base;
+    uint32_t second_offset = bi.secondBootloaderAddress() - base;
+    uint32_t tags_offset = bi.kernelTagsAddress() - base;
+
+#define WRITE_FILE_FMT(supported, path, fmt, ...) \
+    if ((supportMask & (supported)) && !write_file_fmt(path, fmt, __VA_ARGS__)) { \
+        *error = errno_to_string(path); \
+        return false; \
+    }
+
+    WRITE_FILE_FMT(SUPPORTS_CMDLINE,         paths.cmdline,        "%s\n", bi.kernelCmdlineC());
+    WRITE_FILE_FMT(SUPPORTS_BOARD_NAME,      paths.board,          "%s\n", bi.boardNameC());
+    WRITE_FILE_FMT(SUPPORTS_OFFSET_BASE,     paths.base,           "%08x\n", base);
+    WRITE_FILE_FMT(SUPPORTS_KERNEL_ADDRESS,  paths.kernel_offset,  "%08x\n", kernel_offset);
+    WRITE_FILE_FMT(SUPPORTS_RAMDISK_ADDRESS, paths.ramdisk_offset, "%08x\n", ramdisk_offset);
+    WRITE_FILE_FMT(SUPPORTS_SECOND_ADDRESS,  paths.second_offset,  "%08x\n", second_offset);
+    WRITE_FILE_FMT(SUPPORTS_TAGS_ADDRESS,    paths.tags_offset,    "%08x\n", tags_offset);
+    WRITE_FILE_FMT(SUPPORTS_IPL_ADDRESS,     paths.ipl_address,    "%08x\n", bi.iplAddress());
+    WRITE_FILE_FMT(SUPPORTS_RPM_ADDRESS,     paths.rpm_address,    "%08x\n", bi.rpmAddress());
+    WRITE_FILE_FMT(SUPPORTS_APPSBL_ADDRESS,  paths.appsbl_address, "%08x\n", bi.appsblAddress());
+    WRITE_FILE_FMT(SUPPORTS_ENTRYPOINT,      paths.entrypoint,     "%08x\n", bi.entrypointAddress());
+    WRITE_FILE_FMT(SUPPORTS_PAGE_SIZE,       paths.page_size,      "%u\n", bi.pageSize());
+
+#undef WRITE_FILE_FMT
+
+    for (const DataItem &item : DataItems) {
+        if (!item.get || !(supportMask & item.flag)) {
+            continue;
+        }
+
+        const unsigned char *data;
+        std::size_t size;
+        (bi.*item.get)(&data, &size);
+
+        if (!write_file_data(paths.*item.path, data, size, error)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Create a boot image from its items
+ *
+ * Items in \p values take precedence over the item files. Empty paths in
+ * \p paths are set to [input_dir]/[prefix][item], except for the aboot image,
+ * which must be given explicitly for loki images. \p map is used for mapping
+ * the data item files. If \p verbose is true, the item sources are listed on
+ * stdout.
+ */
+static bool pack_image(const std::string &output_file,
+                       mbp::BootImage::Type type,
+                       const std::string &input_dir, const std::string &prefix,
+                       ItemPaths paths, const ItemValues &values,
+                       io::MappedFile *map, bool verbose, std::string *error)
+{
+    static const char *not_supported =
+            "Warning: Target type does not support %s\n";
+    static const char *fmt_path   = "- %-14s (path)  %s\n";
+    static const char *fmt_string = "- %-14s (value) %s\n";
+    static const char *fmt_hex    = "- %-14s (value) 0x%08x\n";
+    static const char *fmt_uint   = "- %-14s (value) %u\n";
+
+    bool sony = type == mbp::BootImage::Type::SonyElf;
+    uint64_t supportMask = mbp::BootImage::typeSupportMask(type);
+
+    mbp::BootImage bi;
+    std::string str;
+    uint32_t base = 0;
+    uint32_t value;
+
+    // Take an item from its value, its file or its default value (in that
+    // order) and pass it to the setter in __VA_ARGS__
+#define PACK_ITEM(supported, item, var, fmt_value, print_arg, read, ...) \
+    if (supportMask & (supported)) { \
+        if (values.has_##item) { \
+            var = values.item; \
+            if (verbose) { \
+                printf(fmt_value, #item, print_arg); \
+            } \
+        } else { \
+            if (paths.item.empty()) { \
+                paths.item = io::pathJoin({input_dir, prefix + #item}); \
+            } \
+            if (verbose) { \
+                printf(fmt_path, #item, paths.item.c_str()); \
+            } \
+            if (!(read)) { \
+                return false; \
+            } \
+        } \
+        __VA_ARGS__; \
+    } else { \
+        if (!paths.item.empty()) { \
+            printf(not_supported, "--input-" #item); \
+        } \
+        if (values.has_##item) { \
+            printf(not_supported, "--value-" #item); \
+        } \
+    }
+
+#define PACK_STRING(supported, item, max_size, default_value, ...) \
+    PACK_ITEM(supported, item, str, fmt_string, str.c_str(), \
+              read_file_string(paths.item, max_size, default_value, \
+                               &str, error), \
+              __VA_ARGS__)
+
+#define PACK_UINT32(supported, item, hex, default_value, ...) \
+    PACK_ITEM(supported, item, value, hex ? fmt_hex : fmt_uint, value, \
+              read_file_uint32(paths.item, hex, default_value, \
+                               &value, error), \
+              __VA_ARGS__)
+
+    PACK_STRING(SUPPORTS_CMDLINE, cmdline,
+                mbp::BootImage::AndroidBootArgsSize,
+                mbp::BootImage::DefaultCmdline,
+                bi.setKernelCmdline(std::move(str)));
+    PACK_STRING(SUPPORTS_BOARD_NAME, board,
+                mbp::BootImage::AndroidBootNameSize,
+                mbp::BootImage::AndroidDefaultBoard,
+                bi.setBoardName(std::move(str)));
+
+    // Sony ELF boot images use absolute addresses
+    PACK_UINT32(SUPPORTS_OFFSET_BASE, base, true,
+                sony ? 0 : mbp::BootImage::AndroidDefaultBase,
+                base = value);
+    PACK_UINT32(SUPPORTS_KERNEL_ADDRESS, kernel_offset, true,
+                sony ? mbp::BootImage::SonyElfDefaultKernelAddress
+                        : mbp::BootImage::AndroidDefaultKernelOffset,
+                bi.setKernelAddress(base + value));
+    PACK_UINT32(SUPPORTS_RAMDISK_ADDRESS, ramdisk_offset, true,
+                sony ? mbp::BootImage::SonyElfDefaultRamdiskAddress
+                        : mbp::BootImage::AndroidDefaultRamdiskOffset,
+                bi.setRamdiskAddress(base + value));
+    PACK_UINT32(SUPPORTS_SECOND_ADDRESS, second_offset, true,
+                mbp::BootImage::AndroidDefaultSecondOffset,
+                bi.setSecondBootloaderAddress(base + value));
+    PACK_UINT32(SUPPORTS_TAGS_ADDRESS, tags_offset, true,
+                mbp::BootImage::AndroidDefaultTagsOffset,
+                bi.setKernelTagsAddress(base + value));
+    PACK_UINT32(SUPPORTS_IPL_ADDRESS, ipl_address, true,
+                mbp::BootImage::SonyElfDefaultIplAddress,
+                bi.setIplAddress(value));
+    PACK_UINT32(SUPPORTS_RPM_ADDRESS, rpm_address, true,
+                mbp::BootImage::SonyElfDefaultRpmAddress,
+                bi.setRpmAddress(value));
+    PACK_UINT32(SUPPORTS_APPSBL_ADDRESS, appsbl_address, true,
+                mbp::BootImage::SonyElfDefaultAppsblAddress,
+                bi.setAppsblAddress(value));
+    PACK_UINT32(SUPPORTS_ENTRYPOINT, entrypoint, true,
+                mbp::BootImage::SonyElfDefaultEntrypointAddress,
+                bi.setEntrypointAddress(value));
+    PACK_UINT32(SUPPORTS_PAGE_SIZE, page_size, false,
+                mbp::BootImage::AndroidDefaultPageSize,
+                bi.setPageSize(value));
+
+#undef PACK_UINT32
+#undef PACK_STRING
+#undef PACK_ITEM
+
+    for (const DataItem &item : DataItems) {
+        std::string &path = paths.*item.path;
+
+        if (!(supportMask & item.flag)) {
+            if (!path.empty()) {
+                printf(not_supported, ("--input-" + std::string(item.name)).c_str());
+            }
+            continue;
+        }
+
+        if (path.empty()) {
+            // The aboot image is never unpacked, so there is no default path
+            if (!item.get) {
+                *error = "An aboot image must be specified to create a loki image";
+                return false;
+            }
+            path = io::pathJoin({input_dir, prefix + item.name});
+        }
+
+        if (verbose) {
+            printf(fmt_path, item.name, path.c_str());
+        }
+
+        if (!load_file_data(map, path, item.required, &bi, item.set, error)) {
+            return false;
+        }
+    }
+
+    bi.setTargetType(type);
+
+    if (!bi.createFile(output_file)) {
+        *error = output_file + ": " + error_to_string(bi.error());
+        return false;
+    }
+
+    return true;
+}
+
 bool unpack_main(int argc, char *argv[])
 {
     int opt;
@@ -352,29 +950,7 @@ bool unpack_main(int argc, char *argv[])
     std::string input_file;
     std::string output_dir;
     std::string prefix;
-    std::string path_cmdline;
-    std::string path_board;
-    std::string path_base;
-    std::string path_kernel_offset;
-    std::string path_ramdisk_offset;
-    std::string path_second_offset;
-    std::string path_tags_offset;
-    std::string path_ipl_address;
-    std::string path_rpm_address;
-    std::string path_appsbl_address;
-    std::string path_entrypoint;
-    std::string path_page_size;
-    std::string path_kernel;
-    std::string path_ramdisk;
-    std::string path_second;
-    std::string path_dt;
-    std::string path_kernel_mtkhdr;
-    std::string path_ramdisk_mtkhdr;
-    std::string path_ipl;
-    std::string path_rpm;
-    std::string path_appsbl;
-    std::string path_sin;
-    std::string path_sinhdr;
+    ItemPaths paths;
 
     // Arguments with no short options
     enum unpack_options : int
@@ -440,32 +1016,32 @@ bool unpack_main(int argc, char *argv[])
 
     while ((opt = getopt_long(argc, argv, "o:p:n", long_options, &long_index)) != -1) {
         switch (opt) {
-        case 'o':                       output_dir = optarg;          break;
-        case 'p':                       prefix = optarg;              break;
-        case 'n':                       no_prefix = true;             break;
-        case OPT_OUTPUT_CMDLINE:        path_cmdline = optarg;        break;
-        case OPT_OUTPUT_BOARD:          path_board = optarg;          break;
-        case OPT_OUTPUT_BASE:           path_base = optarg;           break;
-        case OPT_OUTPUT_KERNEL_OFFSET:  path_kernel_offset = optarg;  break;
-        case OPT_OUTPUT_RAMDISK_OFFSET: path_ramdisk_offset = optarg; break;
-        case OPT_OUTPUT_SECOND_OFFSET:  path_second_offset = optarg;  break;
-        case OPT_OUTPUT_TAGS_OFFSET:    path_tags_offset = optarg;    break;
-        case OPT_OUTPUT_IPL_ADDRESS:    path_ipl_address = optarg;    break;
-        case OPT_OUTPUT_RPM_ADDRESS:    path_rpm_address = optarg;    break;
-        case OPT_OUTPUT_APPSBL_ADDRESS: path_appsbl_address = optarg; break;
-        case OPT_OUTPUT_ENTRYPOINT:     path_entrypoint = optarg;     break;
-        case OPT_OUTPUT_PAGE_SIZE:      path_page_size = optarg;      break;
-        case OPT_OUTPUT_KERNEL:         path_kernel = optarg;         break;
-        case OPT_OUTPUT_RAMDISK:        path_ramdisk = optarg;        break;
-        case OPT_OUTPUT_SECOND:         path_second = optarg;         break;
-        case OPT_OUTPUT_DT:             path_dt = optarg;             break;
-        case OPT_OUTPUT_KERNEL_MTKHDR:  path_kernel_mtkhdr = optarg;  break;
-        case OPT_OUTPUT_RAMDISK_MTKHDR: path_ramdisk_mtkhdr = optarg; break;
-        case OPT_OUTPUT_IPL:            path_ipl = optarg;            break;
-        case OPT_OUTPUT_RPM:            path_rpm = optarg;            break;
-        case OPT_OUTPUT_APPSBL:         path_appsbl = optarg;         break;
-        case OPT_OUTPUT_SIN:            path_sin = optarg;            break;
-        case OPT_OUTPUT_SINHDR:         path_sinhdr = optarg;         break;
+        case 'o':                       output_dir = optarg;           break;
+        case 'p':                       prefix = optarg;               break;
+        case 'n':                       no_prefix = true;              break;
+        case OPT_OUTPUT_CMDLINE:        paths.cmdline = optarg;        break;
+        case OPT_OUTPUT_BOARD:          paths.board = optarg;          break;
+        case OPT_OUTPUT_BASE:           paths.base = optarg;           break;
+        case OPT_OUTPUT_KERNEL_OFFSET:  paths.kernel_offset = optarg;  break;
+        case OPT_OUTPUT_RAMDISK_OFFSET: paths.ramdisk_offset = optarg; break;
+        case OPT_OUTPUT_SECOND_OFFSET:  paths.second_offset = optarg;  break;
+        case OPT_OUTPUT_TAGS_OFFSET:    paths.tags_offset = optarg;    break;
+        case OPT_OUTPUT_IPL_ADDRESS:    paths.ipl_address = optarg;    break;
+        case OPT_OUTPUT_RPM_ADDRESS:    paths.rpm_address = optarg;    break;
+        case OPT_OUTPUT_APPSBL_ADDRESS: paths.appsbl_address = optarg; break;
+        case OPT_OUTPUT_ENTRYPOINT:     paths.entrypoint = optarg;     break;
+        case OPT_OUTPUT_PAGE_SIZE:      paths.page_size = optarg;      break;
+        case OPT_OUTPUT_KERNEL:         paths.kernel = optarg;         break;
+        case OPT_OUTPUT_RAMDISK:        paths.ramdisk = optarg;        break;
+        case OPT_OUTPUT_SECOND:         paths.second = optarg;         break;
+        case OPT_OUTPUT_DT:             paths.dt = optarg;             break;
+        case OPT_OUTPUT_KERNEL_MTKHDR:  paths.kernel_mtkhdr = optarg;  break;
+        case OPT_OUTPUT_RAMDISK_MTKHDR: paths.ramdisk_mtkhdr = optarg; break;
+        case OPT_OUTPUT_IPL:            paths.ipl = optarg;            break;
+        case OPT_OUTPUT_RPM:            paths.rpm = optarg;            break;
+        case OPT_OUTPUT_APPSBL:         paths.appsbl = optarg;         break;
+        case OPT_OUTPUT_SIN:            paths.sin = optarg;            break;
+        case OPT_OUTPUT_SINHDR:         paths.sinhdr = optarg;         break;
 
         case 'h':
             fprintf(stdout, UnpackUsage);
@@ -498,52 +1074,7 @@ bool unpack_main(int argc, char *argv[])
         output_dir = ".";
     }
 
-    if (path_cmdline.empty())
-        path_cmdline = io::pathJoin({output_dir, prefix + "cmdline"});
-    if (path_board.empty())
-        path_board = io::pathJoin({output_dir, prefix + "board"});
-    if (path_base.empty())
-        path_base = io::pathJoin({output_dir, prefix + "base"});
-    if (path_kernel_offset.empty())
-        path_kernel_offset = io::pathJoin({output_dir, prefix + "kernel_offset"});
-    if (path_ramdisk_offset.empty())
-        path_ramdisk_offset = io::pathJoin({output_dir, prefix + "ramdisk_offset"});
-    if (path_second_offset.empty())
-        path_second_offset = io::pathJoin({output_dir, prefix + "second_offset"});
-    if (path_tags_offset.empty())
-        path_tags_offset = io::pathJoin({output_dir, prefix + "tags_offset"});
-    if (path_ipl_address.empty())
-        path_ipl_address = io::pathJoin({output_dir, prefix + "ipl_address"});
-    if (path_rpm_address.empty())
-        path_rpm_address = io::pathJoin({output_dir, prefix + "rpm_address"});
-    if (path_appsbl_address.empty())
-        path_appsbl_address = io::pathJoin({output_dir, prefix + "appsbl_address"});
-    if (path_entrypoint.empty())
-        path_entrypoint = io::pathJoin({output_dir, prefix + "entrypoint"});
-    if (path_page_size.empty())
-        path_page_size = io::pathJoin({output_dir, prefix + "page_size"});
-    if (path_kernel.empty())
-        path_kernel = io::pathJoin({output_dir, prefix + "kernel"});
-    if (path_ramdisk.empty())
-        path_ramdisk = io::pathJoin({output_dir, prefix + "ramdisk"});
-    if (path_second.empty())
-        path_second = io::pathJoin({output_dir, prefix + "second"});
-    if (path_dt.empty())
-        path_dt = io::pathJoin({output_dir, prefix + "dt"});
-    if (path_kernel_mtkhdr.empty())
-        path_kernel_mtkhdr = io::pathJoin({output_dir, prefix + "kernel_mtkhdr"});
-    if (path_ramdisk_mtkhdr.empty())
-        path_ramdisk_mtkhdr = io::pathJoin({output_dir, prefix + "ramdisk_mtkhdr"});
-    if (path_ipl.empty())
-        path_ipl = io::pathJoin({output_dir, prefix + "ipl"});
-    if (path_rpm.empty())
-        path_rpm = io::pathJoin({output_dir, prefix + "rpm"});
-    if (path_appsbl.empty())
-        path_appsbl = io::pathJoin({output_dir, prefix + "appsbl"});
-    if (path_sin.empty())
-        path_sin = io::pathJoin({output_dir, prefix + "sin"});
-    if (path_sinhdr.empty())
-        path_sinhdr = io::pathJoin({output_dir, prefix + "sinhdr"});
+    default_item_paths(&paths, output_dir, prefix);
 
     if (!io::createDirectories(output_dir)) {
         fprintf(stderr, "%s: Failed to create directory: %s\n",
@@ -551,184 +1082,12 @@ bool unpack_main(int argc, char *argv[])
         return false;
     }
 
-    // Load the boot image
-    mbp::BootImage bi;
-    if (!bi.loadFile(input_file)) {
-        fprintf(stderr, "%s\n", error_to_string(bi.error()).c_str());
+    std::string error;
+    if (!unpack_image(input_file, paths, true, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
         return false;
     }
 
-    uint64_t supportMask = mbp::BootImage::typeSupportMask(bi.wasType());
-    printf("\nOutput files:\n");
-#define PRINT_IF(supported, fmt, ...) \
-    if (supportMask & (supported)) { \
-        printf(fmt, __VA_ARGS__); \
-    }
-    PRINT_IF(SUPPORTS_CMDLINE,         "- cmdline:        %s\n", path_cmdline.c_str());
-    PRINT_IF(SUPPORTS_BOARD_NAME,      "- board:          %s\n", path_board.c_str());
-    PRINT_IF(SUPPORTS_OFFSET_BASE,     "- base:           %s\n", path_base.c_str());
-    PRINT_IF(SUPPORTS_KERNEL_ADDRESS,  "- kernel_offset:  %s\n", path_kernel_offset.c_str());
-    PRINT_IF(SUPPORTS_RAMDISK_ADDRESS, "- ramdisk_offset: %s\n", path_ramdisk_offset.c_str());
-    PRINT_IF(SUPPORTS_SECOND_ADDRESS,  "- second_offset:  %s\n", path_second_offset.c_str());
-    PRINT_IF(SUPPORTS_TAGS_ADDRESS,    "- tags_offset:    %s\n", path_tags_offset.c_str());
-    PRINT_IF(SUPPORTS_IPL_ADDRESS,     "- ipl_address:    %s\n", path_ipl_address.c_str());
-    PRINT_IF(SUPPORTS_RPM_ADDRESS,     "- rpm_address:    %s\n", path_rpm_address.c_str());
-    PRINT_IF(SUPPORTS_APPSBL_ADDRESS,  "- appsbl_address: %s\n", path_appsbl_address.c_str());
-    PRINT_IF(SUPPORTS_ENTRYPOINT,      "- entrypoint:     %s\n", path_entrypoint.c_str());
-    PRINT_IF(SUPPORTS_PAGE_SIZE,       "- page_size:      %s\n", path_page_size.c_str());
-    PRINT_IF(SUPPORTS_KERNEL_IMAGE,    "- kernel:         %s\n", path_kernel.c_str());
-    PRINT_IF(SUPPORTS_RAMDISK_IMAGE,   "- ramdisk:        %s\n", path_ramdisk.c_str());
-    PRINT_IF(SUPPORTS_SECOND_IMAGE,    "- second:         %s\n", path_second.c_str());
-    PRINT_IF(SUPPORTS_DT_IMAGE,        "- dt:             %s\n", path_dt.c_str());
-    PRINT_IF(SUPPORTS_KERNEL_MTKHDR,   "- kernel_mtkhdr:  %s\n", path_kernel_mtkhdr.c_str());
-    PRINT_IF(SUPPORTS_RAMDISK_MTKHDR,  "- ramdisk_mtkhdr: %s\n", path_ramdisk_mtkhdr.c_str());
-    PRINT_IF(SUPPORTS_IPL_IMAGE,       "- ipl:            %s\n", path_ipl.c_str());
-    PRINT_IF(SUPPORTS_RPM_IMAGE,       "- rpm:            %s\n", path_rpm.c_str());
-    PRINT_IF(SUPPORTS_APPSBL_IMAGE,    "- appsbl:         %s\n", path_appsbl.c_str());
-    PRINT_IF(SUPPORTS_SONY_SIN_IMAGE,  "- sin:            %s\n", path_sin.c_str());
-    PRINT_IF(SUPPORTS_SONY_SIN_HEADER, "- sinhdr:         %s\n", path_sinhdr.c_str());
-#undef PRINT_IF
-
-    /* Extract all the stuff! */
-
-    // Use base relative to the default kernel offset
-    uint32_t base = bi.kernelAddress() - mbp::BootImage::AndroidDefaultKernelOffset;
-    uint32_t kernel_offset = mbp::BootImage::AndroidDefaultKernelOffset;
-    uint32_t ramdisk_offset = bi.ramdiskAddress() - base;
-    uint32_t second_offset = bi.secondBootloaderAddress() - base;
-    uint32_t tags_offset = bi.kernelTagsAddress() - base;
-
-#define WRITE_FILE_FMT(file, fmt, ...) \
-    if (!write_file_fmt(file, fmt, __VA_ARGS__)) { \
-        fprintf(stderr, "%s: %s\n", (file).c_str(), strerror(errno)); \
-        return false; \
-    }
-
-    // Write kernel command line
-    if (supportMask & SUPPORTS_CMDLINE) {
-        WRITE_FILE_FMT(path_cmdline, "%s\n", bi.kernelCmdlineC());
-    }
-
-    // Write board name field
-    if (supportMask & SUPPORTS_BOARD_NAME) {
-        WRITE_FILE_FMT(path_board, "%s\n", bi.boardNameC());
-    }
-
-    // Write base address on which the offsets are applied
-    if (supportMask & SUPPORTS_OFFSET_BASE) {
-        WRITE_FILE_FMT(path_base, "%08x\n", base);
-    }
-
-    // Write kernel offset
-    if (supportMask & SUPPORTS_KERNEL_ADDRESS) {
-        WRITE_FILE_FMT(path_kernel_offset, "%08x\n", kernel_offset);
-    }
-
-    // Write ramdisk offset
-    if (supportMask & SUPPORTS_RAMDISK_ADDRESS) {
-        WRITE_FILE_FMT(path_ramdisk_offset, "%08x\n", ramdisk_offset);
-    }
-
-    // Write second bootloader offset
-    if (supportMask & SUPPORTS_SECOND_ADDRESS) {
-        WRITE_FILE_FMT(path_second_offset, "%08x\n", second_offset);
-    }
-
-    // Write kernel tags offset
-    if (supportMask & SUPPORTS_TAGS_ADDRESS) {
-        WRITE_FILE_FMT(path_tags_offset, "%08x\n", tags_offset);
-    }
-
-    // Write ipl address
-    if (supportMask & SUPPORTS_IPL_ADDRESS) {
-        WRITE_FILE_FMT(path_ipl_address, "%08x\n", bi.iplAddress());
-    }
-
-    // Write rpm address
-    if (supportMask & SUPPORTS_RPM_ADDRESS) {
-        WRITE_FILE_FMT(path_rpm_address, "%08x\n", bi.rpmAddress());
-    }
-
-    // Write appsbl address
-    if (supportMask & SUPPORTS_APPSBL_ADDRESS) {
-        WRITE_FILE_FMT(path_appsbl_address, "%08x\n", bi.appsblAddress());
-    }
-
-    // Write entrypoint address
-    if (supportMask & SUPPORTS_ENTRYPOINT) {
-        WRITE_FILE_FMT(path_entrypoint, "%08x\n", bi.entrypointAddress());
-    }
-
-    // Write page size
-    if (supportMask & SUPPORTS_PAGE_SIZE) {
-        WRITE_FILE_FMT(path_page_size, "%u\n", bi.pageSize());
-    }
-
-#undef WRITE_FILE_FMT
-
-#define WRITE_FILE_DATA(file, data) \
-    if (!write_file_data(file, data)) { \
-        fprintf(stderr, "%s: %s\n", (file).c_str(), strerror(errno)); \
-        return false; \
-    }
-
-    // Write kernel image
-    if (supportMask & SUPPORTS_KERNEL_IMAGE) {
-        WRITE_FILE_DATA(path_kernel, bi.kernelImage());
-    }
-
-    // Write ramdisk image
-    if (supportMask & SUPPORTS_RAMDISK_IMAGE) {
-        WRITE_FILE_DATA(path_ramdisk, bi.ramdiskImage());
-    }
-
-    // Write second bootloader image
-    if (supportMask & SUPPORTS_SECOND_IMAGE) {
-        WRITE_FILE_DATA(path_second, bi.secondBootloaderImage());
-    }
-
-    // Write device tree image
-    if (supportMask & SUPPORTS_DT_IMAGE) {
-        WRITE_FILE_DATA(path_dt, bi.deviceTreeImage());
-    }
-
-    // Write MTK kernel header
-    if (supportMask & SUPPORTS_KERNEL_MTKHDR) {
-        WRITE_FILE_DATA(path_kernel_mtkhdr, bi.kernelMtkHeader());
-    }
-
-    // Write MTK ramdisk header
-    if (supportMask & SUPPORTS_RAMDISK_MTKHDR) {
-        WRITE_FILE_DATA(path_ramdisk_mtkhdr, bi.ramdiskMtkHeader());
-    }
-
-    // Write ipl image
-    if (supportMask & SUPPORTS_IPL_IMAGE) {
-        WRITE_FILE_DATA(path_ipl, bi.iplImage());
-    }
-
-    // Write rpm image
-    if (supportMask & SUPPORTS_RPM_IMAGE) {
-        WRITE_FILE_DATA(path_rpm, bi.rpmImage());
-    }
-
-    // Write appsbl image
-    if (supportMask & SUPPORTS_APPSBL_IMAGE) {
-        WRITE_FILE_DATA(path_appsbl, bi.appsblImage());
-    }
-
-    // Write sin image
-    if (supportMask & SUPPORTS_SONY_SIN_IMAGE) {
-        WRITE_FILE_DATA(path_sin, bi.sinImage());
-    }
-
-    // Write sinhdr image
-    if (supportMask & SUPPORTS_SONY_SIN_HEADER) {
-        WRITE_FILE_DATA(path_sinhdr, bi.sinHeader());
-    }
-
-#undef WRITE_FILE_DATA
-
     printf("\nDone\n");
 
     return true;
@@ -741,56 +1100,8 @@ bool pack_main(int argc, char *argv[])
     std::string output_file;
     std::string input_dir;
     std::string prefix;
-    std::string path_cmdline;
-    std::string path_board;
-    std::string path_base;
-    std::string path_kernel_offset;
-    std::string path_ramdisk_offset;
-    std::string path_second_offset;
-    std::string path_tags_offset;
-    std::string path_ipl_address;
-    std::string path_rpm_address;
-    std::string path_appsbl_address;
-    std::string path_entrypoint;
-    std::string path_page_size;
-    std::string path_kernel;
-    std::string path_ramdisk;
-    std::string path_second;
-    std::string path_dt;
-    std::string path_aboot;
-    std::string path_kernel_mtkhdr;
-    std::string path_ramdisk_mtkhdr;
-    std::string path_ipl;
-    std::string path_rpm;
-    std::string path_appsbl;
-    std::string path_sin;
-    std::string path_sinhdr;
-    // Values
-    std::unordered_map<int, bool> values;
-    std::string cmdline;
-    std::string board;
-    uint32_t base;
-    uint32_t kernel_offset;
-    uint32_t ramdisk_offset;
-    uint32_t second_offset;
-    uint32_t tags_offset;
-    uint32_t ipl_address;
-    uint32_t rpm_address;
-    uint32_t appsbl_address;
-    uint32_t entrypoint;
-    uint32_t page_size;
-    std::vector<unsigned char> kernel_image;
-    std::vector<unsigned char> ramdisk_image;
-    std::vector<unsigned char> second_image;
-    std::vector<unsigned char> dt_image;
-    std::vector<unsigned char> aboot_image;
-    std::vector<unsigned char> kernel_mtkhdr;
-    std::vector<unsigned char> ramdisk_mtkhdr;
-    std::vector<unsigned char> ipl_image;
-    std::vector<unsigned char> rpm_image;
-    std::vector<unsigned char> appsbl_image;
-    std::vector<unsigned char> sin_image;
-    std::vector<unsigned char> sin_header;
+    ItemPaths paths;
+    ItemValues values;
     mbp::BootImage::Type type = mbp::BootImage::Type::Android;
 
     // Arguments with no short options
@@ -887,148 +1198,138 @@ bool pack_main(int argc, char *argv[])
 
     while ((opt = getopt_long(argc, argv, "i:p:nt:", long_options, &long_index)) != -1) {
         switch (opt) {
-        case 'i':                      input_dir = optarg;           break;
-        case 'p':                      prefix = optarg;              break;
-        case 'n':                      no_prefix = true;             break;
-        case OPT_INPUT_CMDLINE:        path_cmdline = optarg;        break;
-        case OPT_INPUT_BOARD:          path_board = optarg;          break;
-        case OPT_INPUT_BASE:           path_base = optarg;           break;
-        case OPT_INPUT_KERNEL_OFFSET:  path_kernel_offset = optarg;  break;
-        case OPT_INPUT_RAMDISK_OFFSET: path_ramdisk_offset = optarg; break;
-        case OPT_INPUT_SECOND_OFFSET:  path_second_offset = optarg;  break;
-        case OPT_INPUT_TAGS_OFFSET:    path_tags_offset = optarg;    break;
-        case OPT_INPUT_IPL_ADDRESS:    path_ipl_address = optarg;    break;
-        case OPT_INPUT_RPM_ADDRESS:    path_rpm_address = optarg;    break;
-        case OPT_INPUT_APPSBL_ADDRESS: path_appsbl_address = optarg; break;
-        case OPT_INPUT_ENTRYPOINT:     path_entrypoint = optarg;     break;
-        case OPT_INPUT_PAGE_SIZE:      path_page_size = optarg;      break;
-        case OPT_INPUT_KERNEL:         path_kernel = optarg;         break;
-        case OPT_INPUT_RAMDISK:        path_ramdisk = optarg;        break;
-        case OPT_INPUT_SECOND:         path_second = optarg;         break;
-        case OPT_INPUT_DT:             path_dt = optarg;             break;
-        case OPT_INPUT_ABOOT:          path_aboot = optarg;          break;
-        case OPT_INPUT_KERNEL_MTKHDR:  path_kernel_mtkhdr = optarg;  break;
-        case OPT_INPUT_RAMDISK_MTKHDR: path_ramdisk_mtkhdr = optarg; break;
-        case OPT_INPUT_IPL:            path_ipl = optarg;            break;
-        case OPT_INPUT_RPM:            path_rpm = optarg;            break;
-        case OPT_INPUT_APPSBL:         path_appsbl = optarg;         break;
-        case OPT_INPUT_SIN:            path_sin = optarg;            break;
-        case OPT_INPUT_SINHDR:         path_sinhdr = optarg;         break;
+        case 'i':                      input_dir = optarg;            break;
+        case 'p':                      prefix = optarg;               break;
+        case 'n':                      no_prefix = true;              break;
+        case OPT_INPUT_CMDLINE:        paths.cmdline = optarg;        break;
+        case OPT_INPUT_BOARD:          paths.board = optarg;          break;
+        case OPT_INPUT_BASE:           paths.base = optarg;           break;
+        case OPT_INPUT_KERNEL_OFFSET:  paths.kernel_offset = optarg;  break;
+        case OPT_INPUT_RAMDISK_OFFSET: paths.ramdisk_offset = optarg; break;
+        case OPT_INPUT_SECOND_OFFSET:  paths.second_offset = optarg;  break;
+        case OPT_INPUT_TAGS_OFFSET:    paths.tags_offset = optarg;    break;
+        case OPT_INPUT_IPL_ADDRESS:    paths.ipl_address = optarg;    break;
+        case OPT_INPUT_RPM_ADDRESS:    paths.rpm_address = optarg;    break;
+        case OPT_INPUT_APPSBL_ADDRESS: paths.appsbl_address = optarg; break;
+        case OPT_INPUT_ENTRYPOINT:     paths.entrypoint = optarg;     break;
+        case OPT_INPUT_PAGE_SIZE:      paths.page_size = optarg;      break;
+        case OPT_INPUT_KERNEL:         paths.kernel = optarg;         break;
+        case OPT_INPUT_RAMDISK:        paths.ramdisk = optarg;        break;
+        case OPT_INPUT_SECOND:         paths.second = optarg;         break;
+        case OPT_INPUT_DT:             paths.dt = optarg;             break;
+        case OPT_INPUT_ABOOT:          paths.aboot = optarg;          break;
+        case OPT_INPUT_KERNEL_MTKHDR:  paths.kernel_mtkhdr = optarg;  break;
+        case OPT_INPUT_RAMDISK_MTKHDR: paths.ramdisk_mtkhdr = optarg; break;
+        case OPT_INPUT_IPL:            paths.ipl = optarg;            break;
+        case OPT_INPUT_RPM:            paths.rpm = optarg;            break;
+        case OPT_INPUT_APPSBL:         paths.appsbl = optarg;         break;
+        case OPT_INPUT_SIN:            paths.sin = optarg;            break;
+        case OPT_INPUT_SINHDR:         paths.sinhdr = optarg;         break;
 
         case OPT_VALUE_CMDLINE:
-            path_cmdline.clear();
-            values[opt] = true;
-            cmdline = optarg;
+            paths.cmdline.clear();
+            values.has_cmdline = true;
+            values.cmdline = optarg;
             break;
 
         case OPT_VALUE_BOARD:
-            path_board.clear();
-            values[opt] = true;
-            board = optarg;
+            paths.board.clear();
+            values.has_board = true;
+            values.board = optarg;
             break;
 
         case OPT_VALUE_BASE:
-            path_base.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&base, optarg, 16)) {
+            paths.base.clear();
+            values.has_base = true;
+            if (!str_to_uint32(&values.base, optarg, 16)) {
                 fprintf(stderr, "Invalid base: %s\n", optarg);
                 return false;
             }
             break;
 
         case OPT_VALUE_KERNEL_OFFSET:
-            path_kernel_offset.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&kernel_offset, optarg, 16)) {
+            paths.kernel_offset.clear();
+            values.has_kernel_offset = true;
+            if (!str_to_uint32(&values.kernel_offset, optarg, 16)) {
                 fprintf(stderr, "Invalid kernel_offset: %s\n", optarg);
                 return false;
             }
             break;
 
         case OPT_VALUE_RAMDISK_OFFSET:
-            path_ramdisk_offset.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&ramdisk_offset, optarg, 16)) {
+            paths.ramdisk_offset.clear();
+            values.has_ramdisk_offset = true;
+            if (!str_to_uint32(&values.ramdisk_offset, optarg, 16)) {
                 fprintf(stderr, "Invalid ramdisk_offset: %s\n", optarg);
                 return false;
             }
             break;
 
         case OPT_VALUE_SECOND_OFFSET:
-            path_second_offset.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&second_offset, optarg, 16)) {
+            paths.second_offset.clear();
+            values.has_second_offset = true;
+            if (!str_to_uint32(&values.second_offset, optarg, 16)) {
                 fprintf(stderr, "Invalid second_offset: %s\n", optarg);
                 return false;
             }
             break;
 
         case OPT_VALUE_TAGS_OFFSET:
-            path_tags_offset.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&tags_offset, optarg, 16)) {
+            paths.tags_offset.clear();
+            values.has_tags_offset = true;
+            if (!str_to_uint32(&values.tags_offset, optarg, 16)) {
                 fprintf(stderr, "Invalid tags_offset: %s\n", optarg);
                 return false;
             }
             break;
 
         case OPT_VALUE_IPL_ADDRESS:
-            path_ipl_address.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&ipl_address, optarg, 16)) {
+            paths.ipl_address.clear();
+            values.has_ipl_address = true;
+            if (!str_to_uint32(&values.ipl_address, optarg, 16)) {
                 fprintf(stderr, "Invalid ipl_address: %s\n", optarg);
                 return false;
             }
             break;
 
         case OPT_VALUE_RPM_ADDRESS:
-            path_rpm_address.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&rpm_address, optarg, 16)) {
+            paths.rpm_address.clear();
+            values.has_rpm_address = true;
+            if (!str_to_uint32(&values.rpm_address, optarg, 16)) {
                 fprintf(stderr, "Invalid rpm_address: %s\n", optarg);
                 return false;
             }
             break;
 
         case OPT_VALUE_APPSBL_ADDRESS:
-            path_appsbl_address.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&appsbl_address, optarg, 16)) {
+            paths.appsbl_address.clear();
+            values.has_appsbl_address = true;
+            if (!str_to_uint32(&values.appsbl_address, optarg, 16)) {
                 fprintf(stderr, "Invalid appsbl_address: %s\n", optarg);
                 return false;
             }
             break;
 
         case OPT_VALUE_ENTRYPOINT:
-            path_entrypoint.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&entrypoint, optarg, 16)) {
+            paths.entrypoint.clear();
+            values.has_entrypoint = true;
+            if (!str_to_uint32(&values.entrypoint, optarg, 16)) {
                 fprintf(stderr, "Invalid entrypoint: %s\n", optarg);
                 return false;
             }
             break;
 
         case OPT_VALUE_PAGE_SIZE:
-            path_page_size.clear();
-            values[opt] = true;
-            if (!str_to_uint32(&page_size, optarg, 10)) {
+            paths.page_size.clear();
+            values.has_page_size = true;
+            if (!str_to_uint32(&values.page_size, optarg, 10)) {
                 fprintf(stderr, "Invalid page_size: %s\n", optarg);
                 return false;
             }
             break;
 
         case 't':
-            if (strcmp(optarg, "android") == 0) {
-                type = mbp::BootImage::Type::Android;
-            } else if (strcmp(optarg, "bump") == 0) {
-                type = mbp::BootImage::Type::Bump;
-            } else if (strcmp(optarg, "loki") == 0) {
-                type = mbp::BootImage::Type::Loki;
-            } else if (strcmp(optarg, "mtk") == 0) {
-                type = mbp::BootImage::Type::Mtk;
-            } else if (strcmp(optarg, "sonyelf") == 0) {
-                type = mbp::BootImage::Type::SonyElf;
-            } else {
+            if (!parse_type(optarg, &type)) {
                 fprintf(stderr, "Invalid type: %s\n", optarg);
                 return false;
             }
@@ -1065,808 +1366,579 @@ bool pack_main(int argc, char *argv[])
         input_dir = ".";
     }
 
-    // Create new boot image
-    mbp::BootImage bi;
+    io::MappedFile map;
+    std::string error;
+    if (!pack_image(output_file, type, input_dir, prefix, paths, values,
+                    &map, true, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
 
-    uint64_t support_mask = mbp::BootImage::typeSupportMask(type);
+    printf("\nDone\n");
 
-    static const char *not_supported =
-            "Warning: Target type does not support %s\n";
-    static const char *fmt_path   = "- %-14s (path)  %s\n";
-    static const char *fmt_string = "- %-14s (value) %s\n";
-    static const char *fmt_hex    = "- %-14s (value) 0x%08x\n";
-    static const char *fmt_uint   = "- %-14s (value) %u\n";
+    return true;
+}
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Kernel cmdline
-    ////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+// Batch mode
+////////////////////////////////////////////////////////////////////////////////
 
-    if (support_mask & SUPPORTS_CMDLINE) {
-        if (values[OPT_VALUE_CMDLINE]) {
-            printf(fmt_string, "cmdline", cmdline.c_str());
-        } else {
-            if (path_cmdline.empty())
-                path_cmdline = io::pathJoin({input_dir, prefix + "cmdline"});
-
-            printf(fmt_path, "cmdline", path_cmdline.c_str());
-
-            file_ptr fp(fopen(path_cmdline.c_str(), "rb"), fclose);
-            if (fp) {
-                std::vector<char> buf(mbp::BootImage::AndroidBootArgsSize + 1);
-                if (!fgets(buf.data(), mbp::BootImage::AndroidBootArgsSize + 1, fp.get())) {
-                    if (ferror(fp.get())) {
-                        fprintf(stderr, "%s: %s\n",
-                                path_cmdline.c_str(), strerror(errno));
-                        return false;
-                    }
-                }
-                cmdline = buf.data();
-                auto pos = cmdline.find('\n');
-                if (pos != std::string::npos) {
-                    cmdline.erase(pos);
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_cmdline.c_str(), strerror(errno));
-                return false;
-            } else {
-                cmdline = mbp::BootImage::DefaultCmdline;
-            }
-        }
+enum class BatchAction
+{
+    Unpack,
+    Pack
+};
 
-        bi.setKernelCmdline(std::move(cmdline));
-    } else {
-        if (!path_cmdline.empty())
-            printf(not_supported, "--input-cmdline");
-        if (values[OPT_VALUE_CMDLINE])
-            printf(not_supported, "--value-cmdline");
+struct BatchJob
+{
+    BatchAction action;
+    // Path to the boot image
+    std::string image;
+    // Directory containing the item files
+    std::string dir;
+    // Target type when packing
+    mbp::BootImage::Type type;
+
+    bool success = false;
+    // Size of the boot image that was read or written
+    uint64_t bytes = 0;
+    double seconds = 0;
+    std::string error;
+};
+
+static bool batch_unpack(BatchJob *job)
+{
+    if (!file_size(job->image, &job->bytes)) {
+        job->error = errno_to_string(job->image);
+        return false;
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Board name
-    ////////////////////////////////////////////////////////////////////////////
-
-    if (support_mask & SUPPORTS_BOARD_NAME) {
-        if (values[OPT_VALUE_BOARD]) {
-            printf(fmt_string, "board", board.c_str());
-        } else {
-            if (path_board.empty())
-                path_board = io::pathJoin({input_dir, prefix + "board"});
-
-            printf(fmt_path, "board", path_board.c_str());
-
-            file_ptr fp(fopen(path_board.c_str(), "rb"), fclose);
-            if (fp) {
-                std::vector<char> buf(mbp::BootImage::AndroidBootNameSize + 1);
-                if (!fgets(buf.data(), mbp::BootImage::AndroidBootNameSize + 1, fp.get())) {
-                    if (ferror(fp.get())) {
-                        fprintf(stderr, "%s: %s\n",
-                                path_board.c_str(), strerror(errno));
-                        return false;
-                    }
-                }
-                board = buf.data();
-                auto pos = board.find('\n');
-                if (pos != std::string::npos) {
-                    board.erase(pos);
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_board.c_str(), strerror(errno));
-                return false;
-            } else {
-                board = mbp::BootImage::AndroidDefaultBoard;
-            }
-        }
+    ItemPaths paths;
+    default_item_paths(&paths, job->dir, io::baseName(job->image) + "-");
 
-        bi.setBoardName(std::move(board));
-    } else {
-        if (!path_board.empty())
-            printf(not_supported, "--input-board");
-        if (values[OPT_VALUE_BOARD])
-            printf(not_supported, "--value-board");
-    }
+    return unpack_image(job->image, paths, false, &job->error);
+}
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Base for address offsets
-    ////////////////////////////////////////////////////////////////////////////
+static bool batch_pack(BatchJob *job, io::MappedFile *map)
+{
+    std::string prefix = io::baseName(job->image) + "-";
 
-    if (support_mask & SUPPORTS_OFFSET_BASE) {
-        if (values[OPT_VALUE_BASE]) {
-            printf(fmt_hex, "base", base);
-        } else {
-            if (path_base.empty())
-                path_base = io::pathJoin({input_dir, prefix + "base"});
-
-            printf(fmt_path, "base", path_base.c_str());
-
-            file_ptr fp(fopen(path_base.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%08x", &base);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_base.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%08x' format\n",
-                            path_base.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_base.c_str(), strerror(errno));
-                return false;
-            } else {
-                if (type == mbp::BootImage::Type::SonyElf) {
-                    // We use absolute addresses for Sony ELF boot images
-                    base = 0;
-                } else {
-                    base = mbp::BootImage::AndroidDefaultBase;
-                }
-            }
-        }
+    ItemPaths paths;
+    if (mbp::BootImage::typeSupportMask(job->type) & SUPPORTS_ABOOT_IMAGE) {
+        paths.aboot = io::pathJoin({job->dir, prefix + "aboot"});
+    }
 
-        // The base will be used by the offsets below
-    } else {
-        if (!path_base.empty())
-            printf(not_supported, "--input-base");
-        if (values[OPT_VALUE_BASE])
-            printf(not_supported, "--value-base");
+    if (!pack_image(job->image, job->type, job->dir, prefix, paths,
+                    ItemValues(), map, false, &job->error)) {
+        return false;
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Kernel offset
-    ////////////////////////////////////////////////////////////////////////////
+    if (!file_size(job->image, &job->bytes)) {
+        job->error = errno_to_string(job->image);
+        return false;
+    }
 
-    if (support_mask & SUPPORTS_KERNEL_ADDRESS) {
-        if (values[OPT_VALUE_KERNEL_OFFSET]) {
-            printf(fmt_hex, "kernel_offset", kernel_offset);
-        } else {
-            if (path_kernel_offset.empty())
-                path_kernel_offset = io::pathJoin({input_dir, prefix + "kernel_offset"});
-
-            printf(fmt_path, "kernel_offset", path_kernel_offset.c_str());
-
-            file_ptr fp(fopen(path_kernel_offset.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%08x", &kernel_offset);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_kernel_offset.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%08x' format\n",
-                            path_kernel_offset.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_kernel_offset.c_str(), strerror(errno));
-                return false;
-            } else {
-                if (type == mbp::BootImage::Type::SonyElf) {
-                    kernel_offset = mbp::BootImage::SonyElfDefaultKernelAddress;
-                } else {
-                    kernel_offset = mbp::BootImage::AndroidDefaultKernelOffset;
-                }
-            }
-        }
+    return true;
+}
 
-        bi.setKernelAddress(base + kernel_offset);
-    } else {
-        if (!path_kernel_offset.empty())
-            printf(not_supported, "--input-kernel_offset");
-        if (values[OPT_VALUE_KERNEL_OFFSET])
-            printf(not_supported, "--value-kernel_offset");
+static bool batch_expand(const std::string &pattern,
+                         std::vector<std::string> *paths)
+{
+#ifdef _WIN32
+    paths->push_back(pattern);
+    return true;
+#else
+    glob_t g;
+    int ret = glob(pattern.c_str(), 0, nullptr, &g);
+    if (ret == GLOB_NOMATCH) {
+        // Not a pattern or nothing matched. Let the job report the error.
+        paths->push_back(pattern);
+        return true;
+    } else if (ret != 0) {
+        globfree(&g);
+        return false;
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Ramdisk offset
-    ////////////////////////////////////////////////////////////////////////////
+    for (std::size_t i = 0; i < g.gl_pathc; ++i) {
+        paths->push_back(g.gl_pathv[i]);
+    }
 
-    if (support_mask & SUPPORTS_RAMDISK_ADDRESS) {
-        if (values[OPT_VALUE_RAMDISK_OFFSET]) {
-            printf(fmt_hex, "ramdisk_offset", ramdisk_offset);
-        } else {
-            if (path_ramdisk_offset.empty())
-                path_ramdisk_offset = io::pathJoin({input_dir, prefix + "ramdisk_offset"});
-
-            printf(fmt_path, "ramdisk_offset", path_ramdisk_offset.c_str());
-
-            file_ptr fp(fopen(path_ramdisk_offset.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%08x", &ramdisk_offset);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_ramdisk_offset.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%08x' format\n",
-                            path_ramdisk_offset.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_ramdisk_offset.c_str(), strerror(errno));
-                return false;
-            } else {
-                if (type == mbp::BootImage::Type::SonyElf) {
-                    ramdisk_offset = mbp::BootImage::SonyElfDefaultRamdiskAddress;
-                } else {
-                    ramdisk_offset = mbp::BootImage::AndroidDefaultRamdiskOffset;
-                }
-            }
-        }
+    globfree(&g);
+    return true;
+#endif
+}
 
-        bi.setRamdiskAddress(base + ramdisk_offset);
-    } else {
-        if (!path_ramdisk_offset.empty())
-            printf(not_supported, "--input-ramdisk_offset");
-        if (values[OPT_VALUE_RAMDISK_OFFSET])
-            printf(not_supported, "--value-ramdisk_offset");
+static void batch_add_unpack(std::vector<BatchJob> *jobs,
+                             const std::vector<std::string> &paths,
+                             const std::string &output_dir)
+{
+    for (const std::string &path : paths) {
+        BatchJob job;
+        job.action = BatchAction::Unpack;
+        job.image = path;
+        job.dir = output_dir;
+        job.type = mbp::BootImage::Type::Android;
+        jobs->push_back(std::move(job));
     }
+}
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Second bootloader offset
-    ////////////////////////////////////////////////////////////////////////////
+static bool batch_read_manifest(const std::string &path,
+                                std::vector<BatchJob> *jobs)
+{
+    std::ifstream file;
+    std::istream *stream = &std::cin;
 
-    if (support_mask & SUPPORTS_SECOND_ADDRESS) {
-        if (values[OPT_VALUE_SECOND_OFFSET]) {
-            printf(fmt_hex, "second_offset", second_offset);
-        } else {
-            if (path_second_offset.empty())
-                path_second_offset = io::pathJoin({input_dir, prefix + "second_offset"});
-
-            printf(fmt_path, "second_offset", path_second_offset.c_str());
-
-            file_ptr fp(fopen(path_second_offset.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%08x", &second_offset);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_second_offset.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%08x' format\n",
-                            path_second_offset.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_second_offset.c_str(), strerror(errno));
-                return false;
-            } else {
-                second_offset = mbp::BootImage::AndroidDefaultSecondOffset;
-            }
+    if (path != "-") {
+        file.open(path, std::ios::binary);
+        if (!file) {
+            fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+            return false;
         }
-
-        bi.setSecondBootloaderAddress(base + second_offset);
-    } else {
-        if (!path_second_offset.empty())
-            printf(not_supported, "--input-second_offset");
-        if (values[OPT_VALUE_SECOND_OFFSET])
-            printf(not_supported, "--value-second_offset");
+        stream = &file;
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Kernel tags offset
-    ////////////////////////////////////////////////////////////////////////////
+    std::string line;
+    unsigned int line_num = 0;
 
-    if (support_mask & SUPPORTS_TAGS_ADDRESS) {
-        if (values[OPT_VALUE_TAGS_OFFSET]) {
-            printf(fmt_hex, "tags_offset", tags_offset);
-        } else {
-            if (path_tags_offset.empty())
-                path_tags_offset = io::pathJoin({input_dir, prefix + "tags_offset"});
-
-            printf(fmt_path, "tags_offset", path_tags_offset.c_str());
-
-            file_ptr fp(fopen(path_tags_offset.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%08x", &tags_offset);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_tags_offset.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%08x' format\n",
-                            path_tags_offset.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_tags_offset.c_str(), strerror(errno));
-                return false;
-            } else {
-                tags_offset = mbp::BootImage::AndroidDefaultTagsOffset;
-            }
-        }
+    while (std::getline(*stream, line)) {
+        ++line_num;
 
-        bi.setKernelTagsAddress(base + tags_offset);
-    } else {
-        if (!path_tags_offset.empty())
-            printf(not_supported, "--input-tags_offset");
-        if (values[OPT_VALUE_TAGS_OFFSET])
-            printf(not_supported, "--value-tags_offset");
-    }
+        // Split on whitespace. This also drops the '\r' from CRLF line endings.
+        std::vector<std::string> tokens;
+        std::istringstream iss(line);
+        std::string token;
+        while (iss >> token) {
+            tokens.push_back(std::move(token));
+        }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Ipl address
-    ////////////////////////////////////////////////////////////////////////////
+        if (tokens.empty() || tokens[0][0] == '#') {
+            continue;
+        }
 
-    if (support_mask & SUPPORTS_IPL_ADDRESS) {
-        if (values[OPT_VALUE_IPL_ADDRESS]) {
-            printf(fmt_hex, "ipl_address", ipl_address);
-        } else {
-            if (path_ipl_address.empty())
-                path_ipl_address = io::pathJoin({input_dir, prefix + "ipl_address"});
-
-            printf(fmt_path, "ipl_address", path_ipl_address.c_str());
-
-            file_ptr fp(fopen(path_ipl_address.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%08x", &ipl_address);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_ipl_address.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%08x' format\n",
-                            path_ipl_address.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_ipl_address.c_str(), strerror(errno));
+        if (tokens[0] == "unpack" && tokens.size() >= 2 && tokens.size() <= 3) {
+            std::vector<std::string> paths;
+            if (!batch_expand(tokens[1], &paths)) {
+                fprintf(stderr, "%s:%u: Failed to expand '%s'\n",
+                        path.c_str(), line_num, tokens[1].c_str());
                 return false;
-            } else {
-                ipl_address = mbp::BootImage::SonyElfDefaultIplAddress;
             }
-        }
-
-        bi.setIplAddress(ipl_address);
-    } else {
-        if (!path_ipl_address.empty())
-            printf(not_supported, "--input-ipl_address");
-        if (values[OPT_VALUE_IPL_ADDRESS])
-            printf(not_supported, "--value-ipl_address");
-    }
-
-    ////////////////////////////////////////////////////////////////////////////
-    // Rpm address
-    ////////////////////////////////////////////////////////////////////////////
-
-    if (support_mask & SUPPORTS_RPM_ADDRESS) {
-        if (values[OPT_VALUE_RPM_ADDRESS]) {
-            printf(fmt_hex, "rpm_address", rpm_address);
-        } else {
-            if (path_rpm_address.empty())
-                path_rpm_address = io::pathJoin({input_dir, prefix + "rpm_address"});
-
-            printf(fmt_path, "rpm_address", path_rpm_address.c_str());
-
-            file_ptr fp(fopen(path_rpm_address.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%08x", &rpm_address);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_rpm_address.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%08x' format\n",
-                            path_rpm_address.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_rpm_address.c_str(), strerror(errno));
+            batch_add_unpack(jobs, paths, tokens.size() == 3 ? tokens[2] : ".");
+        } else if (tokens[0] == "pack" && tokens.size() >= 2 && tokens.size() <= 4) {
+            BatchJob job;
+            job.action = BatchAction::Pack;
+            job.image = tokens[1];
+            job.dir = tokens.size() >= 3 ? tokens[2] : ".";
+            job.type = mbp::BootImage::Type::Android;
+            if (tokens.size() == 4 && !parse_type(tokens[3], &job.type)) {
+                fprintf(stderr, "%s:%u: Invalid type: %s\n",
+                        path.c_str(), line_num, tokens[3].c_str());
                 return false;
-            } else {
-                rpm_address = mbp::BootImage::SonyElfDefaultRpmAddress;
             }
+            jobs->push_back(std::move(job));
+        } else {
+            fprintf(stderr, "%s:%u: Invalid job: %s\n",
+                    path.c_str(), line_num, tokens[0].c_str());
+            return false;
         }
-
-        bi.setRpmAddress(rpm_address);
-    } else {
-        if (!path_rpm_address.empty())
-            printf(not_supported, "--input-rpm_address");
-        if (values[OPT_VALUE_RPM_ADDRESS])
-            printf(not_supported, "--value-rpm_address");
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Appsbl address
-    ////////////////////////////////////////////////////////////////////////////
+    if (stream->bad()) {
+        fprintf(stderr, "%s: Failed to read manifest\n", path.c_str());
+        return false;
+    }
 
-    if (support_mask & SUPPORTS_APPSBL_ADDRESS) {
-        if (values[OPT_VALUE_APPSBL_ADDRESS]) {
-            printf(fmt_hex, "appsbl_address", appsbl_address);
-        } else {
-            if (path_appsbl_address.empty())
-                path_appsbl_address = io::pathJoin({input_dir, prefix + "appsbl_address"});
-
-            printf(fmt_path, "appsbl_address", path_appsbl_address.c_str());
-
-            file_ptr fp(fopen(path_appsbl_address.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%08x", &appsbl_address);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_appsbl_address.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%08x' format\n",
-                            path_appsbl_address.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_appsbl_address.c_str(), strerror(errno));
-                return false;
-            } else {
-                appsbl_address = mbp::BootImage::SonyElfDefaultAppsblAddress;
-            }
-        }
+    return true;
+}
 
-        bi.setAppsblAddress(appsbl_address);
-    } else {
-        if (!path_appsbl_address.empty())
-            printf(not_supported, "--input-appsbl_address");
-        if (values[OPT_VALUE_APPSBL_ADDRESS])
-            printf(not_supported, "--value-appsbl_address");
+static void mbp_log_quiet_cb(mbp::LogLevel prio, const std::string &msg)
+{
+    // Messages from parallel jobs are interleaved, so only show problems
+    switch (prio) {
+    case mbp::LogLevel::Error:
+    case mbp::LogLevel::Warning:
+        fprintf(stderr, "%s\n", msg.c_str());
+        break;
+    case mbp::LogLevel::Debug:
+    case mbp::LogLevel::Info:
+    case mbp::LogLevel::Verbose:
+        break;
     }
+}
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Entrypoint address
-    ////////////////////////////////////////////////////////////////////////////
+bool batch_main(int argc, char *argv[])
+{
+    int opt;
 
-    if (support_mask & SUPPORTS_ENTRYPOINT) {
-        if (values[OPT_VALUE_ENTRYPOINT]) {
-            printf(fmt_hex, "entrypoint", entrypoint);
-        } else {
-            if (path_entrypoint.empty())
-                path_entrypoint = io::pathJoin({input_dir, prefix + "entrypoint"});
-
-            printf(fmt_path, "entrypoint", path_entrypoint.c_str());
-
-            file_ptr fp(fopen(path_entrypoint.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%08x", &entrypoint);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_entrypoint.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%08x' format\n",
-                            path_entrypoint.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_entrypoint.c_str(), strerror(errno));
-                return false;
-            } else {
-                entrypoint = mbp::BootImage::SonyElfDefaultEntrypointAddress;
-            }
-        }
+    std::string manifest;
+    std::string output_dir;
+    unsigned int num_jobs = 0;
+    bool verbose = false;
 
-        bi.setEntrypointAddress(entrypoint);
-    } else {
-        if (!path_entrypoint.empty())
-            printf(not_supported, "--input-entrypoint");
-        if (values[OPT_VALUE_ENTRYPOINT])
-            printf(not_supported, "--value-entrypoint");
-    }
+    static struct option long_options[] = {
+        {"help",     no_argument,       0, 'h'},
+        {"manifest", required_argument, 0, 'm'},
+        {"output",   required_argument, 0, 'o'},
+        {"jobs",     required_argument, 0, 'j'},
+        {"verbose",  no_argument,       0, 'v'},
+        {0, 0, 0, 0}
+    };
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Page size
-    ////////////////////////////////////////////////////////////////////////////
+    int long_index = 0;
 
-    if (support_mask & SUPPORTS_PAGE_SIZE) {
-        if (values[OPT_VALUE_PAGE_SIZE]) {
-            printf(fmt_uint, "page_size", page_size);
-        } else {
-            if (path_page_size.empty())
-                path_page_size = io::pathJoin({input_dir, prefix + "page_size"});
-
-            printf(fmt_path, "page_size", path_page_size.c_str());
-
-            file_ptr fp(fopen(path_page_size.c_str(), "rb"), fclose);
-            if (fp) {
-                int count = fscanf(fp.get(), "%u", &page_size);
-                if (count == EOF && ferror(fp.get())) {
-                    fprintf(stderr, "%s: %s\n",
-                            path_page_size.c_str(), strerror(errno));
-                    return false;
-                } else if (count != 1) {
-                    fprintf(stderr, "%s: Error: expected '%%u' format\n",
-                            path_page_size.c_str());
-                    return false;
-                }
-            } else if (errno != ENOENT) {
-                fprintf(stderr, "%s: %s\n",
-                        path_page_size.c_str(), strerror(errno));
+    while ((opt = getopt_long(argc, argv, "hm:o:j:v", long_options, &long_index)) != -1) {
+        switch (opt) {
+        case 'm':
+            manifest = optarg;
+            break;
+        case 'o':
+            output_dir = optarg;
+            break;
+        case 'j':
+            if (!str_to_uint32(&num_jobs, optarg, 10) || num_jobs == 0) {
+                fprintf(stderr, "Invalid job count: %s\n", optarg);
                 return false;
-            } else {
-                page_size = mbp::BootImage::AndroidDefaultPageSize;
             }
-        }
-
-        bi.setPageSize(page_size);
-    } else {
-        if (!path_page_size.empty())
-            printf(not_supported, "--input-page_size");
-        if (values[OPT_VALUE_PAGE_SIZE])
-            printf(not_supported, "--value-page_size");
-    }
-
-    ////////////////////////////////////////////////////////////////////////////
-    // Kernel image
-    ////////////////////////////////////////////////////////////////////////////
-
-    if (support_mask & SUPPORTS_KERNEL_IMAGE) {
-        if (path_kernel.empty())
-            path_kernel = io::pathJoin({input_dir, prefix + "kernel"});
+            break;
+        case 'v':
+            verbose = true;
+            break;
 
-        printf(fmt_path, "kernel", path_kernel.c_str());
+        case 'h':
+            fprintf(stdout, BatchUsage);
+            return true;
 
-        if (!read_file_data(path_kernel, &kernel_image)) {
-            fprintf(stderr, "%s: %s\n", path_kernel.c_str(), strerror(errno));
+        default:
+            fprintf(stderr, BatchUsage);
             return false;
         }
-
-        bi.setKernelImage(std::move(kernel_image));
-    } else {
-        if (!path_kernel.empty())
-            printf(not_supported, "--input-kernel");
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Ramdisk image
-    ////////////////////////////////////////////////////////////////////////////
+    if (manifest.empty() && argc - optind == 0) {
+        fprintf(stderr, BatchUsage);
+        return false;
+    }
 
-    if (support_mask & SUPPORTS_RAMDISK_IMAGE) {
-        if (path_ramdisk.empty())
-            path_ramdisk = io::pathJoin({input_dir, prefix + "ramdisk"});
+    if (output_dir.empty()) {
+        output_dir = ".";
+    }
 
-        printf(fmt_path, "ramdisk", path_ramdisk.c_str());
+    std::vector<BatchJob> jobs;
 
-        if (!read_file_data(path_ramdisk, &ramdisk_image)) {
-            fprintf(stderr, "%s: %s\n", path_ramdisk.c_str(), strerror(errno));
+    for (int i = optind; i < argc; ++i) {
+        std::vector<std::string> paths;
+        if (!batch_expand(argv[i], &paths)) {
+            fprintf(stderr, "Failed to expand '%s'\n", argv[i]);
             return false;
         }
-
-        bi.setRamdiskImage(std::move(ramdisk_image));
-    } else {
-        if (!path_ramdisk.empty())
-            printf(not_supported, "--input-ramdisk");
+        batch_add_unpack(&jobs, paths, output_dir);
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Second bootloader image
-    ////////////////////////////////////////////////////////////////////////////
+    if (!manifest.empty() && !batch_read_manifest(manifest, &jobs)) {
+        return false;
+    }
 
-    if (support_mask & SUPPORTS_SECOND_IMAGE) {
-        if (path_second.empty())
-            path_second = io::pathJoin({input_dir, prefix + "second"});
+    if (jobs.empty()) {
+        printf("Nothing to do\n");
+        return true;
+    }
 
-        printf(fmt_path, "second", path_second.c_str());
+    // Create the output directories up front so the workers don't race to
+    // create the same parent directories
+    std::vector<std::string> dirs;
+    for (const BatchJob &job : jobs) {
+        std::string dir = job.action == BatchAction::Unpack
+                ? job.dir : io::dirName(job.image);
+        // A bare filename (eg. "pack boot.img unpacked") has no directory
+        dirs.push_back(dir.empty() ? "." : dir);
+    }
+    std::sort(dirs.begin(), dirs.end());
+    dirs.erase(std::unique(dirs.begin(), dirs.end()), dirs.end());
 
-        if (!read_file_data(path_second, &second_image) && errno != ENOENT) {
-            fprintf(stderr, "%s: %s\n", path_second.c_str(), strerror(errno));
+    for (const std::string &dir : dirs) {
+        if (!io::createDirectories(dir)) {
+            fprintf(stderr, "%s: Failed to create directory: %s\n",
+                    dir.c_str(), io::lastErrorString().c_str());
             return false;
         }
+    }
 
-        bi.setSecondBootloaderImage(std::move(second_image));
-    } else {
-        if (!path_second.empty())
-            printf(not_supported, "--input-second");
+    if (num_jobs == 0) {
+        num_jobs = std::max(1u, std::thread::hardware_concurrency());
     }
+    num_jobs = std::min<std::size_t>(num_jobs, jobs.size());
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Device tree image
-    ////////////////////////////////////////////////////////////////////////////
+    if (!verbose) {
+        mbp::setLogCallback(mbp_log_quiet_cb);
+    }
 
-    if (support_mask & SUPPORTS_DT_IMAGE) {
-        if (path_dt.empty())
-            path_dt = io::pathJoin({input_dir, prefix + "dt"});
+    std::atomic<std::size_t> next_job(0);
 
-        printf(fmt_path, "dt", path_dt.c_str());
+    auto worker = [&]() {
+        // Reused for every item file this worker maps
+        io::MappedFile map;
 
-        if (!read_file_data(path_dt, &dt_image) && errno != ENOENT) {
-            fprintf(stderr, "%s: %s\n", path_dt.c_str(), strerror(errno));
-            return false;
-        }
+        std::size_t i;
+        while ((i = next_job++) < jobs.size()) {
+            BatchJob &job = jobs[i];
 
-        bi.setDeviceTreeImage(std::move(dt_image));
-    } else {
-        if (!path_dt.empty())
-            printf(not_supported, "--input-dt");
-    }
+            auto start = std::chrono::steady_clock::now();
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Aboot image
-    ////////////////////////////////////////////////////////////////////////////
+            if (job.action == BatchAction::Unpack) {
+                job.success = batch_unpack(&job);
+            } else {
+                job.success = batch_pack(&job, &map);
+            }
 
-    if (support_mask & SUPPORTS_ABOOT_IMAGE) {
-        if (path_aboot.empty()) {
-            // The aboot image is required
-            fprintf(stderr, "An aboot image must be specified to create a loki image\n");
-            return false;
+            auto end = std::chrono::steady_clock::now();
+            job.seconds = std::chrono::duration<double>(end - start).count();
         }
+    };
 
-        printf(fmt_path, "aboot", path_aboot.c_str());
-
-        if (!read_file_data(path_aboot, &aboot_image) && errno != ENOENT) {
-            fprintf(stderr, "%s: %s\n", path_aboot.c_str(), strerror(errno));
-            return false;
-        }
+    auto start = std::chrono::steady_clock::now();
 
-        bi.setAbootImage(std::move(aboot_image));
-    } else {
-        if (!path_aboot.empty())
-            printf(not_supported, "--input-aboot");
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < num_jobs; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &t : threads) {
+        t.join();
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // MTK kernel header
-    ////////////////////////////////////////////////////////////////////////////
+    auto end = std::chrono::steady_clock::now();
+    double total_seconds = std::chrono::duration<double>(end - start).count();
 
-    if (support_mask & SUPPORTS_KERNEL_MTKHDR) {
-        if (path_kernel_mtkhdr.empty())
-            path_kernel_mtkhdr = io::pathJoin({input_dir, prefix + "kernel_mtkhdr"});
+    uint64_t total_bytes = 0;
+    std::size_t failed = 0;
 
-        printf(fmt_path, "kernel_mtkhdr", path_kernel_mtkhdr.c_str());
+    for (const BatchJob &job : jobs) {
+        const char *action = job.action == BatchAction::Unpack
+                ? "unpack" : "pack";
 
-        if (!read_file_data(path_kernel_mtkhdr, &kernel_mtkhdr)) {
-            fprintf(stderr, "%s: %s\n", path_kernel_mtkhdr.c_str(), strerror(errno));
-            return false;
+        if (job.success) {
+            total_bytes += job.bytes;
+            printf("%-6s %s: %.2f MiB in %.1f ms\n", action, job.image.c_str(),
+                   job.bytes / 1048576.0, job.seconds * 1000.0);
+        } else {
+            ++failed;
+            fprintf(stderr, "%-6s %s: Failed: %s\n", action, job.image.c_str(),
+                    job.error.c_str());
         }
-
-        bi.setKernelMtkHeader(std::move(kernel_mtkhdr));
-    } else {
-        if (!path_kernel_mtkhdr.empty())
-            printf(not_supported, "--input-kernel_mtkhdr");
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // MTK ramdisk header
-    ////////////////////////////////////////////////////////////////////////////
+    printf("\n%zu images (%zu failed) using %u threads\n",
+           jobs.size(), failed, num_jobs);
+    printf("%.2f MiB in %.3f s (%.2f MiB/s)\n",
+           total_bytes / 1048576.0, total_seconds,
+           total_seconds > 0 ? total_bytes / 1048576.0 / total_seconds : 0.0);
 
-    if (support_mask & SUPPORTS_RAMDISK_MTKHDR) {
-        if (path_ramdisk_mtkhdr.empty())
-            path_ramdisk_mtkhdr = io::pathJoin({input_dir, prefix + "ramdisk_mtkhdr"});
-
-        printf(fmt_path, "ramdisk_mtkhdr", path_ramdisk_mtkhdr.c_str());
+    return failed == 0;
+}
 
-        if (!read_file_data(path_ramdisk_mtkhdr, &ramdisk_mtkhdr)) {
-            fprintf(stderr, "%s: %s\n", path_ramdisk_mtkhdr.c_str(), strerror(errno));
-            return false;
-        }
+////////////////////////////////////////////////////////////////////////////////
+// Info
+////////////////////////////////////////////////////////////////////////////////
 
-        bi.setRamdiskMtkHeader(std::move(ramdisk_mtkhdr));
-    } else {
-        if (!path_ramdisk_mtkhdr.empty())
-            printf(not_supported, "--input-ramdisk_mtkhdr");
+struct InfoSection
+{
+    const char *name;
+    mbp::BootImage::Section section;
+};
+
+static const InfoSection InfoSections[] = {
+    { "kernel",         mbp::BootImage::Section::Kernel           },
+    { "ramdisk",        mbp::BootImage::Section::Ramdisk          },
+    { "second",         mbp::BootImage::Section::SecondBootloader },
+    { "dt",             mbp::BootImage::Section::DeviceTree       },
+    { "kernel_mtkhdr",  mbp::BootImage::Section::KernelMtkHeader  },
+    { "ramdisk_mtkhdr", mbp::BootImage::Section::RamdiskMtkHeader },
+    { "ipl",            mbp::BootImage::Section::Ipl              },
+    { "rpm",            mbp::BootImage::Section::Rpm              },
+    { "appsbl",         mbp::BootImage::Section::Appsbl           },
+    { "sin",            mbp::BootImage::Section::SonySin          },
+    { "sinhdr",         mbp::BootImage::Section::SonySinHeader    },
+};
+
+static const char * type_to_string(mbp::BootImage::Type type)
+{
+    switch (type) {
+    case mbp::BootImage::Type::Android:
+        return "android";
+    case mbp::BootImage::Type::Bump:
+        return "bump";
+    case mbp::BootImage::Type::Loki:
+        return "loki";
+    case mbp::BootImage::Type::Mtk:
+        return "mtk";
+    case mbp::BootImage::Type::SonyElf:
+        return "sonyelf";
+    default:
+        return "unknown";
     }
+}
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Ipl image
-    ////////////////////////////////////////////////////////////////////////////
+static void info_print_text(const std::string &path, const mbp::BootImage &bi)
+{
+    uint64_t supportMask = mbp::BootImage::typeSupportMask(bi.wasType());
 
-    if (support_mask & SUPPORTS_IPL_IMAGE) {
-        if (path_ipl.empty())
-            path_ipl = io::pathJoin({input_dir, prefix + "ipl"});
+    printf("file=%s\n", path.c_str());
+    printf("type=%s\n", type_to_string(bi.wasType()));
 
-        printf(fmt_path, "ipl", path_ipl.c_str());
+#define PRINT_IF(supported, fmt, ...) \
+    if (supportMask & (supported)) { \
+        printf(fmt, __VA_ARGS__); \
+    }
+    PRINT_IF(SUPPORTS_BOARD_NAME,      "board=%s\n",                bi.boardNameC());
+    PRINT_IF(SUPPORTS_CMDLINE,         "cmdline=%s\n",              bi.kernelCmdlineC());
+    PRINT_IF(SUPPORTS_PAGE_SIZE,       "page_size=%u\n",            bi.pageSize());
+    PRINT_IF(SUPPORTS_KERNEL_ADDRESS,  "kernel_address=0x%08x\n",   bi.kernelAddress());
+    PRINT_IF(SUPPORTS_RAMDISK_ADDRESS, "ramdisk_address=0x%08x\n",  bi.ramdiskAddress());
+    PRINT_IF(SUPPORTS_SECOND_ADDRESS,  "second_address=0x%08x\n",   bi.secondBootloaderAddress());
+    PRINT_IF(SUPPORTS_TAGS_ADDRESS,    "tags_address=0x%08x\n",     bi.kernelTagsAddress());
+    PRINT_IF(SUPPORTS_IPL_ADDRESS,     "ipl_address=0x%08x\n",      bi.iplAddress());
+    PRINT_IF(SUPPORTS_RPM_ADDRESS,     "rpm_address=0x%08x\n",      bi.rpmAddress());
+    PRINT_IF(SUPPORTS_APPSBL_ADDRESS,  "appsbl_address=0x%08x\n",   bi.appsblAddress());
+    PRINT_IF(SUPPORTS_ENTRYPOINT,      "entrypoint=0x%08x\n",       bi.entrypointAddress());
+#undef PRINT_IF
 
-        if (!read_file_data(path_ipl, &ipl_image) && errno != ENOENT) {
-            fprintf(stderr, "%s: %s\n", path_ipl.c_str(), strerror(errno));
-            return false;
+    for (const InfoSection &item : InfoSections) {
+        uint64_t offset;
+        uint64_t size;
+        if (bi.sectionLocation(item.section, &offset, &size)) {
+            printf("section.%s=%" PRIu64 ",%" PRIu64 "\n",
+                   item.name, offset, size);
         }
-
-        bi.setIplImage(std::move(ipl_image));
-    } else {
-        if (!path_ipl.empty())
-            printf(not_supported, "--input-ipl");
     }
+}
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Rpm image
-    ////////////////////////////////////////////////////////////////////////////
+static void info_print_json(const std::string &path, const mbp::BootImage &bi)
+{
+    uint64_t supportMask = mbp::BootImage::typeSupportMask(bi.wasType());
 
-    if (support_mask & SUPPORTS_RPM_IMAGE) {
-        if (path_rpm.empty())
-            path_rpm = io::pathJoin({input_dir, prefix + "rpm"});
+    printf("  {\n");
+    printf("    \"file\": %s,\n", mbp::jsonQuote(path).c_str());
+    printf("    \"type\": \"%s\",\n", type_to_string(bi.wasType()));
 
-        printf(fmt_path, "rpm", path_rpm.c_str());
+#define PRINT_IF(supported, fmt, ...) \
+    if (supportMask & (supported)) { \
+        printf(fmt, __VA_ARGS__); \
+    }
+    PRINT_IF(SUPPORTS_BOARD_NAME,      "    \"board\": %s,\n",            mbp::jsonQuote(bi.boardName()).c_str());
+    PRINT_IF(SUPPORTS_CMDLINE,         "    \"cmdline\": %s,\n",          mbp::jsonQuote(bi.kernelCmdline()).c_str());
+    PRINT_IF(SUPPORTS_PAGE_SIZE,       "    \"page_size\": %u,\n",        bi.pageSize());
+    PRINT_IF(SUPPORTS_KERNEL_ADDRESS,  "    \"kernel_address\": %u,\n",   bi.kernelAddress());
+    PRINT_IF(SUPPORTS_RAMDISK_ADDRESS, "    \"ramdisk_address\": %u,\n",  bi.ramdiskAddress());
+    PRINT_IF(SUPPORTS_SECOND_ADDRESS,  "    \"second_address\": %u,\n",   bi.secondBootloaderAddress());
+    PRINT_IF(SUPPORTS_TAGS_ADDRESS,    "    \"tags_address\": %u,\n",     bi.kernelTagsAddress());
+    PRINT_IF(SUPPORTS_IPL_ADDRESS,     "    \"ipl_address\": %u,\n",      bi.iplAddress());
+    PRINT_IF(SUPPORTS_RPM_ADDRESS,     "    \"rpm_address\": %u,\n",      bi.rpmAddress());
+    PRINT_IF(SUPPORTS_APPSBL_ADDRESS,  "    \"appsbl_address\": %u,\n",   bi.appsblAddress());
+    PRINT_IF(SUPPORTS_ENTRYPOINT,      "    \"entrypoint\": %u,\n",       bi.entrypointAddress());
+#undef PRINT_IF
 
-        if (!read_file_data(path_rpm, &rpm_image) && errno != ENOENT) {
-            fprintf(stderr, "%s: %s\n", path_rpm.c_str(), strerror(errno));
-            return false;
+    printf("    \"sections\": {");
+
+    bool first = true;
+    for (const InfoSection &item : InfoSections) {
+        uint64_t offset;
+        uint64_t size;
+        if (bi.sectionLocation(item.section, &offset, &size)) {
+            printf("%s\n      \"%s\": { \"offset\": %" PRIu64
+                   ", \"size\": %" PRIu64 " }",
+                   first ? "" : ",", item.name, offset, size);
+            first = false;
         }
-
-        bi.setRpmImage(std::move(rpm_image));
-    } else {
-        if (!path_rpm.empty())
-            printf(not_supported, "--input-rpm");
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Appsbl image
-    ////////////////////////////////////////////////////////////////////////////
-
-    if (support_mask & SUPPORTS_APPSBL_IMAGE) {
-        if (path_appsbl.empty())
-            path_appsbl = io::pathJoin({input_dir, prefix + "appsbl"});
+    printf("%s}\n", first ? "" : "\n    ");
+    printf("  }");
+}
 
-        printf(fmt_path, "appsbl", path_appsbl.c_str());
+bool info_main(int argc, char *argv[])
+{
+    int opt;
 
-        if (!read_file_data(path_appsbl, &appsbl_image) && errno != ENOENT) {
-            fprintf(stderr, "%s: %s\n", path_appsbl.c_str(), strerror(errno));
-            return false;
-        }
+    bool json = false;
+    bool verbose = false;
 
-        bi.setAppsblImage(std::move(appsbl_image));
-    } else {
-        if (!path_appsbl.empty())
-            printf(not_supported, "--input-appsbl");
-    }
+    static struct option long_options[] = {
+        {"help",    no_argument,       0, 'h'},
+        {"format",  required_argument, 0, 'f'},
+        {"verbose", no_argument,       0, 'v'},
+        {0, 0, 0, 0}
+    };
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Sony SIN! image
-    ////////////////////////////////////////////////////////////////////////////
+    int long_index = 0;
 
-    if (support_mask & SUPPORTS_SONY_SIN_IMAGE) {
-        if (path_sin.empty())
-            path_sin = io::pathJoin({input_dir, prefix + "sin"});
+    while ((opt = getopt_long(argc, argv, "hf:v", long_options, &long_index)) != -1) {
+        switch (opt) {
+        case 'f':
+            if (strcmp(optarg, "text") == 0) {
+                json = false;
+            } else if (strcmp(optarg, "json") == 0) {
+                json = true;
+            } else {
+                fprintf(stderr, "Invalid format: %s\n", optarg);
+                return false;
+            }
+            break;
+        case 'v':
+            verbose = true;
+            break;
 
-        printf(fmt_path, "sin", path_sin.c_str());
+        case 'h':
+            fprintf(stdout, InfoUsage);
+            return true;
 
-        if (!read_file_data(path_sin, &sin_image) && errno != ENOENT) {
-            fprintf(stderr, "%s: %s\n", path_sin.c_str(), strerror(errno));
+        default:
+            fprintf(stderr, InfoUsage);
             return false;
         }
-
-        bi.setSinImage(std::move(sin_image));
-    } else {
-        if (!path_sin.empty())
-            printf(not_supported, "--input-sin");
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    // Sony SIN! header
-    ////////////////////////////////////////////////////////////////////////////
-
-    if (support_mask & SUPPORTS_SONY_SIN_HEADER) {
-        if (path_sinhdr.empty())
-            path_sinhdr = io::pathJoin({input_dir, prefix + "sinhdr"});
+    if (argc - optind == 0) {
+        fprintf(stderr, InfoUsage);
+        return false;
+    }
 
-        printf(fmt_path, "sinhdr", path_sinhdr.c_str());
+    if (!verbose) {
+        mbp::setLogCallback(mbp_log_quiet_cb);
+    }
 
-        if (!read_file_data(path_sinhdr, &sin_header) && errno != ENOENT) {
-            fprintf(stderr, "%s: %s\n", path_sinhdr.c_str(), strerror(errno));
-            return false;
-        }
+    bool ret = true;
+    bool first = true;
 
-        bi.setSinHeader(std::move(sin_header));
-    } else {
-        if (!path_sinhdr.empty())
-            printf(not_supported, "--input-sinhdr");
+    if (json) {
+        printf("[");
     }
 
-    // Create boot image
+    for (int i = optind; i < argc; ++i) {
+        mbp::BootImage bi;
+        if (!bi.inspectFile(argv[i])) {
+            fprintf(stderr, "%s: %s\n",
+                    argv[i], error_to_string(bi.error()).c_str());
+            ret = false;
+            continue;
+        }
 
-    bi.setTargetType(type);
+        if (json) {
+            printf("%s\n", first ? "" : ",");
+            info_print_json(argv[i], bi);
+        } else {
+            if (!first) {
+                printf("\n");
+            }
+            info_print_text(argv[i], bi);
+        }
 
-    if (!bi.createFile(output_file)) {
-        fprintf(stderr, "Failed to create boot image\n");
-        return false;
+        first = false;
     }
 
-    printf("\nDone\n");
+    if (json) {
+        printf("%s]\n", first ? "" : "\n");
+    }
 
-    return true;
+    return ret;
 }
 
 int main(int argc, char *argv[]) {
@@ -1877,6 +1949,18 @@ int main(int argc, char *argv[]) {
 
     mbp::setLogCallback(mbp_log_cb);
 
+    std::string tracePath;
+    if (strcmp(argv[1], "--trace") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, MainUsage);
+            return EXIT_FAILURE;
+        }
+        tracePath = argv[2];
+        argc -= 2;
+        argv += 2;
+        mbp::setTracingEnabled(true);
+    }
+
     std::string command(argv[1]);
     bool ret = false;
 
@@ -1884,10 +1968,19 @@ int main(int argc, char *argv[]) {
         ret = unpack_main(--argc, ++argv);
     } else if (command == "pack") {
         ret = pack_main(--argc, ++argv);
+    } else if (command == "batch") {
+        ret = batch_main(--argc, ++argv);
+    } else if (command == "info") {
+        ret = info_main(--argc, ++argv);
     } else {
         fprintf(stderr, MainUsage);
         return EXIT_FAILURE;
     }
 
+    if (!tracePath.empty() && !mbp::writeChromeTrace(tracePath)) {
+        fprintf(stderr, "%s: Failed to write trace\n", tracePath.c_str());
+        ret = false;
+    }
+
     return ret ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -8,6 +8,14 @@ if(WIN32)
 endif()
 
 
+# Benchmarks
+option(MBP_ENABLE_BENCHMARKS "Build libmbp benchmarks" OFF)
+if(MBP_ENABLE_BENCHMARKS)
+    # For the patch throughput and bootimgtool batch tests
+    enable_testing()
+endif()
+
+
 # Prefer static libraries when compiling with mingw
 option(
     MBP_MINGW_USE_STATIC_LIBS
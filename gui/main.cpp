@@ -19,6 +19,7 @@
 
 #include "mainwindow.h"
 
+#include <QtCore/QCommandLineParser>
 #include <QtCore/QStringBuilder>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QMessageBox>
@@ -26,6 +27,7 @@
 #include <iostream>
 
 #include <libmbp/logging.h>
+#include <libmbp/tracing.h>
 
 #ifdef PORTABLE
 #  if defined(DATA_DIR)
@@ -44,6 +46,21 @@ int main(int argc, char *argv[])
 
     a.setApplicationName(QObject::tr("Dual Boot Patcher"));
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption traceOption(
+            QStringLiteral("trace"),
+            QObject::tr("Record libmbp trace spans and write them to <file> "
+                        "in the Chrome trace event format on exit."),
+            QObject::tr("file"));
+    parser.addOption(traceOption);
+    parser.process(a);
+
+    QString tracePath = parser.value(traceOption);
+    if (!tracePath.isEmpty()) {
+        mbp::setTracingEnabled(true);
+    }
+
     mbp::PatcherConfig pc;
 
 #ifdef PORTABLE
@@ -55,5 +72,12 @@ int main(int argc, char *argv[])
     MainWindow w(&pc);
     w.show();
 
-    return a.exec();
+    int ret = a.exec();
+
+    if (!tracePath.isEmpty() && !mbp::writeChromeTrace(tracePath.toStdString())) {
+        std::cerr << "Failed to write trace to "
+                  << tracePath.toStdString() << std::endl;
+    }
+
+    return ret;
 }
@@ -25,6 +25,7 @@
 #include "private/fileutils.h"
 #include "private/logging.h"
 #include "private/stringutils.h"
+#include "private/tracing.h"
 
 #define DUMP_DEBUG 0
 
@@ -660,6 +661,8 @@ replaceEdifyRangeSha1(std::vector<EdifyToken *> *tokens,
 
 bool StandardPatcher::patchFiles(const std::string &directory)
 {
+    TraceSpan span("autopatcher", "StandardPatcher::patchFiles");
+
     std::string contents;
 
     FileUtils::readToString(directory + "/" + UpdaterScript, &contents);
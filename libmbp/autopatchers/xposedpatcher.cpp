@@ -24,6 +24,7 @@
 #include "private/fileutils.h"
 #include "private/logging.h"
 #include "private/stringutils.h"
+#include "private/tracing.h"
 
 
 namespace mbp
@@ -79,6 +80,8 @@ std::vector<std::string> XposedPatcher::existingFiles() const
 
 bool XposedPatcher::patchFiles(const std::string &directory)
 {
+    TraceSpan span("autopatcher", "XposedPatcher::patchFiles");
+
     std::string contents;
 
     ErrorCode ret = FileUtils::readToString(
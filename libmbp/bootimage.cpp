@@ -20,10 +20,14 @@
 #include "bootimage.h"
 
 #include <algorithm>
+#include <initializer_list>
 
 #include <cstring>
 
 #include "libmbpio/file.h"
+#include "libmbpio/mappedfile.h"
+
+#include "cancellation.h"
 
 #include "bootimage/androidformat.h"
 #include "bootimage/bumpformat.h"
@@ -31,8 +35,9 @@
 #include "bootimage/mtkformat.h"
 #include "bootimage/sonyelfformat.h"
 
-#include "private/fileutils.h"
 #include "private/logging.h"
+#include "private/memory.h"
+#include "private/tracing.h"
 
 
 namespace mbp
@@ -73,7 +78,157 @@ public:
     BootImage::Type sourceType;
 
     ErrorCode error;
+
+    // Total size of the images copied out of the boot image
+    MemoryCharge charge;
+
+    const CancellationToken *token = nullptr;
+
+    bool shouldContinue();
+    bool loadImage(const unsigned char *data, std::size_t size);
+    void updateMemoryCharge();
 };
+
+static const char * type_name(BootImage::Type type)
+{
+    switch (type) {
+    case BootImage::Type::Android:
+        return "android";
+    case BootImage::Type::Bump:
+        return "bump";
+    case BootImage::Type::Loki:
+        return "loki";
+    case BootImage::Type::Mtk:
+        return "mtk";
+    case BootImage::Type::SonyElf:
+        return "sonyelf";
+    default:
+        return "unknown";
+    }
+}
+
+/*!
+ * \brief Read a file that could not be mapped into memory
+ *
+ * This is used for inputs like pipes and character devices, which have no
+ * usable size and must be read until EOF.
+ */
+static ErrorCode read_unmappable(const std::string &filename,
+                                 std::vector<unsigned char> *data)
+{
+    io::File file;
+    if (!file.open(filename, io::File::OpenRead)) {
+        FLOGE("%s: Failed to open for reading: %s",
+              filename.c_str(), file.errorString().c_str());
+        return ErrorCode::FileOpenError;
+    }
+
+    std::vector<unsigned char> buf(1024 * 1024);
+    uint64_t bytesRead;
+
+    data->clear();
+
+    while (file.read(buf.data(), buf.size(), &bytesRead)) {
+        data->insert(data->end(), buf.begin(), buf.begin() + bytesRead);
+    }
+    if (file.error() != io::File::ErrorEndOfFile) {
+        FLOGE("%s: Failed to read file: %s",
+              filename.c_str(), file.errorString().c_str());
+        return ErrorCode::FileReadError;
+    }
+
+    return ErrorCode::NoError;
+}
+
+bool BootImage::Impl::shouldContinue()
+{
+    if (token && !token->checkpoint()) {
+        error = ErrorCode::PatchingCancelled;
+        return false;
+    }
+    return true;
+}
+
+bool BootImage::Impl::loadImage(const unsigned char *data, std::size_t size)
+{
+    if (!shouldContinue()) {
+        return false;
+    }
+
+    TraceSpan span("bootimage", i10e.headerOnly ? "inspect" : "load");
+    span.addArg("size", size);
+
+    // The formats only record the sections they have, so don't report the
+    // sections of a previously loaded image
+    for (BootImageSection *section : {
+            &i10e.kernelSection, &i10e.ramdiskSection, &i10e.secondSection,
+            &i10e.dtSection, &i10e.mtkKernelHdrSection,
+            &i10e.mtkRamdiskHdrSection, &i10e.iplSection, &i10e.rpmSection,
+            &i10e.appsblSection, &i10e.sonySinSection,
+            &i10e.sonySinHdrSection }) {
+        *section = BootImageSection();
+    }
+
+    bool ret = false;
+
+    if (LokiFormat::isValid(data, size)) {
+        LOGD("Boot image is a loki'd Android boot image");
+        sourceType = Type::Loki;
+        // We can't repatch with Loki until we have access to the aboot
+        // partition
+        type = Type::Android;
+        ret = LokiFormat(&i10e).loadImage(data, size);
+    } else if (BumpFormat::isValid(data, size)) {
+        LOGD("Boot image is a bump'd Android boot image");
+        sourceType = Type::Bump;
+        type = Type::Bump;
+        ret = BumpFormat(&i10e).loadImage(data, size);
+    } else if (MtkFormat::isValid(data, size)) {
+        LOGD("Boot image is an mtk boot image");
+        sourceType = Type::Mtk;
+        type = Type::Mtk;
+        ret = MtkFormat(&i10e).loadImage(data, size);
+    } else if (AndroidFormat::isValid(data, size)) {
+        LOGD("Boot image is a plain boot image");
+        sourceType = Type::Android;
+        type = Type::Android;
+        ret = AndroidFormat(&i10e).loadImage(data, size);
+    } else if (SonyElfFormat::isValid(data, size)) {
+        LOGD("Boot image is a Sony ELF32 boot image");
+        sourceType = Type::SonyElf;
+        type = Type::SonyElf;
+        ret = SonyElfFormat(&i10e).loadImage(data, size);
+    } else {
+        LOGD("Unknown boot image type");
+    }
+
+    if (ret && span.active()) {
+        span.addArg("format", type_name(sourceType));
+    }
+
+    if (!ret) {
+        error = ErrorCode::BootImageParseError;
+        return false;
+    }
+
+    updateMemoryCharge();
+
+    return true;
+}
+
+void BootImage::Impl::updateMemoryCharge()
+{
+    charge.set(i10e.kernelImage.size()
+            + i10e.ramdiskImage.size()
+            + i10e.secondImage.size()
+            + i10e.dtImage.size()
+            + i10e.abootImage.size()
+            + i10e.mtkKernelHdr.size()
+            + i10e.mtkRamdiskHdr.size()
+            + i10e.iplImage.size()
+            + i10e.rpmImage.size()
+            + i10e.appsblImage.size());
+}
 /*! \endcond */
 
 
@@ -147,6 +302,21 @@ ErrorCode BootImage::error() const
     return m_impl->error;
 }
 
+/*!
+ * \brief Set the token used for cancelling or pausing loading and creation
+ *
+ * The token is checked before parsing, before and after building the new boot
+ * image, and while writing it in createFile(). If the operation is cancelled,
+ * it will fail with ErrorCode::PatchingCancelled.
+ *
+ * \param token Cancellation token or nullptr to disable. The token must
+ *              outlive any operation that uses it.
+ */
+void BootImage::setCancellationToken(const CancellationToken *token)
+{
+    m_impl->token = token;
+}
+
 bool BootImage::isValid(const unsigned char *data, std::size_t size)
 {
     return LokiFormat::isValid(data, size)
@@ -158,45 +328,8 @@ bool BootImage::isValid(const unsigned char *data, std::size_t size)
 
 bool BootImage::load(const unsigned char *data, std::size_t size)
 {
-    bool ret = false;
-
-    if (LokiFormat::isValid(data, size)) {
-        LOGD("Boot image is a loki'd Android boot image");
-        m_impl->sourceType = Type::Loki;
-        // We can't repatch with Loki until we have access to the aboot
-        // partition
-        m_impl->type = Type::Android;
-        ret = LokiFormat(&m_impl->i10e).loadImage(data, size);
-    } else if (BumpFormat::isValid(data, size)) {
-        LOGD("Boot image is a bump'd Android boot image");
-        m_impl->sourceType = Type::Bump;
-        m_impl->type = Type::Bump;
-        ret = BumpFormat(&m_impl->i10e).loadImage(data, size);
-    } else if (MtkFormat::isValid(data, size)) {
-        LOGD("Boot image is an mtk boot image");
-        m_impl->sourceType = Type::Mtk;
-        m_impl->type = Type::Mtk;
-        ret = MtkFormat(&m_impl->i10e).loadImage(data, size);
-    } else if (AndroidFormat::isValid(data, size)) {
-        LOGD("Boot image is a plain boot image");
-        m_impl->sourceType = Type::Android;
-        m_impl->type = Type::Android;
-        ret = AndroidFormat(&m_impl->i10e).loadImage(data, size);
-    } else if (SonyElfFormat::isValid(data, size)) {
-        LOGD("Boot image is a Sony ELF32 boot image");
-        m_impl->sourceType = Type::SonyElf;
-        m_impl->type = Type::SonyElf;
-        ret = SonyElfFormat(&m_impl->i10e).loadImage(data, size);
-    } else {
-        LOGD("Unknown boot image type");
-    }
-
-    if (!ret) {
-        m_impl->error = ErrorCode::BootImageParseError;
-        return false;
-    }
-
-    return true;
+    m_impl->i10e.headerOnly = false;
+    return m_impl->loadImage(data, size);
 }
 
 /*!
@@ -220,8 +353,10 @@ bool BootImage::load(const std::vector<unsigned char> &data)
 /*!
  * \brief Load a boot image file
  *
- * This function reads a boot image file and then calls
- * BootImage::load(const std::vector<unsigned char> &)
+ * This function maps a boot image file into memory and then calls
+ * BootImage::load(const unsigned char *, std::size_t). The file is never
+ * copied into an intermediate buffer, except for inputs that cannot be mapped
+ * (eg. pipes), which are read into memory instead. Block devices are mapped.
  *
  * \warning If the boot image cannot be loaded, do not use the same BootImage
  *          object to load another boot image as it may contain partially
@@ -233,14 +368,26 @@ bool BootImage::load(const std::vector<unsigned char> &data)
  */
 bool BootImage::loadFile(const std::string &filename)
 {
-    std::vector<unsigned char> data;
-    auto ret = FileUtils::readToMemory(filename, &data);
-    if (ret != ErrorCode::NoError) {
-        m_impl->error = ret;
-        return false;
+    io::MappedFile file;
+    if (!file.map(filename, io::MappedFile::MapRead)) {
+        FLOGD("%s: Cannot map file (%s); reading it instead",
+              filename.c_str(), file.errorString().c_str());
+
+        std::vector<unsigned char> data;
+        ErrorCode ret = read_unmappable(filename, &data);
+        if (ret != ErrorCode::NoError) {
+            m_impl->error = ret;
+            return false;
+        }
+
+        return load(data.data(), data.size());
     }
 
-    return load(data);
+    // Formats are detected by searching the headers and the sections are then
+    // copied out in order
+    file.advise(io::MappedFile::AdviceSequential);
+
+    return load(file.data(), file.size());
 }
 
 /*!
@@ -253,6 +400,20 @@ bool BootImage::loadFile(const std::string &filename)
  */
 bool BootImage::create(std::vector<unsigned char> *data) const
 {
+    if (m_impl->i10e.headerOnly) {
+        LOGE("Cannot create boot image from one loaded with inspect()");
+        return false;
+    }
+
+    if (!m_impl->shouldContinue()) {
+        return false;
+    }
+
+    TraceSpan span("bootimage", "create");
+    if (span.active()) {
+        span.addArg("format", type_name(m_impl->type));
+    }
+
     bool ret = false;
 
     switch (m_impl->type) {
@@ -281,6 +442,20 @@ bool BootImage::create(std::vector<unsigned char> *data) const
         break;
     }
 
+    if (ret && !m_impl->shouldContinue()) {
+        ret = false;
+    }
+
+    if (ret) {
+        span.addArg("size", data->size());
+
+        // The images may have been replaced since the boot image was loaded.
+        // The output buffer belongs to the caller, so it is only counted
+        // towards the peak.
+        m_impl->updateMemoryCharge();
+        MemoryCharge outputCharge(data->size());
+    }
+
     return ret;
 }
 
@@ -310,15 +485,158 @@ bool BootImage::createFile(const std::string &path)
         return false;
     }
 
-    uint64_t bytesWritten;
-    if (!file.write(data.data(), data.size(), &bytesWritten)) {
-        FLOGE("%s: Failed to write file: %s",
-              path.c_str(), file.errorString().c_str());
+    // The final size is known, so reserve the space up front
+    file.preallocate(data.size());
+
+    // Write in chunks so that cancellation does not wait for the whole image
+    const unsigned char *ptr = data.data();
+    std::size_t remaining = data.size();
+
+    while (remaining > 0) {
+        if (!m_impl->shouldContinue()) {
+            return false;
+        }
+
+        std::size_t chunk = std::min<std::size_t>(remaining, 1024 * 1024);
+
+        uint64_t bytesWritten;
+        if (!file.write(ptr, chunk, &bytesWritten)) {
+            FLOGE("%s: Failed to write file: %s",
+                  path.c_str(), file.errorString().c_str());
+
+            m_impl->error = ErrorCode::FileWriteError;
+            return false;
+        }
+
+        ptr += bytesWritten;
+        remaining -= bytesWritten;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Load only the headers of a boot image
+ *
+ * This function parses the boot image headers like
+ * BootImage::load(const unsigned char *, std::size_t), but does not copy the
+ * images (eg. kernel and ramdisk) out of \p data. Their locations can be
+ * queried with sectionLocation() and the image accessors will return empty
+ * data. A BootImage loaded this way cannot be used to create a new boot image.
+ *
+ * \note Some formats need to look at more than just the header. Bump'd images
+ *       are detected by their trailing magic string, the mtk headers are at the
+ *       beginning of the kernel and ramdisk images, and old-style loki images
+ *       have to be searched for the ramdisk.
+ *
+ * \return Whether the boot image headers were successfully read and parsed
+ */
+bool BootImage::inspect(const unsigned char *data, std::size_t size)
+{
+    m_impl->i10e.headerOnly = true;
+    return m_impl->loadImage(data, size);
+}
+
+/*!
+ * \brief Load only the headers of a boot image file
+ *
+ * The file is mapped into memory and only the pages that are needed to parse
+ * the headers are read from disk. Files that cannot be mapped, such as pipes,
+ * are read in full instead.
+ *
+ * \sa BootImage::inspect(const unsigned char *, std::size_t)
+ *
+ * \return Whether the boot image headers were successfully read and parsed
+ */
+bool BootImage::inspectFile(const std::string &filename)
+{
+    io::MappedFile file;
+    if (!file.map(filename, io::MappedFile::MapRead)) {
+        FLOGD("%s: Cannot map file (%s); reading it instead",
+              filename.c_str(), file.errorString().c_str());
+
+        std::vector<unsigned char> data;
+        ErrorCode ret = read_unmappable(filename, &data);
+        if (ret != ErrorCode::NoError) {
+            m_impl->error = ret;
+            return false;
+        }
+
+        return inspect(data.data(), data.size());
+    }
+
+    // Avoid reading ahead into the images that won't be touched
+    file.advise(io::MappedFile::AdviceRandom);
+
+    return inspect(file.data(), file.size());
+}
+
+/*!
+ * \brief Whether the boot image was loaded with inspect() or inspectFile()
+ */
+bool BootImage::isHeaderOnly() const
+{
+    return m_impl->i10e.headerOnly;
+}
+
+/*!
+ * \brief Get the location of an image in the source boot image
+ *
+ * \param[in] section Section to look up
+ * \param[out] offset Offset of the image in the source file
+ * \param[out] size Size of the image
+ *
+ * \return Whether the image exists in the source boot image
+ */
+bool BootImage::sectionLocation(Section section,
+                                uint64_t *offset, uint64_t *size) const
+{
+    const BootImageSection *s;
+
+    switch (section) {
+    case Section::Kernel:
+        s = &m_impl->i10e.kernelSection;
+        break;
+    case Section::Ramdisk:
+        s = &m_impl->i10e.ramdiskSection;
+        break;
+    case Section::SecondBootloader:
+        s = &m_impl->i10e.secondSection;
+        break;
+    case Section::DeviceTree:
+        s = &m_impl->i10e.dtSection;
+        break;
+    case Section::KernelMtkHeader:
+        s = &m_impl->i10e.mtkKernelHdrSection;
+        break;
+    case Section::RamdiskMtkHeader:
+        s = &m_impl->i10e.mtkRamdiskHdrSection;
+        break;
+    case Section::Ipl:
+        s = &m_impl->i10e.iplSection;
+        break;
+    case Section::Rpm:
+        s = &m_impl->i10e.rpmSection;
+        break;
+    case Section::Appsbl:
+        s = &m_impl->i10e.appsblSection;
+        break;
+    case Section::SonySin:
+        s = &m_impl->i10e.sonySinSection;
+        break;
+    case Section::SonySinHeader:
+        s = &m_impl->i10e.sonySinHdrSection;
+        break;
+    default:
+        return false;
+    }
 
-        m_impl->error = ErrorCode::FileWriteError;
+    if (!s->present) {
         return false;
     }
 
+    *offset = s->offset;
+    *size = s->size;
     return true;
 }
 
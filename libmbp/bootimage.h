@@ -30,6 +30,8 @@
 namespace mbp
 {
 
+class CancellationToken;
+
 class MBP_EXPORT BootImage
 {
 public:
@@ -67,11 +69,28 @@ public:
         SonyElf = 5
     };
 
+    enum class Section : int
+    {
+        Kernel,
+        Ramdisk,
+        SecondBootloader,
+        DeviceTree,
+        KernelMtkHeader,
+        RamdiskMtkHeader,
+        Ipl,
+        Rpm,
+        Appsbl,
+        SonySin,
+        SonySinHeader
+    };
+
     BootImage();
     ~BootImage();
 
     ErrorCode error() const;
 
+    void setCancellationToken(const CancellationToken *token);
+
     static bool isValid(const unsigned char *data, std::size_t size);
 
     bool load(const unsigned char *data, std::size_t size);
@@ -80,6 +99,12 @@ public:
     bool create(std::vector<unsigned char> *data) const;
     bool createFile(const std::string &path);
 
+    bool inspect(const unsigned char *data, std::size_t size);
+    bool inspectFile(const std::string &filename);
+    bool isHeaderOnly() const;
+    bool sectionLocation(Section section,
+                         uint64_t *offset, uint64_t *size) const;
+
     Type wasType() const;
     Type targetType() const;
     void setTargetType(Type type);
@@ -84,7 +84,8 @@ bool AndroidFormat::loadImage(const unsigned char *data, std::size_t size)
         return false;
     }
 
-    mI10e->kernelImage.assign(data + pos, data + pos + mI10e->hdrKernelSize);
+    loadSection(&mI10e->kernelImage, &mI10e->kernelSection, data,
+                data + pos, data + pos + mI10e->hdrKernelSize);
 
     // Save ramdisk image
     pos += mI10e->hdrKernelSize;
@@ -95,7 +96,8 @@ bool AndroidFormat::loadImage(const unsigned char *data, std::size_t size)
         return false;
     }
 
-    mI10e->ramdiskImage.assign(data + pos, data + pos + mI10e->hdrRamdiskSize);
+    loadSection(&mI10e->ramdiskImage, &mI10e->ramdiskSection, data,
+                data + pos, data + pos + mI10e->hdrRamdiskSize);
 
     // Save second bootloader image
     pos += mI10e->hdrRamdiskSize;
@@ -108,9 +110,10 @@ bool AndroidFormat::loadImage(const unsigned char *data, std::size_t size)
 
     // The second bootloader may not exist
     if (mI10e->hdrSecondSize > 0) {
-        mI10e->secondImage.assign(data + pos, data + pos + mI10e->hdrSecondSize);
+        loadSection(&mI10e->secondImage, &mI10e->secondSection, data,
+                    data + pos, data + pos + mI10e->hdrSecondSize);
     } else {
-        mI10e->secondImage.clear();
+        clearSection(&mI10e->secondImage, &mI10e->secondSection);
     }
 
     // Save device tree image
@@ -125,14 +128,16 @@ bool AndroidFormat::loadImage(const unsigned char *data, std::size_t size)
               " bytes and HAS BEEN TRUNCATED", diff);
         FLOGE("WARNING WARNING WARNING WARNING WARNING WARNING WARNING WARNING");
 
-        mI10e->dtImage.assign(data + pos, data + pos + mI10e->hdrDtSize - diff);
+        loadSection(&mI10e->dtImage, &mI10e->dtSection, data,
+                    data + pos, data + pos + mI10e->hdrDtSize - diff);
     } else {
-        mI10e->dtImage.assign(data + pos, data + pos + mI10e->hdrDtSize);
+        loadSection(&mI10e->dtImage, &mI10e->dtSection, data,
+                    data + pos, data + pos + mI10e->hdrDtSize);
     }
 
     // The device tree image may not exist as well
     if (mI10e->hdrDtSize == 0) {
-        mI10e->dtImage.clear();
+        clearSection(&mI10e->dtImage, &mI10e->dtSection);
     }
 
     pos += mI10e->hdrDtSize;
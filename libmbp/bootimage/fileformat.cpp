@@ -30,4 +30,40 @@ BootImageFormat::~BootImageFormat()
 {
 }
 
+/*!
+ * \brief Record the location of an image and copy it if needed
+ *
+ * \param image Image vector in the intermediate representation
+ * \param section Section info for \p image
+ * \param data Beginning of the source boot image
+ * \param begin Beginning of the image within \p data
+ * \param end End of the image within \p data
+ *
+ * The image is only copied into \p image if the boot image is not being
+ * loaded in header-only mode.
+ */
+void BootImageFormat::loadSection(std::vector<unsigned char> *image,
+                                  BootImageSection *section,
+                                  const unsigned char *data,
+                                  const unsigned char *begin,
+                                  const unsigned char *end)
+{
+    section->present = true;
+    section->offset = begin - data;
+    section->size = end - begin;
+
+    if (mI10e->headerOnly) {
+        image->clear();
+    } else {
+        image->assign(begin, end);
+    }
+}
+
+void BootImageFormat::clearSection(std::vector<unsigned char> *image,
+                                   BootImageSection *section)
+{
+    *section = BootImageSection();
+    image->clear();
+}
+
 }
@@ -39,6 +39,14 @@ public:
     virtual bool createImage(std::vector<unsigned char> *dataOut) = 0;
 
 protected:
+    void loadSection(std::vector<unsigned char> *image,
+                     BootImageSection *section,
+                     const unsigned char *data,
+                     const unsigned char *begin,
+                     const unsigned char *end);
+    void clearSection(std::vector<unsigned char> *image,
+                      BootImageSection *section);
+
     BootImageIntermediate *mI10e;
 };
 
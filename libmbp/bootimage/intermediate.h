@@ -17,11 +17,24 @@
  * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#pragma once
+
+#include <string>
 #include <unordered_map>
 #include <vector>
 
+#include <cstdint>
+
 class BootImageFormat;
 
+// Location of an image within the source boot image
+struct BootImageSection
+{
+    bool present = false;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
 struct BootImageIntermediate
 {
     // Used in:                                  | Android | Loki | Bump | Mtk | Sony |
@@ -55,4 +68,19 @@ struct BootImageIntermediate
     uint32_t hdrUnused = 0;                   // | X       | X    | X    | X   |      |
     uint32_t hdrId[8] = { 0 };                // | X       | X    | X    | X   |      |
     uint32_t hdrEntrypoint = 0;               // |         |      |      |     | X    |
+    // Image locations in the source file        |---------|------|------|-----|------|
+    BootImageSection kernelSection;           // | X       | X    | X    | X   | X    |
+    BootImageSection ramdiskSection;          // | X       | X    | X    | X   | X    |
+    BootImageSection secondSection;           // | X       | X    | X    | X   |      |
+    BootImageSection dtSection;               // | X       | X    | X    | X   |      |
+    BootImageSection mtkKernelHdrSection;     // |         |      |      | X   |      |
+    BootImageSection mtkRamdiskHdrSection;    // |         |      |      | X   |      |
+    BootImageSection iplSection;              // |         |      |      |     | X    |
+    BootImageSection rpmSection;              // |         |      |      |     | X    |
+    BootImageSection appsblSection;           // |         |      |      |     | X    |
+    BootImageSection sonySinSection;          // |         |      |      |     | X    |
+    BootImageSection sonySinHdrSection;       // |         |      |      |     | X    |
+    // If true, only the locations of the images are recorded when loading and
+    // the image vectors are left empty
+    bool headerOnly = false;
 };
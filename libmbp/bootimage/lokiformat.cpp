@@ -141,25 +141,26 @@ bool LokiFormat::loadLokiNewImage(const unsigned char *data, std::size_t size,
     uint32_t pageRamdiskSize = (loki->orig_ramdisk_size + pageMask) & ~pageMask;
 
     // Kernel image
-    mI10e->kernelImage.assign(
-            data + mI10e->pageSize,
-            data + mI10e->pageSize + loki->orig_kernel_size);
+    loadSection(&mI10e->kernelImage, &mI10e->kernelSection, data,
+                data + mI10e->pageSize,
+                data + mI10e->pageSize + loki->orig_kernel_size);
 
     // Ramdisk image
-    mI10e->ramdiskImage.assign(
-            data + mI10e->pageSize + pageKernelSize,
-            data + mI10e->pageSize + pageKernelSize + loki->orig_ramdisk_size);
+    loadSection(&mI10e->ramdiskImage, &mI10e->ramdiskSection, data,
+                data + mI10e->pageSize + pageKernelSize,
+                data + mI10e->pageSize + pageKernelSize + loki->orig_ramdisk_size);
 
     // No second bootloader image
-    mI10e->secondImage.clear();
+    clearSection(&mI10e->secondImage, &mI10e->secondSection);
 
     // Possible device tree image
     if (mI10e->hdrDtSize != 0) {
         auto startPtr = data + mI10e->pageSize
                 + pageKernelSize + pageRamdiskSize + fakeSize;
-        mI10e->dtImage.assign(startPtr, startPtr + mI10e->hdrDtSize);
+        loadSection(&mI10e->dtImage, &mI10e->dtSection, data,
+                    startPtr, startPtr + mI10e->hdrDtSize);
     } else {
-        mI10e->dtImage.clear();
+        clearSection(&mI10e->dtImage, &mI10e->dtSection);
     }
 
     return true;
@@ -215,20 +216,20 @@ bool LokiFormat::loadLokiOldImage(const unsigned char *data, std::size_t size,
     mI10e->ramdiskAddr = ramdiskAddr;
 
     // Kernel image
-    mI10e->kernelImage.assign(
-            data + mI10e->pageSize,
-            data + mI10e->pageSize + kernelSize);
+    loadSection(&mI10e->kernelImage, &mI10e->kernelSection, data,
+                data + mI10e->pageSize,
+                data + mI10e->pageSize + kernelSize);
 
     // Ramdisk image
-    mI10e->ramdiskImage.assign(
-            data + gzipOffset,
-            data + gzipOffset + ramdiskSize);
+    loadSection(&mI10e->ramdiskImage, &mI10e->ramdiskSection, data,
+                data + gzipOffset,
+                data + gzipOffset + ramdiskSize);
 
     // No second bootloader image
-    mI10e->secondImage.clear();
+    clearSection(&mI10e->secondImage, &mI10e->secondSection);
 
     // No device tree image
-    mI10e->dtImage.clear();
+    clearSection(&mI10e->dtImage, &mI10e->dtSection);
 
     return true;
 }
@@ -124,13 +124,17 @@ bool MtkFormat::loadImage(const unsigned char *data, std::size_t size)
 
     // Check if the kernel has an mtk header
     if (mI10e->hdrKernelSize >= sizeof(MtkHeader)) {
-        auto mtkHdr = reinterpret_cast<const MtkHeader *>(mI10e->kernelImage.data());
+        // Read from the source data since the image is not copied in
+        // header-only mode
+        const unsigned char *begin = data + mI10e->kernelSection.offset;
+        const unsigned char *end = begin + mI10e->kernelSection.size;
+        auto mtkHdr = reinterpret_cast<const MtkHeader *>(begin);
         // Check magic
         if (std::memcmp(mtkHdr->magic, MTK_MAGIC, MTK_MAGIC_SIZE) == 0) {
             dumpMtkHeader(mtkHdr);
 
             std::size_t expected = sizeof(MtkHeader) + mtkHdr->size;
-            std::size_t actual = mI10e->kernelImage.size();
+            std::size_t actual = mI10e->kernelSection.size;
 
             // Check size
             if (actual < expected) {
@@ -143,14 +147,14 @@ bool MtkFormat::loadImage(const unsigned char *data, std::size_t size)
                 FLOGW("Repacked boot image will not be byte-for-byte identical to original");
             }
 
-            // Move header to mI10e->mtkKernelHdr
-            mI10e->mtkKernelHdr.assign(
-                    mI10e->kernelImage.begin(),
-                    mI10e->kernelImage.begin() + sizeof(MtkHeader));
-            std::vector<unsigned char>(
-                    mI10e->kernelImage.begin() + sizeof(MtkHeader),
-                    mI10e->kernelImage.end())
-                    .swap(mI10e->kernelImage);
+            // Move header to mI10e->mtkKernelHdr. This is done even in
+            // header-only mode since the size field needs to be cleared.
+            mI10e->mtkKernelHdr.assign(begin, begin + sizeof(MtkHeader));
+            mI10e->mtkKernelHdrSection.present = true;
+            mI10e->mtkKernelHdrSection.offset = begin - data;
+            mI10e->mtkKernelHdrSection.size = sizeof(MtkHeader);
+            loadSection(&mI10e->kernelImage, &mI10e->kernelSection, data,
+                        begin + sizeof(MtkHeader), end);
 
             auto newMtkHdr = reinterpret_cast<MtkHeader *>(mI10e->mtkKernelHdr.data());
             newMtkHdr->size = 0;
@@ -159,13 +163,17 @@ bool MtkFormat::loadImage(const unsigned char *data, std::size_t size)
 
     // Check if the ramdisk has an mtk header
     if (mI10e->hdrRamdiskSize >= sizeof(MtkHeader)) {
-        auto mtkHdr = reinterpret_cast<const MtkHeader *>(mI10e->ramdiskImage.data());
+        // Read from the source data since the image is not copied in
+        // header-only mode
+        const unsigned char *begin = data + mI10e->ramdiskSection.offset;
+        const unsigned char *end = begin + mI10e->ramdiskSection.size;
+        auto mtkHdr = reinterpret_cast<const MtkHeader *>(begin);
         // Check magic
         if (std::memcmp(mtkHdr->magic, MTK_MAGIC, MTK_MAGIC_SIZE) == 0) {
             dumpMtkHeader(mtkHdr);
 
             std::size_t expected = sizeof(MtkHeader) + mtkHdr->size;
-            std::size_t actual = mI10e->ramdiskImage.size();
+            std::size_t actual = mI10e->ramdiskSection.size;
 
             // Check size
             if (actual != expected) {
@@ -174,14 +182,14 @@ bool MtkFormat::loadImage(const unsigned char *data, std::size_t size)
                 return false;
             }
 
-            // Move header to mI10e->mtkRamdiskHdr
-            mI10e->mtkRamdiskHdr.assign(
-                    mI10e->ramdiskImage.begin(),
-                    mI10e->ramdiskImage.begin() + sizeof(MtkHeader));
-            std::vector<unsigned char>(
-                    mI10e->ramdiskImage.begin() + sizeof(MtkHeader),
-                    mI10e->ramdiskImage.end())
-                    .swap(mI10e->ramdiskImage);
+            // Move header to mI10e->mtkRamdiskHdr. This is done even in
+            // header-only mode since the size field needs to be cleared.
+            mI10e->mtkRamdiskHdr.assign(begin, begin + sizeof(MtkHeader));
+            mI10e->mtkRamdiskHdrSection.present = true;
+            mI10e->mtkRamdiskHdrSection.offset = begin - data;
+            mI10e->mtkRamdiskHdrSection.size = sizeof(MtkHeader);
+            loadSection(&mI10e->ramdiskImage, &mI10e->ramdiskSection, data,
+                        begin + sizeof(MtkHeader), end);
 
             auto newMtkHdr = reinterpret_cast<MtkHeader *>(mI10e->mtkRamdiskHdr.data());
             newMtkHdr->size = 0;
@@ -174,26 +174,31 @@ bool SonyElfFormat::loadImage(const unsigned char *data, std::size_t size)
 
         if (phdr->p_type == SONY_E_TYPE_KERNEL
                 && phdr->p_flags == SONY_E_FLAGS_KERNEL) {
-            mI10e->kernelImage.assign(begin, end);
+            loadSection(&mI10e->kernelImage, &mI10e->kernelSection,
+                        data, begin, end);
             mI10e->kernelAddr = phdr->p_vaddr;
         } else if (phdr->p_type == SONY_E_TYPE_RAMDISK
                 && phdr->p_flags == SONY_E_FLAGS_RAMDISK) {
-            mI10e->ramdiskImage.assign(begin, end);
+            loadSection(&mI10e->ramdiskImage, &mI10e->ramdiskSection,
+                        data, begin, end);
             mI10e->ramdiskAddr = phdr->p_vaddr;
         } else if (phdr->p_type == SONY_E_TYPE_IPL
                 && phdr->p_flags == SONY_E_FLAGS_IPL) {
-            mI10e->iplImage.assign(begin, end);
+            loadSection(&mI10e->iplImage, &mI10e->iplSection,
+                        data, begin, end);
             mI10e->iplAddr = phdr->p_vaddr;
         } else if (phdr->p_type == SONY_E_TYPE_CMDLINE
                 && phdr->p_flags == SONY_E_FLAGS_CMDLINE) {
             mI10e->cmdline.assign(begin, end);
         } else if (phdr->p_type == SONY_E_TYPE_RPM
                 && phdr->p_flags == SONY_E_FLAGS_RPM) {
-            mI10e->rpmImage.assign(begin, end);
+            loadSection(&mI10e->rpmImage, &mI10e->rpmSection,
+                        data, begin, end);
             mI10e->rpmAddr = phdr->p_vaddr;
         } else if (phdr->p_type == SONY_E_TYPE_APPSBL
                 && phdr->p_flags == SONY_E_FLAGS_APPSBL) {
-            mI10e->appsblImage.assign(begin, end);
+            loadSection(&mI10e->appsblImage, &mI10e->appsblSection,
+                        data, begin, end);
             mI10e->appsblAddr = phdr->p_vaddr;
         } else if (phdr->p_type == SONY_E_TYPE_SIN) {
             // There are two extra bytes unaccounted for by p_filesz and
@@ -208,9 +213,15 @@ bool SonyElfFormat::loadImage(const unsigned char *data, std::size_t size)
                 end += 2;
             }
 
-            mI10e->sonySinImage.assign(begin, end);
+            loadSection(&mI10e->sonySinImage, &mI10e->sonySinSection,
+                        data, begin, end);
 
-            // Save header
+            // Save header. This is always copied since it is part of the
+            // program header table.
+            mI10e->sonySinHdrSection.present = true;
+            mI10e->sonySinHdrSection.offset =
+                    reinterpret_cast<const unsigned char *>(phdr) - data;
+            mI10e->sonySinHdrSection.size = sizeof(Sony_Elf32_Phdr);
             mI10e->sonySinHdr.resize(sizeof(Sony_Elf32_Phdr));
             std::memcpy(mI10e->sonySinHdr.data(), phdr,
                         sizeof(Sony_Elf32_Phdr));
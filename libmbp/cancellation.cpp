@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cancellation.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+
+namespace mbp
+{
+
+/*! \cond INTERNAL */
+class CancellationToken::Impl
+{
+public:
+    std::atomic<bool> cancelled;
+    std::atomic<bool> paused;
+
+    // Only needed for waking up threads blocked in checkpoint()
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+/*! \endcond */
+
+
+CancellationToken::CancellationToken() : m_impl(new Impl())
+{
+    m_impl->cancelled = false;
+    m_impl->paused = false;
+}
+
+CancellationToken::~CancellationToken()
+{
+}
+
+/*!
+ * \brief Request cancellation
+ *
+ * Operations will stop at their next checkpoint. This also wakes up operations
+ * that are paused.
+ */
+void CancellationToken::cancel()
+{
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->cancelled = true;
+    m_impl->cv.notify_all();
+}
+
+/*!
+ * \brief Check if cancellation was requested
+ */
+bool CancellationToken::isCancelled() const
+{
+    return m_impl->cancelled.load(std::memory_order_relaxed);
+}
+
+/*!
+ * \brief Pause operations at their next checkpoint
+ */
+void CancellationToken::pause()
+{
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->paused = true;
+}
+
+/*!
+ * \brief Resume paused operations
+ */
+void CancellationToken::resume()
+{
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->paused = false;
+    m_impl->cv.notify_all();
+}
+
+/*!
+ * \brief Check if operations are paused
+ */
+bool CancellationToken::isPaused() const
+{
+    return m_impl->paused.load(std::memory_order_relaxed);
+}
+
+/*!
+ * \brief Clear the cancelled and paused states so the token can be reused
+ */
+void CancellationToken::reset()
+{
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->cancelled = false;
+    m_impl->paused = false;
+    m_impl->cv.notify_all();
+}
+
+/*!
+ * \brief Wait while paused and check if the operation should continue
+ *
+ * This is cheap when the token is neither paused nor cancelled, so it can be
+ * called for every chunk of data that is processed.
+ *
+ * \return Whether the operation should continue (ie. it was not cancelled)
+ */
+bool CancellationToken::checkpoint() const
+{
+    if (m_impl->paused.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lock(m_impl->mutex);
+        m_impl->cv.wait(lock, [this] {
+            return !m_impl->paused || m_impl->cancelled;
+        });
+    }
+
+    return !m_impl->cancelled.load(std::memory_order_relaxed);
+}
+
+}
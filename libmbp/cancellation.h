@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "libmbp_global.h"
+
+
+namespace mbp
+{
+
+/*!
+ * \class CancellationToken
+ * \brief Cooperative cancellation and pausing of long-running operations
+ *
+ * Long-running operations (eg. copying zip entries or compressing a ramdisk)
+ * call checkpoint() between chunks of work. This allows a patch to be
+ * cancelled or paused from another thread without waiting for the current
+ * file to finish.
+ */
+class MBP_EXPORT CancellationToken
+{
+public:
+    CancellationToken();
+    ~CancellationToken();
+
+    void cancel();
+    bool isCancelled() const;
+
+    void pause();
+    void resume();
+    bool isPaused() const;
+
+    void reset();
+
+    bool checkpoint() const;
+
+    CancellationToken(const CancellationToken &) = delete;
+    CancellationToken & operator=(const CancellationToken &) = delete;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}
@@ -28,8 +28,13 @@
 #include <archive.h>
 #include <archive_entry.h>
 
-#include "private/fileutils.h"
+#include "libmbpio/mappedfile.h"
+
+#include "cancellation.h"
+
 #include "private/logging.h"
+#include "private/memory.h"
+#include "private/tracing.h"
 
 
 namespace mbp
@@ -45,6 +50,22 @@ enum Compression {
     LZMA
 };
 
+static const char * compression_name(Compression compression)
+{
+    switch (compression) {
+    case GZIP:
+        return "gzip";
+    case LZOP:
+        return "lzop";
+    case LZ4:
+        return "lz4";
+    case LZMA:
+        return "lzma";
+    default:
+        return "none";
+    }
+}
+
 /*! \cond INTERNAL */
 class CpioFile::Impl
 {
@@ -52,10 +73,24 @@ public:
     ~Impl();
 
     std::vector<FilePair> files;
+    // Total size of the file contents
+    MemoryCharge charge;
 
     Compression compression;
 
+    const CancellationToken *token = nullptr;
+
     ErrorCode error;
+
+    bool shouldContinue();
+    ErrorCode writeError(ErrorCode error) const;
+};
+
+// Passed to the libarchive write callbacks
+struct WriteContext
+{
+    std::vector<unsigned char> *data;
+    const CancellationToken *token;
 };
 /*! \endcond */
 
@@ -67,6 +102,24 @@ CpioFile::Impl::~Impl()
     }
 }
 
+bool CpioFile::Impl::shouldContinue()
+{
+    if (token && !token->checkpoint()) {
+        error = ErrorCode::PatchingCancelled;
+        return false;
+    }
+    return true;
+}
+
+// Failures caused by the write callback aborting are reported as cancellations
+ErrorCode CpioFile::Impl::writeError(ErrorCode error) const
+{
+    if (token && token->isCancelled()) {
+        return ErrorCode::PatchingCancelled;
+    }
+    return error;
+}
+
 
 /*!
  * \class CpioFile
@@ -104,6 +157,20 @@ ErrorCode CpioFile::error() const
     return m_impl->error;
 }
 
+/*!
+ * \brief Set the token used for cancelling or pausing load() and createData()
+ *
+ * If the operation is cancelled, it will fail with
+ * ErrorCode::PatchingCancelled.
+ *
+ * \param token Cancellation token or nullptr to disable. The token must
+ *              outlive any operation that uses it.
+ */
+void CpioFile::setCancellationToken(const CancellationToken *token)
+{
+    m_impl->token = token;
+}
+
 /*!
  * \brief Load a cpio archive from binary data
  *
@@ -118,6 +185,9 @@ ErrorCode CpioFile::error() const
  */
 bool CpioFile::load(const unsigned char *data, std::size_t size)
 {
+    TraceSpan span("cpio", "load");
+    span.addArg("size", size);
+
     if (size >= 2 && std::memcmp(data, "\x1f\x8b", 2) == 0) {
         m_impl->compression = GZIP;
     } else if (size >= 9 && std::memcmp(data, "\x89LZO\x00\r\n\x1a\n", 9) == 0) {
@@ -132,6 +202,10 @@ bool CpioFile::load(const unsigned char *data, std::size_t size)
         m_impl->compression = NONE;
     }
 
+    if (span.active()) {
+        span.addArg("compression", compression_name(m_impl->compression));
+    }
+
     archive *a;
     archive_entry *entry;
 
@@ -157,6 +231,11 @@ bool CpioFile::load(const unsigned char *data, std::size_t size)
     }
 
     while ((ret = archive_read_next_header(a, &entry)) == ARCHIVE_OK) {
+        if (!m_impl->shouldContinue()) {
+            archive_read_free(a);
+            return false;
+        }
+
         // Read the data for the entry
         std::vector<unsigned char> entryData;
         entryData.reserve(archive_entry_size(entry));
@@ -168,6 +247,11 @@ bool CpioFile::load(const unsigned char *data, std::size_t size)
 
         while ((r = archive_read_data_block(a, &buff,
                 &bytes_read, &offset)) == ARCHIVE_OK) {
+            if (!m_impl->shouldContinue()) {
+                archive_read_free(a);
+                return false;
+            }
+
             entryData.insert(entryData.end(),
                              reinterpret_cast<const char *>(buff),
                              reinterpret_cast<const char *>(buff) + bytes_read);
@@ -183,6 +267,7 @@ bool CpioFile::load(const unsigned char *data, std::size_t size)
 
         // Save the header and data
         archive_entry *cloned = archive_entry_clone(entry);
+        m_impl->charge.add(entryData.size());
         m_impl->files.push_back(std::make_pair(cloned, std::move(entryData)));
     }
 
@@ -220,7 +305,15 @@ static int archiveOpenCallback(archive *a, void *clientData)
 static __LA_SSIZE_T archiveWriteCallback(archive *, void *clientData,
                                          const void *buffer, size_t length)
 {
-    auto data = reinterpret_cast<std::vector<unsigned char> *>(clientData);
+    auto ctx = reinterpret_cast<WriteContext *>(clientData);
+
+    // The compressed output is written out in small blocks, so this is the
+    // only place where compressing a large file can be interrupted
+    if (ctx->token && !ctx->token->checkpoint()) {
+        return -1;
+    }
+
+    auto data = ctx->data;
     data->insert(data->end(),
                  reinterpret_cast<const char *>(buffer),
                  reinterpret_cast<const char *>(buffer) + length);
@@ -253,6 +346,12 @@ static bool sortByName(const FilePair &p1, const FilePair &p2)
  */
 bool CpioFile::createData(std::vector<unsigned char> *dataOut)
 {
+    TraceSpan span("cpio", "createData");
+    if (span.active()) {
+        span.addArg("compression", compression_name(m_impl->compression));
+        span.addArg("files", m_impl->files.size());
+    }
+
     std::vector<unsigned char> data;
     archive *a = archive_write_new();
 
@@ -274,7 +373,11 @@ bool CpioFile::createData(std::vector<unsigned char> *dataOut)
 
     archive_write_set_bytes_per_block(a, 512);
 
-    int ret = archive_write_open(a, reinterpret_cast<void *>(&data),
+    WriteContext ctx;
+    ctx.data = &data;
+    ctx.token = m_impl->token;
+
+    int ret = archive_write_open(a, reinterpret_cast<void *>(&ctx),
                                  &archiveOpenCallback,
                                  &archiveWriteCallback,
                                  &archiveCloseCallback);
@@ -288,11 +391,17 @@ bool CpioFile::createData(std::vector<unsigned char> *dataOut)
     }
 
     for (auto const &p : m_impl->files) {
+        if (!m_impl->shouldContinue()) {
+            archive_write_fail(a);
+            archive_write_free(a);
+            return false;
+        }
+
         if (archive_write_header(a, p.first) != ARCHIVE_OK) {
             FLOGW("libarchive: %s : %s",
                   archive_error_string(a),
                   archive_entry_pathname(p.first));
-            m_impl->error = ErrorCode::ArchiveWriteHeaderError;
+            m_impl->error = m_impl->writeError(ErrorCode::ArchiveWriteHeaderError);
 
             archive_write_fail(a);
             archive_write_free(a);
@@ -304,7 +413,7 @@ bool CpioFile::createData(std::vector<unsigned char> *dataOut)
             archive_write_fail(a);
             archive_write_free(a);
 
-            m_impl->error = ErrorCode::ArchiveWriteDataError;
+            m_impl->error = m_impl->writeError(ErrorCode::ArchiveWriteDataError);
             return false;
         }
     }
@@ -316,12 +425,18 @@ bool CpioFile::createData(std::vector<unsigned char> *dataOut)
         archive_write_fail(a);
         archive_write_free(a);
 
-        m_impl->error = ErrorCode::ArchiveCloseError;
+        m_impl->error = m_impl->writeError(ErrorCode::ArchiveCloseError);
         return false;
     }
 
     archive_write_free(a);
 
+    // Both the entries and the new archive are in memory at this point. The
+    // caller takes over the buffer, so it is only counted towards the peak.
+    MemoryCharge outputCharge(data.size());
+
+    span.addArg("size", data.size());
+
     dataOut->swap(data);
 
     return true;
@@ -364,6 +479,7 @@ bool CpioFile::remove(const std::string &name)
         archive_entry *entry = (*it).first;
         if (name == archive_entry_pathname(entry)) {
             archive_entry_free(entry);
+            m_impl->charge.release((*it).second.size());
             m_impl->files.erase(it);
             return true;
         }
@@ -421,6 +537,8 @@ bool CpioFile::setContents(const std::string &name,
     for (auto &p : m_impl->files) {
         if (name == archive_entry_pathname(p.first)) {
             archive_entry_set_size(p.first, data.size());
+            m_impl->charge.release(p.second.size());
+            m_impl->charge.add(data.size());
             p.second = std::move(data);
             return true;
         }
@@ -451,6 +569,8 @@ bool CpioFile::setContentsC(const std::string &name,
     for (auto &p : m_impl->files) {
         if (name == archive_entry_pathname(p.first)) {
             archive_entry_set_size(p.first, size);
+            m_impl->charge.release(p.second.size());
+            m_impl->charge.add(size);
             p.second.clear();
             p.second.shrink_to_fit();
             p.second.resize(size);
@@ -524,14 +644,17 @@ bool CpioFile::addFile(const std::string &path, const std::string &name,
         return false;
     }
 
-    std::vector<unsigned char> contents;
-    auto ret = FileUtils::readToMemory(path, &contents);
-    if (ret != ErrorCode::NoError) {
-        m_impl->error = ret;
+    io::MappedFile file;
+    if (!file.map(path, io::MappedFile::MapRead)) {
+        FLOGE("%s: Failed to map file: %s",
+              path.c_str(), file.errorString().c_str());
+        m_impl->error = ErrorCode::FileOpenError;
         return false;
     }
 
-    return addFile(std::move(contents), name, perms);
+    file.advise(io::MappedFile::AdviceSequential);
+
+    return addFileC(file.data(), file.size(), name, perms);
 }
 
 /*!
@@ -570,6 +693,7 @@ bool CpioFile::addFile(std::vector<unsigned char> contents,
     archive_entry_set_filetype(entry, AE_IFREG);
     archive_entry_set_perm(entry, perms);
 
+    m_impl->charge.add(contents.size());
     m_impl->files.push_back(std::make_pair(entry, std::move(contents)));
 
     std::sort(m_impl->files.begin(), m_impl->files.end(), sortByName);
@@ -602,6 +726,7 @@ bool CpioFile::addFileC(const unsigned char *data, std::size_t size,
     archive_entry_set_filetype(entry, AE_IFREG);
     archive_entry_set_perm(entry, perms);
 
+    m_impl->charge.add(size);
     m_impl->files.push_back(std::make_pair(
             entry, std::vector<unsigned char>(data, data + size)));
 
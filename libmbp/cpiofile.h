@@ -29,6 +29,8 @@
 namespace mbp
 {
 
+class CancellationToken;
+
 class MBP_EXPORT CpioFile
 {
 public:
@@ -37,6 +39,8 @@ public:
 
     ErrorCode error() const;
 
+    void setCancellationToken(const CancellationToken *token);
+
     bool load(const unsigned char *data, std::size_t size);
     bool load(const std::vector<unsigned char> &data);
     bool createData(std::vector<unsigned char> *dataOut);
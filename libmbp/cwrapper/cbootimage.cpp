@@ -125,6 +125,56 @@ bool mbp_bootimage_load_file(CBootImage *bootImage,
     return bi->loadFile(filename);
 }
 
+/*!
+ * \brief Load only the headers of a boot image from binary data
+ *
+ * \param bootImage CBootImage object
+ * \param data Byte array containing binary data
+ * \param size Size of byte array
+ *
+ * \return true on success or false on failure and error set appropriately
+ *
+ * \sa BootImage::inspect(const unsigned char *, std::size_t)
+ */
+bool mbp_bootimage_inspect_data(CBootImage *bootImage,
+                                const unsigned char *data, size_t size)
+{
+    CAST(bootImage);
+    return bi->inspect(data, size);
+}
+
+/*!
+ * \brief Load only the headers of a boot image file
+ *
+ * \param bootImage CBootImage object
+ * \param filename Path to boot image file
+ *
+ * \return true on success or false on failure and error set appropriately
+ *
+ * \sa BootImage::inspectFile(const std::string &)
+ */
+bool mbp_bootimage_inspect_file(CBootImage *bootImage,
+                                const char *filename)
+{
+    CAST(bootImage);
+    return bi->inspectFile(filename);
+}
+
+/*!
+ * \brief Whether the boot image was loaded with one of the inspect functions
+ *
+ * \param bootImage CBootImage object
+ *
+ * \return Whether only the headers were loaded
+ *
+ * \sa BootImage::isHeaderOnly()
+ */
+bool mbp_bootimage_is_header_only(const CBootImage *bootImage)
+{
+    CCAST(bootImage);
+    return bi->isHeaderOnly();
+}
+
 /*!
  * \brief Constructs the boot image binary data
  *
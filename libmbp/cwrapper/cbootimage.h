@@ -46,6 +46,11 @@ bool mbp_bootimage_load_data(CBootImage *bootImage,
                              const unsigned char *data, size_t size);
 bool mbp_bootimage_load_file(CBootImage *bootImage,
                              const char *filename);
+bool mbp_bootimage_inspect_data(CBootImage *bootImage,
+                                const unsigned char *data, size_t size);
+bool mbp_bootimage_inspect_file(CBootImage *bootImage,
+                                const char *filename);
+bool mbp_bootimage_is_header_only(const CBootImage *bootImage);
 
 bool mbp_bootimage_create_data(const CBootImage *bootImage,
                                unsigned char **data, size_t *size);
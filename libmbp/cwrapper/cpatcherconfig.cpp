@@ -154,6 +154,34 @@ void mbp_config_set_temp_directory(CPatcherConfig *pc, char *path)
     config->setTempDirectory(path);
 }
 
+/*!
+ * \brief Get the memory budget for patching
+ *
+ * \param pc CPatcherConfig object
+ * \return Memory budget in bytes or 0 if unlimited
+ *
+ * \sa PatcherConfig::memoryBudget()
+ */
+uint64_t mbp_config_memory_budget(const CPatcherConfig *pc)
+{
+    CCAST(pc);
+    return config->memoryBudget();
+}
+
+/*!
+ * \brief Set the memory budget for patching
+ *
+ * \param pc CPatcherConfig object
+ * \param bytes Memory budget in bytes or 0 for no limit
+ *
+ * \sa PatcherConfig::setMemoryBudget()
+ */
+void mbp_config_set_memory_budget(CPatcherConfig *pc, uint64_t bytes)
+{
+    CAST(pc);
+    config->setMemoryBudget(bytes);
+}
+
 /*!
  * \brief Get version number of the patcher
  *
@@ -22,6 +22,7 @@
 #include "cwrapper/ctypes.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,6 +39,9 @@ char * mbp_config_temp_directory(const CPatcherConfig *pc);
 void mbp_config_set_data_directory(CPatcherConfig *pc, char *path);
 void mbp_config_set_temp_directory(CPatcherConfig *pc, char *path);
 
+uint64_t mbp_config_memory_budget(const CPatcherConfig *pc);
+void mbp_config_set_memory_budget(CPatcherConfig *pc, uint64_t bytes);
+
 char * mbp_config_version(const CPatcherConfig *pc);
 CDevice ** mbp_config_devices(const CPatcherConfig *pc);
 #ifndef LIBMBP_MINI
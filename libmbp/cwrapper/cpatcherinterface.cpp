@@ -186,6 +186,73 @@ void mbp_patcher_cancel_patching(CPatcher *patcher)
     p->cancelPatching();
 }
 
+/*!
+ * \brief Pause the patching of a file
+ *
+ * \param patcher CPatcher object
+ *
+ * \sa Patcher::pausePatching()
+ */
+void mbp_patcher_pause_patching(CPatcher *patcher)
+{
+    CASTP(patcher);
+    p->pausePatching();
+}
+
+/*!
+ * \brief Resume the patching of a file
+ *
+ * \param patcher CPatcher object
+ *
+ * \sa Patcher::resumePatching()
+ */
+void mbp_patcher_resume_patching(CPatcher *patcher)
+{
+    CASTP(patcher);
+    p->resumePatching();
+}
+
+/*!
+ * \brief Phases of the last patching operation
+ *
+ * \note The returned array should be freed with `mbp_free_array()` when it
+ *       is no longer needed.
+ *
+ * \param patcher CPatcher object
+ * \return A NULL-terminated array containing the phase names
+ *
+ * \sa Patcher::memoryUsage()
+ */
+char ** mbp_patcher_memory_phases(const CPatcher *patcher)
+{
+    CCASTP(patcher);
+    std::vector<std::string> phases;
+    for (auto const &usage : p->memoryUsage()) {
+        phases.push_back(usage.phase);
+    }
+    return vector_to_cstring_array(phases);
+}
+
+/*!
+ * \brief Memory high-water mark of a phase of the last patching operation
+ *
+ * \param patcher CPatcher object
+ * \param phase Phase name
+ * \return Peak number of bytes or 0 if the phase did not run
+ *
+ * \sa Patcher::memoryUsage()
+ */
+uint64_t mbp_patcher_memory_peak(const CPatcher *patcher, const char *phase)
+{
+    CCASTP(patcher);
+    for (auto const &usage : p->memoryUsage()) {
+        if (usage.phase == phase) {
+            return usage.peakBytes;
+        }
+    }
+    return 0;
+}
+
 /*!
  * \brief Get the error information
  *
@@ -42,6 +42,10 @@ bool mbp_patcher_patch_file(CPatcher *patcher,
                             DetailsUpdatedCallback detailsCb,
                             void *userData);
 void mbp_patcher_cancel_patching(CPatcher *patcher);
+void mbp_patcher_pause_patching(CPatcher *patcher);
+void mbp_patcher_resume_patching(CPatcher *patcher);
+char ** mbp_patcher_memory_phases(const CPatcher *patcher);
+uint64_t mbp_patcher_memory_peak(const CPatcher *patcher, const char *phase);
 
 
 /* enum ErrorCode */ int mbp_autopatcher_error(const CAutoPatcher *patcher);
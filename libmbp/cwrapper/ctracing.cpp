@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cwrapper/ctracing.h"
+
+#include "cwrapper/private/util.h"
+
+#include "tracing.h"
+
+
+/*!
+ * \file ctracing.h
+ * \brief C Wrapper for the tracing API
+ *
+ * Please see the C++ documentation (mbp::setTracingEnabled() and friends) for
+ * more information.
+ */
+
+extern "C" {
+
+/*!
+ * \brief Enable or disable recording of trace spans
+ *
+ * \param enabled Whether spans should be recorded
+ *
+ * \sa mbp::setTracingEnabled()
+ */
+void mbp_tracing_set_enabled(bool enabled)
+{
+    mbp::setTracingEnabled(enabled);
+}
+
+/*!
+ * \brief Whether trace spans are being recorded
+ *
+ * \sa mbp::isTracingEnabled()
+ */
+bool mbp_tracing_is_enabled(void)
+{
+    return mbp::isTracingEnabled();
+}
+
+/*!
+ * \brief Discard all recorded trace spans
+ *
+ * \sa mbp::clearTrace()
+ */
+void mbp_tracing_clear(void)
+{
+    mbp::clearTrace();
+}
+
+/*!
+ * \brief Get the recorded spans in the Chrome trace event format
+ *
+ * \note The returned string is dynamically allocated. It should be free()'d
+ *       when it is no longer needed.
+ *
+ * \return Trace JSON
+ *
+ * \sa mbp::chromeTraceJson()
+ */
+char * mbp_tracing_chrome_json(void)
+{
+    return string_to_cstring(mbp::chromeTraceJson());
+}
+
+/*!
+ * \brief Write the recorded spans to a file in the Chrome trace event format
+ *
+ * \param path Output file
+ *
+ * \return Whether the file was successfully written
+ *
+ * \sa mbp::writeChromeTrace()
+ */
+bool mbp_tracing_write_chrome_trace(const char *path)
+{
+    return mbp::writeChromeTrace(path);
+}
+
+}
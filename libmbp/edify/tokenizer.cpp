@@ -23,6 +23,7 @@
 #include <cstring>
 
 #include "private/logging.h"
+#include "private/tracing.h"
 
 namespace mbp
 {
@@ -486,6 +487,9 @@ bool EdifyTokenizer::nextToken(const char *data, std::size_t size,
 bool EdifyTokenizer::tokenize(const char *data, std::size_t size,
                               std::vector<EdifyToken *> *tokens)
 {
+    TraceSpan span("edify", "tokenize");
+    span.addArg("size", size);
+
     std::vector<EdifyToken *> temp;
     EdifyToken *token;
     std::size_t pos = 0;
@@ -519,6 +523,9 @@ bool EdifyTokenizer::tokenize(const char *data, std::size_t size,
 
 std::string EdifyTokenizer::untokenize(const std::vector<EdifyToken *> &tokens)
 {
+    TraceSpan span("edify", "untokenize");
+    span.addArg("tokens", tokens.size());
+
     std::string output;
     for (EdifyToken *token : tokens) {
         output += token->generate();
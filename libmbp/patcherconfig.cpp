@@ -66,6 +66,9 @@ public:
     std::string dataDir;
     std::string tempDir;
 
+    // Limit for buffers held in memory while patching (0 = unlimited)
+    uint64_t memoryBudget = 0;
+
     std::string version;
     std::vector<Device *> devices;
 
@@ -185,6 +188,34 @@ void PatcherConfig::setTempDirectory(std::string path)
     m_impl->tempDir = std::move(path);
 }
 
+/*!
+ * \brief Get the memory budget for patching
+ *
+ * \return Memory budget in bytes or 0 if unlimited
+ */
+uint64_t PatcherConfig::memoryBudget() const
+{
+    return m_impl->memoryBudget;
+}
+
+/*!
+ * \brief Set the memory budget for patching
+ *
+ * If a boot image would not fit in the budget alongside the buffers that are
+ * already in memory, the patcher will extract it to the temporary directory and
+ * work with the file instead of reading it into memory. This lowers the peak
+ * memory usage at the cost of extra disk I/O.
+ *
+ * \note This is a soft limit. Only the large buffers libmbp allocates itself
+ *       (eg. boot image sections and cpio entries) are taken into account.
+ *
+ * \param bytes Memory budget in bytes or 0 for no limit
+ */
+void PatcherConfig::setMemoryBudget(uint64_t bytes)
+{
+    m_impl->memoryBudget = bytes;
+}
+
 /*!
  * \brief Get version number of the patcher
  *
@@ -54,6 +54,9 @@ public:
     void setDataDirectory(std::string path);
     void setTempDirectory(std::string path);
 
+    uint64_t memoryBudget() const;
+    void setMemoryBudget(uint64_t bytes);
+
     std::string version() const;
     std::vector<Device *> devices() const;
 #ifndef LIBMBP_MINI
@@ -19,6 +19,9 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "libmbp_global.h"
 
 #include "cpiofile.h"
@@ -28,6 +31,18 @@
 namespace mbp
 {
 
+/*!
+ * \brief Memory high-water mark of a patching phase
+ */
+struct PhaseMemoryUsage
+{
+    /*! \brief Name of the phase */
+    std::string phase;
+    /*! \brief Highest number of bytes held in libmbp's buffers */
+    uint64_t peakBytes;
+};
+
+
 /*!
  * \class Patcher
  * \brief Handles the patching of zip files and boot images
@@ -87,6 +102,30 @@ public:
      * useful if the patching operation is being done on a thread.
      */
     virtual void cancelPatching() = 0;
+
+    /*!
+     * \brief Pause the patching of a file
+     *
+     * The patching operation will block at its next checkpoint until
+     * resumePatching() or cancelPatching() is called. The checkpoints are
+     * between chunks of data, so this takes effect quickly even when large
+     * files are being copied or compressed.
+     */
+    virtual void pausePatching() = 0;
+
+    /*!
+     * \brief Resume the patching of a file paused by pausePatching()
+     */
+    virtual void resumePatching() = 0;
+
+    /*!
+     * \brief Memory usage of the phases of the last patching operation
+     *
+     * The values are the high-water marks of the buffers libmbp accounts for
+     * (eg. zip entries read into memory, boot image sections and cpio entries)
+     * rather than the process' RSS.
+     */
+    virtual std::vector<PhaseMemoryUsage> memoryUsage() const = 0;
 };
 
 
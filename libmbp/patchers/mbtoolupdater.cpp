@@ -26,6 +26,7 @@
 #include "patcherconfig.h"
 #include "ramdiskpatchers/core.h"
 
+#include "private/memory.h"
 #include "private/stringutils.h"
 
 
@@ -41,6 +42,8 @@ public:
 
     ErrorCode error;
 
+    MemoryPhases memory;
+
     bool patchImage();
     void patchInitRc(CpioFile *cpio);
 };
@@ -80,6 +83,20 @@ void MbtoolUpdater::cancelPatching()
     // Ignore. This runs fast enough that canceling is not needed
 }
 
+void MbtoolUpdater::pausePatching()
+{
+    // Ignore. This runs fast enough that pausing is not needed
+}
+
+void MbtoolUpdater::resumePatching()
+{
+}
+
+std::vector<PhaseMemoryUsage> MbtoolUpdater::memoryUsage() const
+{
+    return m_impl->memory.results();
+}
+
 bool MbtoolUpdater::patchFile(ProgressUpdatedCallback progressCb,
                               FilesUpdatedCallback filesCb,
                               DetailsUpdatedCallback detailsCb,
@@ -92,7 +109,14 @@ bool MbtoolUpdater::patchFile(ProgressUpdatedCallback progressCb,
 
     assert(m_impl->info != nullptr);
 
-    return m_impl->patchImage();
+    m_impl->memory.clear();
+    m_impl->memory.begin("patch");
+
+    bool ret = m_impl->patchImage();
+
+    m_impl->memory.end();
+
+    return ret;
 }
 
 bool MbtoolUpdater::Impl::patchImage()
@@ -50,6 +50,10 @@ public:
                            void *userData) override;
 
     virtual void cancelPatching() override;
+    virtual void pausePatching() override;
+    virtual void resumePatching() override;
+
+    virtual std::vector<PhaseMemoryUsage> memoryUsage() const override;
 
 private:
     class Impl;
@@ -25,12 +25,16 @@
 #include <cassert>
 
 #include "libmbpio/delete.h"
+#include "libmbpio/mappedfile.h"
 
 #include "bootimage.h"
+#include "cancellation.h"
 #include "cpiofile.h"
 #include "patcherconfig.h"
 #include "private/fileutils.h"
 #include "private/logging.h"
+#include "private/memory.h"
+#include "private/tracing.h"
 
 // minizip
 #include "external/minizip/unzip.h"
@@ -52,7 +56,7 @@ public:
     uint64_t files;
     uint64_t maxFiles;
 
-    volatile bool cancelled;
+    CancellationToken token;
 
     ErrorCode error;
 
@@ -67,8 +71,14 @@ public:
     FileUtils::MzZipCtx *zOutput = nullptr;
     std::vector<AutoPatcher *> autoPatchers;
 
+    // Memory accounting
+    MemoryPhases memory;
+    MemoryCharge entryCharge;
+
     bool patchRamdisk(std::vector<unsigned char> *data);
     bool patchBootImage(std::vector<unsigned char> *data);
+    bool patchBootImageFile(const std::string &temporaryDir,
+                            const std::string &name);
     bool patchZip();
 
     bool pass1(const std::string &temporaryDir,
@@ -122,7 +132,22 @@ void MultiBootPatcher::setFileInfo(const FileInfo * const info)
 
 void MultiBootPatcher::cancelPatching()
 {
-    m_impl->cancelled = true;
+    m_impl->token.cancel();
+}
+
+void MultiBootPatcher::pausePatching()
+{
+    m_impl->token.pause();
+}
+
+void MultiBootPatcher::resumePatching()
+{
+    m_impl->token.resume();
+}
+
+std::vector<PhaseMemoryUsage> MultiBootPatcher::memoryUsage() const
+{
+    return m_impl->memory.results();
 }
 
 bool MultiBootPatcher::patchFile(ProgressUpdatedCallback progressCb,
@@ -130,10 +155,16 @@ bool MultiBootPatcher::patchFile(ProgressUpdatedCallback progressCb,
                                  DetailsUpdatedCallback detailsCb,
                                  void *userData)
 {
-    m_impl->cancelled = false;
+    m_impl->token.reset();
 
     assert(m_impl->info != nullptr);
 
+    TraceSpan span("patcher", "MultiBootPatcher::patchFile");
+    if (span.active()) {
+        span.addArg("input", m_impl->info->inputPath());
+        span.addArg("device", m_impl->info->device()->id());
+    }
+
     m_impl->progressCb = progressCb;
     m_impl->filesCb = filesCb;
     m_impl->detailsCb = detailsCb;
@@ -144,8 +175,13 @@ bool MultiBootPatcher::patchFile(ProgressUpdatedCallback progressCb,
     m_impl->files = 0;
     m_impl->maxFiles = 0;
 
+    m_impl->memory.clear();
+
     bool ret = m_impl->patchZip();
 
+    m_impl->memory.end();
+    m_impl->entryCharge.set(0);
+
     m_impl->progressCb = nullptr;
     m_impl->filesCb = nullptr;
     m_impl->detailsCb = nullptr;
@@ -163,7 +199,7 @@ bool MultiBootPatcher::patchFile(ProgressUpdatedCallback progressCb,
         m_impl->closeOutputArchive();
     }
 
-    if (m_impl->cancelled) {
+    if (m_impl->token.isCancelled()) {
         m_impl->error = ErrorCode::PatchingCancelled;
         return false;
     }
@@ -173,14 +209,17 @@ bool MultiBootPatcher::patchFile(ProgressUpdatedCallback progressCb,
 
 bool MultiBootPatcher::Impl::patchRamdisk(std::vector<unsigned char> *data)
 {
+    TRACE_SCOPE("patcher", "patchRamdisk");
+
     // Load the ramdisk cpio
     CpioFile cpio;
+    cpio.setCancellationToken(&token);
     if (!cpio.load(*data)) {
         error = cpio.error();
         return false;
     }
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     std::string rpId = info->device()->id() + "/default";
     auto *rp = pc->createRamdiskPatcher(rpId, info, &cpio);
@@ -193,7 +232,14 @@ bool MultiBootPatcher::Impl::patchRamdisk(std::vector<unsigned char> *data)
         return false;
     }
 
-    if (!rp->patchRamdisk()) {
+    bool rpRet;
+    {
+        TraceSpan rpSpan("ramdiskpatcher", "patchRamdisk");
+        rpSpan.addArg("id", rpId);
+        rpRet = rp->patchRamdisk();
+    }
+
+    if (!rpRet) {
         error = rp->error();
         pc->destroyRamdiskPatcher(rp);
         return false;
@@ -201,7 +247,7 @@ bool MultiBootPatcher::Impl::patchRamdisk(std::vector<unsigned char> *data)
 
     pc->destroyRamdiskPatcher(rp);
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     std::vector<unsigned char> newRamdisk;
     if (!cpio.createData(&newRamdisk)) {
@@ -211,14 +257,17 @@ bool MultiBootPatcher::Impl::patchRamdisk(std::vector<unsigned char> *data)
 
     data->swap(newRamdisk);
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     return true;
 }
 
 bool MultiBootPatcher::Impl::patchBootImage(std::vector<unsigned char> *data)
 {
+    TRACE_SCOPE("patcher", "patchBootImage");
+
     BootImage bi;
+    bi.setCancellationToken(&token);
     if (!bi.load(*data)) {
         error = bi.error();
         return false;
@@ -227,6 +276,7 @@ bool MultiBootPatcher::Impl::patchBootImage(std::vector<unsigned char> *data)
     // Release memory since BootImage keeps a copy of the separate components
     data->clear();
     data->shrink_to_fit();
+    entryCharge.set(0);
 
     std::vector<unsigned char> ramdiskImage = bi.ramdiskImage();
     if (!patchRamdisk(&ramdiskImage)) {
@@ -240,11 +290,83 @@ bool MultiBootPatcher::Impl::patchBootImage(std::vector<unsigned char> *data)
         return false;
     }
 
-    if (cancelled) return false;
+    entryCharge.set(data->size());
+
+    if (!token.checkpoint()) return false;
 
     return true;
 }
 
+/*!
+ * \brief Patch a boot image without reading it into memory
+ *
+ * This is used instead of patchBootImage() when the boot image does not fit in
+ * the memory budget. The current file in the input zip is extracted to the
+ * temporary directory, patched in place, and added to the output zip from
+ * there. Only the sections of the boot image are kept in memory.
+ */
+bool MultiBootPatcher::Impl::patchBootImageFile(const std::string &temporaryDir,
+                                                const std::string &name)
+{
+    TRACE_SCOPE("patcher", "patchBootImageFile");
+
+    unzFile uf = FileUtils::mzCtxGetUnzFile(zInput);
+    zipFile zf = FileUtils::mzCtxGetZipFile(zOutput);
+
+    if (!FileUtils::mzExtractFile(uf, temporaryDir, &token)) {
+        error = ErrorCode::ArchiveReadDataError;
+        return false;
+    }
+
+    const std::string path = temporaryDir + "/" + name;
+
+    bool isBootImage;
+    {
+        io::MappedFile file;
+        if (!file.map(path, io::MappedFile::MapRead)) {
+            FLOGE("%s: Failed to map file: %s",
+                  path.c_str(), file.errorString().c_str());
+            io::deleteRecursively(path);
+            error = ErrorCode::FileOpenError;
+            return false;
+        }
+        isBootImage = BootImage::isValid(file.data(), file.size());
+    }
+
+    if (isBootImage) {
+        BootImage bi;
+        bi.setCancellationToken(&token);
+        if (!bi.loadFile(path)) {
+            io::deleteRecursively(path);
+            error = bi.error();
+            return false;
+        }
+
+        std::vector<unsigned char> ramdiskImage = bi.ramdiskImage();
+        if (!patchRamdisk(&ramdiskImage)) {
+            io::deleteRecursively(path);
+            return false;
+        }
+
+        bi.setRamdiskImage(std::move(ramdiskImage));
+
+        if (!bi.createFile(path)) {
+            io::deleteRecursively(path);
+            error = bi.error();
+            return false;
+        }
+    }
+
+    auto ret = FileUtils::mzAddFile(zf, name, path, &token);
+    io::deleteRecursively(path);
+    if (ret != ErrorCode::NoError) {
+        error = ret;
+        return false;
+    }
+
+    return token.checkpoint();
+}
+
 bool MultiBootPatcher::Impl::patchZip()
 {
     std::unordered_set<std::string> excludeFromPass1;
@@ -278,7 +400,9 @@ bool MultiBootPatcher::Impl::patchZip()
 
     zipFile zf = FileUtils::mzCtxGetZipFile(zOutput);
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
+
+    memory.begin("stats");
 
     FileUtils::ArchiveStats stats;
     auto result = FileUtils::mzArchiveStats(info->inputPath(), &stats,
@@ -290,7 +414,7 @@ bool MultiBootPatcher::Impl::patchZip()
 
     maxBytes = stats.totalSize;
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     // +1 for mbtool_recovery (update-binary)
     // +1 for bb-wrapper.sh
@@ -305,15 +429,19 @@ bool MultiBootPatcher::Impl::patchZip()
     // Create temporary dir for extracted files for autopatchers
     std::string tempDir = FileUtils::createTemporaryDir(pc->tempDirectory());
 
+    memory.begin("pass1");
+
     if (!pass1(tempDir, excludeFromPass1)) {
         io::deleteRecursively(tempDir);
         return false;
     }
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     // On the second pass, run the autopatchers on the rest of the files
 
+    memory.begin("pass2");
+
     if (!pass2(tempDir, excludeFromPass1)) {
         io::deleteRecursively(tempDir);
         return false;
@@ -321,7 +449,11 @@ bool MultiBootPatcher::Impl::patchZip()
 
     io::deleteRecursively(tempDir);
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
+
+    // Everything from here on is part of the finalization phase
+    TRACE_SCOPE("patcher", "finalize");
+    memory.begin("finalize");
 
     updateFiles(++files, maxFiles);
     updateDetails("META-INF/com/google/android/update-binary");
@@ -336,7 +468,7 @@ bool MultiBootPatcher::Impl::patchZip()
         return false;
     }
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     updateFiles(++files, maxFiles);
     updateDetails("multiboot/bb-wrapper.sh");
@@ -350,7 +482,7 @@ bool MultiBootPatcher::Impl::patchZip()
         return false;
     }
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     updateFiles(++files, maxFiles);
     updateDetails("multiboot/info.prop");
@@ -364,7 +496,7 @@ bool MultiBootPatcher::Impl::patchZip()
         return false;
     }
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     return true;
 }
@@ -381,6 +513,8 @@ bool MultiBootPatcher::Impl::patchZip()
 bool MultiBootPatcher::Impl::pass1(const std::string &temporaryDir,
                                    const std::unordered_set<std::string> &exclude)
 {
+    TRACE_SCOPE("patcher", "pass1");
+
     unzFile uf = FileUtils::mzCtxGetUnzFile(zInput);
     zipFile zf = FileUtils::mzCtxGetZipFile(zOutput);
 
@@ -391,7 +525,7 @@ bool MultiBootPatcher::Impl::pass1(const std::string &temporaryDir,
     }
 
     do {
-        if (cancelled) return false;
+        if (!token.checkpoint()) return false;
 
         unz_file_info64 fi;
         std::string curFile;
@@ -404,9 +538,12 @@ bool MultiBootPatcher::Impl::pass1(const std::string &temporaryDir,
         updateFiles(++files, maxFiles);
         updateDetails(curFile);
 
+        TraceSpan entrySpan("patcher", "entry");
+        entrySpan.addArg("name", curFile);
+
         // Skip files that should be patched and added in pass 2
         if (exclude.find(curFile) != exclude.end()) {
-            if (!FileUtils::mzExtractFile(uf, temporaryDir)) {
+            if (!FileUtils::mzExtractFile(uf, temporaryDir, &token)) {
                 error = ErrorCode::ArchiveReadDataError;
                 return false;
             }
@@ -422,16 +559,36 @@ bool MultiBootPatcher::Impl::pass1(const std::string &temporaryDir,
         // patcher won't try to read a multi-gigabyte system image into RAM
         bool isSizeOK = fi.uncompressed_size <= 30 * 1024 * 1024;
 
-        if ((isExtImg || isExtLok || isExtGz) && isSizeOK) {
+        // Reading a boot image into memory needs space for the file, its
+        // sections, the patched ramdisk and the new boot image
+        bool overBudget = exceedsMemoryBudget(
+                4 * fi.uncompressed_size, pc->memoryBudget());
+
+        if ((isExtImg || isExtLok) && isSizeOK && overBudget) {
+            FLOGW("%s: Boot image does not fit in memory budget; "
+                  "patching on disk", curFile.c_str());
+
+            uint64_t oldSize = fi.uncompressed_size;
+
+            if (!patchBootImageFile(temporaryDir, curFile)) {
+                return false;
+            }
+
+            // The patched file is not read back, so progress is tracked using
+            // the original size
+            bytes += oldSize;
+        } else if ((isExtImg || isExtLok || isExtGz) && isSizeOK) {
             // Load the file into memory
             std::vector<unsigned char> data;
 
             if (!FileUtils::mzReadToMemory(uf, &data,
-                                           &laProgressCb, this)) {
+                                           &laProgressCb, this, &token)) {
                 error = ErrorCode::ArchiveReadDataError;
                 return false;
             }
 
+            entryCharge.set(data.size());
+
             if (isExtGz) {
                 // Some zips build the boot image at install time and the zip
                 // just includes the split out parts of the boot image
@@ -448,16 +605,20 @@ bool MultiBootPatcher::Impl::pass1(const std::string &temporaryDir,
                 }
             }
 
+            entryCharge.set(data.size());
+
             // Update total size
             maxBytes += (data.size() - fi.uncompressed_size);
 
-            auto ret2 = FileUtils::mzAddFile(zf, curFile, data);
+            auto ret2 = FileUtils::mzAddFile(zf, curFile, data, &token);
             if (ret2 != ErrorCode::NoError) {
                 error = ret2;
                 return false;
             }
 
             bytes += data.size();
+
+            entryCharge.set(0);
         } else {
             // Directly copy other files to the output zip
 
@@ -467,7 +628,7 @@ bool MultiBootPatcher::Impl::pass1(const std::string &temporaryDir,
             }
 
             if (!FileUtils::mzCopyFileRaw(uf, zf, curFile,
-                                          &laProgressCb, this)) {
+                                          &laProgressCb, this, &token)) {
                 FLOGW("minizip: Failed to copy raw data: %s", curFile.c_str());
                 error = ErrorCode::ArchiveWriteDataError;
                 return false;
@@ -482,7 +643,7 @@ bool MultiBootPatcher::Impl::pass1(const std::string &temporaryDir,
         return false;
     }
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     return true;
 }
@@ -498,10 +659,12 @@ bool MultiBootPatcher::Impl::pass1(const std::string &temporaryDir,
 bool MultiBootPatcher::Impl::pass2(const std::string &temporaryDir,
                                    const std::unordered_set<std::string> &files)
 {
+    TRACE_SCOPE("patcher", "pass2");
+
     zipFile zf = FileUtils::mzCtxGetZipFile(zOutput);
 
     for (auto *ap : autoPatchers) {
-        if (cancelled) return false;
+        if (!token.checkpoint()) return false;
         if (!ap->patchFiles(temporaryDir)) {
             error = ap->error();
             return false;
@@ -511,7 +674,7 @@ bool MultiBootPatcher::Impl::pass2(const std::string &temporaryDir,
     // TODO Headers are being discarded
 
     for (auto const &file : files) {
-        if (cancelled) return false;
+        if (!token.checkpoint()) return false;
 
         ErrorCode ret;
 
@@ -519,12 +682,14 @@ bool MultiBootPatcher::Impl::pass2(const std::string &temporaryDir,
             ret = FileUtils::mzAddFile(
                     zf,
                     "META-INF/com/google/android/update-binary.orig",
-                    temporaryDir + "/" + file);
+                    temporaryDir + "/" + file,
+                    &token);
         } else {
             ret = FileUtils::mzAddFile(
                     zf,
                     file,
-                    temporaryDir + "/" + file);
+                    temporaryDir + "/" + file,
+                    &token);
         }
 
         if (ret == ErrorCode::FileOpenError) {
@@ -535,7 +700,7 @@ bool MultiBootPatcher::Impl::pass2(const std::string &temporaryDir,
         }
     }
 
-    if (cancelled) return false;
+    if (!token.checkpoint()) return false;
 
     return true;
 }
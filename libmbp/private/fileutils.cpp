@@ -25,13 +25,16 @@
 #include <cerrno>
 #include <cstring>
 
+#include "libmbpio/asyncio.h"
 #include "libmbpio/directory.h"
 #include "libmbpio/error.h"
 #include "libmbpio/file.h"
+#include "libmbpio/mappedfile.h"
 #include "libmbpio/path.h"
 #include "libmbpio/private/utf8.h"
 
 #include "private/logging.h"
+#include "private/tracing.h"
 
 #include "external/minizip/ioapi_buf.h"
 #if defined(_WIN32)
@@ -51,6 +54,12 @@
 namespace mbp
 {
 
+// Returns false if the operation was cancelled. Blocks while paused.
+static inline bool shouldContinue(const CancellationToken *token)
+{
+    return !token || token->checkpoint();
+}
+
 /*!
     \brief Read contents of a file into memory
 
@@ -62,6 +71,9 @@ namespace mbp
 ErrorCode FileUtils::readToMemory(const std::string &path,
                                   std::vector<unsigned char> *contents)
 {
+    TraceSpan span("fileutils", "readToMemory");
+    span.addArg("path", path);
+
     io::File file;
     if (!file.open(path, io::File::OpenRead)) {
         FLOGE("%s: Failed to open for reading: %s",
@@ -129,6 +141,10 @@ ErrorCode FileUtils::readToString(const std::string &path,
 ErrorCode FileUtils::writeFromMemory(const std::string &path,
                                      const std::vector<unsigned char> &contents)
 {
+    TraceSpan span("fileutils", "writeFromMemory");
+    span.addArg("path", path);
+    span.addArg("size", contents.size());
+
     io::File file;
     if (!file.open(path, io::File::OpenWrite)) {
         FLOGE("%s: Failed to open for writing: %s",
@@ -136,6 +152,8 @@ ErrorCode FileUtils::writeFromMemory(const std::string &path,
         return ErrorCode::FileOpenError;
     }
 
+    file.preallocate(contents.size());
+
     uint64_t bytesWritten;
     if (!file.write(contents.data(), contents.size(), &bytesWritten)) {
         FLOGE("%s: Failed to write file: %s",
@@ -156,6 +174,8 @@ ErrorCode FileUtils::writeFromString(const std::string &path,
         return ErrorCode::FileOpenError;
     }
 
+    file.preallocate(contents.size());
+
     uint64_t bytesWritten;
     if (!file.write(contents.data(), contents.size(), &bytesWritten)) {
         FLOGE("%s: Failed to write file: %s",
@@ -518,6 +538,9 @@ ErrorCode FileUtils::mzArchiveStats(const std::string &path,
 {
     assert(stats != nullptr);
 
+    TraceSpan span("fileutils", "mzArchiveStats");
+    span.addArg("path", path);
+
     MzUnzCtx *ctx = mzOpenInputFile(path);
 
     if (!ctx) {
@@ -624,8 +647,12 @@ bool FileUtils::mzGetInfo(unzFile uf,
 bool FileUtils::mzCopyFileRaw(unzFile uf,
                               zipFile zf,
                               const std::string &name,
-                              void (*cb)(uint64_t bytes, void *), void *userData)
+                              void (*cb)(uint64_t bytes, void *), void *userData,
+                              const CancellationToken *token)
 {
+    TraceSpan span("fileutils", "mzCopyFileRaw");
+    span.addArg("name", name);
+
     unz_file_info64 ufi;
 
     if (!mzGetInfo(uf, &ufi, nullptr)) {
@@ -694,6 +721,12 @@ bool FileUtils::mzCopyFileRaw(unzFile uf,
     double ratio;
 
     while ((bytes_read = unzReadCurrentFile(uf, buf.data(), buf.size())) > 0) {
+        if (!shouldContinue(token)) {
+            unzCloseCurrentFile(uf);
+            zipCloseFileInZip(zf);
+            return false;
+        }
+
         bytes += bytes_read;
         if (cb) {
             // Scale this to the uncompressed size for the purposes of a
@@ -736,14 +769,19 @@ bool FileUtils::mzCopyFileRaw(unzFile uf,
 
 bool FileUtils::mzReadToMemory(unzFile uf,
                                std::vector<unsigned char> *output,
-                               void (*cb)(uint64_t bytes, void *), void *userData)
+                               void (*cb)(uint64_t bytes, void *), void *userData,
+                               const CancellationToken *token)
 {
+    TraceSpan span("fileutils", "mzReadToMemory");
+
     unz_file_info64 fi;
 
     if (!mzGetInfo(uf, &fi, nullptr)) {
         return false;
     }
 
+    span.addArg("size", fi.uncompressed_size);
+
     std::vector<unsigned char> data;
     data.reserve(fi.uncompressed_size);
 
@@ -758,6 +796,11 @@ bool FileUtils::mzReadToMemory(unzFile uf,
     char buf[32768];
 
     while ((n = unzReadCurrentFile(uf, buf, sizeof(buf))) > 0) {
+        if (!shouldContinue(token)) {
+            unzCloseCurrentFile(uf);
+            return false;
+        }
+
         if (cb) {
             cb(data.size() + n, userData);
         }
@@ -784,9 +827,133 @@ bool FileUtils::mzReadToMemory(unzFile uf,
     return true;
 }
 
+// Entries at least this large are written with the async I/O engine so that
+// inflating the next chunk overlaps with writing the previous one
+static const uint64_t MZ_ASYNC_EXTRACT_THRESHOLD = 8 * 1024 * 1024;
+static const std::size_t MZ_ASYNC_BUFFER_SIZE = 1024 * 1024;
+static const unsigned int MZ_ASYNC_QUEUE_DEPTH = 4;
+
+static bool mzWaitForWrite(io::AsyncIo *aio, const std::string &path,
+                           std::size_t *bufIndex)
+{
+    io::AsyncIo::Completion c;
+    std::size_t count;
+
+    if (!aio->wait(&c, 1, 1, &count) || count != 1) {
+        FLOGE("%s: Failed to wait for write: %s",
+              path.c_str(), aio->errorString().c_str());
+        return false;
+    }
+    if (!c.success) {
+        FLOGE("%s: Failed to write file: %s",
+              path.c_str(), c.errorString.c_str());
+        return false;
+    }
+
+    *bufIndex = c.userData;
+    return true;
+}
+
+/*!
+    \brief Inflate the current inner file into an open file asynchronously
+
+    \param uf Input zip with the inner file already opened
+    \param file Output file
+    \param path Path of output file (for logging)
+    \param unzRet Last return value of unzReadCurrentFile() (output parameter)
+    \param token Cancellation token (may be nullptr)
+
+    \return Whether all of the data was written. Check \a unzRet for errors
+            reading the inner file.
+ */
+static bool mzExtractAsync(unzFile uf, io::File *file, const std::string &path,
+                           int *unzRet, const CancellationToken *token)
+{
+    io::AsyncIo aio;
+    if (!aio.init(MZ_ASYNC_QUEUE_DEPTH, io::AsyncIo::BackendAuto, 1)) {
+        FLOGE("Failed to initialize async I/O: %s", aio.errorString().c_str());
+        return false;
+    }
+
+    std::vector<std::vector<unsigned char>> bufs(MZ_ASYNC_QUEUE_DEPTH);
+    std::vector<std::size_t> freeBufs;
+    for (std::size_t i = 0; i < bufs.size(); ++i) {
+        bufs[i].resize(MZ_ASYNC_BUFFER_SIZE);
+        freeBufs.push_back(i);
+    }
+
+    uint64_t offset = 0;
+    int n = 0;
+
+    while (true) {
+        if (!shouldContinue(token)) {
+            aio.drain();
+            return false;
+        }
+
+        std::size_t index;
+        if (!freeBufs.empty()) {
+            index = freeBufs.back();
+            freeBufs.pop_back();
+        } else if (!mzWaitForWrite(&aio, path, &index)) {
+            aio.drain();
+            return false;
+        }
+
+        // Fill the buffer completely to keep the number of writes low
+        std::vector<unsigned char> &buf = bufs[index];
+        std::size_t filled = 0;
+        while (filled < buf.size() && (n = unzReadCurrentFile(
+                uf, buf.data() + filled, buf.size() - filled)) > 0) {
+            filled += n;
+        }
+
+        if (filled > 0) {
+            io::AsyncIo::Request req;
+            req.op = io::AsyncIo::OpWrite;
+            req.file = file;
+            req.buf = buf.data();
+            req.size = filled;
+            req.offset = offset;
+            req.flags = 0;
+            req.userData = index;
+
+            if (!aio.submit(req)) {
+                FLOGE("%s: Failed to queue write: %s",
+                      path.c_str(), aio.errorString().c_str());
+                aio.drain();
+                return false;
+            }
+
+            offset += filled;
+        } else {
+            freeBufs.push_back(index);
+        }
+
+        if (n <= 0) {
+            break;
+        }
+    }
+
+    *unzRet = n;
+
+    while (aio.inFlight() > 0) {
+        std::size_t index;
+        if (!mzWaitForWrite(&aio, path, &index)) {
+            aio.drain();
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool FileUtils::mzExtractFile(unzFile uf,
-                              const std::string &directory)
+                              const std::string &directory,
+                              const CancellationToken *token)
 {
+    TraceSpan span("fileutils", "mzExtractFile");
+
     unz_file_info64 fi;
     std::string filename;
 
@@ -794,6 +961,8 @@ bool FileUtils::mzExtractFile(unzFile uf,
         return false;
     }
 
+    span.addArg("name", filename);
+
     std::string fullPath(directory);
     fullPath += "/";
     fullPath += filename;
@@ -811,6 +980,10 @@ bool FileUtils::mzExtractFile(unzFile uf,
         return false;
     }
 
+    // Avoid growing the file in small increments
+    file.preallocate(fi.uncompressed_size);
+    file.advise(io::File::AdviceSequential);
+
     int ret = unzOpenCurrentFile(uf);
     if (ret != UNZ_OK) {
         FLOGE("miniunz: Failed to open inner file: %s",
@@ -819,16 +992,29 @@ bool FileUtils::mzExtractFile(unzFile uf,
     }
 
     int n;
-    char buf[32768];
-    uint64_t bytesWritten;
 
-    while ((n = unzReadCurrentFile(uf, buf, sizeof(buf))) > 0) {
-        if (!file.write(buf, n, &bytesWritten)) {
-            FLOGE("%s: Failed to write file: %s",
-                  fullPath.c_str(), file.errorString().c_str());
+    if (fi.uncompressed_size >= MZ_ASYNC_EXTRACT_THRESHOLD) {
+        if (!mzExtractAsync(uf, &file, fullPath, &n, token)) {
             unzCloseCurrentFile(uf);
             return false;
         }
+    } else {
+        char buf[32768];
+        uint64_t bytesWritten;
+
+        while ((n = unzReadCurrentFile(uf, buf, sizeof(buf))) > 0) {
+            if (!shouldContinue(token)) {
+                unzCloseCurrentFile(uf);
+                return false;
+            }
+
+            if (!file.write(buf, n, &bytesWritten)) {
+                FLOGE("%s: Failed to write file: %s",
+                      fullPath.c_str(), file.errorString().c_str());
+                unzCloseCurrentFile(uf);
+                return false;
+            }
+        }
     }
     if (n != 0) {
         FLOGE("miniunz: Finished before reaching inner file's EOF: %s",
@@ -900,8 +1086,13 @@ static bool mzGetFileTime(const std::string &filename,
 
 ErrorCode FileUtils::mzAddFile(zipFile zf,
                                const std::string &name,
-                               const std::vector<unsigned char> &contents)
+                               const std::vector<unsigned char> &contents,
+                               const CancellationToken *token)
 {
+    TraceSpan span("fileutils", "mzAddFile");
+    span.addArg("name", name);
+    span.addArg("size", contents.size());
+
     // Obviously never true, but we'll keep it here just in case
     bool zip64 = (uint64_t) contents.size() >= ((1ull << 32) - 1);
 
@@ -930,14 +1121,31 @@ ErrorCode FileUtils::mzAddFile(zipFile zf,
         return ErrorCode::ArchiveWriteDataError;
     }
 
-    // Write data to file
-    ret = zipWriteInFileInZip(zf, contents.data(), contents.size());
-    if (ret != ZIP_OK) {
-        FLOGE("minizip: Failed to write inner file data: %s",
-              mzZipErrorString(ret).c_str());
-        zipCloseFileInZip(zf);
+    // Write data to file. The data is compressed as it is written, so write
+    // it in chunks to be able to stop partway through.
+    const unsigned char *data = contents.data();
+    std::size_t remaining = contents.size();
 
-        return ErrorCode::ArchiveWriteDataError;
+    while (remaining > 0) {
+        if (!shouldContinue(token)) {
+            zipCloseFileInZip(zf);
+
+            return ErrorCode::PatchingCancelled;
+        }
+
+        unsigned int chunk = std::min<std::size_t>(remaining, 1024 * 1024);
+
+        ret = zipWriteInFileInZip(zf, data, chunk);
+        if (ret != ZIP_OK) {
+            FLOGE("minizip: Failed to write inner file data: %s",
+                  mzZipErrorString(ret).c_str());
+            zipCloseFileInZip(zf);
+
+            return ErrorCode::ArchiveWriteDataError;
+        }
+
+        data += chunk;
+        remaining -= chunk;
     }
 
     ret = zipCloseFileInZip(zf);
@@ -953,20 +1161,24 @@ ErrorCode FileUtils::mzAddFile(zipFile zf,
 
 ErrorCode FileUtils::mzAddFile(zipFile zf,
                                const std::string &name,
-                               const std::string &path)
+                               const std::string &path,
+                               const CancellationToken *token)
 {
-    // Copy file into archive
-    io::File file;
-    if (!file.open(path, io::File::OpenRead)) {
-        FLOGE("%s: Failed to open for reading: %s",
+    TraceSpan span("fileutils", "mzAddFile");
+    span.addArg("name", name);
+    span.addArg("path", path);
+
+    // Copy file into archive directly from the mapping
+    io::MappedFile file;
+    if (!file.map(path, io::MappedFile::MapRead)) {
+        FLOGE("%s: Failed to map file: %s",
               path.c_str(), file.errorString().c_str());
         return ErrorCode::FileOpenError;
     }
 
-    uint64_t size;
-    file.seek(0, io::File::SeekEnd);
-    file.tell(&size);
-    file.seek(0, io::File::SeekBegin);
+    file.advise(io::MappedFile::AdviceSequential);
+
+    uint64_t size = file.size();
 
     bool zip64 = size >= ((1ull << 32) - 1);
 
@@ -1000,12 +1212,21 @@ ErrorCode FileUtils::mzAddFile(zipFile zf,
         return ErrorCode::ArchiveWriteDataError;
     }
 
-    // Write data to file
-    char buf[32768];
-    uint64_t bytesRead;
+    // Write data to file. zipWriteInFileInZip() takes a 32-bit length, so
+    // feed it the mapping in chunks.
+    const unsigned char *data = file.data();
+    uint64_t remaining = size;
+
+    while (remaining > 0) {
+        if (!shouldContinue(token)) {
+            zipCloseFileInZip(zf);
 
-    while (file.read(buf, sizeof(buf), &bytesRead)) {
-        ret = zipWriteInFileInZip(zf, buf, bytesRead);
+            return ErrorCode::PatchingCancelled;
+        }
+
+        unsigned int chunk = std::min<uint64_t>(remaining, 1024 * 1024);
+
+        ret = zipWriteInFileInZip(zf, data, chunk);
         if (ret != ZIP_OK) {
             FLOGE("minizip: Failed to write inner file data: %s",
                   mzZipErrorString(ret).c_str());
@@ -1013,13 +1234,9 @@ ErrorCode FileUtils::mzAddFile(zipFile zf,
 
             return ErrorCode::ArchiveWriteDataError;
         }
-    }
-    if (file.error() != io::File::ErrorEndOfFile) {
-        FLOGE("%s: Failed to read data: %s",
-              path.c_str(), file.errorString().c_str());
-        zipCloseFileInZip(zf);
 
-        return ErrorCode::FileReadError;
+        data += chunk;
+        remaining -= chunk;
     }
 
     ret = zipCloseFileInZip(zf);
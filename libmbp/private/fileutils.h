@@ -25,6 +25,7 @@
 #include "external/minizip/unzip.h"
 #include "external/minizip/zip.h"
 
+#include "cancellation.h"
 #include "errors.h"
 
 
@@ -83,22 +84,27 @@ public:
     static bool mzCopyFileRaw(unzFile uf,
                               zipFile zf,
                               const std::string &name,
-                              void (*cb)(uint64_t bytes, void *), void *userData);
+                              void (*cb)(uint64_t bytes, void *), void *userData,
+                              const CancellationToken *token = nullptr);
 
     static bool mzReadToMemory(unzFile uf,
                                std::vector<unsigned char> *output,
-                               void (*cb)(uint64_t bytes, void *), void *userData);
+                               void (*cb)(uint64_t bytes, void *), void *userData,
+                               const CancellationToken *token = nullptr);
 
     static bool mzExtractFile(unzFile uf,
-                              const std::string &directory);
+                              const std::string &directory,
+                              const CancellationToken *token = nullptr);
 
     static ErrorCode mzAddFile(zipFile zf,
                                const std::string &name,
-                               const std::vector<unsigned char> &contents);
+                               const std::vector<unsigned char> &contents,
+                               const CancellationToken *token = nullptr);
 
     static ErrorCode mzAddFile(zipFile zf,
                                const std::string &name,
-                               const std::string &path);
+                               const std::string &path,
+                               const CancellationToken *token = nullptr);
 };
 
 }
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "private/memory.h"
+
+#include <atomic>
+
+
+namespace mbp
+{
+
+static std::atomic<uint64_t> gMemoryInUse(0);
+static std::atomic<uint64_t> gMemoryPeak(0);
+
+static void charge(uint64_t bytes)
+{
+    uint64_t current = gMemoryInUse.fetch_add(bytes) + bytes;
+    uint64_t peak = gMemoryPeak.load();
+    while (current > peak && !gMemoryPeak.compare_exchange_weak(peak, current));
+}
+
+static void uncharge(uint64_t bytes)
+{
+    gMemoryInUse.fetch_sub(bytes);
+}
+
+MemoryCharge::MemoryCharge() : m_bytes(0)
+{
+}
+
+MemoryCharge::MemoryCharge(uint64_t bytes) : m_bytes(bytes)
+{
+    charge(bytes);
+}
+
+MemoryCharge::~MemoryCharge()
+{
+    uncharge(m_bytes);
+}
+
+uint64_t MemoryCharge::bytes() const
+{
+    return m_bytes;
+}
+
+void MemoryCharge::set(uint64_t bytes)
+{
+    if (bytes > m_bytes) {
+        add(bytes - m_bytes);
+    } else {
+        release(m_bytes - bytes);
+    }
+}
+
+void MemoryCharge::add(uint64_t bytes)
+{
+    m_bytes += bytes;
+    charge(bytes);
+}
+
+void MemoryCharge::release(uint64_t bytes)
+{
+    if (bytes > m_bytes) {
+        bytes = m_bytes;
+    }
+    m_bytes -= bytes;
+    uncharge(bytes);
+}
+
+uint64_t memoryInUse()
+{
+    return gMemoryInUse;
+}
+
+uint64_t memoryPeak()
+{
+    return gMemoryPeak;
+}
+
+void resetMemoryPeak()
+{
+    gMemoryPeak = gMemoryInUse.load();
+}
+
+bool exceedsMemoryBudget(uint64_t bytes, uint64_t budget)
+{
+    return budget != 0 && gMemoryInUse + bytes > budget;
+}
+
+MemoryPhases::MemoryPhases() : m_active(false)
+{
+}
+
+void MemoryPhases::clear()
+{
+    m_results.clear();
+    m_active = false;
+}
+
+void MemoryPhases::begin(const char *phase)
+{
+    end();
+
+    resetMemoryPeak();
+
+    PhaseMemoryUsage usage;
+    usage.phase = phase;
+    usage.peakBytes = memoryInUse();
+    m_results.push_back(std::move(usage));
+    m_active = true;
+}
+
+void MemoryPhases::end()
+{
+    if (m_active) {
+        m_results.back().peakBytes = memoryPeak();
+        m_active = false;
+    }
+}
+
+const std::vector<PhaseMemoryUsage> & MemoryPhases::results() const
+{
+    return m_results;
+}
+
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include "patcherinterface.h"
+
+namespace mbp
+{
+
+/*!
+ * \brief Accounts for the memory used by one of libmbp's large buffers
+ *
+ * Large buffers (zip entries read into memory, boot image sections, cpio
+ * entries, etc.) are charged against a process-wide counter, which is used for
+ * the per-phase high-water marks reported by the patchers and for enforcing
+ * PatcherConfig::memoryBudget(). The charge is released when the object is
+ * destroyed.
+ */
+class MemoryCharge
+{
+public:
+    MemoryCharge();
+    explicit MemoryCharge(uint64_t bytes);
+    ~MemoryCharge();
+
+    uint64_t bytes() const;
+
+    void set(uint64_t bytes);
+    void add(uint64_t bytes);
+    void release(uint64_t bytes);
+
+    MemoryCharge(const MemoryCharge &) = delete;
+    MemoryCharge & operator=(const MemoryCharge &) = delete;
+
+private:
+    uint64_t m_bytes;
+};
+
+/*!
+ * \brief Number of bytes currently charged
+ */
+uint64_t memoryInUse();
+
+/*!
+ * \brief Highest number of bytes charged since the last resetMemoryPeak()
+ */
+uint64_t memoryPeak();
+
+/*!
+ * \brief Reset the high-water mark to the current usage
+ */
+void resetMemoryPeak();
+
+/*!
+ * \brief Check if charging \p bytes more would exceed \p budget
+ *
+ * A budget of 0 means unlimited.
+ */
+bool exceedsMemoryBudget(uint64_t bytes, uint64_t budget);
+
+/*!
+ * \brief Records the memory high-water mark of each patching phase
+ *
+ * The accounting is process-wide, so the marks include buffers charged by
+ * other threads running at the same time.
+ */
+class MemoryPhases
+{
+public:
+    MemoryPhases();
+
+    void clear();
+    void begin(const char *phase);
+    void end();
+
+    const std::vector<PhaseMemoryUsage> & results() const;
+
+private:
+    std::vector<PhaseMemoryUsage> m_results;
+    bool m_active;
+};
+
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "private/tracing.h"
+
+#include <chrono>
+#include <mutex>
+
+#include <cstdio>
+
+#include "libmbpio/file.h"
+
+#include "private/logging.h"
+
+
+namespace mbp
+{
+
+/*! \cond INTERNAL */
+struct TraceEvent
+{
+    const char *category;
+    const char *name;
+    unsigned int tid;
+    uint64_t start;
+    uint64_t duration;
+    std::vector<std::pair<const char *, std::string>> args;
+};
+/*! \endcond */
+
+std::atomic<bool> gTracingEnabled(false);
+
+// Once this many spans are recorded, the oldest ones are overwritten so that a
+// long-running process with tracing enabled does not grow without bound
+static const std::size_t MaxTraceEvents = 65536;
+
+static std::mutex gTraceMutex;
+// Ring buffer of spans. gTraceHead is the oldest span once the buffer is full.
+static std::vector<TraceEvent> gTraceEvents;
+static std::size_t gTraceHead = 0;
+static uint64_t gTraceDropped = 0;
+
+// Chrome wants small integer thread IDs, so number threads in order of their
+// first span
+static std::atomic<unsigned int> gNextTid(1);
+static thread_local unsigned int tTid = 0;
+
+static const std::chrono::steady_clock::time_point gTraceEpoch =
+        std::chrono::steady_clock::now();
+
+static uint64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - gTraceEpoch).count();
+}
+
+static void json_escape(const std::string &str, std::string *out)
+{
+    *out += '"';
+    for (unsigned char c : str) {
+        switch (c) {
+        case '"':  *out += "\\\""; break;
+        case '\\': *out += "\\\\"; break;
+        case '\b': *out += "\\b";  break;
+        case '\f': *out += "\\f";  break;
+        case '\n': *out += "\\n";  break;
+        case '\r': *out += "\\r";  break;
+        case '\t': *out += "\\t";  break;
+        default:
+            if (c < 0x20) {
+                *out += StringUtils::format("\\u%04x", c);
+            } else {
+                *out += static_cast<char>(c);
+            }
+            break;
+        }
+    }
+    *out += '"';
+}
+
+void TraceSpan::begin()
+{
+    m_start = now_us();
+}
+
+void TraceSpan::end()
+{
+    uint64_t end = now_us();
+
+    if (tTid == 0) {
+        tTid = gNextTid++;
+    }
+
+    TraceEvent event;
+    event.category = m_category;
+    event.name = m_name;
+    event.tid = tTid;
+    event.start = m_start;
+    event.duration = end - m_start;
+    event.args.swap(m_args);
+
+    std::lock_guard<std::mutex> lock(gTraceMutex);
+    if (gTraceEvents.size() < MaxTraceEvents) {
+        gTraceEvents.push_back(std::move(event));
+    } else {
+        gTraceEvents[gTraceHead] = std::move(event);
+        gTraceHead = (gTraceHead + 1) % gTraceEvents.size();
+        ++gTraceDropped;
+    }
+}
+
+void TraceSpan::addStringArg(const char *key, const std::string &value)
+{
+    std::string encoded;
+    json_escape(value, &encoded);
+    m_args.emplace_back(key, std::move(encoded));
+}
+
+void setTracingEnabled(bool enabled)
+{
+    gTracingEnabled = enabled;
+}
+
+bool isTracingEnabled()
+{
+    return gTracingEnabled;
+}
+
+void clearTrace()
+{
+    std::lock_guard<std::mutex> lock(gTraceMutex);
+    gTraceEvents.clear();
+    gTraceEvents.shrink_to_fit();
+    gTraceHead = 0;
+    gTraceDropped = 0;
+}
+
+std::string jsonQuote(const std::string &str)
+{
+    std::string out;
+    out.reserve(str.size() + 2);
+    json_escape(str, &out);
+    return out;
+}
+
+std::string chromeTraceJson()
+{
+    std::string out;
+    out += "{\"displayTimeUnit\":\"ms\"";
+
+    std::lock_guard<std::mutex> lock(gTraceMutex);
+
+    if (gTraceDropped > 0) {
+        out += ",\"otherData\":{\"droppedSpans\":\"";
+        out += std::to_string(gTraceDropped);
+        out += "\"}";
+    }
+
+    out += ",\"traceEvents\":[";
+
+    bool first = true;
+    for (std::size_t i = 0; i < gTraceEvents.size(); ++i) {
+        const TraceEvent &event =
+                gTraceEvents[(gTraceHead + i) % gTraceEvents.size()];
+
+        if (!first) {
+            out += ",";
+        }
+        first = false;
+
+        out += "\n{\"ph\":\"X\",\"pid\":1,\"tid\":";
+        out += std::to_string(event.tid);
+        out += ",\"ts\":";
+        out += std::to_string(event.start);
+        out += ",\"dur\":";
+        out += std::to_string(event.duration);
+        out += ",\"cat\":";
+        json_escape(event.category, &out);
+        out += ",\"name\":";
+        json_escape(event.name, &out);
+
+        if (!event.args.empty()) {
+            out += ",\"args\":{";
+            bool firstArg = true;
+            for (auto const &arg : event.args) {
+                if (!firstArg) {
+                    out += ",";
+                }
+                firstArg = false;
+                json_escape(arg.first, &out);
+                out += ":";
+                out += arg.second;
+            }
+            out += "}";
+        }
+
+        out += "}";
+    }
+
+    out += "\n]}\n";
+
+    return out;
+}
+
+bool writeChromeTrace(const std::string &path)
+{
+    std::string json = chromeTraceJson();
+
+    io::File file;
+    if (!file.open(path, io::File::OpenWrite)) {
+        FLOGE("%s: Failed to open for writing: %s",
+              path.c_str(), file.errorString().c_str());
+        return false;
+    }
+
+    uint64_t bytesWritten;
+    if (!file.write(json.data(), json.size(), &bytesWritten)
+            || bytesWritten != json.size()) {
+        FLOGE("%s: Failed to write trace: %s",
+              path.c_str(), file.errorString().c_str());
+        return false;
+    }
+
+    if (!file.close()) {
+        FLOGE("%s: Failed to close file: %s",
+              path.c_str(), file.errorString().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../tracing.h"
+
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+namespace mbp
+{
+
+extern std::atomic<bool> gTracingEnabled;
+
+/*!
+ * \brief Scoped trace span
+ *
+ * Records the time between construction and destruction as a complete event.
+ * The category and name must be string literals (or otherwise outlive the
+ * trace) since only the pointers are stored. Arguments are only recorded if
+ * tracing was enabled when the span was created.
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(const char *category, const char *name)
+        : m_category(category), m_name(name),
+        m_active(gTracingEnabled.load(std::memory_order_relaxed))
+    {
+        if (m_active) {
+            begin();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (m_active) {
+            end();
+        }
+    }
+
+    bool active() const
+    {
+        return m_active;
+    }
+
+    void addArg(const char *key, const std::string &value)
+    {
+        if (m_active) {
+            addStringArg(key, value);
+        }
+    }
+
+    void addArg(const char *key, uint64_t value)
+    {
+        if (m_active) {
+            m_args.emplace_back(key, std::to_string(value));
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan(TraceSpan &&) = delete;
+    TraceSpan & operator=(const TraceSpan &) & = delete;
+    TraceSpan & operator=(TraceSpan &&) & = delete;
+
+private:
+    void begin();
+    void end();
+    void addStringArg(const char *key, const std::string &value);
+
+    const char *m_category;
+    const char *m_name;
+    bool m_active;
+    uint64_t m_start;
+    // Values are already JSON-encoded
+    std::vector<std::pair<const char *, std::string>> m_args;
+};
+
+}
+
+#define MBP_TRACE_CONCAT2(a, b) a ## b
+#define MBP_TRACE_CONCAT(a, b) MBP_TRACE_CONCAT2(a, b)
+
+// For spans that don't need arguments
+#define TRACE_SCOPE(category, name) \
+    mbp::TraceSpan MBP_TRACE_CONCAT(_traceSpan, __LINE__)(category, name)
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libmbp_global.h"
+
+#include <string>
+
+namespace mbp
+{
+
+/*!
+ * \brief Enable or disable recording of trace spans
+ *
+ * When enabled, libmbp records a timed span for each patcher pass, boot image
+ * and cpio operation, AutoPatcher run and zip operation. The spans are kept in
+ * memory until they are cleared. Only the most recent 65536 spans are kept;
+ * older ones are dropped and counted in the export. When disabled, a span
+ * costs a single atomic load.
+ */
+MBP_EXPORT void setTracingEnabled(bool enabled);
+
+/*!
+ * \brief Whether trace spans are being recorded
+ */
+MBP_EXPORT bool isTracingEnabled();
+
+/*!
+ * \brief Discard all recorded trace spans
+ */
+MBP_EXPORT void clearTrace();
+
+/*!
+ * \brief Get the recorded spans in the Chrome trace event format
+ *
+ * The output can be loaded in chrome://tracing or https://ui.perfetto.dev.
+ */
+MBP_EXPORT std::string chromeTraceJson();
+
+/*!
+ * \brief Write the recorded spans to a file in the Chrome trace event format
+ *
+ * \return Whether the file was successfully written
+ */
+MBP_EXPORT bool writeChromeTrace(const std::string &path);
+
+/*!
+ * \brief Quote and escape a string as a JSON string literal
+ *
+ * This is the encoder used for the trace export. It is available for tools
+ * that print their own JSON.
+ */
+MBP_EXPORT std::string jsonQuote(const std::string &str);
+
+}
@@ -19,13 +19,22 @@
 
 #include "libmbpio/android/file.h"
 
+#include <algorithm>
+#include <vector>
+
 #include <cerrno>
+#include <climits>
 #include <cstring>
 
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
 #if __ANDROID_API__ >= 21
 #define OPEN_FUNC open64
 #else
@@ -176,6 +185,219 @@ bool FileAndroid::write(const void *buf, uint64_t size, uint64_t *bytesWritten)
     return true;
 }
 
+bool FileAndroid::pread(void *buf, uint64_t size, uint64_t offset,
+                        uint64_t *bytesRead)
+{
+    ssize_t n;
+    do {
+        n = ::pread64(m_impl->fd, buf, size, offset);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    *bytesRead = n;
+
+    if (n == 0) {
+        m_impl->error = ErrorEndOfFile;
+        return false;
+    }
+
+    return true;
+}
+
+bool FileAndroid::pwrite(const void *buf, uint64_t size, uint64_t offset,
+                         uint64_t *bytesWritten)
+{
+    ssize_t n;
+    do {
+        n = ::pwrite64(m_impl->fd, buf, size, offset);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    *bytesWritten = n;
+
+    return true;
+}
+
+static ssize_t vectoredIo(int fd, const FileAndroid::IoVec *iov,
+                          std::size_t count, bool write)
+{
+    std::vector<struct iovec> vec;
+    vec.reserve(std::min<std::size_t>(count, IOV_MAX));
+
+    ssize_t total = 0;
+
+    for (std::size_t i = 0; i < count; i += IOV_MAX) {
+        std::size_t batch = std::min<std::size_t>(count - i, IOV_MAX);
+        std::size_t batchSize = 0;
+
+        vec.clear();
+        for (std::size_t j = i; j < i + batch; ++j) {
+            struct iovec v;
+            v.iov_base = iov[j].data;
+            v.iov_len = iov[j].size;
+            vec.push_back(v);
+            batchSize += iov[j].size;
+        }
+
+        ssize_t n;
+        do {
+            n = write ? ::writev(fd, vec.data(), vec.size())
+                    : ::readv(fd, vec.data(), vec.size());
+        } while (n < 0 && errno == EINTR);
+
+        if (n < 0) {
+            return total > 0 ? total : n;
+        }
+
+        total += n;
+
+        // Stop on a short transfer (EOF or full disk)
+        if (static_cast<std::size_t>(n) < batchSize) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+bool FileAndroid::readv(const IoVec *iov, std::size_t count,
+                        uint64_t *bytesRead)
+{
+    ssize_t n = vectoredIo(m_impl->fd, iov, count, false);
+    if (n < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    *bytesRead = n;
+
+    if (n == 0) {
+        m_impl->error = ErrorEndOfFile;
+        return false;
+    }
+
+    return true;
+}
+
+bool FileAndroid::writev(const IoVec *iov, std::size_t count,
+                         uint64_t *bytesWritten)
+{
+    ssize_t n = vectoredIo(m_impl->fd, iov, count, true);
+    if (n < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    *bytesWritten = n;
+
+    return true;
+}
+
+bool FileAndroid::preallocate(uint64_t size)
+{
+#if __ANDROID_API__ >= 21
+    // Reserve the blocks without changing the apparent file size
+    if (fallocate64(m_impl->fd, FALLOC_FL_KEEP_SIZE, 0, size) < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    return true;
+#else
+    (void) size;
+    m_impl->error = ErrorPlatformError;
+    m_impl->errnoCode = ENOSYS;
+    m_impl->errnoString = strerror(ENOSYS);
+    return false;
+#endif
+}
+
+bool FileAndroid::advise(int advice)
+{
+#if __ANDROID_API__ >= 21
+    int fadvice;
+    switch (advice) {
+    case AdviceNormal:
+        fadvice = POSIX_FADV_NORMAL;
+        break;
+    case AdviceSequential:
+        fadvice = POSIX_FADV_SEQUENTIAL;
+        break;
+    case AdviceRandom:
+        fadvice = POSIX_FADV_RANDOM;
+        break;
+    case AdviceWillNeed:
+        fadvice = POSIX_FADV_WILLNEED;
+        break;
+    case AdviceDontNeed:
+        fadvice = POSIX_FADV_DONTNEED;
+        break;
+    default:
+        m_impl->error = ErrorInvalidAdvice;
+        return false;
+    }
+
+    // posix_fadvise() returns the error instead of setting errno
+    int ret = posix_fadvise64(m_impl->fd, 0, 0, fadvice);
+    if (ret != 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = ret;
+        m_impl->errnoString = strerror(ret);
+        return false;
+    }
+
+    return true;
+#else
+    // Not available before API 21. It's only a hint, so ignore it.
+    if (advice < AdviceNormal || advice > AdviceDontNeed) {
+        m_impl->error = ErrorInvalidAdvice;
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+bool FileAndroid::sync()
+{
+    if (fsync(m_impl->fd) < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Get the underlying file descriptor
+ *
+ * \return File descriptor or -1 if the file is not open
+ */
+int FileAndroid::fd()
+{
+    return m_impl->fd;
+}
+
 bool FileAndroid::tell(uint64_t *pos)
 {
     off64_t offset = lseek64(m_impl->fd, 0, SEEK_CUR);
@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libmbpio/asyncio.h"
+
+#include "libmbpio/private/asyncbackend.h"
+#include "libmbpio/private/asyncthreadpool.h"
+#include "libmbpio/private/common.h"
+
+#if !IO_PLATFORM_WINDOWS
+#include "libmbpio/posix/asynciouring.h"
+#endif
+
+namespace io
+{
+
+namespace priv
+{
+
+AsyncBackend::~AsyncBackend()
+{
+}
+
+}
+
+class AsyncIo::Impl
+{
+public:
+    std::unique_ptr<priv::AsyncBackend> backend;
+    int backendType;
+    unsigned int queueDepth = 0;
+    std::size_t inFlight = 0;
+    int error;
+    std::string backendError;
+};
+
+/*!
+ * \class AsyncIo
+ * \brief Asynchronous positional I/O on io::File objects
+ *
+ * Requests are queued with submit() and their results are collected with
+ * wait(). Several requests can be passed to submit() at once and requests
+ * with FlagLink set are executed in order (eg. a write followed by a sync).
+ * No more than queueDepth() requests may be in flight at any time.
+ *
+ * On Linux, io_uring is used when the kernel supports it. Otherwise, the
+ * requests are executed by a pool of worker threads. The io::File objects and
+ * buffers must remain valid until the corresponding completion is returned by
+ * wait() and must not be used by the caller in the meantime.
+ */
+
+AsyncIo::AsyncIo() : m_impl(new Impl())
+{
+}
+
+AsyncIo::~AsyncIo()
+{
+    if (m_impl->backend && m_impl->inFlight > 0) {
+        drain();
+    }
+}
+
+/*!
+ * \brief Initialize the I/O engine
+ *
+ * \param queueDepth Maximum number of requests in flight
+ * \param backend One of BackendAuto, BackendThreadPool, or BackendIoUring
+ * \param threads Number of worker threads for the thread pool backend or 0 to
+ *                use the number of CPUs
+ *
+ * \return True if successful. Otherwise, false with the error set
+ *         appropriately. BackendIoUring fails with ErrorBackendUnavailable if
+ *         io_uring is not supported.
+ */
+bool AsyncIo::init(unsigned int queueDepth, int backend, unsigned int threads)
+{
+    if (m_impl->backend) {
+        m_impl->error = ErrorAlreadyInitialized;
+        return false;
+    }
+
+    if (queueDepth == 0) {
+        m_impl->error = ErrorInvalidRequest;
+        return false;
+    }
+
+#if IO_HAVE_IO_URING
+    if (backend == BackendAuto || backend == BackendIoUring) {
+        std::unique_ptr<priv::AsyncBackend> uring(new posix::AsyncIoUring());
+        if (uring->init(queueDepth, threads)) {
+            m_impl->backend = std::move(uring);
+            m_impl->backendType = BackendIoUring;
+        } else if (backend == BackendIoUring) {
+            m_impl->error = ErrorBackendUnavailable;
+            m_impl->backendError = uring->errorString();
+            return false;
+        }
+    }
+#else
+    if (backend == BackendIoUring) {
+        m_impl->error = ErrorBackendUnavailable;
+        m_impl->backendError.clear();
+        return false;
+    }
+#endif
+
+    if (!m_impl->backend) {
+        std::unique_ptr<priv::AsyncBackend> pool(new priv::AsyncThreadPool());
+        if (!pool->init(queueDepth, threads)) {
+            m_impl->error = ErrorPlatformError;
+            m_impl->backendError = pool->errorString();
+            return false;
+        }
+        m_impl->backend = std::move(pool);
+        m_impl->backendType = BackendThreadPool;
+    }
+
+    m_impl->queueDepth = queueDepth;
+    return true;
+}
+
+/*!
+ * \brief Get the backend that is in use
+ *
+ * \return BackendThreadPool or BackendIoUring. The return value is undefined
+ *         if init() has not succeeded.
+ */
+int AsyncIo::backend()
+{
+    return m_impl->backendType;
+}
+
+unsigned int AsyncIo::queueDepth()
+{
+    return m_impl->queueDepth;
+}
+
+/*!
+ * \brief Number of requests that have been submitted but not yet returned by
+ *        wait()
+ */
+std::size_t AsyncIo::inFlight()
+{
+    return m_impl->inFlight;
+}
+
+/*!
+ * \brief Submit a batch of requests
+ *
+ * Normally, either all of the requests are submitted or none are. If the
+ * kernel accepts only part of the batch, false is returned and the requests
+ * that were accepted (always the first ones in \a reqs) are counted in
+ * inFlight() and will be returned by wait().
+ *
+ * \param reqs Array of requests
+ * \param count Number of requests in \a reqs
+ *
+ * \return True if the requests were submitted. Otherwise, false with the error
+ *         set appropriately. ErrorQueueFull is returned if submitting the
+ *         requests would exceed the queue depth.
+ */
+bool AsyncIo::submit(const Request *reqs, std::size_t count)
+{
+    if (!m_impl->backend) {
+        m_impl->error = ErrorNotInitialized;
+        return false;
+    }
+
+    if (count == 0) {
+        return true;
+    }
+
+    if (m_impl->inFlight + count > m_impl->queueDepth) {
+        m_impl->error = ErrorQueueFull;
+        return false;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const Request &req = reqs[i];
+
+        if (!req.file || !req.file->isOpen()) {
+            m_impl->error = ErrorInvalidRequest;
+            return false;
+        }
+
+        switch (req.op) {
+        case OpRead:
+        case OpWrite:
+            if (!req.buf && req.size > 0) {
+                m_impl->error = ErrorInvalidRequest;
+                return false;
+            }
+            break;
+        case OpSync:
+            break;
+        default:
+            m_impl->error = ErrorInvalidRequest;
+            return false;
+        }
+    }
+
+    std::size_t submitted = 0;
+    bool ret = m_impl->backend->submit(reqs, count, &submitted);
+
+    // The requests that made it to the backend must be waited for either way
+    m_impl->inFlight += submitted;
+
+    if (!ret) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->backendError = m_impl->backend->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool AsyncIo::submit(const Request &req)
+{
+    return submit(&req, 1);
+}
+
+/*!
+ * \brief Wait for requests to complete
+ *
+ * \param completions Array to store the completions in
+ * \param min Minimum number of completions to wait for. This is capped at the
+ *            number of requests in flight. Use 0 to poll.
+ * \param max Size of \a completions
+ * \param count Number of completions stored (output parameter)
+ *
+ * \return True if successful. Otherwise, false with the error set
+ *         appropriately. Failed requests are reported through
+ *         Completion::success and do not cause this function to fail.
+ */
+bool AsyncIo::wait(Completion *completions, std::size_t min, std::size_t max,
+                   std::size_t *count)
+{
+    if (!m_impl->backend) {
+        m_impl->error = ErrorNotInitialized;
+        return false;
+    }
+
+    if (min > m_impl->inFlight) {
+        min = m_impl->inFlight;
+    }
+    if (min > max) {
+        min = max;
+    }
+
+    std::size_t n = 0;
+    bool ret = m_impl->backend->wait(completions, min, max, &n);
+
+    m_impl->inFlight -= n;
+    *count = n;
+
+    if (!ret) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->backendError = m_impl->backend->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Wait for all requests in flight and discard their completions
+ *
+ * \return True if all requests completed successfully. False otherwise.
+ */
+bool AsyncIo::drain()
+{
+    bool success = true;
+    Completion c;
+    std::size_t n;
+
+    while (m_impl->inFlight > 0) {
+        if (!wait(&c, 1, 1, &n)) {
+            return false;
+        }
+        if (n > 0 && !c.success) {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+int AsyncIo::error()
+{
+    return m_impl->error;
+}
+
+std::string AsyncIo::errorString()
+{
+    switch (m_impl->error) {
+    case ErrorNotInitialized:
+        return "I/O engine is not initialized";
+    case ErrorAlreadyInitialized:
+        return "I/O engine is already initialized";
+    case ErrorBackendUnavailable:
+        return m_impl->backendError.empty()
+                ? "Backend is not available"
+                : "Backend is not available: " + m_impl->backendError;
+    case ErrorInvalidRequest:
+        return "Invalid request";
+    case ErrorQueueFull:
+        return "Too many requests in flight";
+    case ErrorPlatformError:
+        return m_impl->backendError;
+    default:
+        return std::string();
+    }
+}
+
+}
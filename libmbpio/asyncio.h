@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmbpio/file.h"
+
+namespace io
+{
+
+class AsyncIo
+{
+public:
+    enum Backend : int {
+        BackendAuto,
+        BackendThreadPool,
+        BackendIoUring
+    };
+
+    enum Operation : int {
+        OpRead,
+        OpWrite,
+        OpSync
+    };
+
+    enum Flag : int {
+        // The next request in the same submit() call will not be started
+        // until this one completes successfully
+        FlagLink = 1 << 0
+    };
+
+    enum Error : int {
+        ErrorNotInitialized,
+        ErrorAlreadyInitialized,
+        ErrorBackendUnavailable,
+        ErrorInvalidRequest,
+        ErrorQueueFull,
+        ErrorPlatformError
+    };
+
+    struct Request {
+        int op;
+        File *file;
+        void *buf;
+        uint64_t size;
+        uint64_t offset;
+        int flags;
+        uint64_t userData;
+    };
+
+    struct Completion {
+        uint64_t userData;
+        bool success;
+        // Bytes transferred. A successful read with 0 bytes indicates EOF.
+        uint64_t bytes;
+        std::string errorString;
+    };
+
+    AsyncIo();
+    ~AsyncIo();
+
+    bool init(unsigned int queueDepth, int backend = BackendAuto,
+              unsigned int threads = 0);
+    int backend();
+    unsigned int queueDepth();
+    std::size_t inFlight();
+
+    bool submit(const Request *reqs, std::size_t count);
+    bool submit(const Request &req);
+    bool wait(Completion *completions, std::size_t min, std::size_t max,
+              std::size_t *count);
+    bool drain();
+
+    int error();
+    std::string errorString();
+
+    AsyncIo(const AsyncIo &) = delete;
+    AsyncIo & operator=(const AsyncIo &) = delete;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}
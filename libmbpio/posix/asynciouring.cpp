@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libmbpio/posix/asynciouring.h"
+
+#if IO_HAVE_IO_URING
+
+#include <algorithm>
+
+#include <cerrno>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace io
+{
+namespace posix
+{
+
+// There is no liburing on Android or on older distros, so talk to the kernel
+// directly. Only the submission queue tail and completion queue head are
+// written by us; the kernel owns the other ring indices.
+
+static int sysIoUringSetup(unsigned int entries, struct io_uring_params *p)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int sysIoUringEnter(int fd, unsigned int toSubmit,
+                           unsigned int minComplete, unsigned int flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, nullptr, 0));
+}
+
+template<typename T>
+static inline T * ringPtr(void *base, uint32_t offset)
+{
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+AsyncIoUring::AsyncIoUring()
+{
+}
+
+AsyncIoUring::~AsyncIoUring()
+{
+    if (m_sqes) {
+        munmap(m_sqes, m_sqesSize);
+    }
+    if (m_cqRing && m_cqRing != m_sqRing) {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    if (m_sqRing) {
+        munmap(m_sqRing, m_sqRingSize);
+    }
+    if (m_ringFd >= 0) {
+        close(m_ringFd);
+    }
+}
+
+bool AsyncIoUring::init(unsigned int queueDepth, unsigned int threads)
+{
+    (void) threads;
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+
+    m_ringFd = sysIoUringSetup(queueDepth, &p);
+    if (m_ringFd < 0) {
+        setErrno(errno);
+        return false;
+    }
+
+    m_sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    m_cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+    bool singleMmap = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+    }
+
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        m_sqRing = nullptr;
+        setErrno(errno);
+        return false;
+    }
+
+    if (singleMmap) {
+        m_cqRing = m_sqRing;
+    } else {
+        m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, m_ringFd,
+                        IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED) {
+            m_cqRing = nullptr;
+            setErrno(errno);
+            return false;
+        }
+    }
+
+    m_sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES);
+    if (m_sqes == MAP_FAILED) {
+        m_sqes = nullptr;
+        setErrno(errno);
+        return false;
+    }
+
+    m_sqTail = ringPtr<unsigned>(m_sqRing, p.sq_off.tail);
+    m_sqMask = ringPtr<unsigned>(m_sqRing, p.sq_off.ring_mask);
+    m_sqArray = ringPtr<unsigned>(m_sqRing, p.sq_off.array);
+    m_cqHead = ringPtr<unsigned>(m_cqRing, p.cq_off.head);
+    m_cqTail = ringPtr<unsigned>(m_cqRing, p.cq_off.tail);
+    m_cqMask = ringPtr<unsigned>(m_cqRing, p.cq_off.ring_mask);
+    m_cqes = ringPtr<void>(m_cqRing, p.cq_off.cqes);
+
+    m_slots.resize(queueDepth);
+    m_freeSlots.reserve(queueDepth);
+    for (unsigned int i = queueDepth; i > 0; --i) {
+        m_freeSlots.push_back(i - 1);
+    }
+
+    return true;
+}
+
+void AsyncIoUring::queueSqe(unsigned int slotIndex, bool link)
+{
+    Slot &slot = m_slots[slotIndex];
+
+    unsigned tail = *m_sqTail + m_pending;
+    unsigned index = tail & *m_sqMask;
+    struct io_uring_sqe *sqe =
+            static_cast<struct io_uring_sqe *>(m_sqes) + index;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = slot.fd;
+    sqe->user_data = slotIndex;
+    if (link) {
+        sqe->flags |= IOSQE_IO_LINK;
+    }
+
+    switch (slot.req.op) {
+    case AsyncIo::OpRead:
+    case AsyncIo::OpWrite:
+        // The vectored opcodes are supported since Linux 5.1, unlike
+        // IORING_OP_READ/WRITE, which need 5.6
+        slot.iov.iov_base = static_cast<char *>(slot.req.buf) + slot.done;
+        slot.iov.iov_len = slot.req.size - slot.done;
+        sqe->opcode = slot.req.op == AsyncIo::OpRead
+                ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe->off = slot.req.offset + slot.done;
+        sqe->addr = reinterpret_cast<uintptr_t>(&slot.iov);
+        sqe->len = 1;
+        break;
+    case AsyncIo::OpSync:
+        sqe->opcode = IORING_OP_FSYNC;
+        break;
+    }
+
+    m_sqArray[index] = index;
+    ++m_pending;
+}
+
+/*!
+ * Pass the queued SQEs to the kernel. The kernel may consume fewer than were
+ * queued, eg. if it runs out of memory. The SQEs that it skipped are taken
+ * back out of the ring and stay queued in m_pending, so the tail never runs
+ * ahead of what was actually submitted.
+ */
+bool AsyncIoUring::enter(unsigned int minComplete, unsigned int flags)
+{
+    unsigned tail = *m_sqTail;
+    unsigned int toSubmit = m_pending;
+
+    // Publish the new SQEs before the kernel looks at the tail
+    __atomic_store_n(m_sqTail, tail + toSubmit, __ATOMIC_RELEASE);
+
+    int ret;
+    do {
+        ret = sysIoUringEnter(m_ringFd, toSubmit, minComplete, flags);
+    } while (ret < 0 && errno == EINTR);
+
+    int savedErrno = errno;
+    unsigned int consumed = ret > 0 ? static_cast<unsigned int>(ret) : 0;
+
+    if (consumed < toSubmit) {
+        // The kernel only reads the SQ ring during io_uring_enter(), so moving
+        // the tail back is safe
+        __atomic_store_n(m_sqTail, tail + consumed, __ATOMIC_RELEASE);
+    }
+    m_pending = toSubmit - consumed;
+
+    if (ret < 0) {
+        setErrno(savedErrno);
+        return false;
+    }
+
+    return true;
+}
+
+bool AsyncIoUring::submit(const AsyncIo::Request *reqs, std::size_t count,
+                          std::size_t *submitted)
+{
+    // Short write remainders that could not be resubmitted by wait() are
+    // still queued in front of the new requests
+    unsigned int carried = m_pending;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        unsigned int slotIndex = m_freeSlots.back();
+        m_freeSlots.pop_back();
+
+        Slot &slot = m_slots[slotIndex];
+        slot.req = reqs[i];
+        slot.fd = reqs[i].file->fd();
+        slot.done = 0;
+
+        bool link = (reqs[i].flags & AsyncIo::FlagLink) && i != count - 1;
+        queueSqe(slotIndex, link);
+    }
+
+    bool ret = true;
+
+    while (m_pending > 0) {
+        unsigned int before = m_pending;
+
+        if (!enter(0, 0)) {
+            ret = false;
+            break;
+        } else if (m_pending == before) {
+            setErrno(EAGAIN);
+            ret = false;
+            break;
+        }
+    }
+
+    // The SQEs that were not consumed are at the end of the queue. Withdraw
+    // the ones that belong to this call and return their slots.
+    std::size_t unsubmitted = m_pending > carried ? m_pending - carried : 0;
+    m_pending -= unsubmitted;
+
+    for (std::size_t i = 0; i < unsubmitted; ++i) {
+        unsigned index = (*m_sqTail + m_pending + i) & *m_sqMask;
+        struct io_uring_sqe *sqe =
+                static_cast<struct io_uring_sqe *>(m_sqes) + index;
+        m_freeSlots.push_back(static_cast<unsigned int>(sqe->user_data));
+    }
+
+    *submitted = count - unsubmitted;
+    return ret;
+}
+
+bool AsyncIoUring::wait(AsyncIo::Completion *completions, std::size_t min,
+                        std::size_t max, std::size_t *count)
+{
+    std::size_t n = 0;
+
+    while (true) {
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+
+        while (head != tail && n < max) {
+            struct io_uring_cqe *cqe =
+                    static_cast<struct io_uring_cqe *>(m_cqes)
+                    + (head & *m_cqMask);
+            unsigned int slotIndex = static_cast<unsigned int>(cqe->user_data);
+            int res = cqe->res;
+            ++head;
+
+            Slot &slot = m_slots[slotIndex];
+
+            if (res > 0 && slot.req.op == AsyncIo::OpWrite) {
+                slot.done += res;
+                if (slot.done < slot.req.size) {
+                    // Short write; queue the remainder in the same slot
+                    queueSqe(slotIndex, false);
+                    continue;
+                }
+            } else if (res > 0) {
+                slot.done += res;
+            }
+
+            AsyncIo::Completion &c = completions[n++];
+            c.userData = slot.req.userData;
+            c.bytes = slot.done;
+            c.success = res >= 0;
+            c.errorString.clear();
+            if (res < 0) {
+                c.errorString = strerror(-res);
+            }
+
+            m_freeSlots.push_back(slotIndex);
+        }
+
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+
+        if (n >= min && m_pending == 0) {
+            break;
+        }
+
+        // Remainders that the kernel does not accept now stay queued and are
+        // retried by the next submit() or wait()
+        unsigned int flags = n < min ? IORING_ENTER_GETEVENTS : 0;
+        if (!enter(n < min ? 1 : 0, flags)) {
+            *count = n;
+            return false;
+        }
+
+        if (n >= min) {
+            break;
+        }
+    }
+
+    *count = n;
+    return true;
+}
+
+std::string AsyncIoUring::errorString()
+{
+    return m_errorString;
+}
+
+void AsyncIoUring::setErrno(int code)
+{
+    m_errorString = strerror(code);
+}
+
+}
+}
+
+#endif
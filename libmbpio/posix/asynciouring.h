@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libmbpio/private/asyncbackend.h"
+
+#if defined(__linux__) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    define IO_HAVE_IO_URING 1
+#  endif
+#endif
+
+#if IO_HAVE_IO_URING
+
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace io
+{
+namespace posix
+{
+
+class AsyncIoUring : public priv::AsyncBackend
+{
+public:
+    AsyncIoUring();
+    virtual ~AsyncIoUring();
+
+    virtual bool init(unsigned int queueDepth, unsigned int threads) override;
+    virtual bool submit(const AsyncIo::Request *reqs, std::size_t count,
+                        std::size_t *submitted) override;
+    virtual bool wait(AsyncIo::Completion *completions, std::size_t min,
+                      std::size_t max, std::size_t *count) override;
+    virtual std::string errorString() override;
+
+private:
+    struct Slot {
+        AsyncIo::Request req;
+        int fd;
+        uint64_t done;
+        struct iovec iov;
+    };
+
+    void queueSqe(unsigned int slotIndex, bool link);
+    bool enter(unsigned int minComplete, unsigned int flags);
+    void setErrno(int code);
+
+    int m_ringFd = -1;
+
+    void *m_sqRing = nullptr;
+    std::size_t m_sqRingSize = 0;
+    void *m_cqRing = nullptr;
+    std::size_t m_cqRingSize = 0;
+    void *m_sqes = nullptr;
+    std::size_t m_sqesSize = 0;
+
+    unsigned *m_sqTail;
+    unsigned *m_sqMask;
+    unsigned *m_sqArray;
+    unsigned *m_cqHead;
+    unsigned *m_cqTail;
+    unsigned *m_cqMask;
+    void *m_cqes;
+
+    // Number of SQEs queued in the ring but not yet consumed by the kernel
+    unsigned int m_pending = 0;
+
+    std::vector<Slot> m_slots;
+    std::vector<unsigned int> m_freeSlots;
+
+    std::string m_errorString;
+};
+
+}
+}
+
+#endif
@@ -19,13 +19,23 @@
 
 #include "libmbpio/posix/file.h"
 
+#include <algorithm>
+#include <vector>
+
 #include <cerrno>
+#include <climits>
 #include <cstdio>
 #include <cstring>
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
 namespace io
 {
 namespace posix
@@ -171,6 +181,301 @@ bool FilePosix::write(const void *buf, uint64_t size, uint64_t *bytesWritten)
     return true;
 }
 
+// The positional and vectored functions below bypass stdio and operate on the
+// underlying file descriptor. Any buffered data is flushed first and the
+// stream position is resynchronized afterwards.
+
+bool FilePosix::pread(void *buf, uint64_t size, uint64_t offset,
+                      uint64_t *bytesRead)
+{
+    if (fflush(m_impl->fp) == EOF) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    ssize_t n;
+    do {
+        n = ::pread64(fileno(m_impl->fp), buf, size, offset);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    *bytesRead = n;
+
+    if (n == 0) {
+        m_impl->error = ErrorEndOfFile;
+        return false;
+    }
+
+    return true;
+}
+
+bool FilePosix::pwrite(const void *buf, uint64_t size, uint64_t offset,
+                       uint64_t *bytesWritten)
+{
+    if (fflush(m_impl->fp) == EOF) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    const char *ptr = static_cast<const char *>(buf);
+    uint64_t total = 0;
+
+    while (total < size) {
+        ssize_t n = ::pwrite64(fileno(m_impl->fp), ptr + total, size - total,
+                               offset + total);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *bytesWritten = total;
+            m_impl->error = ErrorPlatformError;
+            m_impl->errnoCode = errno;
+            m_impl->errnoString = strerror(errno);
+            return false;
+        }
+        total += n;
+    }
+
+    *bytesWritten = total;
+    return true;
+}
+
+static ssize_t vectoredIo(int fd, const FilePosix::IoVec *iov,
+                          std::size_t count, bool write)
+{
+    std::vector<struct iovec> vec;
+    vec.reserve(std::min<std::size_t>(count, IOV_MAX));
+
+    ssize_t total = 0;
+
+    for (std::size_t i = 0; i < count; i += IOV_MAX) {
+        std::size_t batch = std::min<std::size_t>(count - i, IOV_MAX);
+        std::size_t batchSize = 0;
+
+        vec.clear();
+        for (std::size_t j = i; j < i + batch; ++j) {
+            struct iovec v;
+            v.iov_base = iov[j].data;
+            v.iov_len = iov[j].size;
+            vec.push_back(v);
+            batchSize += iov[j].size;
+        }
+
+        ssize_t n;
+        do {
+            n = write ? ::writev(fd, vec.data(), vec.size())
+                    : ::readv(fd, vec.data(), vec.size());
+        } while (n < 0 && errno == EINTR);
+
+        if (n < 0) {
+            return total > 0 ? total : n;
+        }
+
+        total += n;
+
+        // Stop on a short transfer (EOF or full disk)
+        if (static_cast<std::size_t>(n) < batchSize) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+bool FilePosix::readv(const IoVec *iov, std::size_t count, uint64_t *bytesRead)
+{
+    off64_t pos = ftello64(m_impl->fp);
+    if (pos < 0 || fflush(m_impl->fp) == EOF) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    int fd = fileno(m_impl->fp);
+
+    // stdio may have read ahead of the logical position
+    if (lseek64(fd, pos, SEEK_SET) < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    ssize_t n = vectoredIo(fd, iov, count, false);
+    int savedErrno = errno;
+
+    if (n > 0) {
+        fseeko64(m_impl->fp, pos + n, SEEK_SET);
+    } else {
+        fseeko64(m_impl->fp, pos, SEEK_SET);
+    }
+
+    if (n < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = savedErrno;
+        m_impl->errnoString = strerror(savedErrno);
+        return false;
+    }
+
+    *bytesRead = n;
+
+    if (n == 0) {
+        m_impl->error = ErrorEndOfFile;
+        return false;
+    }
+
+    return true;
+}
+
+bool FilePosix::writev(const IoVec *iov, std::size_t count,
+                       uint64_t *bytesWritten)
+{
+    off64_t pos = ftello64(m_impl->fp);
+    if (pos < 0 || fflush(m_impl->fp) == EOF) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    int fd = fileno(m_impl->fp);
+
+    if (lseek64(fd, pos, SEEK_SET) < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    uint64_t size = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        size += iov[i].size;
+    }
+
+    ssize_t n = vectoredIo(fd, iov, count, true);
+    int savedErrno = errno;
+
+    // Use the descriptor's offset since O_APPEND writes ignore pos
+    off64_t newPos = lseek64(fd, 0, SEEK_CUR);
+    if (newPos >= 0) {
+        fseeko64(m_impl->fp, newPos, SEEK_SET);
+    }
+
+    if (n < 0 || static_cast<uint64_t>(n) < size) {
+        *bytesWritten = n < 0 ? 0 : n;
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = n < 0 ? savedErrno : ENOSPC;
+        m_impl->errnoString = strerror(m_impl->errnoCode);
+        return false;
+    }
+
+    *bytesWritten = n;
+    return true;
+}
+
+bool FilePosix::preallocate(uint64_t size)
+{
+    int fd = fileno(m_impl->fp);
+    int ret;
+
+#ifdef __linux__
+    // Reserve the blocks without changing the apparent file size
+    ret = fallocate64(fd, FALLOC_FL_KEEP_SIZE, 0, size);
+    if (ret < 0) {
+        ret = errno;
+    }
+#else
+    // posix_fallocate() returns the error instead of setting errno
+    ret = posix_fallocate(fd, 0, size);
+#endif
+
+    if (ret != 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = ret;
+        m_impl->errnoString = strerror(ret);
+        return false;
+    }
+
+    return true;
+}
+
+bool FilePosix::advise(int advice)
+{
+    int fadvice;
+    switch (advice) {
+    case AdviceNormal:
+        fadvice = POSIX_FADV_NORMAL;
+        break;
+    case AdviceSequential:
+        fadvice = POSIX_FADV_SEQUENTIAL;
+        break;
+    case AdviceRandom:
+        fadvice = POSIX_FADV_RANDOM;
+        break;
+    case AdviceWillNeed:
+        fadvice = POSIX_FADV_WILLNEED;
+        break;
+    case AdviceDontNeed:
+        fadvice = POSIX_FADV_DONTNEED;
+        break;
+    default:
+        m_impl->error = ErrorInvalidAdvice;
+        return false;
+    }
+
+    // posix_fadvise() returns the error instead of setting errno
+    int ret = posix_fadvise64(fileno(m_impl->fp), 0, 0, fadvice);
+    if (ret != 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = ret;
+        m_impl->errnoString = strerror(ret);
+        return false;
+    }
+
+    return true;
+}
+
+bool FilePosix::sync()
+{
+    if (fflush(m_impl->fp) == EOF || fsync(fileno(m_impl->fp)) < 0) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->errnoCode = errno;
+        m_impl->errnoString = strerror(errno);
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Get the underlying file descriptor
+ *
+ * Buffered data is flushed first so that I/O performed directly on the file
+ * descriptor sees the same contents as the stream.
+ *
+ * \return File descriptor or -1 if the file is not open
+ */
+int FilePosix::fd()
+{
+    if (!m_impl->fp) {
+        return -1;
+    }
+
+    fflush(m_impl->fp);
+    return fileno(m_impl->fp);
+}
+
 bool FilePosix::tell(uint64_t *pos)
 {
     off64_t offset = ftello64(m_impl->fp);
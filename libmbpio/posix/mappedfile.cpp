@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libmbpio/posix/mappedfile.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// This file is shared by the posix and android backends. bionic only gained
+// open64() in API 21, but O_LARGEFILE works everywhere.
+#ifndef O_LARGEFILE
+#define O_LARGEFILE 0
+#endif
+
+namespace io
+{
+namespace posix
+{
+
+class MappedFilePosix::Impl
+{
+public:
+    bool mapped = false;
+    void *addr = nullptr;
+    uint64_t size = 0;
+    int mode;
+    int error;
+    int errnoCode;
+    std::string errnoString;
+
+    void setErrno(int code);
+};
+
+void MappedFilePosix::Impl::setErrno(int code)
+{
+    error = ErrorPlatformError;
+    errnoCode = code;
+    errnoString = strerror(code);
+}
+
+MappedFilePosix::MappedFilePosix() : m_impl(new Impl())
+{
+}
+
+MappedFilePosix::~MappedFilePosix()
+{
+    if (isMapped()) {
+        unmap();
+    }
+}
+
+bool MappedFilePosix::map(const char *filename, int mode, uint64_t size)
+{
+    if (m_impl->mapped) {
+        m_impl->error = ErrorFileIsMapped;
+        return false;
+    }
+
+    if (!filename) {
+        m_impl->error = ErrorInvalidFilename;
+        return false;
+    }
+
+    int openFlags;
+    int prot;
+    switch (mode) {
+    case MapRead:
+        openFlags = O_LARGEFILE | O_RDONLY;
+        prot = PROT_READ;
+        break;
+    case MapReadWrite:
+        openFlags = O_LARGEFILE | O_RDWR | O_CREAT;
+        prot = PROT_READ | PROT_WRITE;
+        break;
+    default:
+        m_impl->error = ErrorInvalidMapMode;
+        return false;
+    }
+
+    if (size != 0 && mode != MapReadWrite) {
+        m_impl->error = ErrorInvalidMapMode;
+        return false;
+    }
+
+    // Only regular files and block devices can be mapped. Opening a FIFO just
+    // to find that out would consume the writer's end of the handshake.
+    struct stat sb;
+    if (stat(filename, &sb) == 0 && !S_ISREG(sb.st_mode)
+            && !S_ISBLK(sb.st_mode) && !S_ISDIR(sb.st_mode)) {
+        m_impl->setErrno(ENODEV);
+        return false;
+    }
+
+    int fd = ::open(filename, openFlags | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        m_impl->setErrno(errno);
+        return false;
+    }
+
+    if (fstat(fd, &sb) < 0) {
+        m_impl->setErrno(errno);
+        ::close(fd);
+        return false;
+    }
+
+    if (S_ISDIR(sb.st_mode)) {
+        m_impl->setErrno(EISDIR);
+        ::close(fd);
+        return false;
+    }
+
+    uint64_t mapSize = sb.st_size;
+
+    if (S_ISBLK(sb.st_mode)) {
+        // st_size is 0 for block devices, but their size can be found by
+        // seeking to the end
+        if (size != 0) {
+            m_impl->setErrno(EINVAL);
+            ::close(fd);
+            return false;
+        }
+
+        off64_t end = lseek64(fd, 0, SEEK_END);
+        if (end < 0) {
+            m_impl->setErrno(errno);
+            ::close(fd);
+            return false;
+        }
+        mapSize = end;
+    }
+
+    if (size != 0) {
+        if (ftruncate64(fd, size) < 0) {
+            m_impl->setErrno(errno);
+            ::close(fd);
+            return false;
+        }
+        mapSize = size;
+    }
+
+    if (static_cast<uint64_t>(static_cast<size_t>(mapSize)) != mapSize) {
+        // Too large for the address space (32-bit targets)
+        m_impl->setErrno(EFBIG);
+        ::close(fd);
+        return false;
+    }
+
+    void *addr = nullptr;
+
+    // mmap() does not allow zero-length mappings
+    if (mapSize > 0) {
+        addr = mmap(nullptr, mapSize, prot, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            m_impl->setErrno(errno);
+            ::close(fd);
+            return false;
+        }
+    }
+
+    // The mapping holds its own reference to the file
+    ::close(fd);
+
+    m_impl->mapped = true;
+    m_impl->addr = addr;
+    m_impl->size = mapSize;
+    m_impl->mode = mode;
+    return true;
+}
+
+bool MappedFilePosix::map(const std::string &filename, int mode, uint64_t size)
+{
+    return map(filename.c_str(), mode, size);
+}
+
+bool MappedFilePosix::unmap()
+{
+    if (!m_impl->mapped) {
+        m_impl->error = ErrorFileIsNotMapped;
+        return false;
+    }
+
+    void *addr = m_impl->addr;
+    uint64_t size = m_impl->size;
+    m_impl->mapped = false;
+    m_impl->addr = nullptr;
+    m_impl->size = 0;
+
+    if (addr && munmap(addr, size) < 0) {
+        m_impl->setErrno(errno);
+        return false;
+    }
+
+    return true;
+}
+
+bool MappedFilePosix::isMapped()
+{
+    return m_impl->mapped;
+}
+
+unsigned char * MappedFilePosix::data()
+{
+    return static_cast<unsigned char *>(m_impl->addr);
+}
+
+uint64_t MappedFilePosix::size()
+{
+    return m_impl->size;
+}
+
+static bool toMadvise(int advice, int *out)
+{
+    switch (advice) {
+    case MappedFilePosix::AdviceNormal:
+        *out = MADV_NORMAL;
+        return true;
+    case MappedFilePosix::AdviceSequential:
+        *out = MADV_SEQUENTIAL;
+        return true;
+    case MappedFilePosix::AdviceRandom:
+        *out = MADV_RANDOM;
+        return true;
+    case MappedFilePosix::AdviceWillNeed:
+        *out = MADV_WILLNEED;
+        return true;
+    case MappedFilePosix::AdviceDontNeed:
+        *out = MADV_DONTNEED;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool MappedFilePosix::advise(int advice)
+{
+    if (!m_impl->mapped) {
+        m_impl->error = ErrorFileIsNotMapped;
+        return false;
+    }
+
+    int madv;
+    if (!toMadvise(advice, &madv)) {
+        m_impl->error = ErrorInvalidAdvice;
+        return false;
+    }
+
+    if (m_impl->addr && madvise(m_impl->addr, m_impl->size, madv) < 0) {
+        m_impl->setErrno(errno);
+        return false;
+    }
+
+    return true;
+}
+
+bool MappedFilePosix::prefetch(uint64_t offset, uint64_t size)
+{
+    if (!m_impl->mapped) {
+        m_impl->error = ErrorFileIsNotMapped;
+        return false;
+    }
+
+    if (offset > m_impl->size || size > m_impl->size - offset) {
+        m_impl->error = ErrorInvalidRange;
+        return false;
+    }
+
+    if (size == 0) {
+        return true;
+    }
+
+    // madvise() requires a page-aligned address
+    uint64_t pageSize = sysconf(_SC_PAGESIZE);
+    uint64_t alignedOffset = offset - offset % pageSize;
+    unsigned char *addr = static_cast<unsigned char *>(m_impl->addr);
+
+    if (madvise(addr + alignedOffset, size + (offset - alignedOffset),
+                MADV_WILLNEED) < 0) {
+        m_impl->setErrno(errno);
+        return false;
+    }
+
+    return true;
+}
+
+bool MappedFilePosix::sync()
+{
+    if (!m_impl->mapped) {
+        m_impl->error = ErrorFileIsNotMapped;
+        return false;
+    }
+
+    if (m_impl->mode == MapReadWrite && m_impl->addr
+            && msync(m_impl->addr, m_impl->size, MS_SYNC) < 0) {
+        m_impl->setErrno(errno);
+        return false;
+    }
+
+    return true;
+}
+
+int MappedFilePosix::error()
+{
+    return m_impl->error;
+}
+
+std::string MappedFilePosix::platformErrorString()
+{
+    return m_impl->errnoString;
+}
+
+}
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libmbpio/asyncio.h"
+
+namespace io
+{
+namespace priv
+{
+
+/*
+ * Backends only need to implement submission and completion. Argument
+ * validation and queue depth accounting are done by AsyncIo, so a backend can
+ * assume that the number of requests in flight never exceeds the queue depth
+ * passed to init().
+ *
+ * submit() reports how many of the requests were actually submitted. These
+ * are always the first ones in \a reqs, and they are in flight even if
+ * submit() returns false.
+ */
+class AsyncBackend
+{
+public:
+    virtual ~AsyncBackend();
+
+    virtual bool init(unsigned int queueDepth, unsigned int threads) = 0;
+    virtual bool submit(const AsyncIo::Request *reqs, std::size_t count,
+                        std::size_t *submitted) = 0;
+    virtual bool wait(AsyncIo::Completion *completions, std::size_t min,
+                      std::size_t max, std::size_t *count) = 0;
+    virtual std::string errorString() = 0;
+};
+
+}
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libmbpio/private/asyncthreadpool.h"
+
+#include <functional>
+
+namespace io
+{
+namespace priv
+{
+
+AsyncThreadPool::AsyncThreadPool()
+{
+}
+
+AsyncThreadPool::~AsyncThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_taskCv.notify_all();
+
+    for (std::thread &t : m_threads) {
+        t.join();
+    }
+}
+
+bool AsyncThreadPool::init(unsigned int queueDepth, unsigned int threads)
+{
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0) {
+            threads = 2;
+        }
+    }
+    if (threads > queueDepth) {
+        threads = queueDepth;
+    }
+
+    for (unsigned int i = 0; i < threads; ++i) {
+        m_threads.emplace_back(&AsyncThreadPool::workerLoop, this);
+    }
+
+    return true;
+}
+
+bool AsyncThreadPool::submit(const AsyncIo::Request *reqs, std::size_t count,
+                             std::size_t *submitted)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Chain chain;
+        for (std::size_t i = 0; i < count; ++i) {
+            chain.push_back(reqs[i]);
+            if (!(reqs[i].flags & AsyncIo::FlagLink) || i == count - 1) {
+                m_tasks.push_back(std::move(chain));
+                chain.clear();
+            }
+        }
+    }
+    m_taskCv.notify_all();
+
+    *submitted = count;
+    return true;
+}
+
+bool AsyncThreadPool::wait(AsyncIo::Completion *completions, std::size_t min,
+                           std::size_t max, std::size_t *count)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_doneCv.wait(lock, [&]{ return m_done.size() >= min; });
+
+    std::size_t n = 0;
+    while (n < max && !m_done.empty()) {
+        completions[n++] = std::move(m_done.front());
+        m_done.pop_front();
+    }
+
+    *count = n;
+    return true;
+}
+
+std::string AsyncThreadPool::errorString()
+{
+    return std::string();
+}
+
+void AsyncThreadPool::workerLoop()
+{
+    while (true) {
+        Chain chain;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskCv.wait(lock, [&]{ return m_stop || !m_tasks.empty(); });
+
+            if (m_stop) {
+                return;
+            }
+
+            chain = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        runChain(chain);
+    }
+}
+
+void AsyncThreadPool::runChain(const Chain &chain)
+{
+    std::vector<AsyncIo::Completion> results(chain.size());
+    bool failed = false;
+
+    for (std::size_t i = 0; i < chain.size(); ++i) {
+        AsyncIo::Completion &c = results[i];
+        c.userData = chain[i].userData;
+        c.bytes = 0;
+
+        if (failed) {
+            // Mirror io_uring: the rest of a broken chain is canceled
+            c.success = false;
+            c.errorString = "Canceled because a linked request failed";
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(fileLock(chain[i].file));
+        c.success = runRequest(chain[i], &c);
+        failed = !c.success;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (AsyncIo::Completion &c : results) {
+            m_done.push_back(std::move(c));
+        }
+    }
+    m_doneCv.notify_all();
+}
+
+bool AsyncThreadPool::runRequest(const AsyncIo::Request &req,
+                                 AsyncIo::Completion *c)
+{
+    char *buf = static_cast<char *>(req.buf);
+    uint64_t n;
+
+    switch (req.op) {
+    case AsyncIo::OpRead:
+        // Keep reading until the buffer is full or EOF is reached
+        while (c->bytes < req.size) {
+            if (!req.file->pread(buf + c->bytes, req.size - c->bytes,
+                                 req.offset + c->bytes, &n)) {
+                if (req.file->error() == File::ErrorEndOfFile) {
+                    break;
+                }
+                c->errorString = req.file->errorString();
+                return false;
+            }
+            c->bytes += n;
+        }
+        return true;
+
+    case AsyncIo::OpWrite:
+        while (c->bytes < req.size) {
+            if (!req.file->pwrite(buf + c->bytes, req.size - c->bytes,
+                                  req.offset + c->bytes, &n)) {
+                c->errorString = req.file->errorString();
+                return false;
+            } else if (n == 0) {
+                c->errorString = "Short write";
+                return false;
+            }
+            c->bytes += n;
+        }
+        return true;
+
+    case AsyncIo::OpSync:
+        if (!req.file->sync()) {
+            c->errorString = req.file->errorString();
+            return false;
+        }
+        return true;
+
+    default:
+        c->errorString = "Invalid operation";
+        return false;
+    }
+}
+
+std::mutex & AsyncThreadPool::fileLock(File *file)
+{
+    return m_fileLocks[std::hash<File *>()(file) % NumFileLocks];
+}
+
+}
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libmbpio/private/asyncbackend.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace io
+{
+namespace priv
+{
+
+class AsyncThreadPool : public AsyncBackend
+{
+public:
+    AsyncThreadPool();
+    virtual ~AsyncThreadPool();
+
+    virtual bool init(unsigned int queueDepth, unsigned int threads) override;
+    virtual bool submit(const AsyncIo::Request *reqs, std::size_t count,
+                        std::size_t *submitted) override;
+    virtual bool wait(AsyncIo::Completion *completions, std::size_t min,
+                      std::size_t max, std::size_t *count) override;
+    virtual std::string errorString() override;
+
+private:
+    // Requests linked with FlagLink are executed in order by a single worker
+    typedef std::vector<AsyncIo::Request> Chain;
+
+    void workerLoop();
+    void runChain(const Chain &chain);
+    bool runRequest(const AsyncIo::Request &req, AsyncIo::Completion *c);
+    std::mutex & fileLock(File *file);
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_taskCv;
+    std::condition_variable m_doneCv;
+    std::deque<Chain> m_tasks;
+    std::deque<AsyncIo::Completion> m_done;
+    bool m_stop = false;
+
+    // io::File is not safe for concurrent use, so requests for the same file
+    // are serialized by hashing the file into one of these locks
+    static const std::size_t NumFileLocks = 16;
+    std::mutex m_fileLocks[NumFileLocks];
+};
+
+}
+}
@@ -37,6 +37,8 @@ std::string FileBase::errorString()
         return "Invalid open mode";
     case ErrorInvalidSeekOrigin:
         return "Invalid seek origin";
+    case ErrorInvalidAdvice:
+        return "Invalid advice";
     case ErrorFileIsNotOpen:
         return "File is not open";
     case ErrorEndOfFile:
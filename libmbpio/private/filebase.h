@@ -21,6 +21,9 @@
 
 #include <string>
 
+#include <cstddef>
+#include <cstdint>
+
 namespace io
 {
 namespace priv
@@ -41,15 +44,32 @@ public:
         SeekEnd
     };
 
+    enum Advice : int {
+        AdviceNormal,
+        AdviceSequential,
+        AdviceRandom,
+        AdviceWillNeed,
+        AdviceDontNeed
+    };
+
     enum Error : int {
         ErrorInvalidFilename,
         ErrorInvalidOpenMode,
         ErrorInvalidSeekOrigin,
+        ErrorInvalidAdvice,
         ErrorFileIsNotOpen,
         ErrorEndOfFile,
         ErrorPlatformError
     };
 
+    /*!
+     * \brief Buffer descriptor for vectored I/O
+     */
+    struct IoVec {
+        void *data;
+        uint64_t size;
+    };
+
     /*!
      * \brief Destructor
      *
@@ -131,6 +151,109 @@ public:
      */
     virtual bool write(const void *buf, uint64_t size, uint64_t *bytesWritten) = 0;
 
+    /*!
+     * \brief Read bytes from the file at the specified offset
+     *
+     * This behaves like read(), except that the data is read from \a offset
+     * and the file pointer position is not changed.
+     *
+     * \param buf Buffer to read into
+     * \param size Buffer size
+     * \param offset Offset from the beginning of the file
+     * \param bytesRead Bytes read (output parameter)
+     *
+     * \return Whether the read was successful
+     */
+    virtual bool pread(void *buf, uint64_t size, uint64_t offset,
+                       uint64_t *bytesRead) = 0;
+
+    /*!
+     * \brief Write bytes to the file at the specified offset
+     *
+     * This behaves like write(), except that the data is written at \a offset
+     * and the file pointer position is not changed.
+     *
+     * \note If the file was opened with OpenAppend, the data may be appended
+     *       to the end of the file regardless of \a offset.
+     *
+     * \param buf Buffer to write from
+     * \param size Buffer size
+     * \param offset Offset from the beginning of the file
+     * \param bytesWritten Bytes written (output parameter)
+     *
+     * \return Whether the write was successful
+     */
+    virtual bool pwrite(const void *buf, uint64_t size, uint64_t offset,
+                        uint64_t *bytesWritten) = 0;
+
+    /*!
+     * \brief Read bytes from the file into multiple buffers
+     *
+     * The buffers are filled in order. The return value and EOF handling are
+     * the same as read().
+     *
+     * \param iov Array of buffers to read into
+     * \param count Number of buffers in \a iov
+     * \param bytesRead Total bytes read (output parameter)
+     *
+     * \return Whether the read was successful
+     */
+    virtual bool readv(const IoVec *iov, std::size_t count,
+                       uint64_t *bytesRead) = 0;
+
+    /*!
+     * \brief Write bytes to the file from multiple buffers
+     *
+     * The buffers are written in order with as few system calls as the
+     * platform allows.
+     *
+     * \param iov Array of buffers to write from
+     * \param count Number of buffers in \a iov
+     * \param bytesWritten Total bytes written (output parameter)
+     *
+     * \return Whether the write was successful
+     */
+    virtual bool writev(const IoVec *iov, std::size_t count,
+                        uint64_t *bytesWritten) = 0;
+
+    /*!
+     * \brief Reserve disk space for the file
+     *
+     * Allocates space for at least \a size bytes so that writing the file
+     * sequentially does not need to grow (and fragment) it. The file size as
+     * reported by seek() and stat() is not changed.
+     *
+     * \note This is only an optimization. Callers should not treat failure as
+     *       fatal.
+     *
+     * \param size Number of bytes to reserve from the beginning of the file
+     *
+     * \return True if successful. Otherwise, false if an error occurs with the
+     *         error set appropriately.
+     */
+    virtual bool preallocate(uint64_t size) = 0;
+
+    /*!
+     * \brief Give the kernel a hint about the access pattern
+     *
+     * \note Hints that the platform does not support are silently ignored.
+     *
+     * \param advice One of AdviceNormal, AdviceSequential, AdviceRandom,
+     *               AdviceWillNeed, or AdviceDontNeed
+     *
+     * \return True if successful. Otherwise, false if an error occurs with the
+     *         error set appropriately.
+     */
+    virtual bool advise(int advice) = 0;
+
+    /*!
+     * \brief Flush data to the storage device
+     *
+     * \return True if successful. Otherwise, false if an error occurs with the
+     *         error set appropriately.
+     */
+    virtual bool sync() = 0;
+
     /*!
      * \brief Get file pointer position
      *
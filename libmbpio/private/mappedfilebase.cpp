@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libmbpio/private/mappedfilebase.h"
+
+namespace io
+{
+namespace priv
+{
+
+MappedFileBase::~MappedFileBase()
+{
+}
+
+std::string MappedFileBase::errorString()
+{
+    switch (error()) {
+    case ErrorInvalidFilename:
+        return "Invalid or null filename";
+    case ErrorInvalidMapMode:
+        return "Invalid map mode";
+    case ErrorInvalidAdvice:
+        return "Invalid advice";
+    case ErrorInvalidRange:
+        return "Range is outside of the mapping";
+    case ErrorFileIsNotMapped:
+        return "File is not mapped";
+    case ErrorFileIsMapped:
+        return "File is already mapped";
+    case ErrorPlatformError:
+        return platformErrorString();
+    default:
+        return std::string();
+    }
+}
+
+}
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <cstdint>
+
+namespace io
+{
+namespace priv
+{
+
+class MappedFileBase
+{
+public:
+    enum MapMode : int {
+        MapRead,
+        MapReadWrite
+    };
+
+    enum Advice : int {
+        AdviceNormal,
+        AdviceSequential,
+        AdviceRandom,
+        AdviceWillNeed,
+        AdviceDontNeed
+    };
+
+    enum Error : int {
+        ErrorInvalidFilename,
+        ErrorInvalidMapMode,
+        ErrorInvalidAdvice,
+        ErrorInvalidRange,
+        ErrorFileIsNotMapped,
+        ErrorFileIsMapped,
+        ErrorPlatformError
+    };
+
+    /*!
+     * \brief Destructor
+     *
+     * The destructor will automatically call unmap() if isMapped() returns
+     * true.
+     */
+    virtual ~MappedFileBase();
+
+    /*!
+     * \brief Map a file into memory
+     *
+     * With MapRead, the file must exist and the mapping is read-only. With
+     * MapReadWrite, the file is created if it does not exist and changes to
+     * the mapping are written back to the file. If \a size is non-zero, the
+     * file is resized to \a size bytes before it is mapped (MapReadWrite
+     * only).
+     *
+     * Mapping an empty file succeeds, but data() will return nullptr.
+     * Block devices are mapped in full and cannot be resized. Other special
+     * files, like pipes and character devices, cannot be mapped.
+     *
+     * \param filename UTF-8 encoded filename
+     * \param mode Map mode; one of MapRead or MapReadWrite
+     * \param size New size of the file or 0 to keep the current size
+     *
+     * \return True if the file was successfully mapped. False otherwise, with
+     *         the error set appropriately. If a file is already mapped, this
+     *         fails with ErrorFileIsMapped instead of leaking the mapping.
+     */
+    virtual bool map(const char *filename, int mode, uint64_t size = 0) = 0;
+    virtual bool map(const std::string &filename, int mode,
+                     uint64_t size = 0) = 0;
+
+    /*!
+     * \brief Unmap the file
+     *
+     * \return True if the file was successfully unmapped. False otherwise,
+     *         with the error set appropriately.
+     */
+    virtual bool unmap() = 0;
+
+    /*!
+     * \brief Check if the file is mapped
+     *
+     * \return True if the file is mapped. False otherwise.
+     */
+    virtual bool isMapped() = 0;
+
+    /*!
+     * \brief Pointer to the beginning of the mapping
+     *
+     * \note The returned pointer is only valid until unmap() is called. Do not
+     *       write to the memory if the file was mapped with MapRead.
+     *
+     * \return Pointer to mapped data or nullptr if the file is not mapped or
+     *         is empty
+     */
+    virtual unsigned char * data() = 0;
+
+    /*!
+     * \brief Size of the mapping
+     *
+     * \return Size of the mapped file or 0 if the file is not mapped
+     */
+    virtual uint64_t size() = 0;
+
+    /*!
+     * \brief Give the kernel a hint about the access pattern
+     *
+     * \note Hints that the platform does not support are silently ignored.
+     *
+     * \param advice One of AdviceNormal, AdviceSequential, AdviceRandom,
+     *               AdviceWillNeed, or AdviceDontNeed
+     *
+     * \return True if successful. Otherwise, false if an error occurs with the
+     *         error set appropriately.
+     */
+    virtual bool advise(int advice) = 0;
+
+    /*!
+     * \brief Ask the kernel to start reading a range of the file
+     *
+     * The call does not wait for the pages to be read in.
+     *
+     * \param offset Offset of the range from the beginning of the file
+     * \param size Size of the range
+     *
+     * \return True if successful. Otherwise, false if an error occurs with the
+     *         error set appropriately.
+     */
+    virtual bool prefetch(uint64_t offset, uint64_t size) = 0;
+
+    /*!
+     * \brief Flush changes in a read-write mapping back to the file
+     *
+     * \return True if successful. Otherwise, false if an error occurs with the
+     *         error set appropriately.
+     */
+    virtual bool sync() = 0;
+
+    /*!
+     * \brief Get the error code
+     *
+     * \note: This value is valid only if the return value of another function
+     *        indicates an error.
+     *
+     * \return Error code
+     */
+    virtual int error() = 0;
+
+    /*!
+     * \brief Get the error string
+     *
+     * \note: This value is valid only if the return value of another function
+     *        indicates an error.
+     *
+     * \return Error string
+     */
+    virtual std::string errorString();
+
+protected:
+    virtual std::string platformErrorString() = 0;
+};
+
+}
+}
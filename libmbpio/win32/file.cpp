@@ -20,6 +20,7 @@
 #include "libmbpio/win32/file.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <tchar.h>
 
 #include <windows.h>
@@ -189,6 +190,176 @@ bool FileWin32::write(const void *buf, uint64_t size, uint64_t *bytesWritten)
     return true;
 }
 
+bool FileWin32::pread(void *buf, uint64_t size, uint64_t offset,
+                      uint64_t *bytesRead)
+{
+    // ReadFile() with an OVERLAPPED offset moves the file pointer of a
+    // synchronous handle, so restore it afterwards
+    uint64_t currentPos;
+    if (!tell(&currentPos)) {
+        return false;
+    }
+
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    unsigned long n = 0;
+
+    bool ret = ReadFile(
+        m_impl->handle, // hFile
+        buf,            // lpBuffer
+        size,           // nNumberOfBytesToRead
+        &n,             // lpNumberOfBytesRead
+        &ov             // lpOverlapped
+    );
+    DWORD readError = ret ? NO_ERROR : GetLastError();
+
+    *bytesRead = n;
+
+    if (!seek(currentPos, SeekBegin)) {
+        return false;
+    }
+
+    if (!ret && readError != ERROR_HANDLE_EOF) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->win32Error = readError;
+        m_impl->win32ErrorString = errorToWString(m_impl->win32Error);
+        return false;
+    } else if (n == 0) {
+        m_impl->error = ErrorEndOfFile;
+        return false;
+    }
+
+    return true;
+}
+
+bool FileWin32::pwrite(const void *buf, uint64_t size, uint64_t offset,
+                       uint64_t *bytesWritten)
+{
+    uint64_t currentPos;
+    if (!tell(&currentPos)) {
+        return false;
+    }
+
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    unsigned long n = 0;
+
+    bool ret = WriteFile(
+        m_impl->handle, // hFile
+        buf,            // lpBuffer
+        size,           // nNumberOfBytesToWrite
+        &n,             // lpNumberOfBytesWritten
+        &ov             // lpOverlapped
+    );
+    DWORD writeError = ret ? NO_ERROR : GetLastError();
+
+    *bytesWritten = n;
+
+    if (!seek(currentPos, SeekBegin)) {
+        return false;
+    }
+
+    if (!ret) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->win32Error = writeError;
+        m_impl->win32ErrorString = errorToWString(m_impl->win32Error);
+        return false;
+    }
+
+    return true;
+}
+
+// ReadFileScatter() and WriteFileGather() require page-aligned buffers and
+// unbuffered handles, so just loop over the buffers
+
+bool FileWin32::readv(const IoVec *iov, std::size_t count, uint64_t *bytesRead)
+{
+    uint64_t total = 0;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        uint64_t n;
+        if (!read(iov[i].data, iov[i].size, &n)) {
+            if (m_impl->error == ErrorEndOfFile && total > 0) {
+                break;
+            }
+            *bytesRead = total;
+            return false;
+        }
+        total += n;
+        if (n < iov[i].size) {
+            break;
+        }
+    }
+
+    *bytesRead = total;
+    return true;
+}
+
+bool FileWin32::writev(const IoVec *iov, std::size_t count,
+                       uint64_t *bytesWritten)
+{
+    uint64_t total = 0;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        uint64_t n;
+        if (!write(iov[i].data, iov[i].size, &n)) {
+            *bytesWritten = total + n;
+            return false;
+        }
+        total += n;
+    }
+
+    *bytesWritten = total;
+    return true;
+}
+
+bool FileWin32::preallocate(uint64_t size)
+{
+    // Reserve the clusters without changing the end-of-file position
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = size;
+
+    if (!SetFileInformationByHandle(m_impl->handle, FileAllocationInfo,
+                                    &info, sizeof(info))) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->win32Error = GetLastError();
+        m_impl->win32ErrorString = errorToWString(m_impl->win32Error);
+        return false;
+    }
+
+    return true;
+}
+
+bool FileWin32::advise(int advice)
+{
+    // Windows only accepts access hints (FILE_FLAG_SEQUENTIAL_SCAN, etc.)
+    // when the file is opened
+    if (advice < AdviceNormal || advice > AdviceDontNeed) {
+        m_impl->error = ErrorInvalidAdvice;
+        return false;
+    }
+
+    return true;
+}
+
+bool FileWin32::sync()
+{
+    if (!FlushFileBuffers(m_impl->handle)) {
+        m_impl->error = ErrorPlatformError;
+        m_impl->win32Error = GetLastError();
+        m_impl->win32ErrorString = errorToWString(m_impl->win32Error);
+        return false;
+    }
+
+    return true;
+}
+
 static win32_wrap_SetFilePointer(HANDLE handle, LARGE_INTEGER pos,
                                  LARGE_INTEGER *newPos, DWORD dwMoveMethod)
 {
@@ -40,6 +40,17 @@ public:
     virtual bool isOpen() override;
     virtual bool read(void *buf, uint64_t size, uint64_t *bytesRead) override;
     virtual bool write(const void *buf, uint64_t size, uint64_t *bytesWritten) override;
+    virtual bool pread(void *buf, uint64_t size, uint64_t offset,
+                       uint64_t *bytesRead) override;
+    virtual bool pwrite(const void *buf, uint64_t size, uint64_t offset,
+                        uint64_t *bytesWritten) override;
+    virtual bool readv(const IoVec *iov, std::size_t count,
+                       uint64_t *bytesRead) override;
+    virtual bool writev(const IoVec *iov, std::size_t count,
+                        uint64_t *bytesWritten) override;
+    virtual bool preallocate(uint64_t size) override;
+    virtual bool advise(int advice) override;
+    virtual bool sync() override;
     virtual bool tell(uint64_t *pos) override;
     virtual bool seek(int64_t offset, int origin) override;
     virtual bool truncate(uint64_t size) override;
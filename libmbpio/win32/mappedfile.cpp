@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libmbpio/win32/mappedfile.h"
+
+#include <windows.h>
+
+#include "libmbpio/private/utf8.h"
+#include "libmbpio/win32/error.h"
+
+namespace io
+{
+namespace win32
+{
+
+class MappedFileWin32::Impl
+{
+public:
+    bool mapped = false;
+    HANDLE hMapping = nullptr;
+    void *addr = nullptr;
+    uint64_t size = 0;
+    int mode;
+    int error;
+    DWORD win32Error;
+    std::wstring win32ErrorString;
+
+    void setWin32Error(DWORD code);
+};
+
+void MappedFileWin32::Impl::setWin32Error(DWORD code)
+{
+    error = ErrorPlatformError;
+    win32Error = code;
+    win32ErrorString = errorToWString(code);
+}
+
+MappedFileWin32::MappedFileWin32() : m_impl(new Impl())
+{
+}
+
+MappedFileWin32::~MappedFileWin32()
+{
+    if (isMapped()) {
+        unmap();
+    }
+}
+
+bool MappedFileWin32::map(const char *filename, int mode, uint64_t size)
+{
+    if (m_impl->mapped) {
+        m_impl->error = ErrorFileIsMapped;
+        return false;
+    }
+
+    if (!filename) {
+        m_impl->error = ErrorInvalidFilename;
+        return false;
+    }
+
+    DWORD dwDesiredAccess;
+    DWORD dwShareMode;
+    DWORD dwCreationDisposition;
+    DWORD flProtect;
+    DWORD dwMapAccess;
+
+    switch (mode) {
+    case MapRead:
+        dwDesiredAccess = GENERIC_READ;
+        dwShareMode = FILE_SHARE_READ;
+        dwCreationDisposition = OPEN_EXISTING;
+        flProtect = PAGE_READONLY;
+        dwMapAccess = FILE_MAP_READ;
+        break;
+    case MapReadWrite:
+        dwDesiredAccess = GENERIC_READ | GENERIC_WRITE;
+        dwShareMode = 0;
+        dwCreationDisposition = OPEN_ALWAYS;
+        flProtect = PAGE_READWRITE;
+        dwMapAccess = FILE_MAP_READ | FILE_MAP_WRITE;
+        break;
+    default:
+        m_impl->error = ErrorInvalidMapMode;
+        return false;
+    }
+
+    if (size != 0 && mode != MapReadWrite) {
+        m_impl->error = ErrorInvalidMapMode;
+        return false;
+    }
+
+    std::wstring wFilename = utf8::utf8ToUtf16(filename);
+
+    HANDLE hFile = CreateFileW(
+        (LPCWSTR) wFilename.c_str(),    // lpFileName
+        dwDesiredAccess,                // dwDesiredAccess
+        dwShareMode,                    // dwShareMode
+        nullptr,                        // lpSecurityAttributes
+        dwCreationDisposition,          // dwCreationDisposition
+        FILE_ATTRIBUTE_NORMAL,          // dwFlagsAndAttributes
+        nullptr                         // hTemplateFile
+    );
+    if (hFile == INVALID_HANDLE_VALUE) {
+        m_impl->setWin32Error(GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (size != 0) {
+        // CreateFileMapping() extends the file to the mapping size
+        fileSize.QuadPart = size;
+    } else if (!GetFileSizeEx(hFile, &fileSize)) {
+        m_impl->setWin32Error(GetLastError());
+        CloseHandle(hFile);
+        return false;
+    }
+
+    if (static_cast<uint64_t>(static_cast<SIZE_T>(fileSize.QuadPart))
+            != static_cast<uint64_t>(fileSize.QuadPart)) {
+        m_impl->setWin32Error(ERROR_FILE_TOO_LARGE);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    HANDLE hMapping = nullptr;
+    void *addr = nullptr;
+
+    // CreateFileMapping() fails for empty files
+    if (fileSize.QuadPart > 0) {
+        hMapping = CreateFileMappingW(
+            hFile,                  // hFile
+            nullptr,                // lpAttributes
+            flProtect,              // flProtect
+            fileSize.HighPart,      // dwMaximumSizeHigh
+            fileSize.LowPart,       // dwMaximumSizeLow
+            nullptr                 // lpName
+        );
+        if (!hMapping) {
+            m_impl->setWin32Error(GetLastError());
+            CloseHandle(hFile);
+            return false;
+        }
+
+        addr = MapViewOfFile(
+            hMapping,               // hFileMappingObject
+            dwMapAccess,            // dwDesiredAccess
+            0,                      // dwFileOffsetHigh
+            0,                      // dwFileOffsetLow
+            0                       // dwNumberOfBytesToMap
+        );
+        if (!addr) {
+            m_impl->setWin32Error(GetLastError());
+            CloseHandle(hMapping);
+            CloseHandle(hFile);
+            return false;
+        }
+    }
+
+    // The mapping object holds its own reference to the file
+    CloseHandle(hFile);
+
+    m_impl->mapped = true;
+    m_impl->hMapping = hMapping;
+    m_impl->addr = addr;
+    m_impl->size = fileSize.QuadPart;
+    m_impl->mode = mode;
+    return true;
+}
+
+bool MappedFileWin32::map(const std::string &filename, int mode, uint64_t size)
+{
+    return map(filename.c_str(), mode, size);
+}
+
+bool MappedFileWin32::unmap()
+{
+    if (!m_impl->mapped) {
+        m_impl->error = ErrorFileIsNotMapped;
+        return false;
+    }
+
+    void *addr = m_impl->addr;
+    HANDLE hMapping = m_impl->hMapping;
+    m_impl->mapped = false;
+    m_impl->addr = nullptr;
+    m_impl->hMapping = nullptr;
+    m_impl->size = 0;
+
+    bool ret = true;
+
+    if (addr && !UnmapViewOfFile(addr)) {
+        m_impl->setWin32Error(GetLastError());
+        ret = false;
+    }
+    if (hMapping && !CloseHandle(hMapping)) {
+        m_impl->setWin32Error(GetLastError());
+        ret = false;
+    }
+
+    return ret;
+}
+
+bool MappedFileWin32::isMapped()
+{
+    return m_impl->mapped;
+}
+
+unsigned char * MappedFileWin32::data()
+{
+    return static_cast<unsigned char *>(m_impl->addr);
+}
+
+uint64_t MappedFileWin32::size()
+{
+    return m_impl->size;
+}
+
+bool MappedFileWin32::advise(int advice)
+{
+    if (!m_impl->mapped) {
+        m_impl->error = ErrorFileIsNotMapped;
+        return false;
+    }
+
+    switch (advice) {
+    case AdviceNormal:
+    case AdviceSequential:
+    case AdviceRandom:
+    case AdviceDontNeed:
+        // Windows has no madvise() equivalent for mapped views
+        return true;
+    case AdviceWillNeed:
+        return prefetch(0, m_impl->size);
+    default:
+        m_impl->error = ErrorInvalidAdvice;
+        return false;
+    }
+}
+
+bool MappedFileWin32::prefetch(uint64_t offset, uint64_t size)
+{
+    if (!m_impl->mapped) {
+        m_impl->error = ErrorFileIsNotMapped;
+        return false;
+    }
+
+    if (offset > m_impl->size || size > m_impl->size - offset) {
+        m_impl->error = ErrorInvalidRange;
+        return false;
+    }
+
+    if (size == 0) {
+        return true;
+    }
+
+#if _WIN32_WINNT >= 0x0602
+    WIN32_MEMORY_RANGE_ENTRY entry;
+    entry.VirtualAddress = static_cast<unsigned char *>(m_impl->addr) + offset;
+    entry.NumberOfBytes = size;
+
+    if (!PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0)) {
+        m_impl->setWin32Error(GetLastError());
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+bool MappedFileWin32::sync()
+{
+    if (!m_impl->mapped) {
+        m_impl->error = ErrorFileIsNotMapped;
+        return false;
+    }
+
+    if (m_impl->mode == MapReadWrite && m_impl->addr
+            && !FlushViewOfFile(m_impl->addr, 0)) {
+        m_impl->setWin32Error(GetLastError());
+        return false;
+    }
+
+    return true;
+}
+
+int MappedFileWin32::error()
+{
+    return m_impl->error;
+}
+
+std::string MappedFileWin32::platformErrorString()
+{
+    return utf8::utf16ToUtf8(m_impl->win32ErrorString);
+}
+
+}
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "libmbpio/private/mappedfilebase.h"
+
+#include <memory>
+
+namespace io
+{
+namespace win32
+{
+
+class MappedFileWin32 : public priv::MappedFileBase
+{
+public:
+    MappedFileWin32();
+    virtual ~MappedFileWin32();
+
+    virtual bool map(const char *filename, int mode,
+                     uint64_t size = 0) override;
+    virtual bool map(const std::string &filename, int mode,
+                     uint64_t size = 0) override;
+    virtual bool unmap() override;
+    virtual bool isMapped() override;
+    virtual unsigned char * data() override;
+    virtual uint64_t size() override;
+    virtual bool advise(int advice) override;
+    virtual bool prefetch(uint64_t offset, uint64_t size) override;
+    virtual bool sync() override;
+    virtual int error() override;
+
+protected:
+    virtual std::string platformErrorString() override;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+}
+}
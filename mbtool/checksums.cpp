@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "checksums.h"
+
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "roms.h"
+#include "util/directory.h"
+#include "util/finally.h"
+#include "util/logging.h"
+#include "util/path.h"
+
+#define CHECKSUMS_PATH "/data/multiboot/checksums.prop"
+#define JOURNAL_SUFFIX ".journal"
+#define TEMP_SUFFIX ".tmp"
+
+// The journal is merged into the main file after this many updates
+#define JOURNAL_MAX_ENTRIES 32
+
+namespace mb
+{
+
+static std::string make_key(const std::string &rom_id, const std::string &image)
+{
+    std::string key(rom_id);
+    key += '/';
+    key += image;
+    return key;
+}
+
+static bool read_fd_fully(int fd, std::string *out)
+{
+    out->clear();
+
+    char buf[8192];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        out->append(buf, n);
+    }
+    return true;
+}
+
+static bool write_fd_fully(int fd, const char *data, std::size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            if (n == 0) {
+                errno = EIO;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+/*!
+ * \brief Parse "key=value" lines into the map
+ *
+ * Later lines override earlier ones. Blank lines and comments are skipped.
+ * Text after the last newline is ignored because it is an append that was
+ * interrupted.
+ *
+ * \return Number of entries that were parsed
+ */
+static std::size_t parse_entries(const std::string &data,
+                                 std::unordered_map<std::string, std::string> *entries)
+{
+    std::size_t count = 0;
+    std::size_t pos = 0;
+
+    while (true) {
+        std::size_t end = data.find('\n', pos);
+        if (end == std::string::npos) {
+            break;
+        }
+
+        std::size_t eq = data.find('=', pos);
+        if (data[pos] != '#' && eq != std::string::npos && eq < end
+                && eq > pos) {
+            (*entries)[data.substr(pos, eq - pos)] =
+                    data.substr(eq + 1, end - eq - 1);
+            ++count;
+        }
+
+        pos = end + 1;
+    }
+
+    return count;
+}
+
+static bool read_entries(const std::string &path,
+                         std::unordered_map<std::string, std::string> *entries,
+                         std::size_t *count_out)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *count_out = 0;
+        return errno == ENOENT;
+    }
+
+    auto close_fd = util::finally([&]{
+        close(fd);
+    });
+
+    std::string data;
+    if (!read_fd_fully(fd, &data)) {
+        return false;
+    }
+
+    *count_out = parse_entries(data, entries);
+    return true;
+}
+
+// Directory entries must be synced for a rename() to be durable
+static void fsync_parent(const std::string &path)
+{
+    int fd = open(util::dir_name(path).c_str(),
+                  O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+ChecksumStore::ChecksumStore() : ChecksumStore(get_raw_path(CHECKSUMS_PATH))
+{
+}
+
+ChecksumStore::ChecksumStore(std::string path)
+    : _path(std::move(path)), _journal_path(_path + JOURNAL_SUFFIX)
+{
+}
+
+/*!
+ * \brief Load the checksums and replay the journal
+ *
+ * A shared lock on the journal is held while both files are read, so a
+ * concurrent compaction cannot replace checksums.prop and truncate the journal
+ * in between.
+ *
+ * \return True if the files were read or don't exist. Otherwise, false.
+ */
+bool ChecksumStore::load()
+{
+    int fd = open(_journal_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 && errno != ENOENT) {
+        LOGE("%s: Failed to open journal: %s",
+             _journal_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    auto close_fd = util::finally([&]{
+        if (fd >= 0) {
+            close(fd);
+        }
+    });
+
+    if (fd >= 0 && flock(fd, LOCK_SH) < 0) {
+        LOGE("%s: Failed to lock journal: %s",
+             _journal_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    return load_locked(fd);
+}
+
+/*!
+ * \brief Read both files, with the journal read from an already locked fd
+ *
+ * \param journal_fd Locked journal or -1 if the journal does not exist
+ */
+bool ChecksumStore::load_locked(int journal_fd)
+{
+    _entries.clear();
+
+    std::size_t count;
+    if (!read_entries(_path, &_entries, &count)) {
+        LOGE("%s: Failed to read checksums: %s",
+             _path.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (journal_fd >= 0) {
+        std::string journal;
+        if (lseek(journal_fd, 0, SEEK_SET) < 0
+                || !read_fd_fully(journal_fd, &journal)) {
+            LOGE("%s: Failed to read journal: %s",
+                 _journal_path.c_str(), strerror(errno));
+            return false;
+        }
+        parse_entries(journal, &_entries);
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Look up the checksum of a ROM's image
+ *
+ * \param rom_id ROM ID
+ * \param image Image filename (without directory)
+ * \param[out] algo_out Hash algorithm (eg. CHECKSUMS_ALGO_SHA512)
+ * \param[out] digest_out Hex digest
+ *
+ * \return ChecksumsGetResult::FOUND if the checksum was found,
+ *         ChecksumsGetResult::NOT_FOUND if there is no checksum for the image,
+ *         ChecksumsGetResult::MALFORMED if the entry has an invalid format
+ */
+ChecksumsGetResult ChecksumStore::get(const std::string &rom_id,
+                                      const std::string &image,
+                                      std::string *algo_out,
+                                      std::string *digest_out) const
+{
+    std::string key = make_key(rom_id, image);
+
+    auto it = _entries.find(key);
+    if (it == _entries.end()) {
+        return ChecksumsGetResult::NOT_FOUND;
+    }
+
+    const std::string &value = it->second;
+
+    std::size_t pos = value.find(':');
+    if (pos == std::string::npos || pos == 0 || pos + 1 == value.size()) {
+        LOGE("%s: Invalid checksum entry: %s=%s",
+             _path.c_str(), key.c_str(), value.c_str());
+        return ChecksumsGetResult::MALFORMED;
+    }
+
+    *algo_out = value.substr(0, pos);
+    *digest_out = value.substr(pos + 1);
+    return ChecksumsGetResult::FOUND;
+}
+
+/*!
+ * \brief Set the checksum of a ROM's image
+ *
+ * The entry is appended to the journal and synced before this function
+ * returns. Concurrent writers are serialized with flock() on the journal.
+ *
+ * \return True if the entry was durably written. Otherwise, false.
+ */
+bool ChecksumStore::set(const std::string &rom_id, const std::string &image,
+                        const std::string &algo, const std::string &digest)
+{
+    std::string key = make_key(rom_id, image);
+    std::string value(algo);
+    value += ':';
+    value += digest;
+
+    if (key.find_first_of("=\n") != std::string::npos
+            || value.find('\n') != std::string::npos) {
+        LOGE("%s: Invalid checksum entry: %s=%s",
+             _path.c_str(), key.c_str(), value.c_str());
+        return false;
+    }
+
+    util::mkdir_parent(_journal_path, 0755);
+
+    int fd = open(_journal_path.c_str(),
+                  O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("%s: Failed to open journal: %s",
+             _journal_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    auto close_fd = util::finally([&]{
+        close(fd);
+    });
+
+    if (flock(fd, LOCK_EX) < 0) {
+        LOGE("%s: Failed to lock journal: %s",
+             _journal_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    // Drop the remains of an interrupted append, which would otherwise be
+    // joined with this entry
+    std::string journal;
+    if (lseek(fd, 0, SEEK_SET) < 0 || !read_fd_fully(fd, &journal)) {
+        LOGE("%s: Failed to read journal: %s",
+             _journal_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    std::size_t valid_size = journal.rfind('\n');
+    valid_size = valid_size == std::string::npos ? 0 : valid_size + 1;
+    if (valid_size != journal.size() && ftruncate(fd, valid_size) < 0) {
+        LOGE("%s: Failed to truncate journal: %s",
+             _journal_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    std::string line(key);
+    line += '=';
+    line += value;
+    line += '\n';
+
+    // The newline is written last, so a torn write is never parsed
+    if (!write_fd_fully(fd, line.data(), line.size()) || fdatasync(fd) < 0) {
+        LOGE("%s: Failed to write journal: %s",
+             _journal_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    _entries[key] = value;
+
+    std::unordered_map<std::string, std::string> journal_entries;
+    if (parse_entries(journal, &journal_entries) + 1 >= JOURNAL_MAX_ENTRIES) {
+        // The entry is already durable, so a failure here is not fatal
+        if (!compact(fd)) {
+            LOGW("%s: Failed to compact checksums", _path.c_str());
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Merge the journal into the main checksums file
+ *
+ * The new file is written next to the old one and renamed over it, so readers
+ * see either the old or the new file. Must be called with the journal locked.
+ * Taking the lock again through a new fd would deadlock.
+ */
+bool ChecksumStore::compact(int journal_fd)
+{
+    // Re-read both files to pick up entries written by other processes
+    if (!load_locked(journal_fd)) {
+        return false;
+    }
+
+    std::string temp_path(_path);
+    temp_path += TEMP_SUFFIX;
+
+    int fd = open(temp_path.c_str(),
+                  O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("%s: Failed to create file: %s",
+             temp_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    std::string data;
+    for (auto const &p : _entries) {
+        data += p.first;
+        data += '=';
+        data += p.second;
+        data += '\n';
+    }
+
+    bool ret = write_fd_fully(fd, data.data(), data.size()) && fsync(fd) == 0;
+    ret = close(fd) == 0 && ret;
+    if (!ret) {
+        LOGE("%s: Failed to write file: %s",
+             temp_path.c_str(), strerror(errno));
+        unlink(temp_path.c_str());
+        return false;
+    }
+
+    if (rename(temp_path.c_str(), _path.c_str()) < 0) {
+        LOGE("%s: Failed to rename to %s: %s",
+             temp_path.c_str(), _path.c_str(), strerror(errno));
+        unlink(temp_path.c_str());
+        return false;
+    }
+
+    fsync_parent(_path);
+
+    // If this fails, the journal is replayed on top of identical entries
+    if (ftruncate(journal_fd, 0) < 0) {
+        LOGW("%s: Failed to truncate journal: %s",
+             _journal_path.c_str(), strerror(errno));
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#define CHECKSUMS_ALGO_SHA512 "sha512"
+
+namespace mb
+{
+
+enum class ChecksumsGetResult
+{
+    FOUND,
+    NOT_FOUND,
+    MALFORMED
+};
+
+// Checksums of the images for each ROM, stored as "<rom>/<image>=<algo>:<hex>"
+// lines in /data/multiboot/checksums.prop.
+//
+// Updates are appended to a journal next to the file, so setting one checksum
+// does not rewrite the others. Once the journal grows large enough, it is
+// merged into a new checksums.prop, which replaces the old one with rename().
+class ChecksumStore
+{
+public:
+    ChecksumStore();
+    explicit ChecksumStore(std::string path);
+
+    bool load();
+
+    ChecksumsGetResult get(const std::string &rom_id, const std::string &image,
+                           std::string *algo_out,
+                           std::string *digest_out) const;
+    bool set(const std::string &rom_id, const std::string &image,
+             const std::string &algo, const std::string &digest);
+
+private:
+    bool load_locked(int journal_fd);
+    bool compact(int journal_fd);
+
+    std::string _path;
+    std::string _journal_path;
+    std::unordered_map<std::string, std::string> _entries;
+};
+
+}
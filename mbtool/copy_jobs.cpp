@@ -0,0 +1,601 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "copy_jobs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "util/finally.h"
+#include "util/logging.h"
+
+// Number of jobs that are copied at the same time
+#define COPY_JOBS_MAX_WORKERS       2
+// Amount of data a job may copy before yielding to the other jobs
+#define COPY_JOBS_SLICE_SIZE        (8 * 1024 * 1024)
+// Maximum size of a single transfer. This is also the size of the buffer when
+// neither copy_file_range() nor sendfile() can be used.
+#define COPY_JOBS_CHUNK_SIZE        (1024 * 1024)
+// Number of finished jobs whose status is kept for the clients
+#define COPY_JOBS_MAX_FINISHED      16
+
+namespace mb
+{
+
+enum class CopyMethod
+{
+    COPY_FILE_RANGE,
+    SENDFILE,
+    READ_WRITE
+};
+
+struct CopyEntry
+{
+    std::string source;
+    std::string target;
+    mode_t mode;
+};
+
+// The copies are created and owned by root, so never carry over the setuid,
+// setgid, or sticky bits. The v3 chmod requests refuse them for the same reason.
+static inline mode_t copy_mode(mode_t mode)
+{
+    return mode & (S_IRWXU | S_IRWXG | S_IRWXO);
+}
+
+// Adds the directory's contents to the list. Symlinks are copied as symlinks
+// and special files are skipped.
+static bool scan_dir(const std::string &source, const std::string &target,
+                     std::vector<CopyEntry> *entries, uint64_t *bytes_total,
+                     uint32_t *files_total, std::string *error_out)
+{
+    DIR *dp = opendir(source.c_str());
+    if (!dp) {
+        *error_out = source + ": Failed to open directory: " + strerror(errno);
+        return false;
+    }
+
+    auto close_dp = util::finally([&]{
+        closedir(dp);
+    });
+
+    std::vector<std::string> subdirs;
+
+    while (struct dirent *ent = readdir(dp)) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+            continue;
+        }
+
+        std::string path(source);
+        path += '/';
+        path += ent->d_name;
+
+        struct stat sb;
+        if (lstat(path.c_str(), &sb) < 0) {
+            *error_out = path + ": Failed to stat: " + strerror(errno);
+            return false;
+        }
+
+        if (S_ISDIR(sb.st_mode)) {
+            subdirs.push_back(ent->d_name);
+        } else if (S_ISREG(sb.st_mode) || S_ISLNK(sb.st_mode)) {
+            entries->push_back({ path, target + "/" + ent->d_name,
+                                 sb.st_mode });
+            if (S_ISREG(sb.st_mode)) {
+                *bytes_total += sb.st_size;
+                ++*files_total;
+            }
+        } else {
+            LOGW("%s: Skipping special file", path.c_str());
+        }
+    }
+
+    // Directories are created before their contents are copied
+    for (const std::string &name : subdirs) {
+        std::string sub_source = source + "/" + name;
+        std::string sub_target = target + "/" + name;
+
+        struct stat sb;
+        if (lstat(sub_source.c_str(), &sb) < 0) {
+            *error_out = sub_source + ": Failed to stat: " + strerror(errno);
+            return false;
+        }
+
+        entries->push_back({ sub_source, sub_target, sb.st_mode });
+        if (!scan_dir(sub_source, sub_target, entries, bytes_total,
+                      files_total, error_out)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Copy up to len bytes from the current position of fd_source
+ *
+ * copy_file_range() lets the filesystem copy without going through userspace
+ * (or share extents). It and sendfile() are not available on every kernel and
+ * don't work for every file type, so the method falls back to the next one on
+ * errors that indicate a lack of support. All methods advance the file
+ * offsets, so they can be mixed within a file.
+ *
+ * \return Number of bytes copied, 0 at the end of the file or -1 on error
+ */
+static ssize_t copy_chunk(int fd_source, int fd_target, size_t len,
+                          CopyMethod *method, std::vector<char> *buf)
+{
+    while (true) {
+        ssize_t n;
+
+        switch (*method) {
+        case CopyMethod::COPY_FILE_RANGE:
+#ifdef __NR_copy_file_range
+            n = syscall(__NR_copy_file_range, fd_source, nullptr,
+                        fd_target, nullptr, len, 0);
+            if (n < 0 && (errno == ENOSYS || errno == EXDEV
+                    || errno == EINVAL || errno == EOPNOTSUPP)) {
+                *method = CopyMethod::SENDFILE;
+                continue;
+            }
+            break;
+#else
+            *method = CopyMethod::SENDFILE;
+            continue;
+#endif
+
+        case CopyMethod::SENDFILE:
+            n = sendfile(fd_target, fd_source, nullptr, len);
+            if (n < 0 && (errno == ENOSYS || errno == EINVAL)) {
+                *method = CopyMethod::READ_WRITE;
+                continue;
+            }
+            break;
+
+        case CopyMethod::READ_WRITE:
+        default:
+            buf->resize(COPY_JOBS_CHUNK_SIZE);
+            n = read(fd_source, buf->data(), std::min(len, buf->size()));
+            if (n > 0) {
+                for (ssize_t written = 0; written < n;) {
+                    ssize_t w = write(fd_target, buf->data() + written,
+                                      n - written);
+                    if (w < 0 && errno == EINTR) {
+                        continue;
+                    } else if (w <= 0) {
+                        return -1;
+                    }
+                    written += w;
+                }
+            }
+            break;
+        }
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n;
+    }
+}
+
+struct CopyJobs::Job
+{
+    uint32_t id;
+    std::string source;
+    std::string target;
+
+    // Only accessed by the slice that is currently running the job
+    bool scanned;
+    std::vector<CopyEntry> entries;
+    size_t next_entry;
+    int fd_source;
+    int fd_target;
+    CopyMethod method;
+    std::vector<char> buf;
+
+    std::atomic_bool cancelled;
+
+    // Protected by CopyJobs::_mutex
+    CopyJobStatus status;
+
+    bool scan(uint64_t *bytes_total, uint32_t *files_total,
+              std::string *error_out)
+    {
+        struct stat sb;
+        if (stat(source.c_str(), &sb) < 0) {
+            *error_out = source + ": Failed to stat: " + strerror(errno);
+            return false;
+        }
+
+        entries.push_back({ source, target, sb.st_mode });
+
+        if (S_ISDIR(sb.st_mode)) {
+            return scan_dir(source, target, &entries, bytes_total,
+                            files_total, error_out);
+        }
+
+        // The size of block devices is only known once they are opened
+        if (S_ISREG(sb.st_mode)) {
+            *bytes_total = sb.st_size;
+        }
+        *files_total = 1;
+        return true;
+    }
+
+    // Creates the directory or symlink or opens the file for the next entry.
+    // For files, the size is returned if it wasn't known from the scan.
+    bool begin_entry(uint64_t *extra_bytes_out, std::string *error_out)
+    {
+        const CopyEntry &entry = entries[next_entry];
+        *extra_bytes_out = 0;
+
+        if (S_ISDIR(entry.mode)) {
+            struct stat sb;
+            if (mkdir(entry.target.c_str(), copy_mode(entry.mode)) < 0
+                    && !(errno == EEXIST && stat(entry.target.c_str(), &sb) == 0
+                            && S_ISDIR(sb.st_mode))) {
+                *error_out = entry.target + ": Failed to create directory: "
+                        + strerror(errno);
+                return false;
+            }
+            return true;
+        } else if (S_ISLNK(entry.mode)) {
+            std::vector<char> link(PATH_MAX);
+            ssize_t n = readlink(entry.source.c_str(), link.data(),
+                                 link.size() - 1);
+            if (n < 0) {
+                *error_out = entry.source + ": Failed to read symlink: "
+                        + strerror(errno);
+                return false;
+            }
+            link[n] = '\0';
+
+            if ((unlink(entry.target.c_str()) < 0 && errno != ENOENT)
+                    || symlink(link.data(), entry.target.c_str()) < 0) {
+                *error_out = entry.target + ": Failed to create symlink: "
+                        + strerror(errno);
+                return false;
+            }
+            return true;
+        }
+
+        fd_source = open(entry.source.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_source < 0) {
+            *error_out = entry.source + ": Failed to open: " + strerror(errno);
+            return false;
+        }
+
+        // Same as PathCopyRequest for a single file
+        mode_t mode = next_entry > 0 ? copy_mode(entry.mode) : 0666;
+        fd_target = open(entry.target.c_str(),
+                         O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+        if (fd_target < 0) {
+            *error_out = entry.target + ": Failed to open: " + strerror(errno);
+            close(fd_source);
+            fd_source = -1;
+            return false;
+        }
+
+        if (!S_ISREG(entry.mode)) {
+            off64_t size = lseek64(fd_source, 0, SEEK_END);
+            if (size > 0 && lseek64(fd_source, 0, SEEK_SET) == 0) {
+                *extra_bytes_out = size;
+            }
+        }
+
+        return true;
+    }
+
+    bool end_entry(std::string *error_out)
+    {
+        const CopyEntry &entry = entries[next_entry];
+        close(fd_source);
+        fd_source = -1;
+        int ret = close(fd_target);
+        fd_target = -1;
+        if (ret < 0) {
+            *error_out = entry.target + ": Failed to close: " + strerror(errno);
+            unlink(entry.target.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Removes the partially copied file. Files that were already copied are
+    // kept.
+    void abort_entry()
+    {
+        if (fd_source >= 0) {
+            close(fd_source);
+            close(fd_target);
+            fd_source = -1;
+            fd_target = -1;
+            unlink(entries[next_entry].target.c_str());
+        }
+    }
+};
+
+CopyJobs::CopyJobs()
+    : _next_id(1), _running(0), _pool(COPY_JOBS_MAX_WORKERS)
+{
+}
+
+CopyJobs::~CopyJobs()
+{
+    // Cancelled jobs are not requeued, so the pool's destructor can drain
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &p : _jobs) {
+            p.second->cancelled = true;
+        }
+    }
+}
+
+CopyJobs & CopyJobs::get()
+{
+    static CopyJobs jobs;
+    return jobs;
+}
+
+/*!
+ * \brief Start copying a file or directory in the background
+ *
+ * \param[out] id_out ID of the new job
+ * \param[out] error_out Error message if the source cannot be accessed
+ *
+ * \return Whether the job was started
+ */
+bool CopyJobs::start(const std::string &source, const std::string &target,
+                     uint32_t *id_out, std::string *error_out)
+{
+    struct stat sb;
+    if (stat(source.c_str(), &sb) < 0) {
+        *error_out = strerror(errno);
+        return false;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->source = source;
+    job->target = target;
+    job->scanned = false;
+    job->next_entry = 0;
+    job->fd_source = -1;
+    job->fd_target = -1;
+    job->method = CopyMethod::COPY_FILE_RANGE;
+    job->cancelled = false;
+    job->status.state = CopyJobState::RUNNING;
+    job->status.bytes_copied = 0;
+    job->status.bytes_total = 0;
+    job->status.files_copied = 0;
+    job->status.files_total = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        job->id = _next_id++;
+        _jobs[job->id] = job;
+        ++_running;
+    }
+
+    LOGD("Copy job %u: %s -> %s", job->id, source.c_str(), target.c_str());
+
+    *id_out = job->id;
+    submit(std::move(job));
+    return true;
+}
+
+bool CopyJobs::status(uint32_t id, CopyJobStatus *status_out)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _jobs.find(id);
+    if (it == _jobs.end()) {
+        return false;
+    }
+    *status_out = it->second->status;
+    return true;
+}
+
+/*!
+ * \brief Wait for a job to finish
+ *
+ * \return False if the job does not exist. Otherwise, \a status_out contains
+ *         the status after the job finished or the timeout expired.
+ */
+bool CopyJobs::wait(uint32_t id, unsigned int timeout_ms,
+                    CopyJobStatus *status_out)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto it = _jobs.find(id);
+    if (it == _jobs.end()) {
+        return false;
+    }
+
+    // Keep the job alive if it is pruned while waiting
+    std::shared_ptr<Job> job = it->second;
+    _cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&]{
+        return job->status.state != CopyJobState::RUNNING;
+    });
+
+    *status_out = job->status;
+    return true;
+}
+
+/*!
+ * \brief Request a running job to stop
+ *
+ * The job stops at the next chunk boundary. The partially copied file is
+ * removed, but files that were already copied are kept.
+ *
+ * \return False if the job does not exist or has already finished
+ */
+bool CopyJobs::cancel(uint32_t id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _jobs.find(id);
+    if (it == _jobs.end()
+            || it->second->status.state != CopyJobState::RUNNING) {
+        return false;
+    }
+    it->second->cancelled = true;
+    return true;
+}
+
+// Block until there are no running jobs
+void CopyJobs::wait_all()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv.wait(lock, [this]{
+        return _running == 0;
+    });
+}
+
+void CopyJobs::submit(std::shared_ptr<Job> job)
+{
+    // Requeued jobs go to the back of the queue, so the workers round-robin
+    // between the running jobs
+    _pool.submit([this, job]{
+        run_slice(job);
+    });
+}
+
+void CopyJobs::run_slice(const std::shared_ptr<Job> &job)
+{
+    Job &j = *job;
+    std::string error;
+
+    if (!j.scanned) {
+        uint64_t bytes_total = 0;
+        uint32_t files_total = 0;
+        bool ret = j.scan(&bytes_total, &files_total, &error);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            j.status.bytes_total = bytes_total;
+            j.status.files_total = files_total;
+        }
+
+        if (!ret) {
+            finish(j, CopyJobState::FAILED, std::move(error));
+            return;
+        }
+
+        j.scanned = true;
+    }
+
+    uint64_t budget = COPY_JOBS_SLICE_SIZE;
+
+    while (true) {
+        if (j.cancelled) {
+            j.abort_entry();
+            finish(j, CopyJobState::CANCELLED, {});
+            return;
+        } else if (budget == 0) {
+            submit(job);
+            return;
+        }
+
+        if (j.fd_source < 0) {
+            if (j.next_entry == j.entries.size()) {
+                finish(j, CopyJobState::SUCCEEDED, {});
+                return;
+            }
+
+            uint64_t extra_bytes;
+            if (!j.begin_entry(&extra_bytes, &error)) {
+                finish(j, CopyJobState::FAILED, std::move(error));
+                return;
+            }
+
+            if (extra_bytes > 0) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                j.status.bytes_total += extra_bytes;
+            }
+
+            // Directories and symlinks are complete once created
+            if (j.fd_source < 0) {
+                ++j.next_entry;
+                continue;
+            }
+        }
+
+        ssize_t n = copy_chunk(j.fd_source, j.fd_target,
+                               std::min<uint64_t>(budget, COPY_JOBS_CHUNK_SIZE),
+                               &j.method, &j.buf);
+        if (n < 0) {
+            error = j.entries[j.next_entry].source + ": Failed to copy: "
+                    + strerror(errno);
+            j.abort_entry();
+            finish(j, CopyJobState::FAILED, std::move(error));
+            return;
+        } else if (n == 0) {
+            if (!j.end_entry(&error)) {
+                finish(j, CopyJobState::FAILED, std::move(error));
+                return;
+            }
+            ++j.next_entry;
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++j.status.files_copied;
+        } else {
+            budget -= n;
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            j.status.bytes_copied += n;
+        }
+    }
+}
+
+void CopyJobs::finish(Job &job, CopyJobState state, std::string error)
+{
+    if (state == CopyJobState::FAILED) {
+        LOGE("Copy job %u failed: %s", job.id, error.c_str());
+    } else {
+        LOGD("Copy job %u finished (cancelled: %d)",
+             job.id, state == CopyJobState::CANCELLED);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        job.status.state = state;
+        job.status.error = std::move(error);
+        --_running;
+
+        _finished.push_back(job.id);
+        while (_finished.size() > COPY_JOBS_MAX_FINISHED) {
+            _jobs.erase(_finished.front());
+            _finished.pop_front();
+        }
+    }
+
+    _cv.notify_all();
+}
+
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <cstdint>
+
+#include "util/thread_pool.h"
+
+namespace mb
+{
+
+enum class CopyJobState
+{
+    RUNNING,
+    SUCCEEDED,
+    FAILED,
+    CANCELLED
+};
+
+struct CopyJobStatus
+{
+    CopyJobState state;
+    std::string error;
+    uint64_t bytes_copied;
+    uint64_t bytes_total;
+    uint32_t files_copied;
+    uint32_t files_total;
+};
+
+// Background file and directory copies. Jobs are copied in slices of a few
+// megabytes on a small worker pool. A job that has used up its slice is queued
+// behind the other jobs, so concurrent copies share the I/O bandwidth evenly.
+class CopyJobs
+{
+public:
+    CopyJobs();
+    ~CopyJobs();
+
+    bool start(const std::string &source, const std::string &target,
+               uint32_t *id_out, std::string *error_out);
+    bool status(uint32_t id, CopyJobStatus *status_out);
+    bool wait(uint32_t id, unsigned int timeout_ms, CopyJobStatus *status_out);
+    bool cancel(uint32_t id);
+    void wait_all();
+
+    static CopyJobs & get();
+
+    CopyJobs(const CopyJobs &) = delete;
+    CopyJobs & operator=(const CopyJobs &) = delete;
+
+private:
+    struct Job;
+
+    void submit(std::shared_ptr<Job> job);
+    void run_slice(const std::shared_ptr<Job> &job);
+    void finish(Job &job, CopyJobState state, std::string error);
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::unordered_map<uint32_t, std::shared_ptr<Job>> _jobs;
+    // IDs of finished jobs, oldest first
+    std::deque<uint32_t> _finished;
+    uint32_t _next_id;
+    unsigned int _running;
+    // Must be destroyed first so that no slice runs after the jobs are gone
+    util::ThreadPool _pool;
+};
+
+}
@@ -20,39 +20,81 @@
 #include "daemon.h"
 
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <climits>
 
 #include <fcntl.h>
 #include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/un.h>
 #include <unistd.h>
 
 #include <proc/readproc.h>
 
 #include "autoclose/file.h"
+#include "copy_jobs.h"
+#include "daemon_stats.h"
 #include "daemon_v3.h"
 #include "multiboot.h"
 #include "packages.h"
+#include "rom_inventory.h"
 #include "sepolpatch.h"
 #include "validcerts.h"
 #include "version.h"
+#include "util/command.h"
 #include "util/directory.h"
 #include "util/finally.h"
 #include "util/logging.h"
 #include "util/properties.h"
 #include "util/selinux.h"
 #include "util/socket.h"
+#include "util/thread_pool.h"
+#include "util/time.h"
 
 #define RESPONSE_ALLOW "ALLOW"                  // Credentials allowed
 #define RESPONSE_DENY "DENY"                    // Credentials denied
 #define RESPONSE_OK "OK"                        // Generic accepted response
 #define RESPONSE_UNSUPPORTED "UNSUPPORTED"      // Generic unsupported response
 
+// Number of threads the event loop daemon uses to service connections
+#define EVENT_LOOP_MAX_WORKERS  8
+#define EVENT_LOOP_MAX_EVENTS   16
+// Seconds a worker waits for a stalled client before dropping the connection
+#define EVENT_LOOP_CLIENT_TIMEOUT 30
+
 
 namespace mb
 {
 
+// Interval for writing the statistics to the log in milliseconds or 0 to
+// disable the periodic dump
+static int stats_interval_ms = 0;
+
+// Returns the poll()/epoll_wait() timeout until the next statistics dump and
+// writes the statistics if the interval has elapsed
+static int stats_poll_timeout(uint64_t *next_dump_us)
+{
+    if (stats_interval_ms <= 0) {
+        return -1;
+    }
+
+    uint64_t now = util::monotonic_time_us();
+    if (now >= *next_dump_us) {
+        daemon_stats_log();
+        *next_dump_us = now + stats_interval_ms * 1000ull;
+    }
+
+    return (*next_dump_us - now + 999) / 1000;
+}
+
 static bool verify_credentials(uid_t uid)
 {
     // Rely on the OS for signature checking and simply compare strings in
@@ -94,7 +136,29 @@ static bool verify_credentials(uid_t uid)
     return false;
 }
 
-static bool client_connection(int fd)
+// Resident set size of the current process in KiB or -1 if it can't be read
+static long current_rss_kib()
+{
+    autoclose::file fp(autoclose::fopen("/proc/self/statm", "r"));
+    if (!fp) {
+        return -1;
+    }
+
+    long size;
+    long resident;
+    if (fscanf(fp.get(), "%ld %ld", &size, &resident) != 2) {
+        return -1;
+    }
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/*!
+ * \brief Verify the client's credentials and negotiate the protocol version
+ *
+ * \return Whether the client was accepted and protocol version 3 was selected
+ */
+static bool client_handshake(int fd)
 {
     bool ret = true;
     auto fail = util::finally([&] {
@@ -144,9 +208,6 @@ static bool client_connection(int fd)
             return false;
         }
 
-        if (!connection_version_3(fd)) {
-            LOGE("[Version 3] Communication error");
-        }
         return true;
     } else {
         LOGE("Unsupported interface version: %d", version);
@@ -157,43 +218,33 @@ static bool client_connection(int fd)
     return true;
 }
 
-static bool run_daemon(void)
+static bool client_connection(int fd, uint64_t accept_time)
 {
-    int fd;
-    struct sockaddr_un addr;
-
-    fd = socket(AF_LOCAL, SOCK_STREAM, 0);
-    if (fd < 0) {
-        LOGE("Failed to create socket: %s", strerror(errno));
+    DaemonStats &stats = daemon_stats();
+    if (!client_handshake(fd)) {
+        stats.connections_rejected.fetch_add(1, std::memory_order_relaxed);
         return false;
     }
 
-    auto close_fd = util::finally([&] {
-        close(fd);
+    stats.connections_active.fetch_add(1, std::memory_order_relaxed);
+    auto decrement_active = util::finally([&] {
+        stats.connections_active.fetch_sub(1, std::memory_order_relaxed);
     });
 
-    char abs_name[] = "\0mbtool.daemon";
-    size_t abs_name_len = sizeof(abs_name) - 1;
-
-    memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_LOCAL;
-    memcpy(addr.sun_path, abs_name, abs_name_len);
-
-    // Calculate correct length so the trailing junk is not included in the
-    // abstract socket name
-    socklen_t addr_len = offsetof(struct sockaddr_un, sun_path) + abs_name_len;
+    LOGD("Connection setup took %" PRIu64 " us",
+         util::monotonic_time_us() - accept_time);
 
-    if (bind(fd, (struct sockaddr *) &addr, addr_len) < 0) {
-        LOGE("Failed to bind socket: %s", strerror(errno));
-        LOGE("Is another instance running?");
-        return false;
+    if (!connection_version_3(fd)) {
+        LOGE("[Version 3] Communication error");
     }
 
-    if (listen(fd, 3) < 0) {
-        LOGE("Failed to listen on socket: %s", strerror(errno));
-        return false;
-    }
+    LOGD("Connection closed (RSS: %ld KiB)", current_rss_kib());
 
+    return true;
+}
+
+static bool run_fork_loop(int fd)
+{
     // Eat zombies!
     // SIG_IGN reaps zombie processes (it's not just a dummy function)
     struct sigaction sa;
@@ -207,15 +258,53 @@ static bool run_daemon(void)
 
     LOGD("Socket ready, waiting for connections");
 
+    DaemonStats &stats = daemon_stats();
+    uint64_t next_dump =
+            util::monotonic_time_us() + stats_interval_ms * 1000ull;
+
     int client_fd;
-    while ((client_fd = accept(fd, nullptr, nullptr)) >= 0) {
+    while (true) {
+        // Only wait for the next statistics dump if enabled
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        int n = poll(&pfd, 1, stats_poll_timeout(&next_dump));
+        if (n < 0 && errno != EINTR) {
+            LOGE("Failed to poll socket: %s", strerror(errno));
+            return false;
+        } else if (n <= 0) {
+            continue;
+        }
+
+        client_fd = accept(fd, nullptr, nullptr);
+        if (client_fd < 0) {
+            break;
+        }
+
+        uint64_t accept_time = util::monotonic_time_us();
+        stats.connections_total.fetch_add(1, std::memory_order_relaxed);
+
+        // Anything cached by a connection process is lost when it exits, so
+        // keep the ROM inventory up to date in this long-lived process and let
+        // each child inherit it. This only rescans if something changed.
+        RomInventory::get().installed_roms();
+
         pid_t child_pid = fork();
         if (child_pid < 0) {
             LOGE("Failed to fork: %s", strerror(errno));
         } else if (child_pid == 0) {
-            bool ret = client_connection(client_fd);
+            // Processes spawned while handling requests are waited for
+            signal(SIGCHLD, SIG_DFL);
+
+            bool ret = client_connection(client_fd, accept_time);
             close(client_fd);
+
+            // Background copies started by the client belong to this process
+            CopyJobs::get().wait_all();
+
             _exit(ret ? EXIT_SUCCESS : EXIT_FAILURE);
+        } else {
+            stats.commands.forks.fetch_add(1, std::memory_order_relaxed);
         }
         close(client_fd);
     }
@@ -228,8 +317,283 @@ static bool run_daemon(void)
     return true;
 }
 
+struct EventLoopClient
+{
+    int fd;
+    uint64_t accept_time;
+    std::unique_ptr<V3Session> session;
+};
+
+// Serves all connections from a single process. Each client socket is
+// registered with EPOLLONESHOT, so at most one worker thread handles a given
+// connection at a time and the socket is rearmed once the request is done.
+class EventLoop
+{
+public:
+    explicit EventLoop(int listen_fd)
+        : _listen_fd(listen_fd),
+          _epoll_fd(-1),
+          _pool(EVENT_LOOP_MAX_WORKERS)
+    {
+    }
+
+    ~EventLoop()
+    {
+        // Wait for the workers before tearing down the remaining clients
+        _pool.wait_idle();
+
+        for (auto &p : _clients) {
+            p.second->session.reset();
+            close(p.first);
+        }
+
+        if (_epoll_fd >= 0) {
+            close(_epoll_fd);
+        }
+    }
+
+    bool run()
+    {
+        _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (_epoll_fd < 0) {
+            LOGE("Failed to create epoll instance: %s", strerror(errno));
+            return false;
+        }
+
+        int flags = fcntl(_listen_fd, F_GETFL);
+        if (flags < 0 || fcntl(_listen_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            LOGE("Failed to make socket non-blocking: %s", strerror(errno));
+            return false;
+        }
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _listen_fd, &ev) < 0) {
+            LOGE("Failed to add socket to epoll: %s", strerror(errno));
+            return false;
+        }
+
+        LOGD("Socket ready, waiting for connections (event loop)");
+
+        struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+        uint64_t next_dump =
+            util::monotonic_time_us() + stats_interval_ms * 1000ull;
+
+        while (true) {
+            int n = epoll_wait(_epoll_fd, events, EVENT_LOOP_MAX_EVENTS,
+                               stats_poll_timeout(&next_dump));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOGE("Failed to wait for events: %s", strerror(errno));
+                return false;
+            }
+
+            for (int i = 0; i < n; ++i) {
+                auto client = static_cast<EventLoopClient *>(events[i].data.ptr);
+                if (!client) {
+                    if (!accept_clients()) {
+                        return false;
+                    }
+                } else {
+                    _pool.submit([this, client]{
+                        handle_request(client);
+                    });
+                }
+            }
+        }
+    }
+
+private:
+    bool accept_clients()
+    {
+        while (true) {
+            int client_fd = accept4(_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client_fd < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK
+                        || errno == ECONNABORTED || errno == EINTR) {
+                    return true;
+                }
+                LOGE("Failed to accept connection on socket: %s",
+                     strerror(errno));
+                return false;
+            }
+
+            // epoll only tells us that the first bytes of a request arrived.
+            // The worker then reads the rest of the frame with blocking
+            // calls, so bound them to keep a slow or stalled client from
+            // holding on to one of the few workers forever.
+            struct timeval tv;
+            tv.tv_sec = EVENT_LOOP_CLIENT_TIMEOUT;
+            tv.tv_usec = 0;
+            if (setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO,
+                           &tv, sizeof(tv)) < 0
+                    || setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO,
+                                  &tv, sizeof(tv)) < 0) {
+                LOGE("Failed to set socket timeouts: %s", strerror(errno));
+                close(client_fd);
+                continue;
+            }
+
+            EventLoopClient *client = new EventLoopClient();
+            client->fd = client_fd;
+            client->accept_time = util::monotonic_time_us();
+
+            daemon_stats().connections_total.fetch_add(
+                    1, std::memory_order_relaxed);
+
+            {
+                std::lock_guard<std::mutex> lock(_clients_mutex);
+                _clients[client_fd].reset(client);
+            }
+
+            // Credential verification parses packages.xml, so keep it off the
+            // event loop thread
+            _pool.submit([this, client]{
+                handle_handshake(client);
+            });
+        }
+    }
+
+    void handle_handshake(EventLoopClient *client)
+    {
+        if (!client_handshake(client->fd)) {
+            daemon_stats().connections_rejected.fetch_add(
+                    1, std::memory_order_relaxed);
+            close_client(client);
+            return;
+        }
+
+        daemon_stats().connections_active.fetch_add(
+                1, std::memory_order_relaxed);
+
+        LOGD("Connection setup took %" PRIu64 " us",
+             util::monotonic_time_us() - client->accept_time);
+
+        client->session.reset(new V3Session(client->fd));
+
+        if (!arm(client, EPOLL_CTL_ADD)) {
+            close_client(client);
+        }
+    }
+
+    void handle_request(EventLoopClient *client)
+    {
+        if (!client->session->handle_request() || !arm(client, EPOLL_CTL_MOD)) {
+            close_client(client);
+        }
+    }
+
+    bool arm(EventLoopClient *client, int op)
+    {
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        ev.data.ptr = client;
+        if (epoll_ctl(_epoll_fd, op, client->fd, &ev) < 0) {
+            LOGE("Failed to register connection with epoll: %s",
+                 strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    void close_client(EventLoopClient *client)
+    {
+        int client_fd = client->fd;
+
+        // Not registered if the handshake failed
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, client_fd, nullptr);
+
+        if (client->session) {
+            daemon_stats().connections_active.fetch_sub(
+                    1, std::memory_order_relaxed);
+        }
+
+        client->session.reset();
+
+        // The fd number can be reused by accept4() as soon as it is closed,
+        // so drop the entry first. Otherwise, the erase could free a new
+        // client registered under the same fd.
+        std::unique_ptr<EventLoopClient> owned;
+        {
+            std::lock_guard<std::mutex> lock(_clients_mutex);
+            auto it = _clients.find(client_fd);
+            if (it != _clients.end()) {
+                owned = std::move(it->second);
+                _clients.erase(it);
+            }
+        }
+
+        close(client_fd);
+
+        LOGD("Connection closed (RSS: %ld KiB)", current_rss_kib());
+    }
+
+    int _listen_fd;
+    int _epoll_fd;
+    util::ThreadPool _pool;
+    std::mutex _clients_mutex;
+    std::unordered_map<int, std::unique_ptr<EventLoopClient>> _clients;
+};
+
+static bool run_event_loop(int fd)
+{
+    // A client that disconnects while a response is being written must not
+    // kill the whole daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop(fd);
+    return loop.run();
+}
+
+static bool run_daemon(bool event_loop)
+{
+    int fd;
+    struct sockaddr_un addr;
+
+    fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    if (fd < 0) {
+        LOGE("Failed to create socket: %s", strerror(errno));
+        return false;
+    }
+
+    auto close_fd = util::finally([&] {
+        close(fd);
+    });
+
+    char abs_name[] = "\0mbtool.daemon";
+    size_t abs_name_len = sizeof(abs_name) - 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_LOCAL;
+    memcpy(addr.sun_path, abs_name, abs_name_len);
+
+    // Calculate correct length so the trailing junk is not included in the
+    // abstract socket name
+    socklen_t addr_len = offsetof(struct sockaddr_un, sun_path) + abs_name_len;
+
+    if (bind(fd, (struct sockaddr *) &addr, addr_len) < 0) {
+        LOGE("Failed to bind socket: %s", strerror(errno));
+        LOGE("Is another instance running?");
+        return false;
+    }
+
+    if (listen(fd, 3) < 0) {
+        LOGE("Failed to listen on socket: %s", strerror(errno));
+        return false;
+    }
+
+    // Must be set up before forking for the connections so that the children
+    // share the counters
+    daemon_stats_init();
+
+    return event_loop ? run_event_loop(fd) : run_fork_loop(fd);
+}
+
 __attribute__((noreturn))
-static void run_daemon_fork(void)
+static void run_daemon_fork(bool event_loop)
 {
     pid_t pid = fork();
     if (pid < 0) {
@@ -279,7 +643,7 @@ static void run_daemon_fork(void)
         _exit(EXIT_FAILURE);
     }
 
-    run_daemon();
+    run_daemon(event_loop);
     _exit(EXIT_SUCCESS);
 }
 
@@ -323,6 +687,13 @@ static void daemon_usage(bool error)
             "Options:\n"
             "  -d, --daemonize  Fork to background\n"
             "  -r, --replace    Kill existing daemon (if any) before starting\n"
+            "  -e, --event-loop Serve all connections from one process instead\n"
+            "                   of forking for each connection (package counts\n"
+            "                   and directory sizes are then cached across\n"
+            "                   connections)\n"
+            "  -s, --stats-interval <seconds>\n"
+            "                   Write request statistics to the log at the\n"
+            "                   specified interval\n"
             "  -h, --help       Display this help message\n");
 }
 
@@ -331,17 +702,20 @@ int daemon_main(int argc, char *argv[])
     int opt;
     bool fork_flag = false;
     bool replace_flag = false;
+    bool event_loop_flag = false;
 
     static struct option long_options[] = {
-        {"daemonize", no_argument, 0, 'd'},
-        {"replace",   no_argument, 0, 'r'},
-        {"help",      no_argument, 0, 'h'},
+        {"daemonize",  no_argument, 0, 'd'},
+        {"replace",    no_argument, 0, 'r'},
+        {"event-loop", no_argument, 0, 'e'},
+        {"stats-interval", required_argument, 0, 's'},
+        {"help",       no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
     int long_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "drh", long_options, &long_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "dres:h", long_options, &long_index)) != -1) {
         switch (opt) {
         case 'd':
             fork_flag = true;
@@ -351,6 +725,23 @@ int daemon_main(int argc, char *argv[])
             replace_flag = true;
             break;
 
+        case 'e':
+            event_loop_flag = true;
+            break;
+
+        case 's': {
+            char *end;
+            errno = 0;
+            long seconds = strtol(optarg, &end, 10);
+            if (errno != 0 || *optarg == '\0' || *end != '\0'
+                    || seconds <= 0 || seconds > INT_MAX / 1000) {
+                fprintf(stderr, "Invalid statistics interval: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            stats_interval_ms = seconds * 1000;
+            break;
+        }
+
         case 'h':
             daemon_usage(0);
             return EXIT_SUCCESS;
@@ -367,11 +758,24 @@ int daemon_main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    // Patch SELinux policy to make init permissive
-    patch_loaded_sepolicy();
+    auto patch_sepolicy = []{
+        // Patch SELinux policy to make init permissive
+        patch_loaded_sepolicy();
+
+        // Allow untrusted_app to connect to our daemon
+        patch_sepolicy_daemon();
 
-    // Allow untrusted_app to connect to our daemon
-    patch_sepolicy_daemon();
+        return true;
+    };
+
+    if (event_loop_flag) {
+        // The event loop daemon is long-lived and is not protected by a
+        // per-connection process, so keep libsepol crashes and the memory used
+        // by the loaded policy out of it
+        util::run_in_child(patch_sepolicy);
+    } else {
+        patch_sepolicy();
+    }
 
     // Set version property if we're the system mbtool (i.e. launched by init)
     // Possible to override this with another program by double forking, letting
@@ -430,9 +834,9 @@ int daemon_main(int argc, char *argv[])
     util::log_set_logger(std::make_shared<util::StdioLogger>(fp.get(), true));
 
     if (fork_flag) {
-        run_daemon_fork();
+        run_daemon_fork(event_loop_flag);
     } else {
-        return run_daemon() ? EXIT_SUCCESS : EXIT_FAILURE;
+        return run_daemon(event_loop_flag) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 }
 
@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "daemon_bench.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "daemon_v3.h"
+#include "util/socket.h"
+#include "util/time.h"
+
+// flatbuffers
+#include "protocol/file_close_generated.h"
+#include "protocol/file_open_generated.h"
+#include "protocol/file_stat_generated.h"
+#include "protocol/mb_get_version_generated.h"
+#include "protocol/request_generated.h"
+#include "protocol/response_generated.h"
+
+#define DEFAULT_ITERATIONS      10000
+#define DEFAULT_DEPTH           1
+
+namespace mb
+{
+
+namespace v3 = mbtool::daemon::v3;
+namespace fb = flatbuffers;
+
+static bool bench_send(int fd, const fb::FlatBufferBuilder &builder)
+{
+    return util::socket_write_bytes(
+            fd, builder.GetBufferPointer(), builder.GetSize());
+}
+
+static const v3::Response * bench_receive(int fd, std::vector<uint8_t> *buf,
+                                          v3::ResponseType type)
+{
+    if (!util::socket_read_bytes(fd, buf)) {
+        fprintf(stderr, "Failed to read response: %s\n", strerror(errno));
+        return nullptr;
+    }
+
+    auto verifier = fb::Verifier(buf->data(), buf->size());
+    if (!v3::VerifyResponseBuffer(verifier)) {
+        fprintf(stderr, "Received invalid buffer\n");
+        return nullptr;
+    }
+
+    const v3::Response *response = v3::GetResponse(buf->data());
+    if (response->response_type() != type) {
+        fprintf(stderr, "Unexpected response type: %s\n",
+                v3::EnumNameResponseType(response->response_type()));
+        return nullptr;
+    }
+
+    return response;
+}
+
+static bool bench_open_file(int fd, const char *path, int *id_out)
+{
+    fb::FlatBufferBuilder builder;
+    std::vector<int16_t> flags{ v3::FileOpenFlag_RDONLY };
+    auto request = v3::CreateFileOpenRequest(
+            builder, builder.CreateString(path), builder.CreateVector(flags));
+    builder.Finish(v3::CreateRequest(
+            builder, v3::RequestType_FileOpenRequest, request.Union()));
+
+    std::vector<uint8_t> buf;
+    const v3::Response *response;
+
+    if (!bench_send(fd, builder) || !(response = bench_receive(
+            fd, &buf, v3::ResponseType_FileOpenResponse))) {
+        return false;
+    }
+
+    auto r = static_cast<const v3::FileOpenResponse *>(response->response());
+    if (!r->success()) {
+        fprintf(stderr, "%s: Failed to open: %s\n", path,
+                r->error_msg() ? r->error_msg()->c_str() : "(unknown)");
+        return false;
+    }
+
+    *id_out = r->id();
+    return true;
+}
+
+static bool bench_close_file(int fd, int id)
+{
+    fb::FlatBufferBuilder builder;
+    auto request = v3::CreateFileCloseRequest(builder, id);
+    builder.Finish(v3::CreateRequest(
+            builder, v3::RequestType_FileCloseRequest, request.Union()));
+
+    std::vector<uint8_t> buf;
+    return bench_send(fd, builder) && bench_receive(
+            fd, &buf, v3::ResponseType_FileCloseResponse);
+}
+
+/*!
+ * \brief Send a request repeatedly and report the throughput
+ *
+ * With a depth greater than 1, up to \p depth requests are kept in flight by
+ * giving them a non-zero request ID, which allows the daemon to execute them
+ * concurrently.
+ */
+static bool bench_run(int fd, const char *name,
+                      const fb::FlatBufferBuilder &builder,
+                      v3::ResponseType type,
+                      unsigned long iterations, unsigned long depth)
+{
+    std::vector<uint8_t> buf;
+    unsigned long sent = 0;
+    unsigned long received = 0;
+
+    uint64_t start = util::monotonic_time_us();
+
+    while (received < iterations) {
+        while (sent < iterations && sent - received < depth) {
+            if (!bench_send(fd, builder)) {
+                fprintf(stderr, "Failed to send request: %s\n",
+                        strerror(errno));
+                return false;
+            }
+            ++sent;
+        }
+
+        if (!bench_receive(fd, &buf, type)) {
+            return false;
+        }
+        ++received;
+    }
+
+    uint64_t elapsed = util::monotonic_time_us() - start;
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+
+    printf("%-24s %8lu requests in %8.3f ms: %10.1f req/s, %8.2f us/req\n",
+           name, iterations, elapsed / 1000.0,
+           iterations * 1000000.0 / elapsed,
+           static_cast<double>(elapsed) / iterations);
+    return true;
+}
+
+static bool bench_all(int fd, const char *path, unsigned long iterations,
+                      unsigned long depth)
+{
+    // Requests with ID 0 are executed in order on the reading thread
+    uint64_t id = depth > 1 ? 1 : 0;
+
+    int file_id;
+    if (!bench_open_file(fd, path, &file_id)) {
+        return false;
+    }
+
+    fb::FlatBufferBuilder builder;
+    bool ret = true;
+
+    // The request buffers are built once so that only the daemon side is
+    // measured
+    auto stat_request = v3::CreateFileStatRequest(builder, file_id);
+    builder.Finish(v3::CreateRequest(
+            builder, v3::RequestType_FileStatRequest,
+            stat_request.Union(), id));
+    ret = bench_run(fd, "FileStatRequest", builder,
+                    v3::ResponseType_FileStatResponse, iterations, depth);
+
+    if (ret) {
+        builder.Clear();
+        auto version_request = v3::CreateMbGetVersionRequest(builder);
+        builder.Finish(v3::CreateRequest(
+                builder, v3::RequestType_MbGetVersionRequest,
+                version_request.Union(), id));
+        ret = bench_run(fd, "MbGetVersionRequest", builder,
+                        v3::ResponseType_MbGetVersionResponse,
+                        iterations, depth);
+    }
+
+    return bench_close_file(fd, file_id) && ret;
+}
+
+static void daemon_bench_usage(bool error)
+{
+    FILE *stream = error ? stderr : stdout;
+
+    fprintf(stream,
+            "Usage: daemon_bench [OPTION]...\n\n"
+            "Options:\n"
+            "  -n, --iterations <N>\n"
+            "                   Number of requests per type (default: %d)\n"
+            "  -d, --depth <N>  Number of requests in flight (default: %d)\n"
+            "  -f, --file <path>\n"
+            "                   File to use for FileStat requests\n"
+            "                   (default: /proc/self/exe)\n"
+            "  -h, --help       Display this help message\n"
+            "\n"
+            "This tool measures the throughput of the daemon's protocol\n"
+            "version 3 request handling. The daemon code runs in-process and\n"
+            "is connected with a socket pair, so no daemon needs to be\n"
+            "running and no credentials are checked.\n",
+            DEFAULT_ITERATIONS, DEFAULT_DEPTH);
+}
+
+static bool parse_count(const char *str, unsigned long *out)
+{
+    char *end;
+    errno = 0;
+    unsigned long value = strtoul(str, &end, 10);
+    if (errno != 0 || *str == '\0' || *end != '\0' || value == 0) {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+int daemon_bench_main(int argc, char *argv[])
+{
+    unsigned long iterations = DEFAULT_ITERATIONS;
+    unsigned long depth = DEFAULT_DEPTH;
+    const char *path = "/proc/self/exe";
+
+    int opt;
+
+    static struct option long_options[] = {
+        {"iterations", required_argument, 0, 'n'},
+        {"depth",      required_argument, 0, 'd'},
+        {"file",       required_argument, 0, 'f'},
+        {"help",       no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int long_index = 0;
+
+    while ((opt = getopt_long(argc, argv, "n:d:f:h",
+                              long_options, &long_index)) != -1) {
+        switch (opt) {
+        case 'n':
+            if (!parse_count(optarg, &iterations)) {
+                fprintf(stderr, "Invalid iteration count: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'd':
+            if (!parse_count(optarg, &depth)) {
+                fprintf(stderr, "Invalid depth: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'f':
+            path = optarg;
+            break;
+        case 'h':
+            daemon_bench_usage(false);
+            return EXIT_SUCCESS;
+        default:
+            daemon_bench_usage(true);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // There should be no other arguments
+    if (argc - optind != 0) {
+        daemon_bench_usage(true);
+        return EXIT_FAILURE;
+    }
+
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        fprintf(stderr, "Failed to create socket pair: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    std::thread server([&sv]{
+        connection_version_3(sv[0]);
+    });
+
+    bool ret = bench_all(sv[1], path, iterations, depth);
+
+    // Closing the client side makes the server's read fail
+    shutdown(sv[1], SHUT_RDWR);
+    server.join();
+    close(sv[0]);
+    close(sv[1]);
+
+    return ret ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}
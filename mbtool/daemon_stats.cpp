@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "daemon_stats.h"
+
+#include <algorithm>
+#include <new>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+
+#include <sys/mman.h>
+
+#include "util/logging.h"
+#include "util/time.h"
+
+// flatbuffers
+#include "protocol/request_generated.h"
+
+namespace mb
+{
+
+namespace v3 = mbtool::daemon::v3;
+
+// Used until daemon_stats_init() is called, eg. by the daemon benchmark
+static DaemonStats g_local_stats;
+static DaemonStats *g_stats = &g_local_stats;
+
+static void atomic_store_max(std::atomic<uint64_t> &value, uint64_t new_value)
+{
+    uint64_t cur = value.load(std::memory_order_relaxed);
+    while (cur < new_value && !value.compare_exchange_weak(
+            cur, new_value, std::memory_order_relaxed));
+}
+
+static unsigned int latency_bucket(uint64_t time_us)
+{
+    if (time_us == 0) {
+        return 0;
+    }
+    unsigned int bucket = 63 - __builtin_clzll(time_us);
+    return std::min(bucket, DAEMON_STATS_LATENCY_BUCKETS - 1u);
+}
+
+/*!
+ * \brief Allocate the daemon statistics in memory shared with child processes
+ *
+ * This must be called before any connections are accepted. In fork mode, every
+ * connection is served by a child process, so the counters must be shared for
+ * the parent to see them.
+ *
+ * \return Whether the shared mapping was created. If it was not, statistics are
+ *         only collected for the current process.
+ */
+bool daemon_stats_init()
+{
+    void *mem = mmap(nullptr, sizeof(DaemonStats), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        LOGW("Failed to map shared memory for statistics: %s",
+             strerror(errno));
+        g_local_stats.start_time_us = util::monotonic_time_us();
+        util::command_set_counters(&g_local_stats.commands);
+        return false;
+    }
+
+    // The mapping is zero-filled and never unmapped
+    g_stats = new (mem) DaemonStats();
+    g_stats->start_time_us = util::monotonic_time_us();
+    util::command_set_counters(&g_stats->commands);
+    return true;
+}
+
+DaemonStats & daemon_stats()
+{
+    return *g_stats;
+}
+
+// Zero if daemon_stats_init() was never called
+uint64_t daemon_stats_uptime_us()
+{
+    uint64_t start = g_stats->start_time_us;
+    return start == 0 ? 0 : util::monotonic_time_us() - start;
+}
+
+/*!
+ * \brief Record a completed request
+ *
+ * \param type RequestType union tag
+ * \param time_us Time taken to handle the request
+ * \param success False if the request ended in a connection error
+ */
+void daemon_stats_record_request(unsigned int type, uint64_t time_us,
+                                 bool success)
+{
+    if (type >= DAEMON_STATS_MAX_REQUEST_TYPES) {
+        return;
+    }
+
+    DaemonRequestStats &rs = g_stats->requests[type];
+    rs.count.fetch_add(1, std::memory_order_relaxed);
+    if (!success) {
+        rs.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    rs.total_time_us.fetch_add(time_us, std::memory_order_relaxed);
+    atomic_store_max(rs.max_time_us, time_us);
+    rs.latency[latency_bucket(time_us)].fetch_add(
+            1, std::memory_order_relaxed);
+}
+
+void daemon_stats_worker_begin()
+{
+    uint64_t active = g_stats->workers_active.fetch_add(
+            1, std::memory_order_relaxed) + 1;
+    atomic_store_max(g_stats->workers_peak, active);
+}
+
+void daemon_stats_worker_end()
+{
+    g_stats->workers_active.fetch_sub(1, std::memory_order_relaxed);
+}
+
+static const char * request_type_name(unsigned int type)
+{
+    const char **names = v3::EnumNamesRequestType();
+    for (unsigned int i = 0; names[i]; ++i) {
+        if (i == type) {
+            return names[i];
+        }
+    }
+    return "Unknown";
+}
+
+// Upper bound of the bucket containing the given fraction of the requests
+static uint64_t latency_percentile(const uint64_t *buckets, uint64_t count,
+                                   double fraction)
+{
+    uint64_t target = static_cast<uint64_t>(count * fraction);
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < DAEMON_STATS_LATENCY_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen > target) {
+            return 2ull << i;
+        }
+    }
+    return 2ull << (DAEMON_STATS_LATENCY_BUCKETS - 1);
+}
+
+/*!
+ * \brief Write a summary of the statistics to the log
+ */
+void daemon_stats_log()
+{
+    DaemonStats &s = *g_stats;
+
+    LOGI("Stats: uptime=%" PRIu64 "s connections=%" PRIu64 " (active=%" PRIu64
+         ", rejected=%" PRIu64 ") read=%" PRIu64 " written=%" PRIu64
+         " workers=%" PRIu64 " (peak=%" PRIu64 ") forks=%" PRIu64
+         " execs=%" PRIu64,
+         daemon_stats_uptime_us() / 1000000,
+         s.connections_total.load(), s.connections_active.load(),
+         s.connections_rejected.load(), s.bytes_read.load(),
+         s.bytes_written.load(), s.workers_active.load(),
+         s.workers_peak.load(), s.commands.forks.load(),
+         s.commands.execs.load());
+
+    for (unsigned int type = 0; type < DAEMON_STATS_MAX_REQUEST_TYPES; ++type) {
+        DaemonRequestStats &rs = s.requests[type];
+
+        uint64_t buckets[DAEMON_STATS_LATENCY_BUCKETS];
+        uint64_t count = 0;
+        for (unsigned int i = 0; i < DAEMON_STATS_LATENCY_BUCKETS; ++i) {
+            buckets[i] = rs.latency[i].load(std::memory_order_relaxed);
+            count += buckets[i];
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        LOGI("Stats: %s: count=%" PRIu64 " errors=%" PRIu64 " mean=%" PRIu64
+             "us p50<%" PRIu64 "us p90<%" PRIu64 "us p99<%" PRIu64
+             "us max=%" PRIu64 "us",
+             request_type_name(type), count, rs.errors.load(),
+             rs.total_time_us.load() / count,
+             latency_percentile(buckets, count, 0.50),
+             latency_percentile(buckets, count, 0.90),
+             latency_percentile(buckets, count, 0.99),
+             rs.max_time_us.load());
+    }
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+
+#include <cstdint>
+
+#include "util/command.h"
+
+// Latency histogram buckets. Bucket i counts durations in [2^i, 2^(i+1)) us.
+#define DAEMON_STATS_LATENCY_BUCKETS    32
+// Request types with a larger union tag are not tracked
+#define DAEMON_STATS_MAX_REQUEST_TYPES  64
+
+namespace mb
+{
+
+struct DaemonRequestStats
+{
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> errors;
+    std::atomic<uint64_t> total_time_us;
+    std::atomic<uint64_t> max_time_us;
+    std::atomic<uint64_t> latency[DAEMON_STATS_LATENCY_BUCKETS];
+};
+
+// Daemon-wide counters. All fields are only updated with relaxed atomic
+// operations, so recording never blocks a request. In fork mode, the structure
+// lives in shared memory that is inherited by the per-connection processes.
+struct DaemonStats
+{
+    uint64_t start_time_us;
+    std::atomic<uint64_t> connections_total;
+    std::atomic<uint64_t> connections_active;
+    std::atomic<uint64_t> connections_rejected;
+    std::atomic<uint64_t> bytes_read;
+    std::atomic<uint64_t> bytes_written;
+    std::atomic<uint64_t> workers_active;
+    std::atomic<uint64_t> workers_peak;
+    util::CommandCounters commands;
+    DaemonRequestStats requests[DAEMON_STATS_MAX_REQUEST_TYPES];
+};
+
+bool daemon_stats_init();
+DaemonStats & daemon_stats();
+uint64_t daemon_stats_uptime_us();
+
+void daemon_stats_record_request(unsigned int type, uint64_t time_us,
+                                 bool success);
+void daemon_stats_worker_begin();
+void daemon_stats_worker_end();
+void daemon_stats_log();
+
+inline void daemon_stats_add_read(uint64_t n)
+{
+    daemon_stats().bytes_read.fetch_add(n, std::memory_order_relaxed);
+}
+
+inline void daemon_stats_add_written(uint64_t n)
+{
+    daemon_stats().bytes_written.fetch_add(n, std::memory_order_relaxed);
+}
+
+}
@@ -19,25 +19,34 @@
 
 #include "daemon_v3.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
-#include <unordered_set>
 
 #include <fcntl.h>
 #include <sys/mount.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "copy_jobs.h"
+#include "daemon_stats.h"
 #include "packages.h"
 #include "reboot.h"
+#include "rom_inventory.h"
 #include "roms.h"
 #include "switcher.h"
 #include "util/copy.h"
+#include "util/directory_size.h"
 #include "util/finally.h"
-#include "util/fts.h"
 #include "util/logging.h"
 #include "util/properties.h"
 #include "util/selinux.h"
 #include "util/socket.h"
+#include "util/thread_pool.h"
+#include "util/time.h"
 #include "version.h"
 #include "wipe.h"
 
@@ -53,6 +62,9 @@
 #include "protocol/file_write_generated.h"
 #include "protocol/path_chmod_generated.h"
 #include "protocol/path_copy_generated.h"
+#include "protocol/path_copy_cancel_generated.h"
+#include "protocol/path_copy_start_generated.h"
+#include "protocol/path_copy_status_generated.h"
 #include "protocol/path_selinux_get_label_generated.h"
 #include "protocol/path_selinux_set_label_generated.h"
 #include "protocol/path_get_directory_size_generated.h"
@@ -63,7 +75,11 @@
 #include "protocol/mb_switch_rom_generated.h"
 #include "protocol/mb_wipe_rom_generated.h"
 #include "protocol/mb_get_packages_count_generated.h"
+#include "protocol/mb_get_stats_generated.h"
 #include "protocol/reboot_generated.h"
+#include "protocol/file_open_fd_generated.h"
+#include "protocol/file_read_stream_generated.h"
+#include "protocol/file_write_stream_generated.h"
 #include "protocol/request_generated.h"
 #include "protocol/response_generated.h"
 
@@ -73,50 +89,315 @@ namespace mb
 namespace v3 = mbtool::daemon::v3;
 namespace fb = flatbuffers;
 
-static std::unordered_map<int, int> fd_map;
-static int fd_count = 0;
+// Requests with a non-zero ID may be executed concurrently on this many threads.
+// The pool is shared by all connections handled by the process, so the event
+// loop daemon does not start more threads for each client.
+#define V3_MAX_WORKERS          4
+
+// Ordering keys for the worker pool. Operations on the same open file are
+// serialized by using (V3_KEY_FILE | file ID) as the key. The session ID is
+// stored in the bits starting at V3_KEY_SESSION_SHIFT.
+#define V3_KEY_STATE            1ull
+#define V3_KEY_FILE             (1ull << 32)
+#define V3_KEY_SESSION_SHIFT    33
+
+// Maximum size of a chunk in the streaming file read/write requests. This is
+// also the requested size of the pipe used for splice().
+#define V3_STREAM_CHUNK_SIZE    (1024 * 1024)
+
+// Number of idle buffers and builders kept around per connection for reuse and
+// the largest size that will be retained. Anything larger (eg. from a big
+// FileRead) is freed instead of pinning the memory for the connection's
+// lifetime.
+#define V3_POOL_MAX_FREE        (V3_MAX_WORKERS + 2)
+#define V3_POOL_MAX_RETAINED    (256 * 1024)
+
+static bool v3_pool_recycle(fb::FlatBufferBuilder *builder)
+{
+    if (builder->GetSize() > V3_POOL_MAX_RETAINED) {
+        return false;
+    }
+    builder->Clear();
+    return true;
+}
+
+static bool v3_pool_recycle(std::vector<uint8_t> *buf)
+{
+    return buf->capacity() <= V3_POOL_MAX_RETAINED;
+}
+
+template<typename T>
+class V3Pool;
+
+template<typename T>
+struct V3PoolReturn
+{
+    V3Pool<T> *pool;
+
+    void operator()(T *obj) const
+    {
+        pool->release(obj);
+    }
+};
+
+// Free list of objects that are expensive to allocate on every request. The
+// returned pointer gives the object back to the pool when it is destroyed, so
+// the pool must outlive all of its objects.
+template<typename T>
+class V3Pool
+{
+public:
+    typedef std::unique_ptr<T, V3PoolReturn<T>> Ptr;
+
+    V3Pool() = default;
+    V3Pool(const V3Pool &) = delete;
+    V3Pool & operator=(const V3Pool &) = delete;
+
+    ~V3Pool()
+    {
+        for (T *obj : _free) {
+            delete obj;
+        }
+    }
+
+    Ptr acquire()
+    {
+        T *obj = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_free.empty()) {
+                obj = _free.back();
+                _free.pop_back();
+            }
+        }
+        if (!obj) {
+            obj = new T();
+        }
+        return Ptr(obj, V3PoolReturn<T>{this});
+    }
+
+    // Takes ownership of a pointer previously released from acquire()'s result
+    Ptr adopt(T *obj)
+    {
+        return Ptr(obj, V3PoolReturn<T>{this});
+    }
+
+    void release(T *obj)
+    {
+        if (v3_pool_recycle(obj)) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_free.size() < V3_POOL_MAX_FREE) {
+                _free.push_back(obj);
+                return;
+            }
+        }
+        delete obj;
+    }
+
+private:
+    std::mutex _mutex;
+    std::vector<T *> _free;
+};
+
+typedef V3Pool<fb::FlatBufferBuilder>::Ptr V3BuilderPtr;
+typedef V3Pool<std::vector<uint8_t>>::Ptr V3BufferPtr;
+
+class V3Connection
+{
+public:
+    explicit V3Connection(int fd) : _fd(fd), _fd_count(0), _failed(false)
+    {
+    }
+
+    ~V3Connection()
+    {
+        close_files();
+    }
+
+    // Responses from concurrently executing requests must not interleave
+    bool send(const fb::FlatBufferBuilder &builder)
+    {
+        return with_socket([&](int fd) {
+            if (!util::socket_write_bytes(
+                    fd, builder.GetBufferPointer(), builder.GetSize())) {
+                return false;
+            }
+            daemon_stats_add_written(sizeof(int32_t) + builder.GetSize());
+            return true;
+        });
+    }
+
+    // Run fn with exclusive write access to the socket. This is used for
+    // responses that are followed by out-of-band data.
+    template<typename F>
+    bool with_socket(F fn)
+    {
+        std::lock_guard<std::mutex> lock(_write_mutex);
+        if (_failed) {
+            return false;
+        }
+        if (!fn(_fd)) {
+            fail();
+            return false;
+        }
+        return true;
+    }
+
+    int fd() const
+    {
+        return _fd;
+    }
+
+    // Cleared builder for constructing a response
+    V3BuilderPtr get_builder()
+    {
+        return _builders.acquire();
+    }
+
+    // Buffer for receiving a request. Its previous contents are unspecified.
+    V3BufferPtr get_buffer()
+    {
+        return _buffers.acquire();
+    }
+
+    V3BufferPtr adopt_buffer(std::vector<uint8_t> *buf)
+    {
+        return _buffers.adopt(buf);
+    }
+
+    // Called when a request executed on a worker thread hits a connection
+    // error. Shutting down the socket wakes up the reader thread.
+    void fail()
+    {
+        if (!_failed.exchange(true)) {
+            shutdown(_fd, SHUT_RDWR);
+        }
+    }
+
+    bool failed() const
+    {
+        return _failed;
+    }
+
+    int add_file(int ffd)
+    {
+        std::lock_guard<std::mutex> lock(_files_mutex);
+        int id = _fd_count++;
+        _fd_map[id] = ffd;
+        return id;
+    }
+
+    bool get_file(int id, int *ffd_out)
+    {
+        std::lock_guard<std::mutex> lock(_files_mutex);
+        auto it = _fd_map.find(id);
+        if (it == _fd_map.end()) {
+            return false;
+        }
+        *ffd_out = it->second;
+        return true;
+    }
+
+    bool remove_file(int id, int *ffd_out)
+    {
+        std::lock_guard<std::mutex> lock(_files_mutex);
+        auto it = _fd_map.find(id);
+        if (it == _fd_map.end()) {
+            return false;
+        }
+        *ffd_out = it->second;
+        _fd_map.erase(it);
+        return true;
+    }
+
+    void close_files()
+    {
+        std::lock_guard<std::mutex> lock(_files_mutex);
+        for (auto &p : _fd_map) {
+            close(p.second);
+        }
+        _fd_map.clear();
+    }
 
-static bool v3_send_response(int fd, const fb::FlatBufferBuilder &builder)
+private:
+    int _fd;
+    std::mutex _write_mutex;
+    std::mutex _files_mutex;
+    std::unordered_map<int, int> _fd_map;
+    int _fd_count;
+    std::atomic_bool _failed;
+    V3Pool<fb::FlatBufferBuilder> _builders;
+    V3Pool<std::vector<uint8_t>> _buffers;
+};
+
+// Collects the responses of a batch's sub-requests
+struct V3BatchCapture
 {
-    return util::socket_write_bytes(
-            fd, builder.GetBufferPointer(), builder.GetSize());
+    fb::FlatBufferBuilder *builder;
+    std::vector<fb::Offset<v3::BatchResult>> results;
+};
+
+// Set while a batch is executing on the current thread. The handlers are not
+// aware of batches, so their responses are redirected here instead of being
+// written to the socket.
+static thread_local V3BatchCapture *v3_batch_capture = nullptr;
+
+static bool v3_send_response(V3Connection &conn,
+                             const fb::FlatBufferBuilder &builder)
+{
+    if (v3_batch_capture) {
+        V3BatchCapture &capture = *v3_batch_capture;
+        auto data = capture.builder->CreateVector(
+                builder.GetBufferPointer(), builder.GetSize());
+        capture.results.push_back(
+                v3::CreateBatchResult(*capture.builder, data));
+        return true;
+    }
+
+    return conn.send(builder);
 }
 
-static bool v3_send_response_invalid(int fd)
+static bool v3_send_response_invalid(V3Connection &conn,
+                                     const v3::Request *msg)
 {
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     auto response = v3::CreateResponse(builder, v3::ResponseType_Invalid,
-                                       v3::CreateInvalid(builder).Union());
+                                       v3::CreateInvalid(builder).Union(),
+                                       msg->id());
     builder.Finish(response);
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_send_response_unsupported(int fd)
+static bool v3_send_response_unsupported(V3Connection &conn,
+                                         const v3::Request *msg)
 {
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     auto response = v3::CreateResponse(builder, v3::ResponseType_Unsupported,
-                                       v3::CreateUnsupported(builder).Union());
+                                       v3::CreateUnsupported(builder).Union(),
+                                       msg->id());
     builder.Finish(response);
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_file_chmod(int fd, const v3::Request *msg)
+static bool v3_file_chmod(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::FileChmodRequest *) msg->request();
-    if (fd_map.find(request->id()) == fd_map.end()) {
-        return v3_send_response_invalid(fd);
+    int ffd;
+    if (!conn.get_file(request->id(), &ffd)) {
+        return v3_send_response_invalid(conn, msg);
     }
 
-    int ffd = fd_map[request->id()];
-
     // Don't allow setting setuid or setgid permissions
     uint32_t mode = request->mode();
     uint32_t masked = mode & (S_IRWXU | S_IRWXG | S_IRWXO);
     if (masked != mode) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::FileChmodResponse> response;
 
     if (fchmod(ffd, mode) < 0) {
@@ -128,25 +409,25 @@ static bool v3_file_chmod(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_FileChmodResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_file_close(int fd, const v3::Request *msg)
+static bool v3_file_close(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::FileCloseRequest *) msg->request();
-    if (fd_map.find(request->id()) == fd_map.end()) {
-        return v3_send_response_invalid(fd);
-    }
-
     // Remove ID from map
-    int ffd = fd_map[request->id()];
-    fd_map.erase(request->id());
+    int ffd;
+    if (!conn.remove_file(request->id(), &ffd)) {
+        return v3_send_response_invalid(conn, msg);
+    }
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::FileCloseResponse> response;
 
     if (close(ffd) < 0) {
@@ -158,24 +439,21 @@ static bool v3_file_close(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_FileCloseResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_file_open(int fd, const v3::Request *msg)
+// Only translates the protocol flags. Callers must add O_CLOEXEC.
+static int v3_open_flags(const fb::Vector<int16_t> *open_flags)
 {
-    auto request = (v3::FileOpenRequest *) msg->request();
-    if (!request->path()) {
-        return v3_send_response_invalid(fd);
-    }
-
-    int flags = O_CLOEXEC;
+    int flags = 0;
 
-    if (request->flags()) {
-        for (short openflag : *request->flags()) {
+    if (open_flags) {
+        for (short openflag : *open_flags) {
             if (openflag == v3::FileOpenFlag_APPEND) {
                 flags |= O_APPEND;
             } else if (openflag == v3::FileOpenFlag_CREAT) {
@@ -194,41 +472,54 @@ static bool v3_file_open(int fd, const v3::Request *msg)
         }
     }
 
-    fb::FlatBufferBuilder builder;
+    return flags;
+}
+
+static bool v3_file_open(V3Connection &conn, const v3::Request *msg)
+{
+    auto request = (v3::FileOpenRequest *) msg->request();
+    if (!request->path()) {
+        return v3_send_response_invalid(conn, msg);
+    }
+
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::FileOpenResponse> response;
 
-    int ffd = open(request->path()->c_str(), flags, request->perms());
+    int ffd = open(request->path()->c_str(),
+                   v3_open_flags(request->flags()) | O_CLOEXEC,
+                   request->perms());
     if (ffd < 0) {
         auto error = builder.CreateString(strerror(errno));
         response = v3::CreateFileOpenResponse(builder, false, error);
     } else {
         // Assign a new ID
-        int id = fd_count++;
+        int id = conn.add_file(ffd);
         response = v3::CreateFileOpenResponse(builder, true, 0, id);
-        fd_map[id] = ffd;
     }
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_FileOpenResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_file_read(int fd, const v3::Request *msg)
+static bool v3_file_read(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::FileReadRequest *) msg->request();
-    if (fd_map.find(request->id()) == fd_map.end()) {
-        return v3_send_response_invalid(fd);
+    int ffd;
+    if (!conn.get_file(request->id(), &ffd)) {
+        return v3_send_response_invalid(conn, msg);
     }
 
-    int ffd = fd_map[request->id()];
-
     std::vector<unsigned char> buf(request->count());
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::FileReadResponse> response;
 
     auto ret = read(ffd, buf.data(), buf.size());
@@ -242,21 +533,21 @@ static bool v3_file_read(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_FileReadResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_file_seek(int fd, const v3::Request *msg)
+static bool v3_file_seek(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::FileSeekRequest *) msg->request();
-    if (fd_map.find(request->id()) == fd_map.end()) {
-        return v3_send_response_invalid(fd);
+    int ffd;
+    if (!conn.get_file(request->id(), &ffd)) {
+        return v3_send_response_invalid(conn, msg);
     }
-
-    int ffd = fd_map[request->id()];
     int64_t offset = request->offset();
     int whence;
 
@@ -267,10 +558,11 @@ static bool v3_file_seek(int fd, const v3::Request *msg)
     } else if (request->whence() == v3::FileSeekWhence_SEEK_END) {
         whence = SEEK_END;
     } else {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::FileSeekResponse> response;
 
     // Ahh, posix...
@@ -285,23 +577,24 @@ static bool v3_file_seek(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_FileSeekResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_file_selinux_get_label(int fd, const v3::Request *msg)
+static bool v3_file_selinux_get_label(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::FileSELinuxGetLabelRequest *) msg->request();
-    if (fd_map.find(request->id()) == fd_map.end()) {
-        return v3_send_response_invalid(fd);
+    int ffd;
+    if (!conn.get_file(request->id(), &ffd)) {
+        return v3_send_response_invalid(conn, msg);
     }
 
-    int ffd = fd_map[request->id()];
-
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::FileSELinuxGetLabelResponse> response;
 
     std::string label;
@@ -318,23 +611,24 @@ static bool v3_file_selinux_get_label(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_PathSELinuxGetLabelResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_file_selinux_set_label(int fd, const v3::Request *msg)
+static bool v3_file_selinux_set_label(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::FileSELinuxSetLabelRequest *) msg->request();
-    if (fd_map.find(request->id()) == fd_map.end() || !request->label()) {
-        return v3_send_response_invalid(fd);
+    int ffd;
+    if (!request->label() || !conn.get_file(request->id(), &ffd)) {
+        return v3_send_response_invalid(conn, msg);
     }
 
-    int ffd = fd_map[request->id()];
-
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::FileSELinuxSetLabelResponse> response;
 
     if (!util::selinux_fset_context(ffd, request->label()->c_str())) {
@@ -346,23 +640,24 @@ static bool v3_file_selinux_set_label(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_FileSELinuxSetLabelResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_file_stat(int fd, const v3::Request *msg)
+static bool v3_file_stat(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::FileStatRequest *) msg->request();
-    if (fd_map.find(request->id()) == fd_map.end()) {
-        return v3_send_response_invalid(fd);
+    int ffd;
+    if (!conn.get_file(request->id(), &ffd)) {
+        return v3_send_response_invalid(conn, msg);
     }
 
-    int ffd = fd_map[request->id()];
-
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::FileStatResponse> response;
 
     struct stat sb;
@@ -392,23 +687,24 @@ static bool v3_file_stat(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_FileStatResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_file_write(int fd, const v3::Request *msg)
+static bool v3_file_write(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::FileWriteRequest *) msg->request();
-    if (fd_map.find(request->id()) == fd_map.end() || !request->data()) {
-        return v3_send_response_invalid(fd);
+    int ffd;
+    if (!request->data() || !conn.get_file(request->id(), &ffd)) {
+        return v3_send_response_invalid(conn, msg);
     }
 
-    int ffd = fd_map[request->id()];
-
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::FileWriteResponse> response;
 
     auto ret = write(ffd, request->data()->Data(), request->data()->size());
@@ -421,28 +717,383 @@ static bool v3_file_write(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_FileWriteResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
+}
+
+static bool v3_file_open_fd(V3Connection &conn, const v3::Request *msg)
+{
+    auto request = (v3::FileOpenFdRequest *) msg->request();
+    if (!request->path()) {
+        return v3_send_response_invalid(conn, msg);
+    }
+
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
+    fb::Offset<v3::FileOpenFdResponse> response;
+
+    // The daemon's copy is closed after it is sent, but it must not leak into
+    // a child that is forked in the meantime
+    int ffd = open(request->path()->c_str(),
+                   v3_open_flags(request->flags()) | O_CLOEXEC,
+                   request->perms());
+    if (ffd < 0) {
+        auto error = builder.CreateString(strerror(errno));
+        response = v3::CreateFileOpenFdResponse(builder, false, error);
+    } else {
+        response = v3::CreateFileOpenFdResponse(builder, true);
+    }
+
+    // The client receives a duplicate of the fd
+    auto close_ffd = util::finally([&]{
+        if (ffd >= 0) {
+            close(ffd);
+        }
+    });
+
+    // Wrap response
+    v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
+    rb.add_response_type(v3::ResponseType_FileOpenFdResponse);
+    rb.add_response(response.Union());
+    builder.Finish(rb.Finish());
+
+    return conn.with_socket([&](int fd) {
+        if (!util::socket_write_bytes(
+                fd, builder.GetBufferPointer(), builder.GetSize())) {
+            return false;
+        }
+        return ffd < 0 || util::socket_send_fds(fd, { ffd });
+    });
+}
+
+// Create the pipe used as the intermediate buffer for splice() and return its
+// capacity, or 0 (with both fds set to -1) if the pipe could not be created
+static size_t v3_create_splice_pipe(int pipe_fds[2])
+{
+    if (pipe2(pipe_fds, O_CLOEXEC) < 0) {
+        LOGW("Failed to create pipe: %s", strerror(errno));
+        pipe_fds[0] = -1;
+        pipe_fds[1] = -1;
+        return 0;
+    }
+
+#ifdef F_SETPIPE_SZ
+    int size = fcntl(pipe_fds[1], F_SETPIPE_SZ, V3_STREAM_CHUNK_SIZE);
+    if (size > 0) {
+        return size;
+    }
+#endif
+
+    // Default pipe capacity
+    return 65536;
+}
+
+// Move exactly size bytes with splice(). The number of bytes that were moved
+// before an error is returned in moved_out.
+static bool v3_splice_fully(int in_fd, int out_fd, size_t size,
+                            size_t *moved_out)
+{
+    *moved_out = 0;
+
+    while (*moved_out < size) {
+        ssize_t n = splice(in_fd, nullptr, out_fd, nullptr, size - *moved_out,
+                           SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            return false;
+        }
+        *moved_out += n;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Send up to count bytes of a file as length-prefixed chunks
+ *
+ * The data is moved with splice() through a pipe, so it is never copied into
+ * userspace. If the file does not support splice(), the data is sent through a
+ * buffer instead.
+ *
+ * \return False if a connection error occurred
+ */
+static bool v3_stream_file_to_socket(int fd, int ffd, uint64_t count)
+{
+    int pipe_fds[2] = { -1, -1 };
+    size_t chunk_size = v3_create_splice_pipe(pipe_fds);
+    bool use_splice = chunk_size > 0;
+
+    // chunk_size is replaced below if there is no pipe, so check the fds
+    auto close_pipe = util::finally([&]{
+        if (pipe_fds[0] >= 0) {
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+        }
+    });
+
+    std::vector<char> buf;
+    if (!use_splice) {
+        chunk_size = 65536;
+    }
+
+    int32_t terminator = 0;
+
+    while (count > 0) {
+        size_t to_read = std::min<uint64_t>(count, chunk_size);
+        ssize_t n;
+
+        if (use_splice) {
+            n = splice(ffd, nullptr, pipe_fds[1], nullptr, to_read,
+                       SPLICE_F_MOVE);
+            if (n < 0 && errno == EINVAL) {
+                // File does not support splice()
+                use_splice = false;
+                continue;
+            }
+        } else {
+            buf.resize(chunk_size);
+            n = read(ffd, buf.data(), to_read);
+        }
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGE("Failed to read file: %s", strerror(errno));
+            terminator = -1;
+            break;
+        } else if (n == 0) {
+            break;
+        }
+
+        if (!util::socket_write_int32(fd, n)) {
+            return false;
+        }
+
+        if (use_splice) {
+            size_t moved;
+            if (!v3_splice_fully(pipe_fds[0], fd, n, &moved)) {
+                return false;
+            }
+        } else if (util::socket_write(fd, buf.data(), n) != n) {
+            return false;
+        }
+
+        daemon_stats_add_written(sizeof(int32_t) + n);
+        count -= n;
+    }
+
+    if (!util::socket_write_int32(fd, terminator)) {
+        return false;
+    }
+    daemon_stats_add_written(sizeof(int32_t));
+    return true;
+}
+
+/*!
+ * \brief Receive count bytes of raw data and write it to a file
+ *
+ * All of the data is consumed from the socket, even if writing to the file
+ * fails, so that the connection stays in sync. If \a ffd is -1, the data is
+ * discarded.
+ *
+ * \param[out] written_out Number of bytes written to the file
+ * \param[out] error_out errno value of the first write error or 0
+ *
+ * \return False if a connection error occurred
+ */
+static bool v3_stream_socket_to_file(int fd, int ffd, uint64_t count,
+                                     uint64_t *written_out, int *error_out)
+{
+    *written_out = 0;
+    *error_out = 0;
+
+    int pipe_fds[2] = { -1, -1 };
+    size_t chunk_size = v3_create_splice_pipe(pipe_fds);
+    bool use_splice = chunk_size > 0 && ffd >= 0;
+
+    // chunk_size is replaced below if there is no pipe, so check the fds
+    auto close_pipe = util::finally([&]{
+        if (pipe_fds[0] >= 0) {
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+        }
+    });
+
+    std::vector<char> buf;
+    if (chunk_size == 0) {
+        chunk_size = 65536;
+    }
+
+    auto write_buf = [&](const char *data, size_t size) {
+        if (ffd < 0) {
+            return;
+        }
+        ssize_t n = util::socket_write(ffd, data, size);
+        if (n > 0) {
+            *written_out += n;
+        }
+        if (n != (ssize_t) size) {
+            *error_out = n < 0 ? errno : EIO;
+            ffd = -1;
+        }
+    };
+
+    while (count > 0) {
+        size_t to_read = std::min<uint64_t>(count, chunk_size);
+
+        if (use_splice) {
+            ssize_t n = splice(fd, nullptr, pipe_fds[1], nullptr, to_read,
+                               SPLICE_F_MOVE);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && errno == EINVAL) {
+                // Kernels older than 4.5 cannot splice from unix sockets
+                use_splice = false;
+                continue;
+            } else if (n <= 0) {
+                return false;
+            }
+
+            size_t moved;
+            if (!v3_splice_fully(pipe_fds[0], ffd, n, &moved)) {
+                int saved_errno = errno;
+                *written_out += moved;
+
+                // Drain what is left in the pipe
+                buf.resize(chunk_size);
+                ssize_t left = n - moved;
+                if (util::socket_read(pipe_fds[0], buf.data(), left) != left) {
+                    return false;
+                }
+
+                if (saved_errno == EINVAL) {
+                    // File does not support splice()
+                    use_splice = false;
+                    write_buf(buf.data(), left);
+                } else {
+                    *error_out = saved_errno;
+                    ffd = -1;
+                    use_splice = false;
+                }
+            } else {
+                *written_out += moved;
+            }
+
+            count -= n;
+        } else {
+            buf.resize(chunk_size);
+            ssize_t n = util::socket_read(fd, buf.data(), to_read);
+            if (n != (ssize_t) to_read) {
+                return false;
+            }
+
+            write_buf(buf.data(), n);
+
+            count -= n;
+        }
+    }
+
+    return true;
+}
+
+static bool v3_file_read_stream(V3Connection &conn, const v3::Request *msg)
+{
+    auto request = (v3::FileReadStreamRequest *) msg->request();
+    int ffd;
+    if (!conn.get_file(request->id(), &ffd)) {
+        return v3_send_response_invalid(conn, msg);
+    }
+
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
+    auto response = v3::CreateFileReadStreamResponse(builder, true);
+
+    // Wrap response
+    v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
+    rb.add_response_type(v3::ResponseType_FileReadStreamResponse);
+    rb.add_response(response.Union());
+    builder.Finish(rb.Finish());
+
+    // Nothing else may be written to the socket until the stream ends
+    return conn.with_socket([&](int fd) {
+        if (!util::socket_write_bytes(
+                fd, builder.GetBufferPointer(), builder.GetSize())) {
+            return false;
+        }
+        daemon_stats_add_written(sizeof(int32_t) + builder.GetSize());
+        return v3_stream_file_to_socket(fd, ffd, request->count());
+    });
+}
+
+// NOTE: The data follows the request on the socket, so this must be called
+//       from the thread that reads requests
+static bool v3_file_write_stream(V3Connection &conn, const v3::Request *msg)
+{
+    auto request = (v3::FileWriteStreamRequest *) msg->request();
+    int ffd;
+    bool valid = conn.get_file(request->id(), &ffd);
+
+    uint64_t written;
+    int error;
+    if (!v3_stream_socket_to_file(conn.fd(), valid ? ffd : -1,
+                                  request->count(), &written, &error)) {
+        conn.fail();
+        return false;
+    }
+
+    daemon_stats_add_read(request->count());
+
+    if (!valid) {
+        return v3_send_response_invalid(conn, msg);
+    }
+
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
+    fb::Offset<v3::FileWriteStreamResponse> response;
+
+    if (error != 0) {
+        auto error_msg = builder.CreateString(strerror(error));
+        response = v3::CreateFileWriteStreamResponse(
+                builder, false, error_msg, written);
+    } else {
+        response = v3::CreateFileWriteStreamResponse(
+                builder, true, 0, written);
+    }
+
+    // Wrap response
+    v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
+    rb.add_response_type(v3::ResponseType_FileWriteStreamResponse);
+    rb.add_response(response.Union());
+    builder.Finish(rb.Finish());
+
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_path_chmod(int fd, const v3::Request *msg)
+static bool v3_path_chmod(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::PathChmodRequest *) msg->request();
     if (!request->path()) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
     // Don't allow setting setuid or setgid permissions
     uint32_t mode = request->mode();
     uint32_t masked = mode & (S_IRWXU | S_IRWXG | S_IRWXO);
     if (masked != mode) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::PathChmodResponse> response;
 
     if (chmod(request->path()->c_str(), mode) < 0) {
@@ -454,21 +1105,23 @@ static bool v3_path_chmod(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_PathChmodResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_path_copy(int fd, const v3::Request *msg)
+static bool v3_path_copy(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::PathCopyRequest *) msg->request();
     if (!request->source() || !request->target()) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::PathCopyResponse> response;
 
     if (util::copy_contents(request->source()->c_str(),
@@ -481,18 +1134,144 @@ static bool v3_path_copy(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_PathCopyResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
+}
+
+static bool v3_path_copy_start(V3Connection &conn, const v3::Request *msg)
+{
+    auto request = (v3::PathCopyStartRequest *) msg->request();
+    if (!request->source() || !request->target()) {
+        return v3_send_response_invalid(conn, msg);
+    }
+
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
+    fb::Offset<v3::PathCopyStartResponse> response;
+
+    uint32_t job_id;
+    std::string error;
+    if (CopyJobs::get().start(request->source()->c_str(),
+                              request->target()->c_str(), &job_id, &error)) {
+        response = v3::CreatePathCopyStartResponse(builder, true, 0, job_id);
+    } else {
+        auto fb_error = builder.CreateString(error);
+        response = v3::CreatePathCopyStartResponse(builder, false, fb_error);
+    }
+
+    // Wrap response
+    v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
+    rb.add_response_type(v3::ResponseType_PathCopyStartResponse);
+    rb.add_response(response.Union());
+    builder.Finish(rb.Finish());
+
+    return v3_send_response(conn, builder);
+}
+
+static v3::PathCopyState v3_path_copy_state(CopyJobState state)
+{
+    switch (state) {
+    case CopyJobState::SUCCEEDED:
+        return v3::PathCopyState_SUCCEEDED;
+    case CopyJobState::FAILED:
+        return v3::PathCopyState_FAILED;
+    case CopyJobState::CANCELLED:
+        return v3::PathCopyState_CANCELLED;
+    case CopyJobState::RUNNING:
+    default:
+        return v3::PathCopyState_RUNNING;
+    }
+}
+
+static bool v3_send_path_copy_status(V3Connection &conn,
+                                     const v3::Request *msg,
+                                     const CopyJobStatus *status)
+{
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
+    fb::Offset<v3::PathCopyStatusResponse> response;
+
+    if (!status) {
+        auto error = builder.CreateString("No such copy job");
+        response = v3::CreatePathCopyStatusResponse(builder, false, error);
+    } else {
+        fb::Offset<fb::String> error;
+        if (!status->error.empty()) {
+            error = builder.CreateString(status->error);
+        }
+        response = v3::CreatePathCopyStatusResponse(
+                builder, true, error, v3_path_copy_state(status->state),
+                status->bytes_copied, status->bytes_total,
+                status->files_copied, status->files_total);
+    }
+
+    // Wrap response
+    v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
+    rb.add_response_type(v3::ResponseType_PathCopyStatusResponse);
+    rb.add_response(response.Union());
+    builder.Finish(rb.Finish());
+
+    return v3_send_response(conn, builder);
+}
+
+static bool v3_path_copy_status(V3Connection &conn, const v3::Request *msg)
+{
+    auto request = (v3::PathCopyStatusRequest *) msg->request();
+    CopyJobs &jobs = CopyJobs::get();
+    CopyJobStatus status;
+
+    // Subscriptions can't be captured in a batch, which only has room for one
+    // response per request
+    if (request->progress_interval() == 0 || v3_batch_capture) {
+        bool found = jobs.status(request->job_id(), &status);
+        return v3_send_path_copy_status(conn, msg, found ? &status : nullptr);
+    }
+
+    while (jobs.wait(request->job_id(), request->progress_interval(),
+                     &status)) {
+        if (!v3_send_path_copy_status(conn, msg, &status)) {
+            return false;
+        } else if (status.state != CopyJobState::RUNNING) {
+            return true;
+        }
+    }
+
+    return v3_send_path_copy_status(conn, msg, nullptr);
+}
+
+static bool v3_path_copy_cancel(V3Connection &conn, const v3::Request *msg)
+{
+    auto request = (v3::PathCopyCancelRequest *) msg->request();
+
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
+
+    bool success = CopyJobs::get().cancel(request->job_id());
+
+    // Create response
+    auto response = v3::CreatePathCopyCancelResponse(builder, success);
+
+    // Wrap response
+    v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
+    rb.add_response_type(v3::ResponseType_PathCopyCancelResponse);
+    rb.add_response(response.Union());
+    builder.Finish(rb.Finish());
+
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_path_selinux_get_label(int fd, const v3::Request *msg)
+static bool v3_path_selinux_get_label(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::PathSELinuxGetLabelRequest *) msg->request();
     if (!request->path()) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
     std::string label;
@@ -503,7 +1282,8 @@ static bool v3_path_selinux_get_label(int fd, const v3::Request *msg)
         ret = util::selinux_lget_context(request->path()->c_str(), &label);
     }
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::PathSELinuxGetLabelResponse> response;
 
     if (!ret) {
@@ -518,18 +1298,19 @@ static bool v3_path_selinux_get_label(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_PathSELinuxGetLabelResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_path_selinux_set_label(int fd, const v3::Request *msg)
+static bool v3_path_selinux_set_label(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::PathSELinuxSetLabelRequest *) msg->request();
     if (!request->path()) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
     bool ret;
@@ -541,7 +1322,8 @@ static bool v3_path_selinux_set_label(int fd, const v3::Request *msg)
                                          request->label()->c_str());
     }
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::PathSELinuxSetLabelResponse> response;
 
     if (!ret) {
@@ -553,67 +1335,39 @@ static bool v3_path_selinux_set_label(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_PathSELinuxSetLabelResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-class DirectorySizeGetter : public util::FTSWrapper {
-public:
-    DirectorySizeGetter(std::string path, std::vector<std::string> exclusions)
-        : FTSWrapper(path, FTS_GroupSpecialFiles),
-        _exclusions(std::move(exclusions)),
-        _total(0)
-    {
-    }
-
-    virtual int on_changed_path() override
-    {
-        // Exclude first-level directories
-        if (_curr->fts_level == 1) {
-            if (std::find(_exclusions.begin(), _exclusions.end(), _curr->fts_name)
-                    != _exclusions.end()) {
-                return Action::FTS_Skip;
-            }
-        }
-
-        return Action::FTS_OK;
-    }
-
-    virtual int on_reached_file() override
-    {
-        dev_t dev = _curr->fts_statp->st_dev;
-        ino_t ino = _curr->fts_statp->st_ino;
-
-        // If this file has been visited before (hard link), then skip it
-        if (_links.find(dev) != _links.end()
-                && _links[dev].find(ino) != _links[dev].end()) {
-            return Action::FTS_OK;
-        }
+static bool v3_send_directory_size_progress(V3Connection &conn,
+                                            const v3::Request *msg,
+                                            uint64_t size)
+{
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
 
-        _total += _curr->fts_statp->st_size;
-        _links[dev].emplace(dev);
+    auto response = v3::CreatePathGetDirectorySizeResponse(
+            builder, true, 0, size, true);
 
-        return Action::FTS_OK;
-    }
-
-    uint64_t total() const {
-        return _total;
-    }
+    // Wrap response
+    v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
+    rb.add_response_type(v3::ResponseType_PathGetDirectorySizeResponse);
+    rb.add_response(response.Union());
+    builder.Finish(rb.Finish());
 
-private:
-    std::vector<std::string> _exclusions;
-    std::unordered_map<dev_t, std::unordered_set<ino_t>> _links;
-    uint64_t _total;
-};
+    return v3_send_response(conn, builder);
+}
 
-static bool v3_path_get_directory_size(int fd, const v3::Request *msg)
+static bool v3_path_get_directory_size(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::PathGetDirectorySizeRequest *) msg->request();
     if (!request->path()) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
     std::vector<std::string> exclusions;
@@ -623,10 +1377,22 @@ static bool v3_path_get_directory_size(int fd, const v3::Request *msg)
         }
     }
 
-    DirectorySizeGetter dsg(request->path()->c_str(), std::move(exclusions));
-    bool ret = dsg.run();
+    // Batches expect exactly one response per request
+    unsigned int progress_interval = request->progress_interval();
+    if (v3_batch_capture) {
+        progress_interval = 0;
+    }
+
+    uint64_t size = 0;
+    bool ret = util::get_directory_size(
+            request->path()->c_str(), exclusions, &size, progress_interval,
+            [&](uint64_t partial) {
+        // A failure here will also fail the final response
+        v3_send_directory_size_progress(conn, msg, partial);
+    });
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<v3::PathGetDirectorySizeResponse> response;
 
     if (!ret) {
@@ -635,25 +1401,25 @@ static bool v3_path_get_directory_size(int fd, const v3::Request *msg)
                 builder, false, error);
     } else {
         response = v3::CreatePathGetDirectorySizeResponse(
-                builder, true, 0, dsg.total());
+                builder, true, 0, size);
     }
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_PathGetDirectorySizeResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_mb_get_booted_rom_id(int fd, const v3::Request *msg)
+static bool v3_mb_get_booted_rom_id(V3Connection &conn, const v3::Request *msg)
 {
-    (void) msg;
-
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     fb::Offset<fb::String> id;
-    auto rom = Roms::get_current_rom();
+    auto rom = RomInventory::get().current_rom();
     if (rom) {
         id = builder.CreateString(rom->id);
     }
@@ -663,55 +1429,37 @@ static bool v3_mb_get_booted_rom_id(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_MbGetBootedRomIdResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_mb_get_installed_roms(int fd, const v3::Request *msg)
+static bool v3_mb_get_installed_roms(V3Connection &conn, const v3::Request *msg)
 {
-    (void) msg;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
 
-    fb::FlatBufferBuilder builder;
-
-    Roms roms;
-    roms.add_installed();
+    auto roms = RomInventory::get().installed_roms();
 
     std::vector<fb::Offset<v3::MbRom>> fb_roms;
+    fb_roms.reserve(roms->size());
 
-    for (auto r : roms.roms) {
-        std::string system_path = r->full_system_path();
-        std::string cache_path = r->full_cache_path();
-        std::string data_path = r->full_data_path();
-
-        auto fb_id = builder.CreateString(r->id);
-        auto fb_system_path = builder.CreateString(system_path);
-        auto fb_cache_path = builder.CreateString(cache_path);
-        auto fb_data_path = builder.CreateString(data_path);
+    for (const InstalledRom &r : *roms) {
+        auto fb_id = builder.CreateString(r.rom->id);
+        auto fb_system_path = builder.CreateString(r.system_path);
+        auto fb_cache_path = builder.CreateString(r.cache_path);
+        auto fb_data_path = builder.CreateString(r.data_path);
         fb::Offset<fb::String> fb_version;
         fb::Offset<fb::String> fb_build;
 
-        std::string build_prop;
-        if (r->system_is_image) {
-            build_prop += "/raw/images/";
-            build_prop += r->id;
-        } else {
-            build_prop += system_path;
-        }
-        build_prop += "/build.prop";
-
-        std::unordered_map<std::string, std::string> properties;
-        util::file_get_all_properties(build_prop, &properties);
-
-        if (properties.find("ro.build.version.release") != properties.end()) {
-            const std::string &version = properties["ro.build.version.release"];
-            fb_version = builder.CreateString(version);
+        if (!r.version.empty()) {
+            fb_version = builder.CreateString(r.version);
         }
-        if (properties.find("ro.build.display.id") != properties.end()) {
-            const std::string &build = properties["ro.build.display.id"];
-            fb_build = builder.CreateString(build);
+        if (!r.build.empty()) {
+            fb_build = builder.CreateString(r.build);
         }
 
         v3::MbRomBuilder mrb(builder);
@@ -732,18 +1480,18 @@ static bool v3_mb_get_installed_roms(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_MbGetInstalledRomsResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_mb_get_version(int fd, const v3::Request *msg)
+static bool v3_mb_get_version(V3Connection &conn, const v3::Request *msg)
 {
-    (void) msg;
-
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
 
     // Get version
     auto version = builder.CreateString(get_mbtool_version());
@@ -751,21 +1499,23 @@ static bool v3_mb_get_version(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_MbGetVersionResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_mb_set_kernel(int fd, const v3::Request *msg)
+static bool v3_mb_set_kernel(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::MbSetKernelRequest *) msg->request();
     if (!request->rom_id() || !request->boot_blockdev()) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
 
     bool success = set_kernel(request->rom_id()->c_str(),
                               request->boot_blockdev()->c_str());
@@ -775,18 +1525,19 @@ static bool v3_mb_set_kernel(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_MbSetKernelResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_mb_switch_rom(int fd, const v3::Request *msg)
+static bool v3_mb_switch_rom(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::MbSwitchRomRequest *) msg->request();
     if (!request->rom_id() || !request->boot_blockdev()) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
     std::vector<std::string> block_dev_dirs;
@@ -799,7 +1550,8 @@ static bool v3_mb_switch_rom(int fd, const v3::Request *msg)
 
     bool force_update_checksums = request->force_update_checksums();
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
 
     SwitchRomResult ret = switch_rom(request->rom_id()->c_str(),
                                      request->boot_blockdev()->c_str(),
@@ -828,18 +1580,19 @@ static bool v3_mb_switch_rom(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_MbSwitchRomResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_mb_wipe_rom(int fd, const v3::Request *msg)
+static bool v3_mb_wipe_rom(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::MbWipeRomRequest *) msg->request();
     if (!request->rom_id()) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
     // Find and verify ROM is installed
@@ -850,14 +1603,14 @@ static bool v3_mb_wipe_rom(int fd, const v3::Request *msg)
     if (!rom) {
         LOGE("Tried to wipe non-installed or invalid ROM ID: %s",
              request->rom_id()->c_str());
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
     // The GUI should check this, but we'll enforce it here
     auto current_rom = Roms::get_current_rom();
     if (current_rom && current_rom->id == rom->id) {
         LOGE("Cannot wipe currently booted ROM: %s", rom->id.c_str());
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
     // Wipe the selected targets
@@ -896,7 +1649,8 @@ static bool v3_mb_wipe_rom(int fd, const v3::Request *msg)
         }
     }
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
 
     // Create response
     auto fb_succeeded = builder.CreateVector(succeeded);
@@ -906,60 +1660,113 @@ static bool v3_mb_wipe_rom(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_MbWipeRomResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
+}
+
+// Cached package counts for each ROM. An entry is only used if packages.xml is
+// still the same file (it is always replaced by a rename when the package
+// manager writes it) with the same size and modification time.
+//
+// The cache lives as long as the process that handles the connection. With
+// the default fork-per-connection daemon, it is only reused within a single
+// connection. It is shared by all connections only with --event-loop.
+struct V3PackageCountsEntry
+{
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    PackageCounts counts;
+};
+
+static std::mutex v3_package_counts_mutex;
+static std::unordered_map<std::string, V3PackageCountsEntry> v3_package_counts;
+
+static bool v3_get_package_counts(const std::string &rom_id,
+                                  const std::string &path,
+                                  PackageCounts *counts)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("%s: Failed to open: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    auto close_fd = util::finally([&]{
+        close(fd);
+    });
+
+    struct stat sb;
+    if (fstat(fd, &sb) < 0) {
+        LOGE("%s: Failed to stat: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(v3_package_counts_mutex);
+        auto it = v3_package_counts.find(rom_id);
+        if (it != v3_package_counts.end()
+                && it->second.dev == sb.st_dev
+                && it->second.ino == sb.st_ino
+                && it->second.size == sb.st_size
+                && it->second.mtime == sb.st_mtime) {
+            *counts = it->second.counts;
+            return true;
+        }
+    }
+
+    if (!count_packages_xml(fd, counts)) {
+        return false;
+    }
+
+    V3PackageCountsEntry entry;
+    entry.dev = sb.st_dev;
+    entry.ino = sb.st_ino;
+    entry.size = sb.st_size;
+    entry.mtime = sb.st_mtime;
+    entry.counts = *counts;
+
+    std::lock_guard<std::mutex> lock(v3_package_counts_mutex);
+    v3_package_counts[rom_id] = entry;
+
+    return true;
 }
 
-static bool v3_mb_get_packages_count(int fd, const v3::Request *msg)
+static bool v3_mb_get_packages_count(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::MbGetPackagesCountRequest *) msg->request();
     if (!request->rom_id()) {
-        return v3_send_response_invalid(fd);
+        return v3_send_response_invalid(conn, msg);
     }
 
     // Find and verify ROM is installed
-    Roms roms;
-    roms.add_installed();
-
-    auto rom = roms.find_by_id(request->rom_id()->c_str());
-    if (!rom) {
-        return v3_send_response_invalid(fd);
+    auto roms = RomInventory::get().installed_roms();
+    auto rom = std::find_if(roms->begin(), roms->end(),
+                            [&](const InstalledRom &r) {
+        return r.rom->id == request->rom_id()->c_str();
+    });
+    if (rom == roms->end()) {
+        return v3_send_response_invalid(conn, msg);
     }
 
-    std::string packages_xml(rom->full_data_path());
+    std::string packages_xml(rom->data_path);
     packages_xml += "/system/packages.xml";
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
     v3::MbGetPackagesCountResponseBuilder response_builder(builder);
 
-    Packages pkgs;
-    if (pkgs.load_xml(packages_xml)) {
-        unsigned int system_pkgs = 0;
-        unsigned int update_pkgs = 0;
-        unsigned int other_pkgs = 0;
-
-        for (std::shared_ptr<Package> pkg : pkgs.pkgs) {
-            bool is_system = (pkg->pkg_flags & Package::FLAG_SYSTEM)
-                    || (pkg->pkg_public_flags & Package::PUBLIC_FLAG_SYSTEM);
-            bool is_update = (pkg->pkg_flags & Package::FLAG_UPDATED_SYSTEM_APP)
-                    || (pkg->pkg_public_flags & Package::PUBLIC_FLAG_UPDATED_SYSTEM_APP);
-
-            if (is_update) {
-                ++update_pkgs;
-            } else if (is_system) {
-                ++system_pkgs;
-            } else {
-                ++other_pkgs;
-            }
-        }
-
+    PackageCounts counts;
+    if (v3_get_package_counts(rom->rom->id, packages_xml, &counts)) {
         response_builder.add_success(true);
-        response_builder.add_system_packages(system_pkgs);
-        response_builder.add_system_update_packages(update_pkgs);
-        response_builder.add_non_system_packages(other_pkgs);
+        response_builder.add_system_packages(counts.system);
+        response_builder.add_system_update_packages(counts.system_update);
+        response_builder.add_non_system_packages(counts.other);
     } else {
         response_builder.add_success(false);
     }
@@ -968,18 +1775,80 @@ static bool v3_mb_get_packages_count(int fd, const v3::Request *msg)
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_MbGetPackagesCountResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
+}
+
+static bool v3_mb_get_stats(V3Connection &conn, const v3::Request *msg)
+{
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
+
+    DaemonStats &stats = daemon_stats();
+
+    // The counters are read individually, so the snapshot is not atomic as a
+    // whole. This is fine for monitoring purposes.
+    std::vector<fb::Offset<v3::MbRequestStats>> fb_requests;
+    for (unsigned int type = 0; type < DAEMON_STATS_MAX_REQUEST_TYPES; ++type) {
+        DaemonRequestStats &rs = stats.requests[type];
+
+        uint64_t count = rs.count.load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+
+        uint64_t buckets[DAEMON_STATS_LATENCY_BUCKETS];
+        for (unsigned int i = 0; i < DAEMON_STATS_LATENCY_BUCKETS; ++i) {
+            buckets[i] = rs.latency[i].load(std::memory_order_relaxed);
+        }
+
+        auto fb_histogram = builder.CreateVector(
+                buckets, DAEMON_STATS_LATENCY_BUCKETS);
+        fb_requests.push_back(v3::CreateMbRequestStats(
+                builder, type, count,
+                rs.errors.load(std::memory_order_relaxed),
+                rs.total_time_us.load(std::memory_order_relaxed),
+                rs.max_time_us.load(std::memory_order_relaxed),
+                fb_histogram));
+    }
+
+    auto fb_requests_vec = builder.CreateVector(fb_requests);
+
+    // Create response
+    auto response = v3::CreateMbGetStatsResponse(
+            builder,
+            daemon_stats_uptime_us(),
+            stats.connections_total.load(std::memory_order_relaxed),
+            stats.connections_active.load(std::memory_order_relaxed),
+            stats.connections_rejected.load(std::memory_order_relaxed),
+            stats.bytes_read.load(std::memory_order_relaxed),
+            stats.bytes_written.load(std::memory_order_relaxed),
+            stats.workers_active.load(std::memory_order_relaxed),
+            stats.workers_peak.load(std::memory_order_relaxed),
+            stats.commands.forks.load(std::memory_order_relaxed),
+            stats.commands.execs.load(std::memory_order_relaxed),
+            fb_requests_vec);
+
+    // Wrap response
+    v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
+    rb.add_response_type(v3::ResponseType_MbGetStatsResponse);
+    rb.add_response(response.Union());
+    builder.Finish(rb.Finish());
+
+    return v3_send_response(conn, builder);
 }
 
-static bool v3_reboot(int fd, const v3::Request *msg)
+static bool v3_reboot(V3Connection &conn, const v3::Request *msg)
 {
     auto request = (v3::RebootRequest *) msg->request();
 
-    fb::FlatBufferBuilder builder;
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
 
     std::string reboot_arg;
     if (request->arg()) {
@@ -987,107 +1856,334 @@ static bool v3_reboot(int fd, const v3::Request *msg)
     }
 
     // The client probably won't get the chance to see the success message, but
-    // we'll still send it for the sake of symmetry
-    bool success = reboot_via_init(reboot_arg);
+    // we'll still send it for the sake of symmetry. Only the property is set
+    // here (init performs the reboot), so the worker returns instead of
+    // pausing forever and nothing has to be forked from a multithreaded
+    // daemon.
+    bool success = request_reboot_via_init(reboot_arg);
 
     // Create response
     auto response = v3::CreateRebootResponse(builder, success);
 
     // Wrap response
     v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
     rb.add_response_type(v3::ResponseType_RebootResponse);
     rb.add_response(response.Union());
     builder.Finish(rb.Finish());
 
-    return v3_send_response(fd, builder);
+    return v3_send_response(conn, builder);
 }
 
-bool connection_version_3(int fd)
+// NOTE: A false return value indicates a connection error, not a command
+//       failure!
+static bool v3_dispatch(V3Connection &conn, const v3::Request *request);
+
+// Requests that write out-of-band data to the socket cannot be captured and
+// nested batches are not allowed
+static bool v3_batch_allowed(v3::RequestType type)
 {
-    std::string command;
+    switch (type) {
+    case v3::RequestType_FileOpenFdRequest:
+    case v3::RequestType_FileReadStreamRequest:
+    case v3::RequestType_FileWriteStreamRequest:
+    case v3::RequestType_BatchRequest:
+        return false;
+    default:
+        return true;
+    }
+}
 
-    auto close_all_fds = util::finally([&]{
-        // Ensure opened fd's are closed if the connection is lost
-        for (auto &p : fd_map) {
-            close(p.second);
-        }
-        fd_map.clear();
-    });
+static bool v3_batch(V3Connection &conn, const v3::Request *msg)
+{
+    auto request = (v3::BatchRequest *) msg->request();
 
-    while (1) {
-        std::vector<uint8_t> data;
-        if (!util::socket_read_bytes(fd, &data)) {
-            return false;
-        }
+    auto builder_ptr = conn.get_builder();
+    fb::FlatBufferBuilder &builder = *builder_ptr;
 
-        auto verifier = fb::Verifier(data.data(), data.size());
-        if (!v3::VerifyRequestBuffer(verifier)) {
-            LOGE("Received invalid buffer");
-            return false;
+    V3BatchCapture capture;
+    capture.builder = &builder;
+
+    auto requests = request->requests();
+    if (requests) {
+        capture.results.reserve(requests->size());
+
+        v3_batch_capture = &capture;
+
+        for (fb::uoffset_t i = 0; i < requests->size(); ++i) {
+            const v3::Request *sub = requests->Get(i);
+            size_t n_results = capture.results.size();
+
+            if (!v3_batch_allowed(sub->request_type())) {
+                v3_send_response_unsupported(conn, sub);
+                continue;
+            }
+
+            // A sub-request failing does not stop the batch. Every item must
+            // still have exactly one result.
+            if (!v3_dispatch(conn, sub)) {
+                LOGW("Batch item %u (%s) failed", i,
+                     v3::EnumNameRequestType(sub->request_type()));
+            }
+            if (capture.results.size() == n_results) {
+                v3_send_response_invalid(conn, sub);
+            }
         }
 
-        const v3::Request *request = v3::GetRequest(data.data());
-        v3::RequestType type = request->request_type();
-
-        // NOTE: A false return value indicates a connection error, not a
-        //       command failure!
-        bool ret = true;
-
-        if (type == v3::RequestType_FileChmodRequest) {
-            ret = v3_file_chmod(fd, request);
-        } else if (type == v3::RequestType_FileCloseRequest) {
-            ret = v3_file_close(fd, request);
-        } else if (type == v3::RequestType_FileOpenRequest) {
-            ret = v3_file_open(fd, request);
-        } else if (type == v3::RequestType_FileReadRequest) {
-            ret = v3_file_read(fd, request);
-        } else if (type == v3::RequestType_FileSeekRequest) {
-            ret = v3_file_seek(fd, request);
-        } else if (type == v3::RequestType_FileSELinuxGetLabelRequest) {
-            ret = v3_file_selinux_get_label(fd, request);
-        } else if (type == v3::RequestType_FileSELinuxSetLabelRequest) {
-            ret = v3_file_selinux_set_label(fd, request);
-        } else if (type == v3::RequestType_FileStatRequest) {
-            ret = v3_file_stat(fd, request);
-        } else if (type == v3::RequestType_FileWriteRequest) {
-            ret = v3_file_write(fd, request);
-        } else if (type == v3::RequestType_PathChmodRequest) {
-            ret = v3_path_chmod(fd, request);
-        } else if (type == v3::RequestType_PathCopyRequest) {
-            ret = v3_path_copy(fd, request);
-        } else if (type == v3::RequestType_PathSELinuxGetLabelRequest) {
-            ret = v3_path_selinux_get_label(fd, request);
-        } else if (type == v3::RequestType_PathSELinuxSetLabelRequest) {
-            ret = v3_path_selinux_set_label(fd, request);
-        } else if (type == v3::RequestType_PathGetDirectorySizeRequest) {
-            ret = v3_path_get_directory_size(fd, request);
-        } else if (type == v3::RequestType_MbGetBootedRomIdRequest) {
-            ret = v3_mb_get_booted_rom_id(fd, request);
-        } else if (type == v3::RequestType_MbGetInstalledRomsRequest) {
-            ret = v3_mb_get_installed_roms(fd, request);
-        } else if (type == v3::RequestType_MbGetVersionRequest) {
-            ret = v3_mb_get_version(fd, request);
-        } else if (type == v3::RequestType_MbSetKernelRequest) {
-            ret = v3_mb_set_kernel(fd, request);
-        } else if (type == v3::RequestType_MbSwitchRomRequest) {
-            ret = v3_mb_switch_rom(fd, request);
-        } else if (type == v3::RequestType_MbWipeRomRequest) {
-            ret = v3_mb_wipe_rom(fd, request);
-        } else if (type == v3::RequestType_MbGetPackagesCountRequest) {
-            ret = v3_mb_get_packages_count(fd, request);
-        } else if (type == v3::RequestType_RebootRequest) {
-            ret = v3_reboot(fd, request);
-        } else {
-            // Invalid command; allow further commands
-            ret = v3_send_response_unsupported(fd);
+        v3_batch_capture = nullptr;
+    }
+
+    auto results = builder.CreateVector(capture.results);
+    auto response = v3::CreateBatchResponse(builder, results);
+
+    // Wrap response
+    v3::ResponseBuilder rb(builder);
+    rb.add_id(msg->id());
+    rb.add_response_type(v3::ResponseType_BatchResponse);
+    rb.add_response(response.Union());
+    builder.Finish(rb.Finish());
+
+    return v3_send_response(conn, builder);
+}
+
+static bool v3_dispatch_request(V3Connection &conn,
+                                const v3::Request *request)
+{
+    v3::RequestType type = request->request_type();
+
+    if (type == v3::RequestType_FileChmodRequest) {
+        return v3_file_chmod(conn, request);
+    } else if (type == v3::RequestType_FileCloseRequest) {
+        return v3_file_close(conn, request);
+    } else if (type == v3::RequestType_FileOpenRequest) {
+        return v3_file_open(conn, request);
+    } else if (type == v3::RequestType_FileReadRequest) {
+        return v3_file_read(conn, request);
+    } else if (type == v3::RequestType_FileSeekRequest) {
+        return v3_file_seek(conn, request);
+    } else if (type == v3::RequestType_FileSELinuxGetLabelRequest) {
+        return v3_file_selinux_get_label(conn, request);
+    } else if (type == v3::RequestType_FileSELinuxSetLabelRequest) {
+        return v3_file_selinux_set_label(conn, request);
+    } else if (type == v3::RequestType_FileStatRequest) {
+        return v3_file_stat(conn, request);
+    } else if (type == v3::RequestType_FileWriteRequest) {
+        return v3_file_write(conn, request);
+    } else if (type == v3::RequestType_PathChmodRequest) {
+        return v3_path_chmod(conn, request);
+    } else if (type == v3::RequestType_PathCopyRequest) {
+        return v3_path_copy(conn, request);
+    } else if (type == v3::RequestType_PathCopyStartRequest) {
+        return v3_path_copy_start(conn, request);
+    } else if (type == v3::RequestType_PathCopyStatusRequest) {
+        return v3_path_copy_status(conn, request);
+    } else if (type == v3::RequestType_PathCopyCancelRequest) {
+        return v3_path_copy_cancel(conn, request);
+    } else if (type == v3::RequestType_PathSELinuxGetLabelRequest) {
+        return v3_path_selinux_get_label(conn, request);
+    } else if (type == v3::RequestType_PathSELinuxSetLabelRequest) {
+        return v3_path_selinux_set_label(conn, request);
+    } else if (type == v3::RequestType_PathGetDirectorySizeRequest) {
+        return v3_path_get_directory_size(conn, request);
+    } else if (type == v3::RequestType_MbGetBootedRomIdRequest) {
+        return v3_mb_get_booted_rom_id(conn, request);
+    } else if (type == v3::RequestType_MbGetInstalledRomsRequest) {
+        return v3_mb_get_installed_roms(conn, request);
+    } else if (type == v3::RequestType_MbGetVersionRequest) {
+        return v3_mb_get_version(conn, request);
+    } else if (type == v3::RequestType_MbSetKernelRequest) {
+        return v3_mb_set_kernel(conn, request);
+    } else if (type == v3::RequestType_MbSwitchRomRequest) {
+        return v3_mb_switch_rom(conn, request);
+    } else if (type == v3::RequestType_MbWipeRomRequest) {
+        return v3_mb_wipe_rom(conn, request);
+    } else if (type == v3::RequestType_MbGetPackagesCountRequest) {
+        return v3_mb_get_packages_count(conn, request);
+    } else if (type == v3::RequestType_RebootRequest) {
+        return v3_reboot(conn, request);
+    } else if (type == v3::RequestType_FileOpenFdRequest) {
+        return v3_file_open_fd(conn, request);
+    } else if (type == v3::RequestType_FileReadStreamRequest) {
+        return v3_file_read_stream(conn, request);
+    } else if (type == v3::RequestType_FileWriteStreamRequest) {
+        return v3_file_write_stream(conn, request);
+    } else if (type == v3::RequestType_BatchRequest) {
+        return v3_batch(conn, request);
+    } else if (type == v3::RequestType_MbGetStatsRequest) {
+        return v3_mb_get_stats(conn, request);
+    } else {
+        // Invalid command; allow further commands
+        return v3_send_response_unsupported(conn, request);
+    }
+}
+
+// Handles the request and records its latency. Batch items are recorded
+// individually in addition to the batch itself.
+static bool v3_dispatch(V3Connection &conn, const v3::Request *request)
+{
+    uint64_t start = util::monotonic_time_us();
+    bool ret = v3_dispatch_request(conn, request);
+    daemon_stats_record_request(request->request_type(),
+                                util::monotonic_time_us() - start, ret);
+    return ret;
+}
+
+// Returns the key that orders the request with respect to other requests in the
+// worker pool. Requests for the same open file are executed in order and
+// requests that change the multiboot state or reboot the device are never run
+// concurrently with each other.
+template<typename T>
+static uint64_t v3_file_key(const v3::Request *request)
+{
+    auto r = static_cast<const T *>(request->request());
+    return V3_KEY_FILE | static_cast<uint32_t>(r->id());
+}
+
+static uint64_t v3_request_key(const v3::Request *request)
+{
+    switch (request->request_type()) {
+    case v3::RequestType_FileChmodRequest:
+        return v3_file_key<v3::FileChmodRequest>(request);
+    case v3::RequestType_FileCloseRequest:
+        return v3_file_key<v3::FileCloseRequest>(request);
+    case v3::RequestType_FileReadRequest:
+        return v3_file_key<v3::FileReadRequest>(request);
+    case v3::RequestType_FileSeekRequest:
+        return v3_file_key<v3::FileSeekRequest>(request);
+    case v3::RequestType_FileSELinuxGetLabelRequest:
+        return v3_file_key<v3::FileSELinuxGetLabelRequest>(request);
+    case v3::RequestType_FileSELinuxSetLabelRequest:
+        return v3_file_key<v3::FileSELinuxSetLabelRequest>(request);
+    case v3::RequestType_FileStatRequest:
+        return v3_file_key<v3::FileStatRequest>(request);
+    case v3::RequestType_FileWriteRequest:
+        return v3_file_key<v3::FileWriteRequest>(request);
+    case v3::RequestType_FileReadStreamRequest:
+        return v3_file_key<v3::FileReadStreamRequest>(request);
+    case v3::RequestType_MbSetKernelRequest:
+    case v3::RequestType_MbSwitchRomRequest:
+    case v3::RequestType_MbWipeRomRequest:
+    case v3::RequestType_RebootRequest:
+        return V3_KEY_STATE;
+    default:
+        return 0;
+    }
+}
+
+static util::ThreadPool & v3_pool()
+{
+    static util::ThreadPool pool(V3_MAX_WORKERS);
+    return pool;
+}
+
+static std::atomic<uint64_t> v3_next_session_id(1);
+
+V3Session::V3Session(int fd)
+    : _fd(fd),
+      _conn(new V3Connection(fd)),
+      _key_base(v3_next_session_id.fetch_add(1, std::memory_order_relaxed)
+              << V3_KEY_SESSION_SHIFT),
+      _pending(0)
+{
+}
+
+V3Session::~V3Session()
+{
+    // In-flight requests must finish before the connection closes its open
+    // files
+    wait_idle();
+}
+
+void V3Session::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(_pending_mutex);
+    _pending_cv.wait(lock, [&]{ return _pending == 0; });
+}
+
+/*!
+ * \brief Read and handle a single request
+ *
+ * Requests with a non-zero ID are queued on the shared worker pool and
+ * their responses are sent asynchronously.
+ *
+ * \return False if the connection should be closed
+ */
+bool V3Session::handle_request()
+{
+    V3Connection &conn = *_conn;
+
+    // Receive buffers are reused across requests to avoid an allocation per
+    // message
+    V3BufferPtr data = conn.get_buffer();
+    if (conn.failed() || !util::socket_read_bytes(_fd, data.get())) {
+        return false;
+    }
+
+    daemon_stats_add_read(sizeof(int32_t) + data->size());
+
+    auto verifier = fb::Verifier(data->data(), data->size());
+    if (!v3::VerifyRequestBuffer(verifier)) {
+        LOGE("Received invalid buffer");
+        return false;
+    }
+
+    const v3::Request *request = v3::GetRequest(data->data());
+
+    // Streaming writes are followed by raw data, which must be consumed before
+    // the next request can be read. Batches may touch any open file or the
+    // multiboot state, so they cannot be ordered by a single key and are run
+    // by themselves instead.
+    if (request->id() == 0
+            || request->request_type() == v3::RequestType_FileWriteStreamRequest
+            || request->request_type() == v3::RequestType_BatchRequest) {
+        // Requests without an ID keep the original semantics: they run after
+        // everything before them has completed
+        wait_idle();
+        return !conn.failed() && v3_dispatch(conn, request);
+    } else {
+        // The response is tagged with the request ID and may be sent out of
+        // order. std::function must be copyable, so the buffer is handed to
+        // the task as a raw pointer and re-adopted there.
+        std::vector<uint8_t> *raw = data.release();
+
+        uint64_t key = v3_request_key(request);
+        if (key != 0) {
+            key |= _key_base;
         }
 
-        if (!ret) {
-            return false;
+        {
+            std::lock_guard<std::mutex> lock(_pending_mutex);
+            ++_pending;
         }
+
+        v3_pool().submit([this, &conn, raw]{
+            {
+                V3BufferPtr owned = conn.adopt_buffer(raw);
+                daemon_stats_worker_begin();
+                if (!v3_dispatch(conn, v3::GetRequest(owned->data()))) {
+                    conn.fail();
+                }
+                daemon_stats_worker_end();
+            }
+
+            // The buffer was returned to the connection above, so the session
+            // may now be destroyed
+            std::lock_guard<std::mutex> lock(_pending_mutex);
+            if (--_pending == 0) {
+                _pending_cv.notify_all();
+            }
+        }, key);
+        return true;
     }
+}
 
-    return true;
+bool connection_version_3(int fd)
+{
+    V3Session session(fd);
+
+    while (session.handle_request());
+
+    return false;
 }
 
-}
\ No newline at end of file
+}
@@ -19,9 +19,46 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include <cstdint>
+
 namespace mb
 {
 
+class V3Connection;
+
+// Protocol version 3 state for a single client connection. This allows
+// requests to be handled one at a time as they become readable instead of
+// dedicating a thread or process to the connection.
+class V3Session
+{
+public:
+    explicit V3Session(int fd);
+    ~V3Session();
+
+    bool handle_request();
+
+    V3Session(const V3Session &) = delete;
+    V3Session & operator=(const V3Session &) = delete;
+
+private:
+    void wait_idle();
+
+    int _fd;
+    std::unique_ptr<V3Connection> _conn;
+    // Requests run on a pool shared by all sessions. The session ID is mixed
+    // into the ordering keys so that sessions are not serialized against each
+    // other.
+    uint64_t _key_base;
+    // Requests of this session that are queued or running
+    std::mutex _pending_mutex;
+    std::condition_variable _pending_cv;
+    unsigned int _pending;
+};
+
 bool connection_version_3(int fd);
 
 }
\ No newline at end of file
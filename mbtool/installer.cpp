@@ -43,10 +43,10 @@
 
 // Local
 #include "autoclose/file.h"
+#include "checksums.h"
 #include "image.h"
 #include "main.h"
 #include "multiboot.h"
-#include "switcher.h"
 #include "util/archive.h"
 #include "util/chmod.h"
 #include "util/chown.h"
@@ -1534,10 +1534,12 @@ Installer::ProceedState Installer::install_stage_finish()
         SHA512(bootimg.data(), bootimg.size(), digest);
         std::string hash = util::hex_string(digest, SHA512_DIGEST_LENGTH);
 
-        std::unordered_map<std::string, std::string> props;
-        checksums_read(&props);
-        checksums_update(&props, _rom->id, "boot.img", hash);
-        checksums_write(props);
+        ChecksumStore checksums;
+        if (!checksums.set(_rom->id, "boot.img", CHECKSUMS_ALGO_SHA512, hash)) {
+            LOGE("Failed to update boot image checksum");
+            display_msg("Failed to update boot image checksum");
+            return ProceedState::Fail;
+        }
     }
 
     fix_multiboot_permissions();
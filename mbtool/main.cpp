@@ -34,6 +34,7 @@
 #else
 #include "appsync.h"
 #include "daemon.h"
+#include "daemon_bench.h"
 #include "init.h"
 #include "miniadbd.h"
 #include "mount_fstab.h"
@@ -75,6 +76,7 @@ struct tool tools[] = {
     { "adbd", mb::miniadbd_main },
     { "appsync", mb::appsync_main },
     { "daemon", mb::daemon_main },
+    { "daemon_bench", mb::daemon_bench_main },
     { "init", mb::init_main },
     { "miniadbd", mb::miniadbd_main },
     { "mount_fstab", mb::mount_fstab_main },
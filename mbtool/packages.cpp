@@ -22,13 +22,18 @@
 #include <algorithm>
 
 #include <cassert>
+#include <cctype>
+#include <cerrno>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 
+#include <unistd.h>
+
 #include <pugixml.hpp>
 
 #include "util/logging.h"
+#include "util/string.h"
 
 
 namespace mb
@@ -576,4 +581,179 @@ std::shared_ptr<Package> Packages::find_by_pkg(const std::string &pkg_id) const
     return it == pkgs.end() ? std::shared_ptr<Package>() : *it;
 }
 
+// Parse the attributes of a start tag (excluding the tag name) and return the
+// package's flags. Attribute values are not unescaped since only the numeric
+// flags are needed.
+static void scan_package_flags(const std::string &tag, size_t pos,
+                               uint64_t *flags, uint64_t *public_flags)
+{
+    const size_t size = tag.size();
+
+    while (true) {
+        while (pos < size && isspace(tag[pos])) {
+            ++pos;
+        }
+        if (pos >= size || tag[pos] == '/') {
+            break;
+        }
+
+        size_t name_begin = pos;
+        while (pos < size && tag[pos] != '=' && !isspace(tag[pos])) {
+            ++pos;
+        }
+        size_t name_end = pos;
+
+        while (pos < size && (isspace(tag[pos]) || tag[pos] == '=')) {
+            ++pos;
+        }
+        if (pos >= size || (tag[pos] != '"' && tag[pos] != '\'')) {
+            break;
+        }
+
+        char quote = tag[pos++];
+        size_t value_begin = pos;
+        while (pos < size && tag[pos] != quote) {
+            ++pos;
+        }
+        std::string value = tag.substr(value_begin, pos - value_begin);
+        ++pos;
+
+        size_t name_len = name_end - name_begin;
+        if (tag.compare(name_begin, name_len, ATTR_FLAGS) == 0) {
+            *flags = strtoll(value.c_str(), nullptr, 10);
+        } else if (tag.compare(name_begin, name_len, ATTR_PUBLIC_FLAGS) == 0) {
+            *public_flags = strtoll(value.c_str(), nullptr, 10);
+        }
+    }
+}
+
+/*!
+ * \brief Count the system, updated system, and other packages in packages.xml
+ *
+ * Unlike Packages::load_xml(), this does not build a DOM or any Package
+ * objects. The file is scanned tag by tag and only the flags of the <package>
+ * elements directly within <packages> are looked at.
+ *
+ * \return False if the file could not be read or is not a packages.xml file
+ */
+bool count_packages_xml(int fd, PackageCounts *counts)
+{
+    enum class State
+    {
+        TEXT,
+        TAG,
+    };
+
+    State state = State::TEXT;
+    std::string tag;
+    char quote = '\0';
+    int depth = 0;
+    int packages_depth = -1;
+    PackageCounts result = {};
+
+    char buf[65536];
+    ssize_t n;
+
+    while ((n = read(fd, buf, sizeof(buf))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGE("Failed to read packages.xml: %s", strerror(errno));
+            return false;
+        }
+
+        for (ssize_t i = 0; i < n; ++i) {
+            char c = buf[i];
+
+            if (state == State::TEXT) {
+                if (c == '<') {
+                    state = State::TAG;
+                    tag.clear();
+                    quote = '\0';
+                }
+                continue;
+            }
+
+            if (quote) {
+                if (c == quote) {
+                    quote = '\0';
+                }
+                tag += c;
+                continue;
+            } else if ((c == '"' || c == '\'') && tag[0] != '!') {
+                quote = c;
+                tag += c;
+                continue;
+            } else if (c != '>') {
+                tag += c;
+                continue;
+            } else if (util::starts_with(tag, "!--") && (tag.size() < 5
+                    || tag.compare(tag.size() - 2, 2, "--") != 0)) {
+                // '>' within a comment
+                tag += c;
+                continue;
+            }
+
+            // Complete tag
+            state = State::TEXT;
+
+            if (tag.empty() || tag[0] == '?' || tag[0] == '!') {
+                // Declarations, processing instructions, and comments
+                continue;
+            } else if (tag[0] == '/') {
+                --depth;
+                if (depth == packages_depth) {
+                    // No need to read the rest of the file
+                    *counts = result;
+                    return true;
+                }
+                continue;
+            }
+
+            bool self_closing = tag.back() == '/';
+
+            size_t name_end = 0;
+            while (name_end < tag.size() && !isspace(tag[name_end])
+                    && tag[name_end] != '/') {
+                ++name_end;
+            }
+
+            if (packages_depth < 0
+                    && tag.compare(0, name_end, TAG_PACKAGES) == 0) {
+                packages_depth = depth;
+            } else if (packages_depth >= 0 && depth == packages_depth + 1
+                    && tag.compare(0, name_end, TAG_PACKAGE) == 0) {
+                uint64_t flags = 0;
+                uint64_t public_flags = 0;
+                scan_package_flags(tag, name_end, &flags, &public_flags);
+
+                bool is_system = (flags & Package::FLAG_SYSTEM)
+                        || (public_flags & Package::PUBLIC_FLAG_SYSTEM);
+                bool is_update = (flags & Package::FLAG_UPDATED_SYSTEM_APP)
+                        || (public_flags & Package::PUBLIC_FLAG_UPDATED_SYSTEM_APP);
+
+                if (is_update) {
+                    ++result.system_update;
+                } else if (is_system) {
+                    ++result.system;
+                } else {
+                    ++result.other;
+                }
+            }
+
+            if (!self_closing) {
+                ++depth;
+            }
+        }
+    }
+
+    if (packages_depth < 0) {
+        LOGE("No <%s> element found in packages.xml", TAG_PACKAGES);
+    } else {
+        LOGE("Unexpected end of file in packages.xml");
+    }
+    return false;
+}
+
 }
@@ -158,4 +158,13 @@ public:
     std::shared_ptr<Package> find_by_pkg(const std::string &pkg_id) const;
 };
 
+struct PackageCounts
+{
+    unsigned int system;
+    unsigned int system_update;
+    unsigned int other;
+};
+
+bool count_packages_xml(int fd, PackageCounts *counts);
+
 }
@@ -0,0 +1,297 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_FILEREADSTREAM_MBTOOL_DAEMON_V3_H_
+#define FLATBUFFERS_GENERATED_FILEREADSTREAM_MBTOOL_DAEMON_V3_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "file_chmod_generated.h"
+#include "file_close_generated.h"
+#include "file_open_generated.h"
+#include "file_open_fd_generated.h"
+#include "file_read_generated.h"
+#include "file_seek_generated.h"
+#include "file_selinux_get_label_generated.h"
+#include "file_selinux_set_label_generated.h"
+#include "file_stat_generated.h"
+#include "file_write_generated.h"
+#include "mb_get_booted_rom_id_generated.h"
+#include "mb_get_installed_roms_generated.h"
+#include "mb_get_packages_count_generated.h"
+#include "mb_get_version_generated.h"
+#include "mb_set_kernel_generated.h"
+#include "mb_switch_rom_generated.h"
+#include "mb_wipe_rom_generated.h"
+#include "path_chmod_generated.h"
+#include "path_copy_generated.h"
+#include "path_get_directory_size_generated.h"
+#include "path_selinux_get_label_generated.h"
+#include "path_selinux_set_label_generated.h"
+#include "reboot_generated.h"
+
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileChmodRequest;
+struct FileChmodResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileCloseRequest;
+struct FileCloseResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileOpenRequest;
+struct FileOpenResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileReadRequest;
+struct FileReadResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSeekRequest;
+struct FileSeekResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct StructStat;
+struct FileStatRequest;
+struct FileStatResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileWriteRequest;
+struct FileWriteResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSELinuxGetLabelRequest;
+struct FileSELinuxGetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSELinuxSetLabelRequest;
+struct FileSELinuxSetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathChmodRequest;
+struct PathChmodResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyRequest;
+struct PathCopyResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathSELinuxGetLabelRequest;
+struct PathSELinuxGetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathSELinuxSetLabelRequest;
+struct PathSELinuxSetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathGetDirectorySizeRequest;
+struct PathGetDirectorySizeResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetVersionRequest;
+struct MbGetVersionResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbRom;
+struct MbGetInstalledRomsRequest;
+struct MbGetInstalledRomsResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetBootedRomIdRequest;
+struct MbGetBootedRomIdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbSwitchRomRequest;
+struct MbSwitchRomResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbSetKernelRequest;
+struct MbSetKernelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbWipeRomRequest;
+struct MbWipeRomResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetPackagesCountRequest;
+struct MbGetPackagesCountResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct RebootRequest;
+struct RebootResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileOpenFdRequest;
+struct FileOpenFdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+
+struct FileReadStreamRequest;
+struct FileReadStreamResponse;
+
+struct FileReadStreamRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  int32_t id() const { return GetField<int32_t>(4, 0); }
+  uint64_t count() const { return GetField<uint64_t>(6, 0); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<int32_t>(verifier, 4 /* id */) &&
+           VerifyField<uint64_t>(verifier, 6 /* count */) &&
+           verifier.EndTable();
+  }
+};
+
+struct FileReadStreamRequestBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_id(int32_t id) { fbb_.AddElement<int32_t>(4, id, 0); }
+  void add_count(uint64_t count) { fbb_.AddElement<uint64_t>(6, count, 0); }
+  FileReadStreamRequestBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  FileReadStreamRequestBuilder &operator=(const FileReadStreamRequestBuilder &);
+  flatbuffers::Offset<FileReadStreamRequest> Finish() {
+    auto o = flatbuffers::Offset<FileReadStreamRequest>(fbb_.EndTable(start_, 2));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<FileReadStreamRequest> CreateFileReadStreamRequest(flatbuffers::FlatBufferBuilder &_fbb,
+   int32_t id = 0,
+   uint64_t count = 0) {
+  FileReadStreamRequestBuilder builder_(_fbb);
+  builder_.add_count(count);
+  builder_.add_id(id);
+  return builder_.Finish();
+}
+
+struct FileReadStreamResponse FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  uint8_t success() const { return GetField<uint8_t>(4, 0); }
+  const flatbuffers::String *error_msg() const { return GetPointer<const flatbuffers::String *>(6); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint8_t>(verifier, 4 /* success */) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 6 /* error_msg */) &&
+           verifier.Verify(error_msg()) &&
+           verifier.EndTable();
+  }
+};
+
+struct FileReadStreamResponseBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_success(uint8_t success) { fbb_.AddElement<uint8_t>(4, success, 0); }
+  void add_error_msg(flatbuffers::Offset<flatbuffers::String> error_msg) { fbb_.AddOffset(6, error_msg); }
+  FileReadStreamResponseBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  FileReadStreamResponseBuilder &operator=(const FileReadStreamResponseBuilder &);
+  flatbuffers::Offset<FileReadStreamResponse> Finish() {
+    auto o = flatbuffers::Offset<FileReadStreamResponse>(fbb_.EndTable(start_, 2));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<FileReadStreamResponse> CreateFileReadStreamResponse(flatbuffers::FlatBufferBuilder &_fbb,
+   uint8_t success = 0,
+   flatbuffers::Offset<flatbuffers::String> error_msg = 0) {
+  FileReadStreamResponseBuilder builder_(_fbb);
+  builder_.add_error_msg(error_msg);
+  builder_.add_success(success);
+  return builder_.Finish();
+}
+
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+
+#endif  // FLATBUFFERS_GENERATED_FILEREADSTREAM_MBTOOL_DAEMON_V3_H_
@@ -0,0 +1,406 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_MBGETSTATS_MBTOOL_DAEMON_V3_H_
+#define FLATBUFFERS_GENERATED_MBGETSTATS_MBTOOL_DAEMON_V3_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "file_chmod_generated.h"
+#include "file_close_generated.h"
+#include "file_open_generated.h"
+#include "file_open_fd_generated.h"
+#include "file_read_generated.h"
+#include "file_read_stream_generated.h"
+#include "file_seek_generated.h"
+#include "file_selinux_get_label_generated.h"
+#include "file_selinux_set_label_generated.h"
+#include "file_stat_generated.h"
+#include "file_write_generated.h"
+#include "file_write_stream_generated.h"
+#include "mb_get_booted_rom_id_generated.h"
+#include "mb_get_installed_roms_generated.h"
+#include "mb_get_packages_count_generated.h"
+#include "mb_get_version_generated.h"
+#include "mb_set_kernel_generated.h"
+#include "mb_switch_rom_generated.h"
+#include "mb_wipe_rom_generated.h"
+#include "path_chmod_generated.h"
+#include "path_copy_generated.h"
+#include "path_get_directory_size_generated.h"
+#include "path_selinux_get_label_generated.h"
+#include "path_selinux_set_label_generated.h"
+#include "reboot_generated.h"
+
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileChmodRequest;
+struct FileChmodResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileCloseRequest;
+struct FileCloseResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileOpenRequest;
+struct FileOpenResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileReadRequest;
+struct FileReadResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSeekRequest;
+struct FileSeekResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct StructStat;
+struct FileStatRequest;
+struct FileStatResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileWriteRequest;
+struct FileWriteResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSELinuxGetLabelRequest;
+struct FileSELinuxGetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSELinuxSetLabelRequest;
+struct FileSELinuxSetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathChmodRequest;
+struct PathChmodResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyRequest;
+struct PathCopyResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathSELinuxGetLabelRequest;
+struct PathSELinuxGetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathSELinuxSetLabelRequest;
+struct PathSELinuxSetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathGetDirectorySizeRequest;
+struct PathGetDirectorySizeResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetVersionRequest;
+struct MbGetVersionResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbRom;
+struct MbGetInstalledRomsRequest;
+struct MbGetInstalledRomsResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetBootedRomIdRequest;
+struct MbGetBootedRomIdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbSwitchRomRequest;
+struct MbSwitchRomResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbSetKernelRequest;
+struct MbSetKernelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbWipeRomRequest;
+struct MbWipeRomResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetPackagesCountRequest;
+struct MbGetPackagesCountResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct RebootRequest;
+struct RebootResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileOpenFdRequest;
+struct FileOpenFdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileReadStreamRequest;
+struct FileReadStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileWriteStreamRequest;
+struct FileWriteStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+
+struct MbRequestStats;
+struct MbGetStatsRequest;
+struct MbGetStatsResponse;
+
+struct MbRequestStats FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  uint8_t request_type() const { return GetField<uint8_t>(4, 0); }
+  uint64_t count() const { return GetField<uint64_t>(6, 0); }
+  uint64_t errors() const { return GetField<uint64_t>(8, 0); }
+  uint64_t total_time_us() const { return GetField<uint64_t>(10, 0); }
+  uint64_t max_time_us() const { return GetField<uint64_t>(12, 0); }
+  const flatbuffers::Vector<uint64_t> *latency_histogram() const { return GetPointer<const flatbuffers::Vector<uint64_t> *>(14); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint8_t>(verifier, 4 /* request_type */) &&
+           VerifyField<uint64_t>(verifier, 6 /* count */) &&
+           VerifyField<uint64_t>(verifier, 8 /* errors */) &&
+           VerifyField<uint64_t>(verifier, 10 /* total_time_us */) &&
+           VerifyField<uint64_t>(verifier, 12 /* max_time_us */) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 14 /* latency_histogram */) &&
+           verifier.Verify(latency_histogram()) &&
+           verifier.EndTable();
+  }
+};
+
+struct MbRequestStatsBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_request_type(uint8_t request_type) { fbb_.AddElement<uint8_t>(4, request_type, 0); }
+  void add_count(uint64_t count) { fbb_.AddElement<uint64_t>(6, count, 0); }
+  void add_errors(uint64_t errors) { fbb_.AddElement<uint64_t>(8, errors, 0); }
+  void add_total_time_us(uint64_t total_time_us) { fbb_.AddElement<uint64_t>(10, total_time_us, 0); }
+  void add_max_time_us(uint64_t max_time_us) { fbb_.AddElement<uint64_t>(12, max_time_us, 0); }
+  void add_latency_histogram(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> latency_histogram) { fbb_.AddOffset(14, latency_histogram); }
+  MbRequestStatsBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  MbRequestStatsBuilder &operator=(const MbRequestStatsBuilder &);
+  flatbuffers::Offset<MbRequestStats> Finish() {
+    auto o = flatbuffers::Offset<MbRequestStats>(fbb_.EndTable(start_, 6));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<MbRequestStats> CreateMbRequestStats(flatbuffers::FlatBufferBuilder &_fbb,
+   uint8_t request_type = 0,
+   uint64_t count = 0,
+   uint64_t errors = 0,
+   uint64_t total_time_us = 0,
+   uint64_t max_time_us = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint64_t>> latency_histogram = 0) {
+  MbRequestStatsBuilder builder_(_fbb);
+  builder_.add_max_time_us(max_time_us);
+  builder_.add_total_time_us(total_time_us);
+  builder_.add_errors(errors);
+  builder_.add_count(count);
+  builder_.add_latency_histogram(latency_histogram);
+  builder_.add_request_type(request_type);
+  return builder_.Finish();
+}
+
+struct MbGetStatsRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           verifier.EndTable();
+  }
+};
+
+struct MbGetStatsRequestBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  MbGetStatsRequestBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  MbGetStatsRequestBuilder &operator=(const MbGetStatsRequestBuilder &);
+  flatbuffers::Offset<MbGetStatsRequest> Finish() {
+    auto o = flatbuffers::Offset<MbGetStatsRequest>(fbb_.EndTable(start_, 0));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<MbGetStatsRequest> CreateMbGetStatsRequest(flatbuffers::FlatBufferBuilder &_fbb) {
+  MbGetStatsRequestBuilder builder_(_fbb);
+  return builder_.Finish();
+}
+
+struct MbGetStatsResponse FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  uint64_t uptime_us() const { return GetField<uint64_t>(4, 0); }
+  uint64_t connections_total() const { return GetField<uint64_t>(6, 0); }
+  uint64_t connections_active() const { return GetField<uint64_t>(8, 0); }
+  uint64_t connections_rejected() const { return GetField<uint64_t>(10, 0); }
+  uint64_t bytes_read() const { return GetField<uint64_t>(12, 0); }
+  uint64_t bytes_written() const { return GetField<uint64_t>(14, 0); }
+  uint64_t workers_active() const { return GetField<uint64_t>(16, 0); }
+  uint64_t workers_peak() const { return GetField<uint64_t>(18, 0); }
+  uint64_t forks() const { return GetField<uint64_t>(20, 0); }
+  uint64_t execs() const { return GetField<uint64_t>(22, 0); }
+  const flatbuffers::Vector<flatbuffers::Offset<MbRequestStats>> *requests() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<MbRequestStats>> *>(24); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint64_t>(verifier, 4 /* uptime_us */) &&
+           VerifyField<uint64_t>(verifier, 6 /* connections_total */) &&
+           VerifyField<uint64_t>(verifier, 8 /* connections_active */) &&
+           VerifyField<uint64_t>(verifier, 10 /* connections_rejected */) &&
+           VerifyField<uint64_t>(verifier, 12 /* bytes_read */) &&
+           VerifyField<uint64_t>(verifier, 14 /* bytes_written */) &&
+           VerifyField<uint64_t>(verifier, 16 /* workers_active */) &&
+           VerifyField<uint64_t>(verifier, 18 /* workers_peak */) &&
+           VerifyField<uint64_t>(verifier, 20 /* forks */) &&
+           VerifyField<uint64_t>(verifier, 22 /* execs */) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 24 /* requests */) &&
+           verifier.Verify(requests()) &&
+           verifier.VerifyVectorOfTables(requests()) &&
+           verifier.EndTable();
+  }
+};
+
+struct MbGetStatsResponseBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_uptime_us(uint64_t uptime_us) { fbb_.AddElement<uint64_t>(4, uptime_us, 0); }
+  void add_connections_total(uint64_t connections_total) { fbb_.AddElement<uint64_t>(6, connections_total, 0); }
+  void add_connections_active(uint64_t connections_active) { fbb_.AddElement<uint64_t>(8, connections_active, 0); }
+  void add_connections_rejected(uint64_t connections_rejected) { fbb_.AddElement<uint64_t>(10, connections_rejected, 0); }
+  void add_bytes_read(uint64_t bytes_read) { fbb_.AddElement<uint64_t>(12, bytes_read, 0); }
+  void add_bytes_written(uint64_t bytes_written) { fbb_.AddElement<uint64_t>(14, bytes_written, 0); }
+  void add_workers_active(uint64_t workers_active) { fbb_.AddElement<uint64_t>(16, workers_active, 0); }
+  void add_workers_peak(uint64_t workers_peak) { fbb_.AddElement<uint64_t>(18, workers_peak, 0); }
+  void add_forks(uint64_t forks) { fbb_.AddElement<uint64_t>(20, forks, 0); }
+  void add_execs(uint64_t execs) { fbb_.AddElement<uint64_t>(22, execs, 0); }
+  void add_requests(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<MbRequestStats>>> requests) { fbb_.AddOffset(24, requests); }
+  MbGetStatsResponseBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  MbGetStatsResponseBuilder &operator=(const MbGetStatsResponseBuilder &);
+  flatbuffers::Offset<MbGetStatsResponse> Finish() {
+    auto o = flatbuffers::Offset<MbGetStatsResponse>(fbb_.EndTable(start_, 11));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<MbGetStatsResponse> CreateMbGetStatsResponse(flatbuffers::FlatBufferBuilder &_fbb,
+   uint64_t uptime_us = 0,
+   uint64_t connections_total = 0,
+   uint64_t connections_active = 0,
+   uint64_t connections_rejected = 0,
+   uint64_t bytes_read = 0,
+   uint64_t bytes_written = 0,
+   uint64_t workers_active = 0,
+   uint64_t workers_peak = 0,
+   uint64_t forks = 0,
+   uint64_t execs = 0,
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<MbRequestStats>>> requests = 0) {
+  MbGetStatsResponseBuilder builder_(_fbb);
+  builder_.add_execs(execs);
+  builder_.add_forks(forks);
+  builder_.add_workers_peak(workers_peak);
+  builder_.add_workers_active(workers_active);
+  builder_.add_bytes_written(bytes_written);
+  builder_.add_bytes_read(bytes_read);
+  builder_.add_connections_rejected(connections_rejected);
+  builder_.add_connections_active(connections_active);
+  builder_.add_connections_total(connections_total);
+  builder_.add_uptime_us(uptime_us);
+  builder_.add_requests(requests);
+  return builder_.Finish();
+}
+
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+
+#endif  // FLATBUFFERS_GENERATED_MBGETSTATS_MBTOOL_DAEMON_V3_H_
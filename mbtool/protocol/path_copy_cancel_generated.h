@@ -0,0 +1,332 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_PATHCOPYCANCEL_MBTOOL_DAEMON_V3_H_
+#define FLATBUFFERS_GENERATED_PATHCOPYCANCEL_MBTOOL_DAEMON_V3_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "file_chmod_generated.h"
+#include "file_close_generated.h"
+#include "file_open_generated.h"
+#include "file_open_fd_generated.h"
+#include "file_read_generated.h"
+#include "file_read_stream_generated.h"
+#include "file_seek_generated.h"
+#include "file_selinux_get_label_generated.h"
+#include "file_selinux_set_label_generated.h"
+#include "file_stat_generated.h"
+#include "file_write_generated.h"
+#include "file_write_stream_generated.h"
+#include "mb_get_booted_rom_id_generated.h"
+#include "mb_get_installed_roms_generated.h"
+#include "mb_get_packages_count_generated.h"
+#include "mb_get_stats_generated.h"
+#include "mb_get_version_generated.h"
+#include "mb_set_kernel_generated.h"
+#include "mb_switch_rom_generated.h"
+#include "mb_wipe_rom_generated.h"
+#include "path_chmod_generated.h"
+#include "path_copy_generated.h"
+#include "path_copy_start_generated.h"
+#include "path_copy_status_generated.h"
+#include "path_get_directory_size_generated.h"
+#include "path_selinux_get_label_generated.h"
+#include "path_selinux_set_label_generated.h"
+#include "reboot_generated.h"
+
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileChmodRequest;
+struct FileChmodResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileCloseRequest;
+struct FileCloseResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileOpenRequest;
+struct FileOpenResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileReadRequest;
+struct FileReadResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSeekRequest;
+struct FileSeekResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct StructStat;
+struct FileStatRequest;
+struct FileStatResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileWriteRequest;
+struct FileWriteResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSELinuxGetLabelRequest;
+struct FileSELinuxGetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSELinuxSetLabelRequest;
+struct FileSELinuxSetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathChmodRequest;
+struct PathChmodResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyRequest;
+struct PathCopyResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathSELinuxGetLabelRequest;
+struct PathSELinuxGetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathSELinuxSetLabelRequest;
+struct PathSELinuxSetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathGetDirectorySizeRequest;
+struct PathGetDirectorySizeResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetVersionRequest;
+struct MbGetVersionResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbRom;
+struct MbGetInstalledRomsRequest;
+struct MbGetInstalledRomsResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetBootedRomIdRequest;
+struct MbGetBootedRomIdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbSwitchRomRequest;
+struct MbSwitchRomResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbSetKernelRequest;
+struct MbSetKernelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbWipeRomRequest;
+struct MbWipeRomResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetPackagesCountRequest;
+struct MbGetPackagesCountResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct RebootRequest;
+struct RebootResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileOpenFdRequest;
+struct FileOpenFdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileReadStreamRequest;
+struct FileReadStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileWriteStreamRequest;
+struct FileWriteStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbRequestStats;
+struct MbGetStatsRequest;
+struct MbGetStatsResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyStartRequest;
+struct PathCopyStartResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyStatusRequest;
+struct PathCopyStatusResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+
+struct PathCopyCancelRequest;
+struct PathCopyCancelResponse;
+
+struct PathCopyCancelRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  uint32_t job_id() const { return GetField<uint32_t>(4, 0); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, 4 /* job_id */) &&
+           verifier.EndTable();
+  }
+};
+
+struct PathCopyCancelRequestBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_job_id(uint32_t job_id) { fbb_.AddElement<uint32_t>(4, job_id, 0); }
+  PathCopyCancelRequestBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  PathCopyCancelRequestBuilder &operator=(const PathCopyCancelRequestBuilder &);
+  flatbuffers::Offset<PathCopyCancelRequest> Finish() {
+    auto o = flatbuffers::Offset<PathCopyCancelRequest>(fbb_.EndTable(start_, 1));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PathCopyCancelRequest> CreatePathCopyCancelRequest(flatbuffers::FlatBufferBuilder &_fbb,
+   uint32_t job_id = 0) {
+  PathCopyCancelRequestBuilder builder_(_fbb);
+  builder_.add_job_id(job_id);
+  return builder_.Finish();
+}
+
+struct PathCopyCancelResponse FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  uint8_t success() const { return GetField<uint8_t>(4, 0); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint8_t>(verifier, 4 /* success */) &&
+           verifier.EndTable();
+  }
+};
+
+struct PathCopyCancelResponseBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_success(uint8_t success) { fbb_.AddElement<uint8_t>(4, success, 0); }
+  PathCopyCancelResponseBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  PathCopyCancelResponseBuilder &operator=(const PathCopyCancelResponseBuilder &);
+  flatbuffers::Offset<PathCopyCancelResponse> Finish() {
+    auto o = flatbuffers::Offset<PathCopyCancelResponse>(fbb_.EndTable(start_, 1));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PathCopyCancelResponse> CreatePathCopyCancelResponse(flatbuffers::FlatBufferBuilder &_fbb,
+   uint8_t success = 0) {
+  PathCopyCancelResponseBuilder builder_(_fbb);
+  builder_.add_success(success);
+  return builder_.Finish();
+}
+
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+
+#endif  // FLATBUFFERS_GENERATED_PATHCOPYCANCEL_MBTOOL_DAEMON_V3_H_
@@ -0,0 +1,373 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_PATHCOPYSTATUS_MBTOOL_DAEMON_V3_H_
+#define FLATBUFFERS_GENERATED_PATHCOPYSTATUS_MBTOOL_DAEMON_V3_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "file_chmod_generated.h"
+#include "file_close_generated.h"
+#include "file_open_generated.h"
+#include "file_open_fd_generated.h"
+#include "file_read_generated.h"
+#include "file_read_stream_generated.h"
+#include "file_seek_generated.h"
+#include "file_selinux_get_label_generated.h"
+#include "file_selinux_set_label_generated.h"
+#include "file_stat_generated.h"
+#include "file_write_generated.h"
+#include "file_write_stream_generated.h"
+#include "mb_get_booted_rom_id_generated.h"
+#include "mb_get_installed_roms_generated.h"
+#include "mb_get_packages_count_generated.h"
+#include "mb_get_stats_generated.h"
+#include "mb_get_version_generated.h"
+#include "mb_set_kernel_generated.h"
+#include "mb_switch_rom_generated.h"
+#include "mb_wipe_rom_generated.h"
+#include "path_chmod_generated.h"
+#include "path_copy_generated.h"
+#include "path_copy_start_generated.h"
+#include "path_get_directory_size_generated.h"
+#include "path_selinux_get_label_generated.h"
+#include "path_selinux_set_label_generated.h"
+#include "reboot_generated.h"
+
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileChmodRequest;
+struct FileChmodResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileCloseRequest;
+struct FileCloseResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileOpenRequest;
+struct FileOpenResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileReadRequest;
+struct FileReadResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSeekRequest;
+struct FileSeekResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct StructStat;
+struct FileStatRequest;
+struct FileStatResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileWriteRequest;
+struct FileWriteResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSELinuxGetLabelRequest;
+struct FileSELinuxGetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileSELinuxSetLabelRequest;
+struct FileSELinuxSetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathChmodRequest;
+struct PathChmodResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyRequest;
+struct PathCopyResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathSELinuxGetLabelRequest;
+struct PathSELinuxGetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathSELinuxSetLabelRequest;
+struct PathSELinuxSetLabelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathGetDirectorySizeRequest;
+struct PathGetDirectorySizeResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetVersionRequest;
+struct MbGetVersionResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbRom;
+struct MbGetInstalledRomsRequest;
+struct MbGetInstalledRomsResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetBootedRomIdRequest;
+struct MbGetBootedRomIdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbSwitchRomRequest;
+struct MbSwitchRomResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbSetKernelRequest;
+struct MbSetKernelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbWipeRomRequest;
+struct MbWipeRomResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbGetPackagesCountRequest;
+struct MbGetPackagesCountResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct RebootRequest;
+struct RebootResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileOpenFdRequest;
+struct FileOpenFdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileReadStreamRequest;
+struct FileReadStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileWriteStreamRequest;
+struct FileWriteStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbRequestStats;
+struct MbGetStatsRequest;
+struct MbGetStatsResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyStartRequest;
+struct PathCopyStartResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+
+struct PathCopyStatusRequest;
+struct PathCopyStatusResponse;
+
+enum PathCopyState {
+  PathCopyState_RUNNING = 0,
+  PathCopyState_SUCCEEDED = 1,
+  PathCopyState_FAILED = 2,
+  PathCopyState_CANCELLED = 3
+};
+
+inline const char **EnumNamesPathCopyState() {
+  static const char *names[] = { "RUNNING", "SUCCEEDED", "FAILED", "CANCELLED", nullptr };
+  return names;
+}
+
+inline const char *EnumNamePathCopyState(PathCopyState e) { return EnumNamesPathCopyState()[static_cast<int>(e)]; }
+
+struct PathCopyStatusRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  uint32_t job_id() const { return GetField<uint32_t>(4, 0); }
+  uint32_t progress_interval() const { return GetField<uint32_t>(6, 0); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, 4 /* job_id */) &&
+           VerifyField<uint32_t>(verifier, 6 /* progress_interval */) &&
+           verifier.EndTable();
+  }
+};
+
+struct PathCopyStatusRequestBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_job_id(uint32_t job_id) { fbb_.AddElement<uint32_t>(4, job_id, 0); }
+  void add_progress_interval(uint32_t progress_interval) { fbb_.AddElement<uint32_t>(6, progress_interval, 0); }
+  PathCopyStatusRequestBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  PathCopyStatusRequestBuilder &operator=(const PathCopyStatusRequestBuilder &);
+  flatbuffers::Offset<PathCopyStatusRequest> Finish() {
+    auto o = flatbuffers::Offset<PathCopyStatusRequest>(fbb_.EndTable(start_, 2));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PathCopyStatusRequest> CreatePathCopyStatusRequest(flatbuffers::FlatBufferBuilder &_fbb,
+   uint32_t job_id = 0,
+   uint32_t progress_interval = 0) {
+  PathCopyStatusRequestBuilder builder_(_fbb);
+  builder_.add_progress_interval(progress_interval);
+  builder_.add_job_id(job_id);
+  return builder_.Finish();
+}
+
+struct PathCopyStatusResponse FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  uint8_t success() const { return GetField<uint8_t>(4, 0); }
+  const flatbuffers::String *error_msg() const { return GetPointer<const flatbuffers::String *>(6); }
+  PathCopyState state() const { return static_cast<PathCopyState>(GetField<int16_t>(8, 0)); }
+  uint64_t bytes_copied() const { return GetField<uint64_t>(10, 0); }
+  uint64_t bytes_total() const { return GetField<uint64_t>(12, 0); }
+  uint32_t files_copied() const { return GetField<uint32_t>(14, 0); }
+  uint32_t files_total() const { return GetField<uint32_t>(16, 0); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint8_t>(verifier, 4 /* success */) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 6 /* error_msg */) &&
+           verifier.Verify(error_msg()) &&
+           VerifyField<int16_t>(verifier, 8 /* state */) &&
+           VerifyField<uint64_t>(verifier, 10 /* bytes_copied */) &&
+           VerifyField<uint64_t>(verifier, 12 /* bytes_total */) &&
+           VerifyField<uint32_t>(verifier, 14 /* files_copied */) &&
+           VerifyField<uint32_t>(verifier, 16 /* files_total */) &&
+           verifier.EndTable();
+  }
+};
+
+struct PathCopyStatusResponseBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_success(uint8_t success) { fbb_.AddElement<uint8_t>(4, success, 0); }
+  void add_error_msg(flatbuffers::Offset<flatbuffers::String> error_msg) { fbb_.AddOffset(6, error_msg); }
+  void add_state(PathCopyState state) { fbb_.AddElement<int16_t>(8, static_cast<int16_t>(state), 0); }
+  void add_bytes_copied(uint64_t bytes_copied) { fbb_.AddElement<uint64_t>(10, bytes_copied, 0); }
+  void add_bytes_total(uint64_t bytes_total) { fbb_.AddElement<uint64_t>(12, bytes_total, 0); }
+  void add_files_copied(uint32_t files_copied) { fbb_.AddElement<uint32_t>(14, files_copied, 0); }
+  void add_files_total(uint32_t files_total) { fbb_.AddElement<uint32_t>(16, files_total, 0); }
+  PathCopyStatusResponseBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  PathCopyStatusResponseBuilder &operator=(const PathCopyStatusResponseBuilder &);
+  flatbuffers::Offset<PathCopyStatusResponse> Finish() {
+    auto o = flatbuffers::Offset<PathCopyStatusResponse>(fbb_.EndTable(start_, 7));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PathCopyStatusResponse> CreatePathCopyStatusResponse(flatbuffers::FlatBufferBuilder &_fbb,
+   uint8_t success = 0,
+   flatbuffers::Offset<flatbuffers::String> error_msg = 0,
+   PathCopyState state = PathCopyState_RUNNING,
+   uint64_t bytes_copied = 0,
+   uint64_t bytes_total = 0,
+   uint32_t files_copied = 0,
+   uint32_t files_total = 0) {
+  PathCopyStatusResponseBuilder builder_(_fbb);
+  builder_.add_bytes_total(bytes_total);
+  builder_.add_bytes_copied(bytes_copied);
+  builder_.add_files_total(files_total);
+  builder_.add_files_copied(files_copied);
+  builder_.add_error_msg(error_msg);
+  builder_.add_state(state);
+  builder_.add_success(success);
+  return builder_.Finish();
+}
+
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+
+#endif  // FLATBUFFERS_GENERATED_PATHCOPYSTATUS_MBTOOL_DAEMON_V3_H_
@@ -135,6 +135,7 @@ struct PathGetDirectorySizeResponse;
 struct PathGetDirectorySizeRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::String *path() const { return GetPointer<const flatbuffers::String *>(4); }
   const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *exclusions() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *>(6); }
+  uint32_t progress_interval() const { return GetField<uint32_t>(8, 0); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, 4 /* path */) &&
@@ -142,6 +143,7 @@ struct PathGetDirectorySizeRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers
            VerifyField<flatbuffers::uoffset_t>(verifier, 6 /* exclusions */) &&
            verifier.Verify(exclusions()) &&
            verifier.VerifyVectorOfStrings(exclusions()) &&
+           VerifyField<uint32_t>(verifier, 8 /* progress_interval */) &&
            verifier.EndTable();
   }
 };
@@ -151,18 +153,21 @@ struct PathGetDirectorySizeRequestBuilder {
   flatbuffers::uoffset_t start_;
   void add_path(flatbuffers::Offset<flatbuffers::String> path) { fbb_.AddOffset(4, path); }
   void add_exclusions(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> exclusions) { fbb_.AddOffset(6, exclusions); }
+  void add_progress_interval(uint32_t progress_interval) { fbb_.AddElement<uint32_t>(8, progress_interval, 0); }
   PathGetDirectorySizeRequestBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
   PathGetDirectorySizeRequestBuilder &operator=(const PathGetDirectorySizeRequestBuilder &);
   flatbuffers::Offset<PathGetDirectorySizeRequest> Finish() {
-    auto o = flatbuffers::Offset<PathGetDirectorySizeRequest>(fbb_.EndTable(start_, 2));
+    auto o = flatbuffers::Offset<PathGetDirectorySizeRequest>(fbb_.EndTable(start_, 3));
     return o;
   }
 };
 
 inline flatbuffers::Offset<PathGetDirectorySizeRequest> CreatePathGetDirectorySizeRequest(flatbuffers::FlatBufferBuilder &_fbb,
    flatbuffers::Offset<flatbuffers::String> path = 0,
-   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> exclusions = 0) {
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> exclusions = 0,
+   uint32_t progress_interval = 0) {
   PathGetDirectorySizeRequestBuilder builder_(_fbb);
+  builder_.add_progress_interval(progress_interval);
   builder_.add_exclusions(exclusions);
   builder_.add_path(path);
   return builder_.Finish();
@@ -172,12 +177,14 @@ struct PathGetDirectorySizeResponse FLATBUFFERS_FINAL_CLASS : private flatbuffer
   uint8_t success() const { return GetField<uint8_t>(4, 0); }
   const flatbuffers::String *error_msg() const { return GetPointer<const flatbuffers::String *>(6); }
   uint64_t size() const { return GetField<uint64_t>(8, 0); }
+  uint8_t in_progress() const { return GetField<uint8_t>(10, 0); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<uint8_t>(verifier, 4 /* success */) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, 6 /* error_msg */) &&
            verifier.Verify(error_msg()) &&
            VerifyField<uint64_t>(verifier, 8 /* size */) &&
+           VerifyField<uint8_t>(verifier, 10 /* in_progress */) &&
            verifier.EndTable();
   }
 };
@@ -188,10 +195,11 @@ struct PathGetDirectorySizeResponseBuilder {
   void add_success(uint8_t success) { fbb_.AddElement<uint8_t>(4, success, 0); }
   void add_error_msg(flatbuffers::Offset<flatbuffers::String> error_msg) { fbb_.AddOffset(6, error_msg); }
   void add_size(uint64_t size) { fbb_.AddElement<uint64_t>(8, size, 0); }
+  void add_in_progress(uint8_t in_progress) { fbb_.AddElement<uint8_t>(10, in_progress, 0); }
   PathGetDirectorySizeResponseBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
   PathGetDirectorySizeResponseBuilder &operator=(const PathGetDirectorySizeResponseBuilder &);
   flatbuffers::Offset<PathGetDirectorySizeResponse> Finish() {
-    auto o = flatbuffers::Offset<PathGetDirectorySizeResponse>(fbb_.EndTable(start_, 3));
+    auto o = flatbuffers::Offset<PathGetDirectorySizeResponse>(fbb_.EndTable(start_, 4));
     return o;
   }
 };
@@ -199,10 +207,12 @@ struct PathGetDirectorySizeResponseBuilder {
 inline flatbuffers::Offset<PathGetDirectorySizeResponse> CreatePathGetDirectorySizeResponse(flatbuffers::FlatBufferBuilder &_fbb,
    uint8_t success = 0,
    flatbuffers::Offset<flatbuffers::String> error_msg = 0,
-   uint64_t size = 0) {
+   uint64_t size = 0,
+   uint8_t in_progress = 0) {
   PathGetDirectorySizeResponseBuilder builder_(_fbb);
   builder_.add_size(size);
   builder_.add_error_msg(error_msg);
+  builder_.add_in_progress(in_progress);
   builder_.add_success(success);
   return builder_.Finish();
 }
@@ -8,21 +8,28 @@
 #include "file_chmod_generated.h"
 #include "file_close_generated.h"
 #include "file_open_generated.h"
+#include "file_open_fd_generated.h"
 #include "file_read_generated.h"
+#include "file_read_stream_generated.h"
 #include "file_seek_generated.h"
 #include "file_selinux_get_label_generated.h"
 #include "file_selinux_set_label_generated.h"
 #include "file_stat_generated.h"
 #include "file_write_generated.h"
+#include "file_write_stream_generated.h"
 #include "mb_get_booted_rom_id_generated.h"
 #include "mb_get_installed_roms_generated.h"
 #include "mb_get_packages_count_generated.h"
+#include "mb_get_stats_generated.h"
 #include "mb_get_version_generated.h"
 #include "mb_set_kernel_generated.h"
 #include "mb_switch_rom_generated.h"
 #include "mb_wipe_rom_generated.h"
 #include "path_chmod_generated.h"
 #include "path_copy_generated.h"
+#include "path_copy_cancel_generated.h"
+#include "path_copy_start_generated.h"
+#include "path_copy_status_generated.h"
 #include "path_get_directory_size_generated.h"
 #include "path_selinux_get_label_generated.h"
 #include "path_selinux_set_label_generated.h"
@@ -206,12 +213,70 @@ struct RebootResponse;
 }  // namespace v3
 }  // namespace daemon
 }  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileOpenFdRequest;
+struct FileOpenFdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileReadStreamRequest;
+struct FileReadStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileWriteStreamRequest;
+struct FileWriteStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbRequestStats;
+struct MbGetStatsRequest;
+struct MbGetStatsResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyStartRequest;
+struct PathCopyStartResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyStatusRequest;
+struct PathCopyStatusResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyCancelRequest;
+struct PathCopyCancelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
 
 namespace mbtool {
 namespace daemon {
 namespace v3 {
 
 struct Request;
+struct BatchRequest;
 
 enum RequestType {
   RequestType_NONE = 0,
@@ -236,11 +301,19 @@ enum RequestType {
   RequestType_MbSetKernelRequest = 19,
   RequestType_MbWipeRomRequest = 20,
   RequestType_MbGetPackagesCountRequest = 21,
-  RequestType_RebootRequest = 22
+  RequestType_RebootRequest = 22,
+  RequestType_FileOpenFdRequest = 23,
+  RequestType_FileReadStreamRequest = 24,
+  RequestType_FileWriteStreamRequest = 25,
+  RequestType_BatchRequest = 26,
+  RequestType_MbGetStatsRequest = 27,
+  RequestType_PathCopyStartRequest = 28,
+  RequestType_PathCopyStatusRequest = 29,
+  RequestType_PathCopyCancelRequest = 30
 };
 
 inline const char **EnumNamesRequestType() {
-  static const char *names[] = { "NONE", "FileChmodRequest", "FileCloseRequest", "FileOpenRequest", "FileReadRequest", "FileSeekRequest", "FileStatRequest", "FileWriteRequest", "FileSELinuxGetLabelRequest", "FileSELinuxSetLabelRequest", "PathChmodRequest", "PathCopyRequest", "PathSELinuxGetLabelRequest", "PathSELinuxSetLabelRequest", "PathGetDirectorySizeRequest", "MbGetVersionRequest", "MbGetInstalledRomsRequest", "MbGetBootedRomIdRequest", "MbSwitchRomRequest", "MbSetKernelRequest", "MbWipeRomRequest", "MbGetPackagesCountRequest", "RebootRequest", nullptr };
+  static const char *names[] = { "NONE", "FileChmodRequest", "FileCloseRequest", "FileOpenRequest", "FileReadRequest", "FileSeekRequest", "FileStatRequest", "FileWriteRequest", "FileSELinuxGetLabelRequest", "FileSELinuxSetLabelRequest", "PathChmodRequest", "PathCopyRequest", "PathSELinuxGetLabelRequest", "PathSELinuxSetLabelRequest", "PathGetDirectorySizeRequest", "MbGetVersionRequest", "MbGetInstalledRomsRequest", "MbGetBootedRomIdRequest", "MbSwitchRomRequest", "MbSetKernelRequest", "MbWipeRomRequest", "MbGetPackagesCountRequest", "RebootRequest", "FileOpenFdRequest", "FileReadStreamRequest", "FileWriteStreamRequest", "BatchRequest", "MbGetStatsRequest", "PathCopyStartRequest", "PathCopyStatusRequest", "PathCopyCancelRequest", nullptr };
   return names;
 }
 
@@ -251,11 +324,13 @@ inline bool VerifyRequestType(flatbuffers::Verifier &verifier, const void *union
 struct Request FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   RequestType request_type() const { return static_cast<RequestType>(GetField<uint8_t>(4, 0)); }
   const void *request() const { return GetPointer<const void *>(6); }
+  uint64_t id() const { return GetField<uint64_t>(8, 0); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<uint8_t>(verifier, 4 /* request_type */) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, 6 /* request */) &&
            VerifyRequestType(verifier, request(), request_type()) &&
+           VerifyField<uint64_t>(verifier, 8 /* id */) &&
            verifier.EndTable();
   }
 };
@@ -265,23 +340,56 @@ struct RequestBuilder {
   flatbuffers::uoffset_t start_;
   void add_request_type(RequestType request_type) { fbb_.AddElement<uint8_t>(4, static_cast<uint8_t>(request_type), 0); }
   void add_request(flatbuffers::Offset<void> request) { fbb_.AddOffset(6, request); }
+  void add_id(uint64_t id) { fbb_.AddElement<uint64_t>(8, id, 0); }
   RequestBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
   RequestBuilder &operator=(const RequestBuilder &);
   flatbuffers::Offset<Request> Finish() {
-    auto o = flatbuffers::Offset<Request>(fbb_.EndTable(start_, 2));
+    auto o = flatbuffers::Offset<Request>(fbb_.EndTable(start_, 3));
     return o;
   }
 };
 
 inline flatbuffers::Offset<Request> CreateRequest(flatbuffers::FlatBufferBuilder &_fbb,
    RequestType request_type = RequestType_NONE,
-   flatbuffers::Offset<void> request = 0) {
+   flatbuffers::Offset<void> request = 0,
+   uint64_t id = 0) {
   RequestBuilder builder_(_fbb);
+  builder_.add_id(id);
   builder_.add_request(request);
   builder_.add_request_type(request_type);
   return builder_.Finish();
 }
 
+struct BatchRequest FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  const flatbuffers::Vector<flatbuffers::Offset<Request>> *requests() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Request>> *>(4); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 4 /* requests */) &&
+           verifier.Verify(requests()) &&
+           verifier.VerifyVectorOfTables(requests()) &&
+           verifier.EndTable();
+  }
+};
+
+struct BatchRequestBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_requests(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Request>>> requests) { fbb_.AddOffset(4, requests); }
+  BatchRequestBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  BatchRequestBuilder &operator=(const BatchRequestBuilder &);
+  flatbuffers::Offset<BatchRequest> Finish() {
+    auto o = flatbuffers::Offset<BatchRequest>(fbb_.EndTable(start_, 1));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<BatchRequest> CreateBatchRequest(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Request>>> requests = 0) {
+  BatchRequestBuilder builder_(_fbb);
+  builder_.add_requests(requests);
+  return builder_.Finish();
+}
+
 inline bool VerifyRequestType(flatbuffers::Verifier &verifier, const void *union_obj, RequestType type) {
   switch (type) {
     case RequestType_NONE: return true;
@@ -307,6 +415,14 @@ inline bool VerifyRequestType(flatbuffers::Verifier &verifier, const void *union
     case RequestType_MbWipeRomRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::MbWipeRomRequest *>(union_obj));
     case RequestType_MbGetPackagesCountRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::MbGetPackagesCountRequest *>(union_obj));
     case RequestType_RebootRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::RebootRequest *>(union_obj));
+    case RequestType_FileOpenFdRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::FileOpenFdRequest *>(union_obj));
+    case RequestType_FileReadStreamRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::FileReadStreamRequest *>(union_obj));
+    case RequestType_FileWriteStreamRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::FileWriteStreamRequest *>(union_obj));
+    case RequestType_BatchRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::BatchRequest *>(union_obj));
+    case RequestType_MbGetStatsRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::MbGetStatsRequest *>(union_obj));
+    case RequestType_PathCopyStartRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::PathCopyStartRequest *>(union_obj));
+    case RequestType_PathCopyStatusRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::PathCopyStatusRequest *>(union_obj));
+    case RequestType_PathCopyCancelRequest: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::PathCopyCancelRequest *>(union_obj));
     default: return false;
   }
 }
@@ -9,21 +9,28 @@
 #include "file_chmod_generated.h"
 #include "file_close_generated.h"
 #include "file_open_generated.h"
+#include "file_open_fd_generated.h"
 #include "file_read_generated.h"
+#include "file_read_stream_generated.h"
 #include "file_seek_generated.h"
 #include "file_selinux_get_label_generated.h"
 #include "file_selinux_set_label_generated.h"
 #include "file_stat_generated.h"
 #include "file_write_generated.h"
+#include "file_write_stream_generated.h"
 #include "mb_get_booted_rom_id_generated.h"
 #include "mb_get_installed_roms_generated.h"
 #include "mb_get_packages_count_generated.h"
+#include "mb_get_stats_generated.h"
 #include "mb_get_version_generated.h"
 #include "mb_set_kernel_generated.h"
 #include "mb_switch_rom_generated.h"
 #include "mb_wipe_rom_generated.h"
 #include "path_chmod_generated.h"
 #include "path_copy_generated.h"
+#include "path_copy_cancel_generated.h"
+#include "path_copy_start_generated.h"
+#include "path_copy_status_generated.h"
 #include "path_get_directory_size_generated.h"
 #include "path_selinux_get_label_generated.h"
 #include "path_selinux_set_label_generated.h"
@@ -210,6 +217,63 @@ struct RebootResponse;
 namespace mbtool {
 namespace daemon {
 namespace v3 {
+struct FileOpenFdRequest;
+struct FileOpenFdResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileReadStreamRequest;
+struct FileReadStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct FileWriteStreamRequest;
+struct FileWriteStreamResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct MbRequestStats;
+struct MbGetStatsRequest;
+struct MbGetStatsResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyStartRequest;
+struct PathCopyStartResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyStatusRequest;
+struct PathCopyStatusResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
+struct PathCopyCancelRequest;
+struct PathCopyCancelResponse;
+}  // namespace v3
+}  // namespace daemon
+}  // namespace mbtool
+namespace mbtool {
+namespace daemon {
+namespace v3 {
 struct Request;
 }  // namespace v3
 }  // namespace daemon
@@ -222,6 +286,8 @@ namespace v3 {
 struct Invalid;
 struct Unsupported;
 struct Response;
+struct BatchResult;
+struct BatchResponse;
 
 enum ResponseType {
   ResponseType_NONE = 0,
@@ -248,11 +314,19 @@ enum ResponseType {
   ResponseType_MbSetKernelResponse = 21,
   ResponseType_MbWipeRomResponse = 22,
   ResponseType_MbGetPackagesCountResponse = 23,
-  ResponseType_RebootResponse = 24
+  ResponseType_RebootResponse = 24,
+  ResponseType_FileOpenFdResponse = 25,
+  ResponseType_FileReadStreamResponse = 26,
+  ResponseType_FileWriteStreamResponse = 27,
+  ResponseType_BatchResponse = 28,
+  ResponseType_MbGetStatsResponse = 29,
+  ResponseType_PathCopyStartResponse = 30,
+  ResponseType_PathCopyStatusResponse = 31,
+  ResponseType_PathCopyCancelResponse = 32
 };
 
 inline const char **EnumNamesResponseType() {
-  static const char *names[] = { "NONE", "Invalid", "Unsupported", "FileChmodResponse", "FileCloseResponse", "FileOpenResponse", "FileReadResponse", "FileSeekResponse", "FileStatResponse", "FileWriteResponse", "FileSELinuxGetLabelResponse", "FileSELinuxSetLabelResponse", "PathChmodResponse", "PathCopyResponse", "PathSELinuxGetLabelResponse", "PathSELinuxSetLabelResponse", "PathGetDirectorySizeResponse", "MbGetVersionResponse", "MbGetInstalledRomsResponse", "MbGetBootedRomIdResponse", "MbSwitchRomResponse", "MbSetKernelResponse", "MbWipeRomResponse", "MbGetPackagesCountResponse", "RebootResponse", nullptr };
+  static const char *names[] = { "NONE", "Invalid", "Unsupported", "FileChmodResponse", "FileCloseResponse", "FileOpenResponse", "FileReadResponse", "FileSeekResponse", "FileStatResponse", "FileWriteResponse", "FileSELinuxGetLabelResponse", "FileSELinuxSetLabelResponse", "PathChmodResponse", "PathCopyResponse", "PathSELinuxGetLabelResponse", "PathSELinuxSetLabelResponse", "PathGetDirectorySizeResponse", "MbGetVersionResponse", "MbGetInstalledRomsResponse", "MbGetBootedRomIdResponse", "MbSwitchRomResponse", "MbSetKernelResponse", "MbWipeRomResponse", "MbGetPackagesCountResponse", "RebootResponse", "FileOpenFdResponse", "FileReadStreamResponse", "FileWriteStreamResponse", "BatchResponse", "MbGetStatsResponse", "PathCopyStartResponse", "PathCopyStatusResponse", "PathCopyCancelResponse", nullptr };
   return names;
 }
 
@@ -309,11 +383,13 @@ inline flatbuffers::Offset<Unsupported> CreateUnsupported(flatbuffers::FlatBuffe
 struct Response FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   ResponseType response_type() const { return static_cast<ResponseType>(GetField<uint8_t>(4, 0)); }
   const void *response() const { return GetPointer<const void *>(6); }
+  uint64_t id() const { return GetField<uint64_t>(8, 0); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<uint8_t>(verifier, 4 /* response_type */) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, 6 /* response */) &&
            VerifyResponseType(verifier, response(), response_type()) &&
+           VerifyField<uint64_t>(verifier, 8 /* id */) &&
            verifier.EndTable();
   }
 };
@@ -323,23 +399,86 @@ struct ResponseBuilder {
   flatbuffers::uoffset_t start_;
   void add_response_type(ResponseType response_type) { fbb_.AddElement<uint8_t>(4, static_cast<uint8_t>(response_type), 0); }
   void add_response(flatbuffers::Offset<void> response) { fbb_.AddOffset(6, response); }
+  void add_id(uint64_t id) { fbb_.AddElement<uint64_t>(8, id, 0); }
   ResponseBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
   ResponseBuilder &operator=(const ResponseBuilder &);
   flatbuffers::Offset<Response> Finish() {
-    auto o = flatbuffers::Offset<Response>(fbb_.EndTable(start_, 2));
+    auto o = flatbuffers::Offset<Response>(fbb_.EndTable(start_, 3));
     return o;
   }
 };
 
 inline flatbuffers::Offset<Response> CreateResponse(flatbuffers::FlatBufferBuilder &_fbb,
    ResponseType response_type = ResponseType_NONE,
-   flatbuffers::Offset<void> response = 0) {
+   flatbuffers::Offset<void> response = 0,
+   uint64_t id = 0) {
   ResponseBuilder builder_(_fbb);
+  builder_.add_id(id);
   builder_.add_response(response);
   builder_.add_response_type(response_type);
   return builder_.Finish();
 }
 
+struct BatchResult FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  const flatbuffers::Vector<uint8_t> *response() const { return GetPointer<const flatbuffers::Vector<uint8_t> *>(4); }
+  const mbtool::daemon::v3::Response *response_nested_root() const { return flatbuffers::GetRoot<mbtool::daemon::v3::Response>(response()->Data()); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 4 /* response */) &&
+           verifier.Verify(response()) &&
+           verifier.EndTable();
+  }
+};
+
+struct BatchResultBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_response(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> response) { fbb_.AddOffset(4, response); }
+  BatchResultBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  BatchResultBuilder &operator=(const BatchResultBuilder &);
+  flatbuffers::Offset<BatchResult> Finish() {
+    auto o = flatbuffers::Offset<BatchResult>(fbb_.EndTable(start_, 1));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<BatchResult> CreateBatchResult(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::Vector<uint8_t>> response = 0) {
+  BatchResultBuilder builder_(_fbb);
+  builder_.add_response(response);
+  return builder_.Finish();
+}
+
+struct BatchResponse FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  const flatbuffers::Vector<flatbuffers::Offset<BatchResult>> *results() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<BatchResult>> *>(4); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 4 /* results */) &&
+           verifier.Verify(results()) &&
+           verifier.VerifyVectorOfTables(results()) &&
+           verifier.EndTable();
+  }
+};
+
+struct BatchResponseBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_results(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<BatchResult>>> results) { fbb_.AddOffset(4, results); }
+  BatchResponseBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  BatchResponseBuilder &operator=(const BatchResponseBuilder &);
+  flatbuffers::Offset<BatchResponse> Finish() {
+    auto o = flatbuffers::Offset<BatchResponse>(fbb_.EndTable(start_, 1));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<BatchResponse> CreateBatchResponse(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<BatchResult>>> results = 0) {
+  BatchResponseBuilder builder_(_fbb);
+  builder_.add_results(results);
+  return builder_.Finish();
+}
+
 inline bool VerifyResponseType(flatbuffers::Verifier &verifier, const void *union_obj, ResponseType type) {
   switch (type) {
     case ResponseType_NONE: return true;
@@ -367,6 +506,14 @@ inline bool VerifyResponseType(flatbuffers::Verifier &verifier, const void *unio
     case ResponseType_MbWipeRomResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::MbWipeRomResponse *>(union_obj));
     case ResponseType_MbGetPackagesCountResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::MbGetPackagesCountResponse *>(union_obj));
     case ResponseType_RebootResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::RebootResponse *>(union_obj));
+    case ResponseType_FileOpenFdResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::FileOpenFdResponse *>(union_obj));
+    case ResponseType_FileReadStreamResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::FileReadStreamResponse *>(union_obj));
+    case ResponseType_FileWriteStreamResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::FileWriteStreamResponse *>(union_obj));
+    case ResponseType_BatchResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::BatchResponse *>(union_obj));
+    case ResponseType_MbGetStatsResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::MbGetStatsResponse *>(union_obj));
+    case ResponseType_PathCopyStartResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::PathCopyStartResponse *>(union_obj));
+    case ResponseType_PathCopyStatusResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::PathCopyStatusResponse *>(union_obj));
+    case ResponseType_PathCopyCancelResponse: return verifier.VerifyTable(reinterpret_cast<const mbtool::daemon::v3::PathCopyCancelResponse *>(union_obj));
     default: return false;
   }
 }
@@ -28,7 +28,7 @@
 namespace mb
 {
 
-bool reboot_via_init(const std::string &reboot_arg)
+bool request_reboot_via_init(const std::string &reboot_arg)
 {
     std::string value("reboot,");
     value.append(reboot_arg);
@@ -44,6 +44,15 @@ bool reboot_via_init(const std::string &reboot_arg)
         return false;
     }
 
+    return true;
+}
+
+bool reboot_via_init(const std::string &reboot_arg)
+{
+    if (!request_reboot_via_init(reboot_arg)) {
+        return false;
+    }
+
     // Obviously shouldn't return
     while (1) {
         pause();
@@ -24,6 +24,7 @@
 namespace mb
 {
 
+bool request_reboot_via_init(const std::string &reboot_arg);
 bool reboot_via_init(const std::string &reboot_arg);
 bool reboot_directly(const std::string &reboot_arg);
 
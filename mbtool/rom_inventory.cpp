@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rom_inventory.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "autoclose/file.h"
+#include "util/finally.h"
+#include "util/logging.h"
+#include "util/path.h"
+#include "util/string.h"
+
+#define PROP_VERSION            "ro.build.version.release"
+#define PROP_BUILD              "ro.build.display.id"
+
+// Changes to the set of entries in a directory
+#define DIR_EVENTS              (IN_CREATE | IN_DELETE | IN_MOVED_FROM \
+                                | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+// Also catches build.prop being rewritten in place
+#define BUILD_PROP_DIR_EVENTS   (DIR_EVENTS | IN_CLOSE_WRITE)
+// Used on the closest existing parent of a directory that does not exist yet
+#define PARENT_DIR_EVENTS       (IN_CREATE | IN_MOVED_TO | IN_DELETE_SELF \
+                                | IN_MOVE_SELF)
+
+namespace mb
+{
+
+// Only the two properties shown by the app are needed, so stop reading as soon
+// as both are found instead of parsing the whole file
+static void read_build_info(const std::string &path, InstalledRom *info)
+{
+    autoclose::file fp(autoclose::fopen(path.c_str(), "r"));
+    if (!fp) {
+        return;
+    }
+
+    char *line = nullptr;
+    size_t len = 0;
+    ssize_t read;
+    bool have_version = false;
+    bool have_build = false;
+
+    auto free_line = util::finally([&] {
+        free(line);
+    });
+
+    while ((!have_version || !have_build)
+            && (read = getline(&line, &len, fp.get())) >= 0) {
+        if (read > 0 && line[read - 1] == '\n') {
+            line[--read] = '\0';
+        }
+
+        char *equals = strchr(line, '=');
+        if (line[0] == '#' || !equals) {
+            continue;
+        }
+        *equals = '\0';
+
+        if (!have_version && strcmp(line, PROP_VERSION) == 0) {
+            info->version = equals + 1;
+            have_version = true;
+        } else if (!have_build && strcmp(line, PROP_BUILD) == 0) {
+            info->build = equals + 1;
+            have_build = true;
+        }
+    }
+}
+
+// procfs files report a size of 0, so read until EOF
+static bool read_mountinfo(std::string *out)
+{
+    int fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGW("Failed to open /proc/self/mountinfo: %s", strerror(errno));
+        return false;
+    }
+
+    auto close_fd = util::finally([&]{
+        close(fd);
+    });
+
+    out->clear();
+
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGW("Failed to read /proc/self/mountinfo: %s", strerror(errno));
+            return false;
+        }
+        out->append(buf, n);
+    }
+
+    return true;
+}
+
+static std::string build_prop_path(const Rom &rom,
+                                   const std::string &system_path)
+{
+    std::string path;
+    if (rom.system_is_image) {
+        path += "/raw/images/";
+        path += rom.id;
+    } else {
+        path += system_path;
+    }
+    path += "/build.prop";
+    return path;
+}
+
+RomInventory::RomInventory() : _inotify_fd(-1), _valid(false)
+{
+}
+
+RomInventory::~RomInventory()
+{
+    if (_inotify_fd >= 0) {
+        close(_inotify_fd);
+    }
+}
+
+/*!
+ * \brief Get the process-wide inventory
+ */
+RomInventory & RomInventory::get()
+{
+    static RomInventory inventory;
+    return inventory;
+}
+
+/*!
+ * \brief Get the installed ROMs, rescanning only if something changed
+ */
+std::shared_ptr<const InstalledRomList> RomInventory::installed_roms()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!is_valid_locked()) {
+        refresh_locked();
+    }
+
+    return _roms;
+}
+
+/*!
+ * \brief Get the booted ROM from the cached list of installed ROMs
+ */
+std::shared_ptr<Rom> RomInventory::current_rom()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!is_valid_locked()) {
+        refresh_locked();
+    }
+
+    return _current_rom;
+}
+
+/*!
+ * \brief Force the next query to rescan
+ */
+void RomInventory::invalidate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _valid = false;
+}
+
+bool RomInventory::is_valid_locked()
+{
+    if (!_valid || _inotify_fd < 0) {
+        return false;
+    }
+
+    // Any pending event (including IN_Q_OVERFLOW and IN_IGNORED from an
+    // unmount) means the cached list may be stale. The events are only
+    // counted, not read: connection processes forked by the daemon share the
+    // inotify instance and must not consume events that the daemon still needs
+    // to see. A new instance is created for the next scan anyway.
+    int pending;
+    if (ioctl(_inotify_fd, FIONREAD, &pending) < 0) {
+        LOGW("Failed to query inotify events: %s", strerror(errno));
+        _valid = false;
+    } else if (pending > 0) {
+        _valid = false;
+    }
+
+    // inotify does not report mounts, so an extsd or other partition mounted
+    // after the scan would otherwise go unnoticed
+    std::string mounts;
+    if (_valid && (!read_mountinfo(&mounts) || mounts != _mounts)) {
+        _valid = false;
+    }
+
+    return _valid;
+}
+
+void RomInventory::refresh_locked()
+{
+    if (_inotify_fd >= 0) {
+        close(_inotify_fd);
+    }
+
+    _inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotify_fd < 0) {
+        LOGW("Failed to initialize inotify: %s", strerror(errno));
+    }
+
+    // Read before the scan for the same reason as the inotify watches are
+    // added first
+    bool have_mounts = read_mountinfo(&_mounts);
+
+    // Add the watches before scanning so that changes made during the scan
+    // are not missed
+    Roms all_roms;
+    all_roms.add_all();
+    if (_inotify_fd >= 0) {
+        add_watches(all_roms);
+    }
+
+    Roms installed;
+    installed.add_installed();
+
+    std::shared_ptr<InstalledRomList> list =
+            std::make_shared<InstalledRomList>();
+    list->reserve(installed.roms.size());
+
+    for (auto rom : installed.roms) {
+        InstalledRom info;
+        info.rom = rom;
+        info.system_path = rom->full_system_path();
+        info.cache_path = rom->full_cache_path();
+        info.data_path = rom->full_data_path();
+        read_build_info(build_prop_path(*rom, info.system_path), &info);
+        list->push_back(std::move(info));
+    }
+
+    _roms = std::move(list);
+    _current_rom = Roms::get_current_rom(installed);
+
+    // Without inotify or mountinfo, every query rescans like before
+    _valid = _inotify_fd >= 0 && have_mounts;
+}
+
+void RomInventory::add_watches(const Roms &all_roms)
+{
+    // New or removed data-slot and extsd-slot ROMs
+    add_watch(get_raw_path("/data/multiboot"), DIR_EVENTS);
+
+    for (const std::string &mount_point : Roms::get_extsd_mount_points()) {
+        std::string dir(mount_point);
+        dir += "/multiboot";
+        if (access(mount_point.c_str(), F_OK) == 0) {
+            add_watch(std::move(dir), DIR_EVENTS);
+        }
+    }
+
+    // Installation, removal, or modification of each possible ROM
+    for (auto rom : all_roms.roms) {
+        std::string system_path = rom->full_system_path();
+        if (system_path.empty()) {
+            continue;
+        }
+
+        if (rom->system_is_image) {
+            add_watch(util::dir_name(system_path), DIR_EVENTS);
+        }
+        add_watch(util::dir_name(build_prop_path(*rom, system_path)),
+                  BUILD_PROP_DIR_EVENTS);
+    }
+}
+
+// If the directory does not exist, its closest existing parent is watched
+// instead so that its creation is noticed
+void RomInventory::add_watch(std::string path, uint32_t mask)
+{
+    if (_inotify_fd < 0) {
+        return;
+    }
+
+    while (!path.empty()) {
+        if (inotify_add_watch(_inotify_fd, path.c_str(),
+                              mask | IN_ONLYDIR) >= 0) {
+            return;
+        } else if (errno != ENOENT && errno != ENOTDIR) {
+            LOGW("%s: Failed to add inotify watch: %s",
+                 path.c_str(), strerror(errno));
+            // Without the watch, a change could go unnoticed
+            _valid = false;
+            close(_inotify_fd);
+            _inotify_fd = -1;
+            return;
+        } else if (path == "/") {
+            return;
+        }
+
+        path = util::dir_name(path);
+        mask = PARENT_DIR_EVENTS;
+    }
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include "roms.h"
+
+namespace mb
+{
+
+struct InstalledRom
+{
+    std::shared_ptr<Rom> rom;
+    // Resolved paths, which require stat()'ing the partition mount points
+    std::string system_path;
+    std::string cache_path;
+    std::string data_path;
+    // ro.build.version.release and ro.build.display.id from the ROM's
+    // build.prop. These are empty if the properties are unavailable.
+    std::string version;
+    std::string build;
+};
+
+typedef std::vector<InstalledRom> InstalledRomList;
+
+// Cached list of installed ROMs. The list is rebuilt only after inotify reports
+// a change to the multiboot directories or to one of the ROMs' build.prop
+// files, or after the mount table changes (eg. an SD card being inserted), so
+// repeated queries do not rescan the filesystem. Checking for changes does not
+// consume them, so a forked process can safely use an inherited inventory.
+class RomInventory
+{
+public:
+    RomInventory();
+    ~RomInventory();
+
+    std::shared_ptr<const InstalledRomList> installed_roms();
+    std::shared_ptr<Rom> current_rom();
+
+    void invalidate();
+
+    static RomInventory & get();
+
+    RomInventory(const RomInventory &) = delete;
+    RomInventory & operator=(const RomInventory &) = delete;
+
+private:
+    bool is_valid_locked();
+    void refresh_locked();
+    void add_watches(const Roms &all_roms);
+    void add_watch(std::string path, uint32_t mask);
+
+    std::mutex _mutex;
+    int _inotify_fd;
+    // /proc/self/mountinfo at the time of the last scan
+    std::string _mounts;
+    bool _valid;
+    std::shared_ptr<const InstalledRomList> _roms;
+    std::shared_ptr<Rom> _current_rom;
+};
+
+}
@@ -246,12 +246,20 @@ void Roms::add_extsd_roms()
     }
 }
 
+/*!
+ * \brief Add every ROM that could be installed, whether it exists or not
+ */
+void Roms::add_all()
+{
+    add_builtin();
+    add_data_roms();
+    add_extsd_roms();
+}
+
 void Roms::add_installed()
 {
     Roms all_roms;
-    all_roms.add_builtin();
-    all_roms.add_data_roms();
-    all_roms.add_extsd_roms();
+    all_roms.add_all();
 
     struct stat sb;
 
@@ -291,6 +299,14 @@ std::shared_ptr<Rom> Roms::get_current_rom()
     Roms roms;
     roms.add_installed();
 
+    return get_current_rom(roms);
+}
+
+/*!
+ * \brief Find the booted ROM in an existing list of installed ROMs
+ */
+std::shared_ptr<Rom> Roms::get_current_rom(const Roms &roms)
+{
     // This is set if mbtool is handling the boot process
     std::string prop_id;
     util::get_property("ro.multiboot.romid", &prop_id, std::string());
@@ -440,6 +456,11 @@ std::string Roms::get_extsd_partition()
     }
 }
 
+const std::vector<std::string> & Roms::get_extsd_mount_points()
+{
+    return extsd_mount_points;
+}
+
 std::string Roms::get_mountpoint(Rom::Source source)
 {
     switch (source) {
@@ -77,11 +77,13 @@ private:
     void add_data_roms();
     void add_extsd_roms();
 public:
+    void add_all();
     void add_installed();
 
     std::shared_ptr<Rom> find_by_id(const std::string &id) const;
 
     static std::shared_ptr<Rom> get_current_rom();
+    static std::shared_ptr<Rom> get_current_rom(const Roms &installed);
 
     static std::shared_ptr<Rom> create_rom(const std::string &id);
     static bool is_valid(const std::string &id);
@@ -90,6 +92,7 @@ public:
     static std::string get_cache_partition();
     static std::string get_data_partition();
     static std::string get_extsd_partition();
+    static const std::vector<std::string> & get_extsd_mount_points();
     static std::string get_mountpoint(Rom::Source source);
 };
 
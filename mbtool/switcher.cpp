@@ -19,13 +19,21 @@
 
 #include "switcher.h"
 
+#include <algorithm>
+#include <thread>
+
+#include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <openssl/sha.h>
 
+#include "checksums.h"
 #include "multiboot.h"
 #include "roms.h"
 #include "util/chmod.h"
@@ -34,150 +42,391 @@
 #include "util/directory.h"
 #include "util/file.h"
 #include "util/finally.h"
+#include "util/hash.h"
 #include "util/logging.h"
 #include "util/path.h"
 #include "util/properties.h"
 #include "util/selinux.h"
 #include "util/string.h"
 
-#define CHECKSUMS_PATH "/data/multiboot/checksums.prop"
+// Root-only directory where images are staged before they are flashed
+#define STAGING_DIR "/data/multiboot/staging"
+
+// Size and alignment of the buffer used for staging and flashing images
+#define FLASH_BUF_SIZE (1024 * 1024)
+#define FLASH_BUF_ALIGN 4096
+// Granularity of the comparison when flashing. Only blocks that differ from
+// the existing data are written.
+#define FLASH_BLOCK_SIZE 4096
 
 namespace mb
 {
 
-/*!
- * \brief Check a checksum property
- *
- * \param props Pointer to properties map
- * \param rom_id ROM ID
- * \param image Image filename (without directory)
- * \param sha512_out SHA512 hex digest output
- *
- * \return ChecksumsGetResult::FOUND if the hash was successfully retrieved,
- *         ChecksumsGetResult::NOT_FOUND if the hash does not exist in the map,
- *         ChecksumsGetResult::MALFORMED if the property has an invalid format
- */
-ChecksumsGetResult checksums_get(std::unordered_map<std::string, std::string> *props,
-                                 const std::string &rom_id,
-                                 const std::string &image,
-                                 std::string *sha512_out)
+struct Flashable
 {
-    std::string checksums_path = get_raw_path(CHECKSUMS_PATH);
+    std::string image;
+    std::string block_dev;
+    std::string expected_hash;
+    std::string hash;
+    // Private copy of the image that is flashed after it has been verified
+    int fd = -1;
+    uint64_t size = 0;
+    std::string error;
+};
+
+// Buffer for staging or flashing. The alignment keeps the writes to block
+// devices page aligned.
+struct FlashBuffer
+{
+    char *data = nullptr;
+
+    FlashBuffer()
+    {
+        if (posix_memalign(reinterpret_cast<void **>(&data), FLASH_BUF_ALIGN,
+                           FLASH_BUF_SIZE) != 0) {
+            data = nullptr;
+        }
+    }
+
+    ~FlashBuffer()
+    {
+        free(data);
+    }
 
-    std::string key(rom_id);
-    key += "/";
-    key += image;
+    FlashBuffer(const FlashBuffer &) = delete;
+    FlashBuffer & operator=(const FlashBuffer &) = delete;
+};
 
-    if (props->find(key) == props->end()) {
-        return ChecksumsGetResult::NOT_FOUND;
+static bool write_fully(int fd, const char *data, std::size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            if (n == 0) {
+                errno = EIO;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
     }
+    return true;
+}
 
-    const std::string &value = (*props)[key];
+static ssize_t read_retry(int fd, char *data, std::size_t size)
+{
+    ssize_t n;
+    do {
+        n = read(fd, data, size);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
 
-    std::size_t pos = value.find(":");
-    if (pos != std::string::npos) {
-        std::string algo = value.substr(0, pos);
-        std::string hash = value.substr(pos + 1);
-        if (algo != "sha512") {
-            LOGE("%s: Invalid hash algorithm: %s",
-                 checksums_path.c_str(), algo.c_str());
-            return ChecksumsGetResult::MALFORMED;
+// Like read_retry(), but only returns less than size at the end of the file
+static ssize_t read_full(int fd, char *data, std::size_t size)
+{
+    std::size_t total = 0;
+    while (total < size) {
+        ssize_t n = read_retry(fd, data + total, size - total);
+        if (n < 0) {
+            return -1;
+        } else if (n == 0) {
+            break;
         }
+        total += n;
+    }
+    return total;
+}
 
-        *sha512_out = hash;
-        return ChecksumsGetResult::FOUND;
-    } else {
-        LOGE("%s: Invalid checksum property: %s=%s",
-             checksums_path.c_str(), key.c_str(), value.c_str());
-        return ChecksumsGetResult::MALFORMED;
+static ssize_t pread_full(int fd, char *data, std::size_t size, off64_t offset)
+{
+    std::size_t total = 0;
+    while (total < size) {
+        ssize_t n = pread64(fd, data + total, size - total, offset + total);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0) {
+            return -1;
+        } else if (n == 0) {
+            break;
+        }
+        total += n;
     }
+    return total;
 }
 
+static bool pwrite_full(int fd, const char *data, std::size_t size,
+                        off64_t offset)
+{
+    while (size > 0) {
+        ssize_t n = pwrite64(fd, data, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            if (n == 0) {
+                errno = EIO;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+struct DiffWriteResult
+{
+    uint64_t blocks_total = 0;
+    uint64_t blocks_written = 0;
+};
+
 /*!
- * \brief Update a checksum property
+ * \brief Copy data to a file or block device, skipping unchanged blocks
+ *
+ * Reads \a fd_source from its current position until the end and compares it
+ * with the existing contents of \a fd_target (from offset 0) one block at a
+ * time. Only runs of differing blocks are written. If nothing differs, the
+ * target is not written to or synced at all. Regular target files are
+ * truncated to the size of the source.
  *
- * \param props Pointer to properties map
- * \param rom_id ROM ID
- * \param image Image filename (without directory)
- * \param sha512 SHA512 hex digest
+ * \param ctx If not null, the source data is added to this hash
  */
-void checksums_update(std::unordered_map<std::string, std::string> *props,
-                      const std::string &rom_id,
-                      const std::string &image,
-                      const std::string &sha512)
+static bool write_differential(int fd_source, int fd_target, SHA512_CTX *ctx,
+                               DiffWriteResult *result)
 {
-    std::string key(rom_id);
-    key += "/";
-    key += image;
+    FlashBuffer source_buf;
+    FlashBuffer target_buf;
+    if (!source_buf.data || !target_buf.data) {
+        errno = ENOMEM;
+        return false;
+    }
+
+    uint64_t offset = 0;
+    bool modified = false;
 
-    (*props)[key] = "sha512:";
-    (*props)[key] += sha512;
+    while (true) {
+        ssize_t n = read_full(fd_source, source_buf.data, FLASH_BUF_SIZE);
+        if (n < 0) {
+            return false;
+        } else if (n == 0) {
+            break;
+        }
+
+        if (ctx) {
+            SHA512_Update(ctx, source_buf.data, n);
+        }
+
+        // Whatever is past the end of the target differs
+        ssize_t target_n = pread_full(fd_target, target_buf.data, n, offset);
+        if (target_n < 0) {
+            return false;
+        }
+
+        ssize_t run_start = -1;
+
+        // The iteration past the last block writes out the final run
+        for (ssize_t pos = 0; ; pos += FLASH_BLOCK_SIZE) {
+            bool at_end = pos >= n;
+            bool differs = false;
+            if (!at_end) {
+                ssize_t size = std::min<ssize_t>(FLASH_BLOCK_SIZE, n - pos);
+                differs = pos + size > target_n || memcmp(
+                        source_buf.data + pos, target_buf.data + pos, size) != 0;
+                ++result->blocks_total;
+            }
+
+            if (differs && run_start < 0) {
+                run_start = pos;
+            } else if (!differs && run_start >= 0) {
+                ssize_t run_end = std::min(pos, n);
+                if (!pwrite_full(fd_target, source_buf.data + run_start,
+                                 run_end - run_start, offset + run_start)) {
+                    return false;
+                }
+                result->blocks_written += (run_end - run_start
+                        + FLASH_BLOCK_SIZE - 1) / FLASH_BLOCK_SIZE;
+                run_start = -1;
+                modified = true;
+            }
+
+            if (at_end) {
+                break;
+            }
+        }
+
+        offset += n;
+    }
+
+    struct stat sb;
+    if (fstat(fd_target, &sb) < 0) {
+        return false;
+    }
+    if (S_ISREG(sb.st_mode) && (uint64_t) sb.st_size != offset) {
+        if (ftruncate64(fd_target, offset) < 0) {
+            return false;
+        }
+        modified = true;
+    }
+
+    return !modified || fsync(fd_target) == 0;
 }
 
 /*!
- * \brief Read checksums properties from \a /data/multiboot/checksums.prop
+ * \brief Create the root-only staging directory
  *
- * \param props Pointer to properties map
- *
- * \return True if the file was successfully read. Otherwise, false.
+ * An existing directory is only used if it is a real directory owned by root.
  */
-bool checksums_read(std::unordered_map<std::string, std::string> *props)
+static bool prepare_staging_dir(const std::string &path)
 {
-    std::string checksums_path = get_raw_path(CHECKSUMS_PATH);
+    if (!util::mkdir_parent(path, 0755)
+            || (mkdir(path.c_str(), 0700) < 0 && errno != EEXIST)) {
+        LOGE("%s: Failed to create directory: %s",
+             path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat sb;
+    if (lstat(path.c_str(), &sb) < 0) {
+        LOGE("%s: Failed to stat: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (!S_ISDIR(sb.st_mode) || sb.st_uid != 0) {
+        LOGE("%s: Not a directory owned by root", path.c_str());
+        return false;
+    }
 
-    if (!util::file_get_all_properties(checksums_path, props)) {
-        LOGE("%s: Failed to load properties", checksums_path.c_str());
+    if ((sb.st_mode & 07777) != 0700 && chmod(path.c_str(), 0700) < 0) {
+        LOGE("%s: Failed to chmod: %s", path.c_str(), strerror(errno));
         return false;
     }
+
     return true;
 }
 
 /*!
- * \brief Write checksums properties to \a /data/multiboot/checksums.prop
- *
- * \param props Properties map
+ * \brief Open an anonymous file in the staging directory
  *
- * \return True if successfully written. Otherwise, false.
+ * The file has no name, so nothing else can open it. O_TMPFILE requires Linux
+ * 3.11 and filesystem support. Otherwise, a named file is created and
+ * immediately unlinked.
  */
-bool checksums_write(const std::unordered_map<std::string, std::string> &props)
+static int open_staging_file(const std::string &dir)
 {
-    std::string checksums_path = get_raw_path(CHECKSUMS_PATH);
+#ifdef O_TMPFILE
+    int fd = open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd >= 0) {
+        return fd;
+    } else if (errno != EISDIR && errno != EOPNOTSUPP && errno != EINVAL) {
+        return -1;
+    }
+#endif
+
+    std::string path(dir);
+    path += "/image.XXXXXX";
+
+    int fd2 = mkstemp(&path[0]);
+    if (fd2 < 0) {
+        return -1;
+    }
 
-    if (remove(checksums_path.c_str()) < 0 && errno != ENOENT) {
-        LOGW("%s: Failed to remove file: %s",
-             checksums_path.c_str(), strerror(errno));
+    if (unlink(path.c_str()) < 0) {
+        int saved_errno = errno;
+        close(fd2);
+        errno = saved_errno;
+        return -1;
     }
 
-    util::mkdir_parent(checksums_path, 0755);
-    util::create_empty_file(checksums_path);
+    fcntl(fd2, F_SETFD, FD_CLOEXEC);
+    return fd2;
+}
 
-    if (!util::chown(checksums_path, 0, 0, 0)) {
-        LOGW("%s: Failed to chown file: %s",
-             checksums_path.c_str(), strerror(errno));
+/*!
+ * \brief Copy an image to the staging directory while hashing it
+ *
+ * The hash is computed from the data that is written to the staged copy, so
+ * the image that is flashed is exactly the one that was verified, even if the
+ * source file is modified in the meantime.
+ */
+static bool stage_image(Flashable *f, const std::string &staging_dir)
+{
+    int fd_source = open(f->image.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_source < 0) {
+        f->error = std::string("Failed to open image: ") + strerror(errno);
+        return false;
     }
-    if (chmod(checksums_path.c_str(), 0700) < 0) {
-        LOGW("%s: Failed to chmod file: %s",
-             checksums_path.c_str(), strerror(errno));
+
+    auto close_source = util::finally([&]{
+        close(fd_source);
+    });
+
+    f->fd = open_staging_file(staging_dir);
+    if (f->fd < 0) {
+        f->error = std::string("Failed to create staging file: ")
+                + strerror(errno);
+        return false;
     }
 
-    if (!util::file_write_properties(checksums_path, props)) {
-        LOGW("%s: Failed to write new properties: %s",
-             checksums_path.c_str(), strerror(errno));
+    bool write_failed = false;
+    util::HashResult result;
+
+    bool ret = util::hash_fd(fd_source, util::HASH_SHA512, &result,
+                             [&](const char *data, size_t size) {
+        if (!write_fully(f->fd, data, size)) {
+            write_failed = true;
+            return false;
+        }
+        f->size += size;
+        return true;
+    });
+    if (!ret) {
+        f->error = std::string(write_failed
+                ? "Failed to write staging file: "
+                : "Failed to read image: ") + strerror(errno);
         return false;
     }
 
+    f->hash = util::hex_string(result.sha512, SHA512_DIGEST_LENGTH);
+
     return true;
 }
 
-struct Flashable
+/*!
+ * \brief Write the staged image to its block device
+ *
+ * Blocks that already contain the right data are not rewritten, which is
+ * common when switching back and forth between ROMs.
+ */
+static bool flash_image(const Flashable &f)
 {
-    std::string image;
-    std::string block_dev;
-    std::string expected_hash;
-    std::string hash;
-    unsigned char *data = nullptr;
-    std::size_t size = 0;
-};
+    int fd_target = open(f.block_dev.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd_target < 0) {
+        return false;
+    }
+
+    auto close_target = util::finally([&]{
+        int saved_errno = errno;
+        close(fd_target);
+        errno = saved_errno;
+    });
+
+    if (lseek(f.fd, 0, SEEK_SET) < 0) {
+        return false;
+    }
+
+    DiffWriteResult result;
+    if (!write_differential(f.fd, fd_target, nullptr, &result)) {
+        return false;
+    }
+
+    LOGD("%s: Wrote %" PRIu64 "/%" PRIu64 " blocks",
+         f.block_dev.c_str(), result.blocks_written, result.blocks_total);
+
+    return true;
+}
 
 /*!
  * \brief Perform non-recursive search for a block device
@@ -325,14 +574,21 @@ SwitchRomResult switch_rom(const std::string &id, const std::string &boot_blockd
         return SwitchRomResult::FAILED;
     }
 
-    // We'll read the files we want to flash into memory so a malicious app
-    // can't change the file between the hash verification step and flashing
-    // step.
+    // We'll copy the files we want to flash to a root-only directory so a
+    // malicious app can't change the file between the hash verification step
+    // and flashing step. The copies are on disk, so memory usage doesn't
+    // depend on the size of the images.
+    std::string staging_dir = get_raw_path(STAGING_DIR);
+    if (!prepare_staging_dir(staging_dir)) {
+        return SwitchRomResult::FAILED;
+    }
 
     std::vector<Flashable> flashables;
-    auto free_flashables = util::finally([&]{
+    auto close_flashables = util::finally([&]{
         for (Flashable &f : flashables) {
-            free(f.data);
+            if (f.fd >= 0) {
+                close(f.fd);
+            }
         }
     });
 
@@ -344,33 +600,47 @@ SwitchRomResult switch_rom(const std::string &id, const std::string &boot_blockd
         LOGW("Failed to find extra images");
     }
 
-    std::unordered_map<std::string, std::string> props;
-    checksums_read(&props);
+    ChecksumStore checksums;
+    if (!force_update_checksums && !checksums.load()) {
+        return SwitchRomResult::FAILED;
+    }
 
-    for (Flashable &f : flashables) {
-        // If memory becomes an issue, an alternative method is to create a
-        // temporary directory in /data/multiboot/ that's only writable by root
-        // and copy the images there.
-        if (!util::file_read_all(f.image, &f.data, &f.size)) {
-            LOGE("%s: Failed to read image: %s",
-                 f.image.c_str(), strerror(errno));
+    // Stage and hash the images in parallel
+    std::vector<char> staged(flashables.size());
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < flashables.size(); ++i) {
+        threads.emplace_back([&, i]{
+            staged[i] = stage_image(&flashables[i], staging_dir);
+        });
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    for (std::size_t i = 0; i < flashables.size(); ++i) {
+        Flashable &f = flashables[i];
+
+        if (!staged[i]) {
+            LOGE("%s: %s", f.image.c_str(), f.error.c_str());
             return SwitchRomResult::FAILED;
         }
 
-        // Get actual sha512sum
-        unsigned char digest[SHA512_DIGEST_LENGTH];
-        SHA512(f.data, f.size, digest);
-        f.hash = util::hex_string(digest, SHA512_DIGEST_LENGTH);
-
         if (force_update_checksums) {
-            checksums_update(&props, id, util::base_name(f.image), f.hash);
+            f.expected_hash = f.hash;
+            continue;
         }
 
         // Get expected sha512sum
-        ChecksumsGetResult ret = checksums_get(
-                &props, id, util::base_name(f.image), &f.expected_hash);
+        std::string algo;
+        ChecksumsGetResult ret = checksums.get(
+                id, util::base_name(f.image), &algo, &f.expected_hash);
         if (ret == ChecksumsGetResult::MALFORMED) {
             return SwitchRomResult::CHECKSUM_INVALID;
+        } else if (ret == ChecksumsGetResult::FOUND
+                && algo != CHECKSUMS_ALGO_SHA512) {
+            LOGE("%s: Unsupported hash algorithm: %s",
+                 f.image.c_str(), algo.c_str());
+            return SwitchRomResult::CHECKSUM_INVALID;
         }
 
         // Verify hashes if we have an expected hash
@@ -393,9 +663,7 @@ SwitchRomResult switch_rom(const std::string &id, const std::string &boot_blockd
 
     // Now we can flash the images
     for (Flashable &f : flashables) {
-        // Cast is okay. The data is just passed to fwrite (ie. no signed
-        // extension issues)
-        if (!util::file_write_data(f.block_dev, (char *) f.data, f.size)) {
+        if (!flash_image(f)) {
             LOGE("%s: Failed to write image: %s",
                  f.block_dev.c_str(), strerror(errno));
             return SwitchRomResult::FAILED;
@@ -403,8 +671,14 @@ SwitchRomResult switch_rom(const std::string &id, const std::string &boot_blockd
     }
 
     if (force_update_checksums) {
-        LOGD("Updating checksums file");
-        checksums_write(props);
+        LOGD("Updating checksums");
+        for (Flashable &f : flashables) {
+            if (!checksums.set(id, util::base_name(f.image),
+                               CHECKSUMS_ALGO_SHA512, f.hash)) {
+                LOGE("%s: Failed to update checksum", f.image.c_str());
+                return SwitchRomResult::FAILED;
+            }
+        }
     }
 
     if (!fix_multiboot_permissions()) {
@@ -453,43 +727,59 @@ bool set_kernel(const std::string &id, const std::string &boot_blockdev)
         return false;
     }
 
-    unsigned char *data;
-    std::size_t size;
-
-    if (!util::file_read_all(boot_blockdev, &data, &size)) {
-        LOGE("%s: Failed to read block device: %s",
+    // Copy the boot partition to boot.img, hashing the data as it is read.
+    // Unchanged blocks of an existing boot.img are not rewritten.
+    int fd_source = open(boot_blockdev.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_source < 0) {
+        LOGE("%s: Failed to open block device: %s",
              boot_blockdev.c_str(), strerror(errno));
         return false;
     }
 
-    auto free_data = util::finally([&]{
-        free(data);
+    auto close_source = util::finally([&]{
+        close(fd_source);
+    });
+
+    int fd_target = open(bootimg_path.c_str(),
+                         O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd_target < 0) {
+        LOGE("%s: Failed to open image: %s",
+             bootimg_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    auto close_target = util::finally([&]{
+        close(fd_target);
     });
 
+    SHA512_CTX ctx;
+    SHA512_Init(&ctx);
+
+    DiffWriteResult result;
+    if (!write_differential(fd_source, fd_target, &ctx, &result)) {
+        LOGE("%s: Failed to copy to %s: %s", boot_blockdev.c_str(),
+             bootimg_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    LOGD("%s: Wrote %" PRIu64 "/%" PRIu64 " blocks",
+         bootimg_path.c_str(), result.blocks_written, result.blocks_total);
+
     // Get actual sha512sum
     unsigned char digest[SHA512_DIGEST_LENGTH];
-    SHA512(data, size, digest);
+    SHA512_Final(digest, &ctx);
     std::string hash = util::hex_string(digest, SHA512_DIGEST_LENGTH);
 
-    // Add to checksums.prop
-    std::unordered_map<std::string, std::string> props;
-    checksums_read(&props);
-    checksums_update(&props, id, "boot.img", hash);
-
     // NOTE: This function isn't responsible for updating the checksums for
     //       any extra images. We don't want to mask any malicious changes.
 
-    // Cast is okay. The data is just passed to fwrite (ie. no signed
-    // extension issues)
-    if (!util::file_write_data(bootimg_path, (char *) data, size)) {
-        LOGE("%s: Failed to write image: %s",
-             bootimg_path.c_str(), strerror(errno));
+    LOGD("Updating checksums");
+    ChecksumStore checksums;
+    if (!checksums.set(id, "boot.img", CHECKSUMS_ALGO_SHA512, hash)) {
+        LOGE("%s: Failed to update checksum", bootimg_path.c_str());
         return false;
     }
 
-    LOGD("Updating checksums file");
-    checksums_write(props);
-
     if (!fix_multiboot_permissions()) {
         //return false;
     }
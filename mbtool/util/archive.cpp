@@ -21,9 +21,17 @@
 
 #include <algorithm>
 #include <memory>
+#include <unordered_map>
 #include <cerrno>
 #include <cstring>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "minizip/ioandroid.h"
+#include "minizip/unzip.h"
+
 #include "autoclose/archive.h"
 #include "util/directory.h"
 #include "util/finally.h"
@@ -567,6 +575,262 @@ static void set_up_output(archive *out)
                                    ARCHIVE_EXTRACT_XATTR);
 }
 
+/*!
+ * \brief Open a zip file for random access
+ *
+ * minizip reads the central directory when the file is opened, so entries can
+ * be found and extracted without reading through the rest of the archive.
+ *
+ * \return unzFile handle or nullptr if \a filename is not a regular file or
+ *         not a zip file with a readable central directory. libarchive's
+ *         streaming reader should be used in that case.
+ */
+static unzFile zip_open_seekable(const std::string &filename)
+{
+    struct stat sb;
+    if (stat(filename.c_str(), &sb) < 0 || !S_ISREG(sb.st_mode)) {
+        return nullptr;
+    }
+
+    zlib_filefunc64_def zFunc;
+    memset(&zFunc, 0, sizeof(zFunc));
+    fill_android_filefunc64(&zFunc);
+
+    return unzOpen2_64(filename.c_str(), &zFunc);
+}
+
+/*!
+ * \brief Find the central directory positions of entries
+ *
+ * Only the central directory is traversed. The local headers and file data
+ * are not read.
+ *
+ * \param uf Zip file handle
+ * \param names Entries to search for
+ * \param[out] positions Positions of the entries that were found
+ *
+ * \return Whether the central directory was fully read
+ */
+static bool zip_find_entries(
+        unzFile uf, const std::vector<std::string> &names,
+        std::unordered_map<std::string, unz64_file_pos> *positions)
+{
+    std::vector<char> name_buf(4096);
+    unz_file_info64 fi;
+
+    int ret = unzGoToFirstFile(uf);
+    if (ret == UNZ_END_OF_LIST_OF_FILE) {
+        // Empty archive
+        return true;
+    }
+
+    for (; ret == UNZ_OK; ret = unzGoToNextFile(uf)) {
+        ret = unzGetCurrentFileInfo64(uf, &fi, name_buf.data(),
+                                      name_buf.size(), nullptr, 0, nullptr, 0);
+        if (ret != UNZ_OK) {
+            LOGE("minizip: Failed to get entry metadata (error code: %d)", ret);
+            return false;
+        }
+
+        // Names longer than the buffer are truncated and cannot match anyway
+        if (fi.size_filename >= name_buf.size()) {
+            continue;
+        }
+
+        std::string name(name_buf.data(), fi.size_filename);
+        if (std::find(names.begin(), names.end(), name) == names.end()) {
+            continue;
+        }
+
+        unz64_file_pos pos;
+        ret = unzGetFilePos64(uf, &pos);
+        if (ret != UNZ_OK) {
+            LOGE("minizip: Failed to get entry position (error code: %d): %s",
+                 ret, name.c_str());
+            return false;
+        }
+
+        (*positions)[name] = pos;
+    }
+
+    if (ret != UNZ_END_OF_LIST_OF_FILE) {
+        LOGE("minizip: Failed to read central directory (error code: %d)",
+             ret);
+        return false;
+    }
+
+    return true;
+}
+
+static bool write_fully(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Extract the current zip entry to a path
+ *
+ * Like libarchive with ARCHIVE_EXTRACT_UNLINK and ARCHIVE_EXTRACT_PERM, an
+ * existing file at \a target is replaced and the permissions stored in the
+ * zip (if it was created on a Unix system) are applied.
+ */
+static bool zip_extract_current(unzFile uf, const std::string &name,
+                                const std::string &target)
+{
+    unz_file_info64 fi;
+    int ret = unzGetCurrentFileInfo64(uf, &fi, nullptr, 0,
+                                      nullptr, 0, nullptr, 0);
+    if (ret != UNZ_OK) {
+        LOGE("minizip: Failed to get entry metadata (error code: %d): %s",
+             ret, name.c_str());
+        return false;
+    }
+
+    mode_t mode = 0644;
+    mode_t unix_mode = fi.external_fa >> 16;
+    if ((fi.version >> 8) == 3 && unix_mode != 0) {
+        if (!S_ISREG(unix_mode)) {
+            LOGE("%s: Only regular files can be extracted", name.c_str());
+            return false;
+        }
+        mode = unix_mode & 07777;
+    }
+
+    if (!mkdir_parent(target, 0755)) {
+        LOGE("%s: Failed to create parent directory: %s",
+             target.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (unlink(target.c_str()) < 0 && errno != ENOENT) {
+        LOGE("%s: Failed to remove existing file: %s",
+             target.c_str(), strerror(errno));
+        return false;
+    }
+
+    int fd = open(target.c_str(),
+                  O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+    if (fd < 0) {
+        LOGE("%s: Failed to open for writing: %s",
+             target.c_str(), strerror(errno));
+        return false;
+    }
+
+    auto close_fd = finally([&] {
+        close(fd);
+    });
+
+    // open() applies the umask
+    fchmod(fd, mode);
+
+    ret = unzOpenCurrentFile(uf);
+    if (ret != UNZ_OK) {
+        LOGE("minizip: Failed to open entry (error code: %d): %s",
+             ret, name.c_str());
+        return false;
+    }
+
+    std::vector<char> buf(65536);
+    int n;
+
+    while ((n = unzReadCurrentFile(uf, buf.data(), buf.size())) > 0) {
+        if (!write_fully(fd, buf.data(), n)) {
+            LOGE("%s: Failed to write file: %s",
+                 target.c_str(), strerror(errno));
+            unzCloseCurrentFile(uf);
+            return false;
+        }
+    }
+
+    if (n < 0) {
+        LOGE("minizip: Failed to read entry (error code: %d): %s",
+             n, name.c_str());
+        unzCloseCurrentFile(uf);
+        return false;
+    }
+
+    // Also verifies the CRC32 checksum
+    ret = unzCloseCurrentFile(uf);
+    if (ret != UNZ_OK) {
+        LOGE("minizip: Failed to close entry (error code: %d): %s",
+             ret, name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static bool zip_extract_files(unzFile uf, const std::string &filename,
+                              const std::vector<extract_info> &files)
+{
+    std::vector<std::string> names;
+    std::unordered_map<std::string, unz64_file_pos> positions;
+
+    for (const extract_info &info : files) {
+        names.push_back(info.from);
+    }
+
+    if (!zip_find_entries(uf, names, &positions)) {
+        LOGE("%s: Failed to read zip file", filename.c_str());
+        return false;
+    }
+
+    for (const extract_info &info : files) {
+        auto it = positions.find(info.from);
+        if (it == positions.end()) {
+            LOGE("Not all specified files were extracted");
+            return false;
+        }
+
+        int ret = unzGoToFilePos64(uf, &it->second);
+        if (ret != UNZ_OK) {
+            LOGE("minizip: Failed to seek to entry (error code: %d): %s",
+                 ret, info.from.c_str());
+            return false;
+        }
+
+        if (!zip_extract_current(uf, info.from, info.to)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool zip_exists(unzFile uf, const std::string &filename,
+                       std::vector<exists_info> &files)
+{
+    std::vector<std::string> names;
+    std::unordered_map<std::string, unz64_file_pos> positions;
+
+    for (const exists_info &info : files) {
+        names.push_back(info.path);
+    }
+
+    if (!zip_find_entries(uf, names, &positions)) {
+        LOGE("%s: Failed to read zip file", filename.c_str());
+        return false;
+    }
+
+    for (exists_info &info : files) {
+        info.exists = positions.find(info.path) != positions.end();
+    }
+
+    return true;
+}
+
 bool extract_archive(const std::string &filename, const std::string &target)
 {
     autoclose::archive in(archive_read_new(), archive_read_free);
@@ -693,6 +957,13 @@ bool extract_files(const std::string &filename, const std::string &target,
     return true;
 }
 
+/*!
+ * \brief Extract entries from a zip file to arbitrary paths
+ *
+ * Regular zip files are read through their central directory and only the
+ * requested entries are read. libarchive is used to scan through the archive
+ * if \a filename is not seekable.
+ */
 bool extract_files2(const std::string &filename,
                     const std::vector<extract_info> &files)
 {
@@ -700,6 +971,15 @@ bool extract_files2(const std::string &filename,
         return false;
     }
 
+    unzFile uf = zip_open_seekable(filename);
+    if (uf) {
+        auto close_uf = finally([&] {
+            unzClose(uf);
+        });
+
+        return zip_extract_files(uf, filename, files);
+    }
+
     autoclose::archive in(archive_read_new(), archive_read_free);
     autoclose::archive out(archive_write_disk_new(), archive_write_free);
 
@@ -748,6 +1028,11 @@ bool extract_files2(const std::string &filename,
     return true;
 }
 
+/*!
+ * \brief Check whether entries exist in a zip file
+ *
+ * For regular zip files, only the central directory is read.
+ */
 bool archive_exists(const std::string &filename,
                     std::vector<exists_info> &files)
 {
@@ -755,6 +1040,15 @@ bool archive_exists(const std::string &filename,
         return false;
     }
 
+    unzFile uf = zip_open_seekable(filename);
+    if (uf) {
+        auto close_uf = finally([&] {
+            unzClose(uf);
+        });
+
+        return zip_exists(uf, filename, files);
+    }
+
     autoclose::archive in(archive_read_new(), archive_read_free);
 
     if (!in) {
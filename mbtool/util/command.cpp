@@ -34,6 +34,30 @@ namespace mb
 namespace util
 {
 
+static std::atomic<CommandCounters *> g_counters(nullptr);
+
+/*!
+ * \brief Set the counters that are incremented for every fork() and exec()
+ *
+ * The counters may live in memory shared with other processes. Pass nullptr to
+ * stop counting.
+ */
+void command_set_counters(CommandCounters *counters)
+{
+    g_counters = counters;
+}
+
+static void count_fork(bool exec)
+{
+    CommandCounters *counters = g_counters;
+    if (counters) {
+        counters->forks.fetch_add(1, std::memory_order_relaxed);
+        if (exec) {
+            counters->execs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
 int run_shell_command(const std::string &command)
 {
     // If /sbin/sh exists (eg. in recovery), then fork and run that. Otherwise,
@@ -50,12 +74,14 @@ int run_shell_command(const std::string &command)
                 execlp("/sbin/sh", "sh", "-c", command.c_str(), nullptr);
                 _exit(127);
             } else {
+                count_fork(true);
                 pid = waitpid(pid, &status, 0);
             }
         }
 
         return pid == -1 ? -1 : status;
     } else {
+        count_fork(true);
         return system(command.c_str());
     }
 }
@@ -137,6 +163,8 @@ int run_command2(const std::vector<std::string> &argv,
             execvp(argv_c[0], const_cast<char * const *>(argv_c.data()));
             _exit(127);
         } else {
+            count_fork(true);
+
             if (cb) {
                 close(stdio_fds[1]);
 
@@ -157,6 +185,8 @@ int run_command2(const std::vector<std::string> &argv,
 
                     _exit(EXIT_SUCCESS);
                 } else {
+                    count_fork(false);
+
                     do {
                         if (waitpid(reader_pid, &reader_status, 0) < 0) {
                             LOGE("Failed to waitpid(): %s", strerror(errno));
@@ -179,6 +209,43 @@ int run_command2(const std::vector<std::string> &argv,
 
     return pid == -1 ? -1 : status;
 }
+/*!
+ * \brief Run a function in a forked child process
+ *
+ * This is used to isolate operations that might crash from long-running
+ * processes. The caller must not have SIGCHLD set to SIG_IGN or the exit status
+ * of the child will be lost.
+ *
+ * \param fn Function to run in the child process
+ *
+ * \return Whether the child exited normally and \a fn returned true
+ */
+bool run_in_child(const std::function<bool()> &fn)
+{
+    pid_t pid = fork();
+    if (pid < 0) {
+        LOGE("Failed to fork: %s", strerror(errno));
+        return false;
+    } else if (pid == 0) {
+        _exit(fn() ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    count_fork(false);
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        LOGE("Failed to wait for child process %d: %s", pid, strerror(errno));
+        return false;
+    }
+
+    if (WIFSIGNALED(status)) {
+        LOGE("Child process %d was killed by signal %d",
+             pid, WTERMSIG(status));
+        return false;
+    }
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
 
 }
 }
@@ -19,9 +19,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <string>
 #include <vector>
 
+#include <cstdint>
+
 namespace mb
 {
 namespace util
@@ -29,6 +33,16 @@ namespace util
 
 typedef void (*OutputCb) (const std::string &line, void *data);
 
+// Number of processes created by the functions below. execs counts the
+// children that were forked to run a program.
+struct CommandCounters
+{
+    std::atomic<uint64_t> forks;
+    std::atomic<uint64_t> execs;
+};
+
+void command_set_counters(CommandCounters *counters);
+
 int run_shell_command(const std::string &command);
 int run_command(const std::vector<std::string> &argv);
 int run_command_cb(const std::vector<std::string> &argv,
@@ -41,6 +55,7 @@ int run_command_chroot_cb(const std::string &dir,
 int run_command2(const std::vector<std::string> &argv,
                  const std::string &chroot_dir,
                  OutputCb cb, void *data);
+bool run_in_child(const std::function<bool()> &fn);
 
 }
 }
\ No newline at end of file
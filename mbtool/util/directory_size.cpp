@@ -0,0 +1,542 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "util/directory_size.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "util/finally.h"
+#include "util/logging.h"
+#include "util/time.h"
+
+// Number of threads walking the tree for a single query
+#define WALKER_MAX_THREADS      4
+
+// Size of the buffer passed to getdents64()
+#define DIRENT_BUF_SIZE         32768
+
+// Changing the size of an existing file does not update the mtime of its
+// directory, so cached directories are fully rescanned after this long
+#define CACHE_MAX_AGE_US        (5ull * 60 * 1000 * 1000)
+// The cache is simply cleared if it grows beyond this many directories
+#define CACHE_MAX_ENTRIES       200000
+
+namespace mb
+{
+namespace util
+{
+
+// Not provided by older versions of bionic
+struct linux_dirent64
+{
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+struct DirKey
+{
+    dev_t dev;
+    ino_t ino;
+
+    bool operator==(const DirKey &other) const
+    {
+        return dev == other.dev && ino == other.ino;
+    }
+};
+
+struct DirKeyHash
+{
+    size_t operator()(const DirKey &key) const
+    {
+        return std::hash<uint64_t>()(key.ino) ^ (std::hash<uint64_t>()(key.dev) << 1);
+    }
+};
+
+// Contents of a single directory (not including subdirectories)
+struct DirEntry
+{
+    time_t mtime;
+    time_t ctime;
+    uint64_t cached_at;
+    // Total size of regular files with a single link
+    uint64_t size;
+    // Regular files with multiple links, which must be deduplicated across the
+    // whole tree
+    std::vector<std::pair<ino_t, uint64_t>> linked;
+    // Subdirectories on the same device
+    std::vector<std::string> subdirs;
+};
+
+// Process-wide, so in the daemon it only outlives a connection with
+// --event-loop. Forked connection processes start from an empty cache.
+static std::mutex cache_mutex;
+static std::unordered_map<DirKey, std::shared_ptr<const DirEntry>, DirKeyHash> cache;
+
+static std::shared_ptr<const DirEntry> cache_get(const DirKey &key,
+                                                 const struct stat &sb)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+        return nullptr;
+    }
+
+    const DirEntry &entry = *it->second;
+    if (entry.mtime != sb.st_mtime || entry.ctime != sb.st_ctime
+            || monotonic_time_us() - entry.cached_at > CACHE_MAX_AGE_US) {
+        cache.erase(it);
+        return nullptr;
+    }
+
+    return it->second;
+}
+
+static void cache_put(const DirKey &key, std::shared_ptr<const DirEntry> entry)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    if (cache.size() >= CACHE_MAX_ENTRIES) {
+        cache.clear();
+    }
+    cache[key] = std::move(entry);
+}
+
+void clear_directory_size_cache()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache.clear();
+}
+
+class DirectorySizeWalker
+{
+public:
+    DirectorySizeWalker(const std::vector<std::string> &exclusions)
+        : _exclusions(exclusions), _pending(0), _queued(0), _size(0),
+        _error(0), _start_time(time(nullptr))
+    {
+    }
+
+    bool run(const std::string &path, unsigned int progress_interval_ms,
+             const DirectorySizeProgressFn &progress);
+
+    uint64_t size() const
+    {
+        return _size;
+    }
+
+private:
+    struct Work
+    {
+        std::string path;
+        struct stat sb;
+        bool is_root;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Work> queue;
+    };
+
+    void push(size_t worker, Work work);
+    bool pop(size_t worker, Work *work);
+    bool steal(size_t worker, Work *work);
+    void finish_one();
+    void worker_loop(size_t worker);
+
+    void process(size_t worker, const Work &work);
+    bool read_dir(int dfd, const Work &work, DirEntry *entry);
+    void add_linked(ino_t ino, uint64_t size, uint64_t *total);
+    void set_error(int error);
+
+    const std::vector<std::string> &_exclusions;
+    dev_t _root_dev;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    // Directories that are queued or being processed
+    std::atomic<uint64_t> _pending;
+    // Directories that are queued
+    std::atomic<uint64_t> _queued;
+    std::mutex _idle_mutex;
+    std::condition_variable _idle_cv;
+
+    std::atomic<uint64_t> _size;
+
+    std::mutex _links_mutex;
+    std::unordered_set<ino_t> _links;
+
+    std::mutex _error_mutex;
+    int _error;
+
+    // Directories modified in the same second as the walk started might be
+    // modified again without changing their mtime, so they are not cached
+    time_t _start_time;
+};
+
+void DirectorySizeWalker::push(size_t worker, Work work)
+{
+    ++_pending;
+    {
+        std::lock_guard<std::mutex> lock(_workers[worker]->mutex);
+        _workers[worker]->queue.push_back(std::move(work));
+    }
+    ++_queued;
+
+    {
+        std::lock_guard<std::mutex> lock(_idle_mutex);
+    }
+    _idle_cv.notify_one();
+}
+
+// Workers take the most recently found directory from their own queue, which
+// keeps the walk depth-first and the queues short
+bool DirectorySizeWalker::pop(size_t worker, Work *work)
+{
+    std::lock_guard<std::mutex> lock(_workers[worker]->mutex);
+    auto &queue = _workers[worker]->queue;
+    if (queue.empty()) {
+        return false;
+    }
+    *work = std::move(queue.back());
+    queue.pop_back();
+    --_queued;
+    return true;
+}
+
+// Idle workers take the oldest directory from another worker's queue, which is
+// likely to be the root of a large subtree
+bool DirectorySizeWalker::steal(size_t worker, Work *work)
+{
+    for (size_t i = 1; i < _workers.size(); ++i) {
+        Worker &victim = *_workers[(worker + i) % _workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.queue.empty()) {
+            *work = std::move(victim.queue.front());
+            victim.queue.pop_front();
+            --_queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirectorySizeWalker::finish_one()
+{
+    if (--_pending == 0) {
+        {
+            std::lock_guard<std::mutex> lock(_idle_mutex);
+        }
+        _idle_cv.notify_all();
+    }
+}
+
+void DirectorySizeWalker::worker_loop(size_t worker)
+{
+    Work work;
+
+    while (true) {
+        if (pop(worker, &work) || steal(worker, &work)) {
+            process(worker, work);
+            finish_one();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_idle_mutex);
+        _idle_cv.wait(lock, [&]{
+            return _queued > 0 || _pending == 0;
+        });
+        if (_pending == 0) {
+            break;
+        }
+    }
+}
+
+void DirectorySizeWalker::set_error(int error)
+{
+    std::lock_guard<std::mutex> lock(_error_mutex);
+    if (_error == 0) {
+        _error = error;
+    }
+}
+
+// The walk never crosses into another filesystem, so the inode number alone
+// identifies a file
+void DirectorySizeWalker::add_linked(ino_t ino, uint64_t size, uint64_t *total)
+{
+    std::lock_guard<std::mutex> lock(_links_mutex);
+    if (_links.insert(ino).second) {
+        *total += size;
+    }
+}
+
+bool DirectorySizeWalker::read_dir(int dfd, const Work &work, DirEntry *entry)
+{
+    std::vector<char> buf(DIRENT_BUF_SIZE);
+    struct stat sb;
+    long n;
+
+    while ((n = syscall(SYS_getdents64, dfd, buf.data(), buf.size())) > 0) {
+        for (long pos = 0; pos < n;) {
+            auto *d = reinterpret_cast<struct linux_dirent64 *>(
+                    buf.data() + pos);
+            pos += d->d_reclen;
+
+            const char *name = d->d_name;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                continue;
+            }
+
+            // Exclusions only apply to the top level
+            if (work.is_root && std::find(_exclusions.begin(),
+                    _exclusions.end(), name) != _exclusions.end()) {
+                continue;
+            }
+
+            // Symlinks and special files are never counted
+            if (d->d_type != DT_DIR && d->d_type != DT_REG
+                    && d->d_type != DT_UNKNOWN) {
+                continue;
+            }
+
+            if (fstatat(dfd, name, &sb, AT_SYMLINK_NOFOLLOW) < 0) {
+                if (errno != ENOENT) {
+                    LOGW("%s/%s: Failed to stat: %s",
+                         work.path.c_str(), name, strerror(errno));
+                    set_error(errno);
+                }
+                continue;
+            }
+
+            if (S_ISDIR(sb.st_mode)) {
+                // Don't cross mount point boundaries
+                if (sb.st_dev == _root_dev) {
+                    entry->subdirs.push_back(name);
+                }
+            } else if (S_ISREG(sb.st_mode)) {
+                if (sb.st_nlink > 1) {
+                    entry->linked.emplace_back(sb.st_ino, sb.st_size);
+                } else {
+                    entry->size += sb.st_size;
+                }
+            }
+        }
+    }
+
+    if (n < 0) {
+        LOGW("%s: Failed to read directory: %s",
+             work.path.c_str(), strerror(errno));
+        set_error(errno);
+        return false;
+    }
+
+    return true;
+}
+
+void DirectorySizeWalker::process(size_t worker, const Work &work)
+{
+    int dfd = open(work.path.c_str(),
+                   O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (dfd < 0) {
+        if (errno != ENOENT) {
+            LOGW("%s: Failed to open directory: %s",
+                 work.path.c_str(), strerror(errno));
+            set_error(errno);
+        }
+        return;
+    }
+
+    auto close_dfd = finally([&]{
+        close(dfd);
+    });
+
+    DirKey key{work.sb.st_dev, work.sb.st_ino};
+    std::shared_ptr<const DirEntry> entry;
+
+    // The root is always read because the exclusions apply to it
+    if (!work.is_root) {
+        entry = cache_get(key, work.sb);
+    }
+
+    if (!entry) {
+        auto new_entry = std::make_shared<DirEntry>();
+        new_entry->mtime = work.sb.st_mtime;
+        new_entry->ctime = work.sb.st_ctime;
+        new_entry->cached_at = monotonic_time_us();
+        new_entry->size = 0;
+
+        if (!read_dir(dfd, work, new_entry.get())) {
+            return;
+        }
+
+        if (!work.is_root && work.sb.st_mtime < _start_time
+                && work.sb.st_ctime < _start_time) {
+            cache_put(key, new_entry);
+        }
+
+        entry = std::move(new_entry);
+    }
+
+    uint64_t size = entry->size;
+    for (auto const &link : entry->linked) {
+        add_linked(link.first, link.second, &size);
+    }
+    _size += size;
+
+    // Even for cached directories, the subdirectories need to be checked since
+    // their changes are not reflected in this directory's mtime
+    for (const std::string &name : entry->subdirs) {
+        Work child;
+        if (fstatat(dfd, name.c_str(), &child.sb, AT_SYMLINK_NOFOLLOW) < 0) {
+            if (errno != ENOENT) {
+                set_error(errno);
+            }
+            continue;
+        }
+        if (!S_ISDIR(child.sb.st_mode) || child.sb.st_dev != _root_dev) {
+            continue;
+        }
+
+        child.path = work.path;
+        if (child.path.empty() || child.path.back() != '/') {
+            child.path += '/';
+        }
+        child.path += name;
+        child.is_root = false;
+
+        push(worker, std::move(child));
+    }
+}
+
+bool DirectorySizeWalker::run(const std::string &path,
+                              unsigned int progress_interval_ms,
+                              const DirectorySizeProgressFn &progress)
+{
+    Work root;
+    root.path = path;
+    root.is_root = true;
+
+    if (lstat(path.c_str(), &root.sb) < 0) {
+        return false;
+    }
+
+    if (!S_ISDIR(root.sb.st_mode)) {
+        // A non-directory root is counted by itself
+        if (S_ISREG(root.sb.st_mode)) {
+            _size = root.sb.st_size;
+        }
+        return true;
+    }
+
+    _root_dev = root.sb.st_dev;
+
+    unsigned int n_threads = std::min<unsigned int>(
+            WALKER_MAX_THREADS,
+            std::max(1u, std::thread::hardware_concurrency()));
+
+    for (unsigned int i = 0; i < n_threads; ++i) {
+        _workers.emplace_back(new Worker());
+    }
+
+    push(0, std::move(root));
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < n_threads; ++i) {
+        threads.emplace_back(&DirectorySizeWalker::worker_loop, this, i);
+    }
+
+    if (progress_interval_ms > 0 && progress) {
+        std::unique_lock<std::mutex> lock(_idle_mutex);
+        while (!_idle_cv.wait_for(
+                lock, std::chrono::milliseconds(progress_interval_ms),
+                [&]{ return _pending == 0; })) {
+            lock.unlock();
+            progress(_size);
+            lock.lock();
+        }
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    if (_error != 0) {
+        errno = _error;
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Get the total size of the regular files in a directory tree
+ *
+ * The tree is walked by several threads and does not cross mount points.
+ * Symlinks are not followed and files with multiple hard links are only counted
+ * once. Directories that have not changed since a previous call are not reread.
+ *
+ * \param path Directory to walk
+ * \param exclusions Names of entries directly within \p path to skip
+ * \param size_out Total size in bytes
+ * \param progress_interval_ms If non-zero, \p progress is called with the
+ *                             running total at this interval
+ * \param progress Progress callback. It is called on the calling thread.
+ *
+ * \return True if the whole tree was walked. Otherwise, false with errno set.
+ */
+bool get_directory_size(const std::string &path,
+                        const std::vector<std::string> &exclusions,
+                        uint64_t *size_out,
+                        unsigned int progress_interval_ms,
+                        const DirectorySizeProgressFn &progress)
+{
+    DirectorySizeWalker walker(exclusions);
+
+    if (!walker.run(path, progress_interval_ms, progress)) {
+        return false;
+    }
+
+    *size_out = walker.size();
+    return true;
+}
+
+}
+}
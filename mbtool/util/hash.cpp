@@ -19,64 +19,410 @@
 
 #include "util/hash.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
+
+#include <cerrno>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 
-#include "autoclose/file.h"
+#include "util/finally.h"
 #include "util/logging.h"
 
+#define HASH_BUF_SIZE (1024 * 1024)
+#define HASH_BUF_ALIGN 4096
+#define HASH_BUF_COUNT 2
+// How often the reader checks whether it should stop while waiting for data
+#define HASH_STOP_POLL_MS 100
+
+#define XXH_PRIME64_1 0x9e3779b185ebca87ULL
+#define XXH_PRIME64_2 0xc2b2ae3d27d4eb4fULL
+#define XXH_PRIME64_3 0x165667b19e3779f9ULL
+#define XXH_PRIME64_4 0x85ebca77c2b2ae63ULL
+#define XXH_PRIME64_5 0x27d4eb2f165667c5ULL
+
 namespace mb
 {
 namespace util
 {
 
+static inline uint64_t xxh_rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const unsigned char *p)
+{
+    // Android only runs on little endian CPUs
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t xxh_read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc = xxh_rotl64(acc, 31);
+    acc *= XXH_PRIME64_1;
+    return acc;
+}
+
+static inline uint64_t xxh64_merge_round(uint64_t acc, uint64_t val)
+{
+    acc ^= xxh64_round(0, val);
+    acc = acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+    return acc;
+}
+
+MultiHasher::MultiHasher(int algos) : _algos(algos)
+{
+    if (_algos & HASH_SHA1) {
+        SHA1_Init(&_sha1);
+    }
+    if (_algos & HASH_SHA512) {
+        SHA512_Init(&_sha512);
+    }
+    if (_algos & HASH_XXH64) {
+        _xxh64.v[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+        _xxh64.v[1] = XXH_PRIME64_2;
+        _xxh64.v[2] = 0;
+        _xxh64.v[3] = -XXH_PRIME64_1;
+        _xxh64.total_len = 0;
+        _xxh64.mem_size = 0;
+    }
+}
+
+void MultiHasher::update(const void *data, size_t size)
+{
+    if (_algos & HASH_SHA1) {
+        SHA1_Update(&_sha1, data, size);
+    }
+    if (_algos & HASH_SHA512) {
+        SHA512_Update(&_sha512, data, size);
+    }
+    if (_algos & HASH_XXH64) {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        const unsigned char *end = p + size;
+        Xxh64State &s = _xxh64;
+
+        s.total_len += size;
+
+        if (s.mem_size + size < 32) {
+            memcpy(s.mem + s.mem_size, p, size);
+            s.mem_size += size;
+            return;
+        }
+
+        if (s.mem_size > 0) {
+            size_t fill = 32 - s.mem_size;
+            memcpy(s.mem + s.mem_size, p, fill);
+            for (int i = 0; i < 4; ++i) {
+                s.v[i] = xxh64_round(s.v[i], xxh_read64(s.mem + i * 8));
+            }
+            p += fill;
+            s.mem_size = 0;
+        }
+
+        for (; p + 32 <= end; p += 32) {
+            for (int i = 0; i < 4; ++i) {
+                s.v[i] = xxh64_round(s.v[i], xxh_read64(p + i * 8));
+            }
+        }
+
+        if (p < end) {
+            s.mem_size = end - p;
+            memcpy(s.mem, p, s.mem_size);
+        }
+    }
+}
+
+void MultiHasher::finish(HashResult *result)
+{
+    if (_algos & HASH_SHA1) {
+        SHA1_Final(result->sha1, &_sha1);
+    }
+    if (_algos & HASH_SHA512) {
+        SHA512_Final(result->sha512, &_sha512);
+    }
+    if (_algos & HASH_XXH64) {
+        const Xxh64State &s = _xxh64;
+        uint64_t h;
+
+        if (s.total_len >= 32) {
+            h = xxh_rotl64(s.v[0], 1) + xxh_rotl64(s.v[1], 7)
+                    + xxh_rotl64(s.v[2], 12) + xxh_rotl64(s.v[3], 18);
+            for (int i = 0; i < 4; ++i) {
+                h = xxh64_merge_round(h, s.v[i]);
+            }
+        } else {
+            h = s.v[2] + XXH_PRIME64_5;
+        }
+
+        h += s.total_len;
+
+        const unsigned char *p = s.mem;
+        const unsigned char *end = p + s.mem_size;
+
+        for (; p + 8 <= end; p += 8) {
+            h ^= xxh64_round(0, xxh_read64(p));
+            h = xxh_rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        }
+        if (p + 4 <= end) {
+            h ^= static_cast<uint64_t>(xxh_read32(p)) * XXH_PRIME64_1;
+            h = xxh_rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            h ^= *p * XXH_PRIME64_5;
+            h = xxh_rotl64(h, 11) * XXH_PRIME64_1;
+        }
+
+        h ^= h >> 33;
+        h *= XXH_PRIME64_2;
+        h ^= h >> 29;
+        h *= XXH_PRIME64_3;
+        h ^= h >> 32;
+
+        result->xxh64 = h;
+    }
+}
+
+struct HashPipeline
+{
+    char *bufs[HASH_BUF_COUNT] = {};
+    ssize_t sizes[HASH_BUF_COUNT] = {};
+    bool filled[HASH_BUF_COUNT] = {};
+    // Also checked without the mutex while the reader waits for data
+    std::atomic<bool> stop{false};
+    int read_errno = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    ~HashPipeline()
+    {
+        for (char *buf : bufs) {
+            free(buf);
+        }
+    }
+};
+
+// Waits for data with poll() so that the reader can be stopped even if the fd
+// is a pipe or other file that never becomes readable
+static ssize_t read_full(int fd, char *data, size_t size, HashPipeline *p)
+{
+    size_t total = 0;
+
+    while (total < size) {
+        if (p->stop) {
+            errno = ECANCELED;
+            return -1;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ret = poll(&pfd, 1, HASH_STOP_POLL_MS);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        } else if (ret == 0) {
+            continue;
+        }
+
+        ssize_t n = read(fd, data + total, size - total);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        } else if (n == 0) {
+            break;
+        }
+        total += n;
+    }
+
+    return total;
+}
+
+static void hash_reader(int fd, HashPipeline *p)
+{
+    for (size_t i = 0; ; i = (i + 1) % HASH_BUF_COUNT) {
+        {
+            std::unique_lock<std::mutex> lock(p->mutex);
+            p->cv.wait(lock, [&]{ return !p->filled[i] || p->stop; });
+            if (p->stop) {
+                return;
+            }
+        }
+
+        // Read without holding the lock so the hashing thread can proceed
+        ssize_t n = read_full(fd, p->bufs[i], HASH_BUF_SIZE, p);
+        int saved_errno = errno;
+
+        {
+            std::lock_guard<std::mutex> lock(p->mutex);
+            p->sizes[i] = n;
+            p->filled[i] = true;
+            if (n < 0) {
+                p->read_errno = saved_errno;
+            }
+        }
+        p->cv.notify_all();
+
+        if (n <= 0) {
+            return;
+        }
+    }
+}
+
 /*!
- * \brief Compute SHA1 hash of a file
+ * \brief Compute several hashes of a file descriptor in a single pass
  *
- * \param path Path to file
- * \param digest `unsigned char` array of size `SHA_DIGEST_SIZE` to store
- *               computed hash value
+ * The data is read from the current file offset until EOF by a separate
+ * thread into large aligned buffers, so reading the next chunk overlaps with
+ * hashing the current one. This matters mostly for block devices, which are
+ * read uncached on many kernels.
+ *
+ * \param fd File descriptor to read from
+ * \param algos Bitwise-OR of HashAlgorithms values
+ * \param[out] result Computed hashes for the requested algorithms
+ * \param data_fn Optional function that receives every chunk of data after it
+ *                has been hashed. Hashing stops if it returns false.
  *
  * \return true on success, false on failure and errno set appropriately
  */
-bool sha1_hash(const std::string &path, unsigned char digest[SHA_DIGEST_LENGTH])
+bool hash_fd(int fd, int algos, HashResult *result, const HashDataFn &data_fn)
 {
-    autoclose::file fp(autoclose::fopen(path.c_str(), "rb"));
-    if (!fp) {
-        LOGE("%s: Failed to open: %s", path.c_str(), strerror(errno));
-        return false;
+    HashPipeline p;
+
+    for (char *&buf : p.bufs) {
+        if (posix_memalign(reinterpret_cast<void **>(&buf), HASH_BUF_ALIGN,
+                           HASH_BUF_SIZE) != 0) {
+            buf = nullptr;
+            errno = ENOMEM;
+            return false;
+        }
     }
 
-    unsigned char buf[10240];
-    size_t n;
+    // Only a hint, so failures (eg. for pipes) don't matter
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
-    SHA_CTX ctx;
-    if (!SHA1_Init(&ctx)) {
-        LOGE("openssl: SHA1_Init() failed");
-        return false;
-    }
+    MultiHasher hasher(algos);
+    std::thread reader(&hash_reader, fd, &p);
 
-    while ((n = fread(buf, 1, sizeof(buf), fp.get())) > 0) {
-        if (!SHA1_Update(&ctx, buf, n)) {
-            LOGE("openssl: SHA1_Update() failed");
-            return false;
+    // The reader notices the stop request within HASH_STOP_POLL_MS, even if it
+    // is waiting for data. errno is preserved for the caller.
+    auto join_reader = finally([&]{
+        int saved_errno = errno;
+        {
+            std::lock_guard<std::mutex> lock(p.mutex);
+            p.stop = true;
+        }
+        p.cv.notify_all();
+        reader.join();
+        errno = saved_errno;
+    });
+
+    for (size_t i = 0; ; i = (i + 1) % HASH_BUF_COUNT) {
+        ssize_t n;
+
+        {
+            std::unique_lock<std::mutex> lock(p.mutex);
+            p.cv.wait(lock, [&]{ return p.filled[i]; });
+            n = p.sizes[i];
+            if (n < 0) {
+                errno = p.read_errno;
+                return false;
+            }
         }
-        if (n < sizeof(buf)) {
+
+        if (n == 0) {
             break;
         }
+
+        hasher.update(p.bufs[i], n);
+
+        if (data_fn && !data_fn(p.bufs[i], n)) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(p.mutex);
+            p.filled[i] = false;
+        }
+        p.cv.notify_all();
+    }
+
+    hasher.finish(result);
+    return true;
+}
+
+/*!
+ * \brief Compute several hashes of a file in a single pass
+ *
+ * \param path Path to file
+ * \param algos Bitwise-OR of HashAlgorithms values
+ * \param[out] result Computed hashes for the requested algorithms
+ *
+ * \return true on success, false on failure and errno set appropriately
+ */
+bool hash_file(const std::string &path, int algos, HashResult *result)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("%s: Failed to open: %s", path.c_str(), strerror(errno));
+        return false;
     }
 
-    if (ferror(fp.get())) {
-        LOGE("%s: Failed to read file", path.c_str());
-        errno = EIO;
+    auto close_fd = finally([&]{
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+    });
+
+    if (!hash_fd(fd, algos, result)) {
+        LOGE("%s: Failed to read file: %s", path.c_str(), strerror(errno));
         return false;
     }
 
-    if (!SHA1_Final(digest, &ctx)) {
-        LOGE("openssl: SHA1_Final() failed");
+    return true;
+}
+
+/*!
+ * \brief Compute SHA1 hash of a file
+ *
+ * \param path Path to file
+ * \param digest `unsigned char` array of size `SHA_DIGEST_SIZE` to store
+ *               computed hash value
+ *
+ * \return true on success, false on failure and errno set appropriately
+ */
+bool sha1_hash(const std::string &path, unsigned char digest[SHA_DIGEST_LENGTH])
+{
+    HashResult result;
+    if (!hash_file(path, HASH_SHA1, &result)) {
         return false;
     }
 
+    memcpy(digest, result.sha1, SHA_DIGEST_LENGTH);
     return true;
 }
 
@@ -19,8 +19,11 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 
+#include <cstdint>
+
 #include <openssl/sha.h>
 
 namespace mb
@@ -28,6 +31,53 @@ namespace mb
 namespace util
 {
 
+enum HashAlgorithms : int
+{
+    HASH_SHA1                = 0x1,
+    HASH_SHA512              = 0x2,
+    // Fast non-cryptographic hash for detecting changes
+    HASH_XXH64               = 0x4
+};
+
+struct HashResult
+{
+    unsigned char sha1[SHA_DIGEST_LENGTH];
+    unsigned char sha512[SHA512_DIGEST_LENGTH];
+    uint64_t xxh64;
+};
+
+/*!
+ * \brief Incremental hash context for several algorithms at once
+ */
+class MultiHasher
+{
+public:
+    explicit MultiHasher(int algos);
+
+    void update(const void *data, size_t size);
+    void finish(HashResult *result);
+
+private:
+    struct Xxh64State
+    {
+        uint64_t v[4];
+        uint64_t total_len;
+        unsigned char mem[32];
+        size_t mem_size;
+    };
+
+    int _algos;
+    SHA_CTX _sha1;
+    SHA512_CTX _sha512;
+    Xxh64State _xxh64;
+};
+
+typedef std::function<bool(const char *data, size_t size)> HashDataFn;
+
+bool hash_fd(int fd, int algos, HashResult *result,
+             const HashDataFn &data_fn = nullptr);
+bool hash_file(const std::string &path, int algos, HashResult *result);
+
 bool sha1_hash(const std::string &path, unsigned char digest[SHA_DIGEST_LENGTH]);
 
 }
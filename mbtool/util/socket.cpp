@@ -23,6 +23,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace mb
@@ -82,6 +83,48 @@ ssize_t socket_write(int fd, const void *buf, size_t size)
     return bytes_written;
 }
 
+ssize_t socket_writev(int fd, struct iovec *iov, int iovcnt)
+{
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        total += iov[i].iov_len;
+    }
+
+    // Same restriction as socket_write()
+    if (total > SSIZE_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ssize_t bytes_written = 0;
+    ssize_t n;
+
+    while (iovcnt > 0) {
+        n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            return n;
+        } else if (n == 0) {
+            break;
+        }
+
+        bytes_written += n;
+
+        // Skip over the fully written buffers and adjust the partially written
+        // one (this modifies the caller's iovec array)
+        while (iovcnt > 0 && (size_t) n >= iov->iov_len) {
+            n -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    return bytes_written;
+}
+
 bool socket_read_bytes(int fd, std::vector<uint8_t> *result)
 {
     int32_t len;
@@ -93,25 +136,30 @@ bool socket_read_bytes(int fd, std::vector<uint8_t> *result)
         return false;
     }
 
-    std::vector<uint8_t> buf(len);
+    // Read directly into the caller's vector so that its capacity can be
+    // reused across messages
+    result->resize(len);
 
-    if (socket_read(fd, buf.data(), len) == (ssize_t) len) {
-        result->swap(buf);
-        return true;
-    }
-    return false;
+    return socket_read(fd, result->data(), len) == (ssize_t) len;
 }
 
 bool socket_write_bytes(int fd, const uint8_t *data, size_t len)
 {
-    if (!socket_write_int32(fd, len)) {
+    if (len > INT32_MAX) {
+        errno = EINVAL;
         return false;
     }
 
-    if (socket_write(fd, data, len) == (ssize_t) len) {
-        return true;
-    }
-    return false;
+    int32_t len32 = len;
+
+    // Send the length prefix and the data with a single syscall
+    struct iovec iov[2];
+    iov[0].iov_base = &len32;
+    iov[0].iov_len = sizeof(len32);
+    iov[1].iov_base = const_cast<uint8_t *>(data);
+    iov[1].iov_len = len;
+
+    return socket_writev(fd, iov, 2) == (ssize_t) (sizeof(len32) + len);
 }
 
 template<typename TYPE>
@@ -23,6 +23,7 @@
 #include <vector>
 
 #include <inttypes.h>
+#include <sys/uio.h>
 
 namespace mb
 {
@@ -31,6 +32,7 @@ namespace util
 
 ssize_t socket_read(int fd, void *buf, size_t size);
 ssize_t socket_write(int fd, const void *buf, size_t size);
+ssize_t socket_writev(int fd, struct iovec *iov, int iovcnt);
 bool socket_read_bytes(int fd, std::vector<uint8_t> *result);
 bool socket_write_bytes(int fd, const uint8_t *data, size_t len);
 bool socket_read_uint16(int fd, uint16_t *result);
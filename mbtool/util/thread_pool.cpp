@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "util/thread_pool.h"
+
+namespace mb
+{
+namespace util
+{
+
+ThreadPool::ThreadPool(unsigned int max_threads)
+    : _max_threads(max_threads > 0 ? max_threads : 1),
+      _idle_threads(0),
+      _running(0),
+      _stop(false)
+{
+}
+
+// Waits for all queued tasks to finish
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _work_cv.notify_all();
+
+    for (std::thread &t : _threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::submit(Task task, uint64_t key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _queue.push_back({ std::move(task), key });
+
+    if (_idle_threads == 0 && _threads.size() < _max_threads) {
+        _threads.emplace_back(&ThreadPool::worker, this);
+    } else {
+        _work_cv.notify_one();
+    }
+}
+
+// Block until the queue is empty and no task is running
+void ThreadPool::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle_cv.wait(lock, [this] {
+        return _queue.empty() && _running == 0;
+    });
+}
+
+// Must be called with _mutex held. The earliest queued task for a key is
+// always found first, so the submission order for the key is preserved.
+bool ThreadPool::take_runnable(Entry *entry)
+{
+    for (auto it = _queue.begin(); it != _queue.end(); ++it) {
+        if (it->key == 0 || _active_keys.find(it->key) == _active_keys.end()) {
+            *entry = std::move(*it);
+            _queue.erase(it);
+            if (entry->key != 0) {
+                _active_keys.insert(entry->key);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true) {
+        Entry entry;
+
+        ++_idle_threads;
+        _work_cv.wait(lock, [&] {
+            return take_runnable(&entry) || (_stop && _queue.empty());
+        });
+        --_idle_threads;
+
+        if (!entry.task) {
+            // Stopping and nothing left to do
+            break;
+        }
+
+        ++_running;
+        lock.unlock();
+
+        entry.task();
+
+        lock.lock();
+        --_running;
+        if (entry.key != 0) {
+            _active_keys.erase(entry.key);
+            // Tasks waiting on this key may now be runnable
+            _work_cv.notify_all();
+        }
+        if (_queue.empty() && _running == 0) {
+            _idle_cv.notify_all();
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2016  Andrew Gunnerson <andrewgunnerson@gmail.com>
+ *
+ * This file is part of MultiBootPatcher
+ *
+ * MultiBootPatcher is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MultiBootPatcher is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MultiBootPatcher.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <cstdint>
+
+namespace mb
+{
+namespace util
+{
+
+// Runs tasks on up to max_threads worker threads. Threads are only started
+// when a task is submitted and no worker is idle.
+//
+// Tasks submitted with the same non-zero key are executed one at a time in the
+// order they were submitted. Tasks with a key of zero have no ordering
+// constraints.
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    explicit ThreadPool(unsigned int max_threads);
+    ~ThreadPool();
+
+    void submit(Task task, uint64_t key = 0);
+    void wait_idle();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+private:
+    struct Entry
+    {
+        Task task;
+        uint64_t key;
+    };
+
+    void worker();
+    bool take_runnable(Entry *entry);
+
+    std::mutex _mutex;
+    std::condition_variable _work_cv;
+    std::condition_variable _idle_cv;
+    std::deque<Entry> _queue;
+    std::unordered_set<uint64_t> _active_keys;
+    std::vector<std::thread> _threads;
+    unsigned int _max_threads;
+    unsigned int _idle_threads;
+    unsigned int _running;
+    bool _stop;
+};
+
+}
+}
@@ -33,6 +33,19 @@ uint64_t current_time_ms()
     return 1000u * res.tv_sec + res.tv_nsec / 1e6;
 }
 
+/*!
+ * \brief Get time from the monotonic clock in microseconds
+ *
+ * Unlike current_time_ms(), the value is not affected by changes to the system
+ * time, so it is suitable for measuring durations.
+ */
+uint64_t monotonic_time_us()
+{
+    struct timespec res;
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return 1000000u * res.tv_sec + res.tv_nsec / 1000u;
+}
+
 /*!
  * \brief Format date and time
  *
@@ -29,6 +29,7 @@ namespace util
 {
 
 uint64_t current_time_ms();
+uint64_t monotonic_time_us();
 bool format_time(const std::string &format, std::string *out);
 
 }
@@ -25,6 +25,13 @@ files=(
     v3/mb_wipe_rom.fbs
     v3/mb_get_packages_count.fbs
     v3/reboot.fbs
+    v3/file_open_fd.fbs
+    v3/file_read_stream.fbs
+    v3/file_write_stream.fbs
+    v3/mb_get_stats.fbs
+    v3/path_copy_start.fbs
+    v3/path_copy_status.fbs
+    v3/path_copy_cancel.fbs
     request.fbs
     response.fbs
 )